@@ -2,7 +2,9 @@
 """
 Convert ADC data files from old binary format to new ASCII format.
 
-Old format: Binary file with 32-bit words (little-endian)
+Old format: Binary file with 32-bit words (little-endian), either a raw dump
+            (--bin) or a chunked capture container (--chunked, see
+            software/shim-test/include/commands/capture_file.h)
 New format: ASCII text file with 8 samples per line, space-separated
 
 Each 32-bit word contains two 16-bit samples:
@@ -18,6 +20,7 @@ The offset_to_signed conversion is:
 import os
 import sys
 import struct
+import zlib
 import argparse
 from pathlib import Path
 
@@ -30,6 +33,82 @@ def adc_offset_to_signed(offset_val):
         signed_val = offset_val - 32767
         return max(-32767, min(32767, signed_val))
 
+CAPTURE_MAGIC = b'SHIMCAP\x00'
+CAPTURE_CHUNK_MAGIC = 0x4B4E4843
+CAPTURE_HEADER_FMT = '<8sHHBB8sBxIIQQQQQQQ256s'  # capture_file_header_t fields
+CAPTURE_CHUNK_FMT = '<IIIIQQII'                   # capture_chunk_header_t
+ADC_CODEC_BLOCK_FRAMES = 16
+
+def decode_adc_codec(payload, word_count):
+    """Decode a delta + bit-pack encoded chunk (see software/shim-test/include/commands/adc_codec.h)."""
+    bits = int.from_bytes(payload, 'little')
+    pos = 0
+    def get(width):
+        nonlocal pos
+        value = (bits >> pos) & ((1 << width) - 1)
+        pos += width
+        return value
+
+    samples = [0] * (word_count * 2)
+    previous = [0] * 8
+    block_samples = 8 * ADC_CODEC_BLOCK_FRAMES
+    block_count = len(samples) // block_samples
+    for block in range(block_count):
+        widths = [get(5) for _ in range(8)]
+        base = block * block_samples
+        for c in range(8):
+            value = previous[c]
+            for f in range(ADC_CODEC_BLOCK_FRAMES):
+                zz = get(widths[c]) if widths[c] else 0
+                value = (value + ((zz >> 1) ^ -(zz & 1))) & 0xFFFF
+                samples[base + f * 8 + c] = value
+            previous[c] = value
+    for i in range(block_count * block_samples, len(samples)):
+        samples[i] = get(16)
+    return [samples[2 * i] | (samples[2 * i + 1] << 16) for i in range(word_count)]
+
+def read_capture_words(binary_data, verbose=False):
+    """Return the payload words of a chunked capture file, checking each chunk CRC."""
+    fields = struct.unpack_from(CAPTURE_HEADER_FMT, binary_data, 0)
+    (magic, version, header_size, stream_type, board, order, codec, chunk_words,
+     spi_clk_freq_hz, cmd_file_hash, words_per_iteration, _, _, chunk_count,
+     total_words, index_offset, cmd_file_path) = fields
+    if verbose:
+        print(f"Chunked capture v{version}: stream type {stream_type}, board {board}, codec {codec}, "
+              f"channel order {list(order)}, SPI clock {spi_clk_freq_hz} Hz")
+        if cmd_file_hash:
+            path = cmd_file_path.split(b'\x00', 1)[0].decode(errors='replace')
+            print(f"Command file '{path}' (FNV-1a 0x{cmd_file_hash:016x}), "
+                  f"{words_per_iteration} words per iteration")
+        if index_offset == 0:
+            print("Capture has no index (not closed cleanly); reading chunks up to the last complete one")
+
+    words = []
+    offset = header_size
+    chunk_size = struct.calcsize(CAPTURE_CHUNK_FMT)
+    end = index_offset if index_offset else len(binary_data)
+    while offset + chunk_size <= end:
+        magic, word_count, sequence, payload_bytes, first_word, timestamp_ns, payload_crc, header_crc = \
+            struct.unpack_from(CAPTURE_CHUNK_FMT, binary_data, offset)
+        if magic != CAPTURE_CHUNK_MAGIC or zlib.crc32(binary_data[offset:offset + chunk_size - 4]) != header_crc:
+            break
+        stored_bytes = payload_bytes if payload_bytes else word_count * 4
+        payload = binary_data[offset + chunk_size:offset + chunk_size + stored_bytes]
+        if len(payload) != stored_bytes:
+            break
+        if payload_bytes:
+            if codec != 1:
+                print(f"Error: unknown capture codec {codec}")
+                break
+            chunk_words = decode_adc_codec(payload, word_count)
+        else:
+            chunk_words = list(struct.unpack(f'<{word_count}I', payload))
+        if zlib.crc32(struct.pack(f'<{word_count}I', *chunk_words)) != payload_crc:
+            print(f"Warning: chunk {sequence} payload CRC mismatch")
+        words.extend(chunk_words)
+        offset += chunk_size + stored_bytes
+    return words
+
 def convert_adc_file(input_file, output_file, verbose=False):
     """Convert a binary ADC data file to ASCII format."""
     
@@ -41,18 +120,25 @@ def convert_adc_file(input_file, output_file, verbose=False):
         with open(input_file, 'rb') as f:
             binary_data = f.read()
         
+        if binary_data.startswith(CAPTURE_MAGIC):
+            words = read_capture_words(binary_data, verbose)
+            word_count = len(words)
+        else:
+            words = None
+
         # Check if file size is valid (multiple of 4 bytes)
-        if len(binary_data) % 4 != 0:
+        if words is None and len(binary_data) % 4 != 0:
             print(f"Warning: {input_file} size ({len(binary_data)} bytes) is not a multiple of 4")
             # Truncate to nearest multiple of 4
             binary_data = binary_data[:len(binary_data) - (len(binary_data) % 4)]
         
-        word_count = len(binary_data) // 4
-        if verbose:
-            print(f"Processing {word_count} words ({len(binary_data)} bytes)")
-        
-        # Unpack as little-endian 32-bit unsigned integers
-        words = struct.unpack(f'<{word_count}I', binary_data)
+        if words is None:
+            word_count = len(binary_data) // 4
+            if verbose:
+                print(f"Processing {word_count} words ({len(binary_data)} bytes)")
+            
+            # Unpack as little-endian 32-bit unsigned integers
+            words = struct.unpack(f'<{word_count}I', binary_data)
         
         # Convert and write ASCII output
         with open(output_file, 'w') as f:
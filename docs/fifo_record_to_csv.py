@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+"""
+Convert a FIFO occupancy recording (shim-test fifo_record command) to CSV and
+print each FIFO's peak and minimum occupancy against its depth.
+
+File layout: see software/shim-test/include/commands/fifo_recorder.h
+"""
+
+import csv
+import os
+import struct
+import sys
+
+FIFO_RECORD_MAGIC = b'SHIMFOR\x00'
+HEADER_FMT = '<8sHHHBxIIIIQQQQQ'  # fifo_record_header_t fields
+SAMPLE_FMT = '<III8H8HHH'         # fifo_record_sample_t
+ABSENT = 0xFFFF
+
+def read_recording(path):
+  with open(path, 'rb') as f:
+    data = f.read()
+  fields = struct.unpack_from(HEADER_FMT, data, 0)
+  magic, version, header_size, sample_size, board_mask, rate_hz = fields[:6]
+  if magic != FIFO_RECORD_MAGIC:
+    raise ValueError(f"{path} is not a FIFO recording")
+  header = {
+    'version': version, 'board_mask': board_mask, 'rate_hz': rate_hz,
+    'dac_cmd_fifo_words': fields[6], 'adc_data_fifo_words': fields[7], 'trig_data_fifo_words': fields[8],
+    'start_realtime_ns': fields[9], 'sample_count': fields[11],
+    'samples_taken': fields[12], 'missed_periods': fields[13],
+  }
+  samples = []
+  offset = header_size
+  wraps = 0
+  last_time = 0
+  for _ in range(header['sample_count']):
+    values = struct.unpack_from(SAMPLE_FMT, data, offset)
+    offset += sample_size
+    # time_us wraps every 2^32 us; samples are in order, so unwrap as they come
+    if values[0] < last_time:
+      wraps += 1
+    last_time = values[0]
+    samples.append((values[0] + (wraps << 32),) + values[1:])
+  return header, samples
+
+def main():
+  if len(sys.argv) < 2:
+    print(f"Usage: {sys.argv[0]} <recording> [output_csv]")
+    sys.exit(1)
+  path = sys.argv[1]
+  if not os.path.isfile(path):
+    print("Input file does not exist.")
+    sys.exit(1)
+  output_csv = sys.argv[2] if len(sys.argv) > 2 else os.path.splitext(path)[0] + ".csv"
+  header, samples = read_recording(path)
+  boards = [b for b in range(8) if header['board_mask'] & (1 << b)]
+
+  with open(output_csv, 'w', newline='') as outfile:
+    writer = csv.writer(outfile)
+    writer.writerow(['seconds', 'trig_counter', 'hw_state', 'hw_status_code', 'missed'] +
+                    [f'dac_cmd{b}' for b in boards] + [f'adc_data{b}' for b in boards] + ['trig_data'])
+    for s in samples:
+      time_us, trig_counter, hw_status = s[0], s[1], s[2]
+      dac_cmd, adc_data, trig_data, missed = s[3:11], s[11:19], s[19], s[20]
+      writer.writerow([f"{time_us / 1e6:.6f}", trig_counter, hw_status & 0xF, (hw_status >> 4) & 0x1FFFFFF, missed] +
+                      [dac_cmd[b] for b in boards] + [adc_data[b] for b in boards] + [trig_data])
+
+  print(f"{len(samples)} samples at {header['rate_hz']} Hz ({header['missed_periods']} missed periods) written to {output_csv}")
+  if not samples:
+    return
+  columns = [(f"DAC command FIFO {b}", 3 + b, header['dac_cmd_fifo_words']) for b in boards]
+  columns += [(f"ADC data FIFO {b}", 11 + b, header['adc_data_fifo_words']) for b in boards]
+  columns += [("Trigger data FIFO", 19, header['trig_data_fifo_words'])]
+  for name, index, depth in columns:
+    levels = [s[index] for s in samples if s[index] != ABSENT]
+    if levels:
+      print(f"  {name:20s} min {min(levels):6d}  max {max(levels):6d}  of {depth} words ({100.0 * max(levels) / depth:.1f}% peak)")
+
+if __name__ == "__main__":
+  main()
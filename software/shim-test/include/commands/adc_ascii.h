@@ -0,0 +1,21 @@
+#ifndef ADC_ASCII_H
+#define ADC_ASCII_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Table-driven text encoder for ADC data words.
+// Produces exactly the same text as fprintf("%d") with single spaces between
+// samples and 8 samples per line, but formats into a caller-supplied buffer
+// so a whole batch can go out with one fwrite().
+
+#define ADC_ASCII_SAMPLES_PER_LINE 8
+// Worst case output per 32-bit word: two "-32768" plus separators/newlines
+#define ADC_ASCII_MAX_BYTES_PER_WORD 16
+
+// Format count ADC words (two int16 samples each, low half first) into out.
+// out must hold at least count * ADC_ASCII_MAX_BYTES_PER_WORD bytes.
+// samples_on_line carries the line position across calls. Returns bytes written.
+size_t adc_ascii_format_words(char* out, const uint32_t* words, size_t count, int* samples_on_line);
+
+#endif // ADC_ASCII_H
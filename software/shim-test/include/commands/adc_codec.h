@@ -0,0 +1,32 @@
+#ifndef ADC_CODEC_H
+#define ADC_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Lossless codec for ADC data words.
+// Samples are de-interleaved into the 8 channel slots of each ADC_RD frame
+// (4 words, low half first) and each channel is predicted from its previous
+// sample. Prediction residuals are zigzag-mapped and bit-packed in blocks of
+// ADC_CODEC_BLOCK_FRAMES frames, with a 5-bit width per channel per block.
+// Samples after the last full block are stored as plain 16-bit values.
+// Every encoded buffer is self-contained (predictors start at 0), so
+// capture chunks can be decoded independently.
+
+#define ADC_CODEC_NONE        0  // Words stored as-is
+#define ADC_CODEC_DELTA_PACK  1  // Per-channel delta + zigzag + bit-packing
+
+#define ADC_CODEC_CHANNELS      8
+#define ADC_CODEC_BLOCK_FRAMES  16
+#define ADC_CODEC_BLOCK_SAMPLES (ADC_CODEC_CHANNELS * ADC_CODEC_BLOCK_FRAMES)
+
+// Upper bound on the encoded size of word_count words
+#define ADC_CODEC_MAX_ENCODED_BYTES(word_count) \
+  ((word_count) * 4 + ((word_count) * 2 / ADC_CODEC_BLOCK_SAMPLES + 1) * 5 + 8)
+
+// Encode word_count words into out (ADC_CODEC_MAX_ENCODED_BYTES bytes); returns encoded bytes
+size_t adc_codec_encode(const uint32_t* words, size_t word_count, uint8_t* out);
+// Decode exactly word_count words from in_bytes bytes; returns 0, or -1 if the input is malformed
+int adc_codec_decode(const uint8_t* in, size_t in_bytes, uint32_t* words, size_t word_count);
+
+#endif // ADC_CODEC_H
@@ -2,6 +2,16 @@
 #define ADC_COMMANDS_H
 
 #include "command_helper.h"
+#include "adc_ctrl.h"
+
+// ADC data stream pipeline (shared drain thread -> per-board SPSC ring -> shared writer thread)
+#define ADC_STREAM_BURST_WORDCOUNT       ADC_DATA_FIFO_WORDCOUNT // Max words per FIFO burst (one full data FIFO)
+#define ADC_STREAM_RING_WORDCOUNT        (1 << 20) // Ring between drain and writer (4 MB per board)
+#define ADC_STREAM_WRITE_BATCH_WORDCOUNT (1 << 16) // Writer waits for 256 KB before writing...
+#define ADC_STREAM_WRITE_MAX_LATENCY_MS  100       // ...or until data has waited this long
+#define ADC_STREAM_WRITER_IDLE_US        1000      // Writer sleep while waiting for a batch
+#define ADC_STREAM_FILE_BUFFER_SIZE      (1 << 20) // stdio buffer for the output file
+#define ADC_STREAM_TEXT_CHUNK_WORDCOUNT  (1 << 14) // Words formatted per ASCII fwrite (256 KB text buffer)
 
 // Enum for ADC command types
 typedef enum {
@@ -20,14 +30,16 @@ typedef struct {
   uint8_t order[8];         // Channel order array (for ADC_ORDER_CMD commands - specifies sampling order 0-7)
 } adc_command_t;
 
-// Structure to pass data to the ADC data streaming thread (for reading ADC data to file)
+// Parameters for an ADC data stream session (for reading ADC data to file)
 typedef struct {
-  command_context_t* ctx;
   uint8_t board;
   char file_path[1024];
   uint64_t word_count;         // Number of words to read from ADC
   volatile bool* should_stop;
   bool binary_mode;            // true for binary format, false for ASCII format
+  bool fprintf_ascii;          // ASCII via per-sample fprintf instead of the fast formatter
+  bool chunked;                // Chunked capture container (implies binary)
+  bool compress;               // Lossless ADC codec in the container (implies chunked)
 } adc_data_stream_params_t;
 
 // Structure to pass data to the ADC command streaming thread (for streaming commands from file)
@@ -36,7 +48,8 @@ typedef struct {
   uint8_t board;
   char file_path[1024];
   volatile bool* should_stop;
-  adc_command_t* commands;
+  uint32_t* words;      // Encoded FIFO words of one iteration (replayed every iteration)
+  size_t word_count;
   int command_count;
   int iterations;  // Total number of iterations to perform
   bool simple_mode;     // Whether to unroll repeats instead of using repeat count in commands
@@ -63,6 +76,20 @@ int cmd_do_adc_rd_ch(const char** args, int arg_count, const command_flag_t* fla
 // ADC data streaming operations (reading ADC data to files)
 int cmd_stream_adc_data_to_file(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
 int cmd_stop_adc_data_stream(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+// Show the shared ADC stream engine statistics
+int cmd_adc_stream_status(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+// Show per-channel statistics of the current or last ADC data stream
+int cmd_adc_stats(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+// Show the header and index of a chunked capture file
+int cmd_capture_info(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+// Benchmark the lossless ADC codec
+int cmd_bench_adc_codec(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+// Benchmark the ASCII writer paths used by stream_adc_data_to_file
+int cmd_bench_adc_ascii(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+// Benchmark the per-channel statistics kept during ADC data streams
+int cmd_bench_adc_stats(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+// Benchmark per-command ADC command streaming against replay of the pre-encoded iteration
+int cmd_bench_adc_cmd_stream(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
 
 // ADC command streaming operations (streaming commands from files)
 int cmd_stream_adc_commands_from_file(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
@@ -70,5 +97,7 @@ int cmd_stop_adc_cmd_stream(const char** args, int arg_count, const command_flag
 
 // Helper function to calculate expected number of ADC words from an ADC command file
 uint64_t calculate_expected_adc_words(const char* file_path, int iterations, bool verbose);
+// Parse an ADC command file and encode one iteration of its FIFO words (malloc'd, NULL on error)
+uint32_t* adc_command_file_words(const char* file_path, size_t* word_count, int* command_count);
 
 #endif // ADC_COMMANDS_H
@@ -0,0 +1,51 @@
+#ifndef ADC_STATS_H
+#define ADC_STATS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+//////////////////// ADC Stream Statistics Definitions ////////////////////
+// Running per-channel statistics for one board's ADC data stream.
+//
+// Each ADC_RD produces one 8-sample frame (4 words, low half first) whose slots
+// hold the channels in the board's SET_ORD order. Words are accumulated per
+// frame slot in integer sums taken relative to a per-channel shift (the running
+// mean), with a fixed 8-wide inner loop the compiler can vectorize. Each batch
+// is then folded into the per-channel count/mean/M2 with the Welford/Chan
+// merge, so the cost per sample is a few integer operations.
+
+#define ADC_STATS_SAMPLE_MIN  INT16_MIN  // Samples at either rail count as saturated
+#define ADC_STATS_SAMPLE_MAX  INT16_MAX
+
+//////////////////////////////////////////////////////////////////
+
+// Statistics for one channel
+typedef struct {
+  uint64_t count;
+  double mean;
+  double m2;                 // Sum of squared deviations from the mean
+  int16_t min;
+  int16_t max;
+  uint64_t saturated;        // Samples at ADC_STATS_SAMPLE_MIN or ADC_STATS_SAMPLE_MAX
+} adc_channel_stats_t;
+
+// Statistics for one board's stream
+typedef struct {
+  adc_channel_stats_t channel[8];  // Indexed by board channel (0-7)
+  uint8_t order[8];                // Channel held by each frame slot
+  uint32_t slot;                   // Frame slot of the next sample (0-7)
+  uint64_t words;                  // Words processed
+} adc_stats_t;
+
+// Reset statistics and set the channel order
+void adc_stats_init(adc_stats_t* stats, const uint8_t order[8]);
+// Change the channel order for the following samples
+void adc_stats_set_order(adc_stats_t* stats, const uint8_t order[8]);
+// Accumulate a run of ADC data words
+void adc_stats_update(adc_stats_t* stats, const uint32_t* words, size_t count);
+// Sample standard deviation of a channel (0 with fewer than two samples)
+double adc_channel_stats_stddev(const adc_channel_stats_t* channel);
+// Print a per-channel table (channels numbered board * 8 + channel)
+void adc_stats_print(const adc_stats_t* stats, uint8_t board, const char* prefix);
+
+#endif // ADC_STATS_H
@@ -0,0 +1,139 @@
+#ifndef ADC_STREAM_ENGINE_H
+#define ADC_STREAM_ENGINE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "command_helper.h"
+#include "adc_commands.h"
+#include "spsc_ring.h"
+#include "capture_file.h"
+#include "poll_sched.h"
+#include "adc_stats.h"
+
+//////////////////// ADC Stream Engine Definitions ////////////////////
+// All ADC data streams share one engine with two threads:
+//   drain thread  - reads every streaming board's data FIFO status once per pass and
+//                   bursts the FIFOs into per-board rings, most-full board first
+//   writer thread - moves each board's ring into that board's file (raw, ASCII or chunked)
+// Boards are attached by stream_adc_data_to_file and retired by the writer once their
+// last word is on disk. With no active streams both threads block on a condition
+// variable, so the engine costs nothing while idle. Between passes the drain thread
+// sleeps until the first board is predicted to reach its batch target (poll_sched.h).
+// The writer also keeps per-channel statistics of every word it writes (adc_stats.h) and
+// publishes them to the engine after each batch, so they can be read while streaming.
+// Both threads also publish their counters under the engine lock once per pass, so
+// status output copies them there and prints with the lock released.
+
+#define ADC_STREAM_RING_FULL_RETRY_NS  100000  // Re-poll interval for a board whose ring is full
+
+//////////////////////////////////////////////////////////////////
+
+// Session counters published for status output (protected by the engine lock)
+typedef struct {
+  uint64_t words_drained;      // Drain thread
+  uint64_t bursts;
+  uint64_t almost_full_services;
+  uint64_t full_services;
+  uint64_t words_written;      // Writer thread
+} adc_stream_session_status_t;
+
+// Drain thread statistics published for status output (protected by the engine lock)
+typedef struct {
+  uint64_t passes;
+  uint64_t idle_sleeps;
+  uint64_t status_polls;
+  uint64_t words_drained;
+  poll_stats_t poll;
+} adc_stream_engine_status_t;
+
+// Per-board stream session (data FIFO -> ring -> file)
+typedef struct {
+  uint8_t board;
+  char file_path[1024];
+  FILE* file;
+  char* file_buffer;           // stdio buffer for the output file
+  spsc_ring_t ring;            // Drained words waiting to be written
+  bool binary_mode;
+  bool fprintf_ascii;          // Use the legacy per-sample fprintf text path
+  char* text_buffer;           // Formatting buffer for the fast ASCII path
+  bool chunked;                // Write a chunked capture container instead of raw words
+  bool compress;               // Chunked capture uses the lossless ADC codec
+  capture_writer_t capture;    // Container state (chunked mode only)
+  atomic_bool drain_done;      // Set by the drain thread after its last commit
+
+  // Drain thread state
+  uint64_t word_count;         // Words to stream
+  volatile bool* should_stop;
+  uint64_t words_drained;
+  uint64_t next_progress_report;
+  uint64_t status_polls;       // Status reads for this board
+  uint64_t sts_not_before_ns;  // Last burst (a sampled FIFO level must be newer, see sts_sampler.h)
+  uint64_t bursts;
+  uint64_t almost_full_services; // Services that found the FIFO almost full
+  uint64_t full_services;        // Services that found the FIFO full (data may have been lost)
+  poll_sched_t poll;           // Fill rate estimate and poll statistics for this board
+  uint32_t fifo_level;         // FIFO words left after the last pass
+  bool ring_full;              // Last pass stopped because the ring was full
+  struct timespec start_time;
+  struct timespec end_time;    // When the drain finished
+
+  // Writer thread state
+  const uint8_t* channel_order; // Board's current SET_ORD order (adc_ctrl)
+  adc_stats_t stats;           // Per-channel statistics of the words written so far
+  int samples_on_line;         // Samples on the current text line (ASCII mode only)
+  struct timespec last_write;
+  uint64_t words_written;
+  uint64_t write_batches;
+  bool write_error;
+
+  adc_stream_session_status_t status; // Published copy of the counters above
+} adc_stream_session_t;
+
+// Shared drain/writer engine (one per command context, created on first use)
+typedef struct adc_stream_engine {
+  command_context_t* ctx;
+  pthread_mutex_t lock;              // Protects sessions[], active_count and shutdown
+  pthread_cond_t wake;               // Signalled when a session is attached or on shutdown
+  pthread_cond_t session_retired;    // Broadcast when the writer retires a session
+  adc_stream_session_t* sessions[8]; // Active session per board (NULL = not streaming)
+  int active_count;
+  bool shutdown;
+  pthread_t drain_thread;
+  pthread_t writer_thread;
+
+  // Drain thread statistics (since the engine was created)
+  uint64_t passes;                   // Status sweeps over the streaming boards
+  uint64_t idle_sleeps;              // Sweeps that found nothing to drain
+  poll_sched_t poll;                 // Sleep/spin statistics between sweeps
+  uint64_t status_polls;
+  uint64_t words_drained;
+
+  adc_stream_engine_status_t status; // Published copy of the drain statistics above
+
+  // Channel statistics per board, published by the writer (protected by lock)
+  adc_stats_t board_stats[8];        // Current stream, or the last one once it retires
+  bool board_stats_valid[8];
+} adc_stream_engine_t;
+
+// Start streaming a board through the engine (creates the engine on first use)
+int adc_stream_engine_start_session(command_context_t* ctx, const adc_data_stream_params_t* params);
+// Signal a board's stream to stop and wait until its file is closed
+void adc_stream_engine_stop_session(command_context_t* ctx, uint8_t board);
+// Stop all streams and the engine threads (call once at exit)
+void adc_stream_engine_shutdown(command_context_t* ctx);
+// Print engine and per-board stream statistics
+void adc_stream_engine_print_status(command_context_t* ctx);
+// Print per-channel statistics of a board's current or last stream (board -1 = all boards)
+int adc_stream_engine_print_channel_stats(command_context_t* ctx, int board);
+
+// Write ADC words as text with fprintf, 8 samples per line (samples_on_line carries across calls; returns bytes written or -1)
+int64_t adc_fprintf_ascii_words(FILE* file, const uint32_t* words, size_t count, int* samples_on_line);
+// Write ADC words as text through the table-driven formatter, one fwrite per chunk (returns bytes written or -1)
+int64_t adc_write_ascii_words(FILE* file, char* text_buffer, const uint32_t* words, size_t count, int* samples_on_line);
+
+#endif // ADC_STREAM_ENGINE_H
@@ -0,0 +1,142 @@
+#ifndef CAPTURE_FILE_H
+#define CAPTURE_FILE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+//////////////////// Chunked Capture File Definitions ////////////////////
+// Self-describing container for binary ADC and trigger captures.
+//
+// Layout (all fields little-endian):
+//   capture_file_header_t                       (fixed CAPTURE_HEADER_SIZE bytes)
+//   { capture_chunk_header_t, payload words }   (repeated)
+//   capture_index_entry_t[chunk_count]          (trailing index, written at close)
+//
+// Chunk payloads are stored raw or, when the header names a codec, encoded
+// per chunk (see adc_codec.h) so each chunk still decodes independently.
+//
+// Every chunk except the last holds exactly chunk_words words, so the chunk
+// holding any word (or the start of any iteration) is found arithmetically and
+// its file offset is one index lookup away. The file header is written with
+// index_offset = 0 when the capture opens and rewritten at close; a capture
+// that was never closed can still be read by scanning the chunk headers.
+
+#define CAPTURE_MAGIC         "SHIMCAP"   // 8 bytes including the terminator
+#define CAPTURE_VERSION       1
+#define CAPTURE_HEADER_SIZE   512
+#define CAPTURE_CHUNK_MAGIC   0x4B4E4843  // "CHNK"
+
+// Stream types
+#define CAPTURE_STREAM_ADC    1  // 32-bit ADC words (two samples each, raw FIFO format)
+#define CAPTURE_STREAM_TRIG   2  // 64-bit trigger samples stored as two words, low word first
+
+#define CAPTURE_BOARD_NONE    0xFF  // Board field for streams not tied to one board
+
+// Default chunk sizes (words)
+#define CAPTURE_ADC_CHUNK_WORDS   (1 << 16)  // 256 KB chunks for ADC data
+#define CAPTURE_TRIG_CHUNK_WORDS  (1 << 11)  // 1024 trigger samples per chunk
+
+//////////////////////////////////////////////////////////////////
+
+// File header (padded to CAPTURE_HEADER_SIZE bytes)
+typedef struct {
+  char magic[8];                 // CAPTURE_MAGIC
+  uint16_t version;              // CAPTURE_VERSION
+  uint16_t header_size;          // CAPTURE_HEADER_SIZE
+  uint8_t stream_type;           // CAPTURE_STREAM_*
+  uint8_t board;                 // ADC board (0-7) or CAPTURE_BOARD_NONE
+  uint8_t channel_order[8];      // ADC channel order (last SET_ORD sent to the board)
+  uint8_t codec;                 // Payload codec (ADC_CODEC_*, 0 = raw words)
+  uint8_t reserved0;
+  uint32_t chunk_words;          // Words in every chunk except the last
+  uint32_t spi_clk_freq_hz;      // SPI clock frequency at capture start
+  uint64_t cmd_file_hash;        // FNV-1a 64 of the command file driving the capture (0 = none)
+  uint64_t words_per_iteration;  // Data words per command file iteration (0 = unknown)
+  uint64_t start_realtime_ns;    // CLOCK_REALTIME at capture start
+  uint64_t start_monotonic_ns;   // CLOCK_MONOTONIC at capture start (chunk timestamps use this clock)
+  uint64_t chunk_count;          // Chunks in the file (valid once index_offset != 0)
+  uint64_t total_words;          // Payload words in the file (valid once index_offset != 0)
+  uint64_t index_offset;         // File offset of the trailing index (0 = capture not closed)
+  char cmd_file_path[256];       // Command file path (informational)
+  uint8_t reserved1[CAPTURE_HEADER_SIZE - 344];
+} capture_file_header_t;
+
+// Chunk header (immediately followed by word_count payload words)
+typedef struct {
+  uint32_t magic;                // CAPTURE_CHUNK_MAGIC
+  uint32_t word_count;           // Payload words in this chunk
+  uint32_t sequence;             // Chunk number (0-based)
+  uint32_t payload_bytes;        // Stored payload size if encoded (0 = word_count raw words)
+  uint64_t first_word;           // Index of the first payload word in the stream
+  uint64_t timestamp_ns;         // CLOCK_MONOTONIC when the chunk was written
+  uint32_t payload_crc;          // CRC-32 (IEEE) of the payload words (after decoding)
+  uint32_t header_crc;           // CRC-32 of the preceding header fields
+} capture_chunk_header_t;
+
+// Trailing index entry (one per chunk)
+typedef struct {
+  uint64_t offset;               // File offset of the chunk header
+  uint64_t timestamp_ns;         // Copy of the chunk timestamp
+} capture_index_entry_t;
+
+// Capture writer state
+typedef struct {
+  FILE* file;
+  capture_file_header_t header;
+  capture_index_entry_t* index;  // Grows as chunks are written
+  uint64_t index_capacity;
+  uint64_t file_offset;          // Current write offset
+  uint32_t* staging;             // Contiguous copy of split chunks (codec only)
+  uint8_t* encoded;              // Encoded chunk buffer (codec only)
+  uint64_t raw_bytes;            // Payload bytes before encoding
+  uint64_t stored_bytes;         // Payload bytes written to the file
+  double encode_seconds;         // Time spent in the codec
+} capture_writer_t;
+
+// Capture reader state
+typedef struct {
+  FILE* file;
+  capture_file_header_t header;
+  capture_index_entry_t* index;  // Loaded from the file, or rebuilt by scanning
+  uint64_t chunk_count;
+  uint64_t total_words;
+  bool index_rebuilt;            // true if the file had no index (capture not closed)
+  uint8_t* encoded;              // Encoded chunk buffer (codec only)
+  uint32_t* chunk_cache;         // Last decoded chunk, for word-level reads (codec only)
+  uint64_t cached_chunk;         // Chunk held in chunk_cache (UINT64_MAX = none)
+} capture_reader_t;
+
+// CRC-32 (IEEE 802.3, reflected) over len bytes, continuing from crc (start with 0)
+uint32_t capture_crc32(uint32_t crc, const void* data, size_t len);
+// FNV-1a 64-bit hash of a file's contents (returns 0 if the file can't be read)
+uint64_t capture_hash_file(const char* path);
+
+// Fill a header with defaults for a stream type and board, stamping the start time
+void capture_header_init(capture_file_header_t* header, uint8_t stream_type, uint8_t board, uint32_t chunk_words);
+
+// Open a stream output file with large-file support (use instead of fopen so captures can pass 2 GB)
+FILE* capture_file_open(const char* path, const char* mode);
+// Start a capture: writes a provisional header to a file from capture_file_open (header->codec selects encoding)
+int capture_writer_open(capture_writer_t* writer, FILE* file, const capture_file_header_t* header);
+// Write one chunk whose payload is split across up to two spans (second may be NULL/0)
+int capture_writer_write_chunk(capture_writer_t* writer, const uint32_t* first, size_t first_count,
+                               const uint32_t* second, size_t second_count);
+// Finish a capture: writes the trailing index and rewrites the header (file is not closed)
+int capture_writer_close(capture_writer_t* writer);
+
+// Open a capture for random access (loads the index, or scans chunk headers if it is missing)
+int capture_reader_open(capture_reader_t* reader, const char* path, bool verbose);
+// Close a capture reader
+void capture_reader_close(capture_reader_t* reader);
+// Locate the chunk and in-chunk offset holding a stream word (O(1))
+int capture_reader_locate(const capture_reader_t* reader, uint64_t word, uint64_t* chunk, uint32_t* offset);
+// Read one whole chunk into dst (at least chunk_words words) and verify its CRCs; returns words read or -1
+int64_t capture_reader_read_chunk(capture_reader_t* reader, uint64_t chunk, uint32_t* dst, capture_chunk_header_t* chunk_header);
+// Read count words starting at stream word first_word (no CRC check for raw captures); returns words read or -1
+int64_t capture_reader_read_words(capture_reader_t* reader, uint64_t first_word, uint32_t* dst, size_t count);
+// First stream word of a command file iteration (fails if words_per_iteration is unknown)
+int capture_reader_iteration_word(const capture_reader_t* reader, uint64_t iteration, uint64_t* word);
+
+#endif // CAPTURE_FILE_H
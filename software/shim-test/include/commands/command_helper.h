@@ -24,9 +24,16 @@ typedef enum {
   FLAG_SIMPLE,
   FLAG_BIN,
   FLAG_NO_RESET,
-  FLAG_NO_CAL
+  FLAG_NO_CAL,
+  FLAG_FPRINTF,
+  FLAG_CHUNKED,
+  FLAG_COMPRESS,
+  FLAG_DELTA
 } command_flag_t;
 
+struct adc_stream_engine;
+struct dac_stream_engine;
+
 // Global context passed to all command handlers
 typedef struct command_context {
   // Hardware control interfaces
@@ -42,17 +49,22 @@ typedef struct command_context {
   bool* should_exit;
   
   // ADC streaming management
-  pthread_t adc_data_stream_threads[8];      // Thread handles for ADC data streaming (reading to file)
-  bool adc_data_stream_running[8];           // Status of each ADC data stream thread
-  volatile bool adc_data_stream_stop[8];     // Stop signals for each ADC data stream thread
+  struct adc_stream_engine* adc_stream_engine; // Shared drain/writer engine for ADC data streams (created on first use)
+  bool adc_data_stream_running[8];           // Status of each ADC data stream
+  volatile bool adc_data_stream_stop[8];     // Stop signals for each ADC data stream
   pthread_t adc_cmd_stream_threads[8];       // Thread handles for ADC command streaming (from file)
   bool adc_cmd_stream_running[8];            // Status of each ADC command stream thread
   volatile bool adc_cmd_stream_stop[8];      // Stop signals for each ADC command stream thread
   
+  // ADC command file metadata (recorded by stream_adc_commands_from_file, stored in chunked captures)
+  uint64_t adc_cmd_file_hash[8];             // FNV-1a hash of the last ADC command file streamed to each board
+  uint64_t adc_cmd_words_per_iteration[8];   // ADC data words produced per iteration of that file
+  char adc_cmd_file_path[8][1024];           // Path of that file
+  
   // DAC streaming management
-  pthread_t dac_cmd_stream_threads[8];      // Thread handles for DAC command streaming
-  bool dac_cmd_stream_running[8];           // Status of each DAC command stream thread
-  volatile bool dac_cmd_stream_stop[8];     // Stop signals for each DAC command stream thread
+  struct dac_stream_engine* dac_stream_engine; // Shared feeder for DAC command streams (created on first use)
+  bool dac_cmd_stream_running[8];           // Status of each DAC command stream
+  volatile bool dac_cmd_stream_stop[8];     // Stop signals for each DAC command stream
   pthread_t dac_debug_stream_threads[8];    // Thread handles for DAC debug data streaming (reading to file)
   bool dac_debug_stream_running[8];         // Status of each DAC debug data stream thread
   volatile bool dac_debug_stream_stop[8];   // Stop signals for each DAC debug data stream thread
@@ -19,14 +19,15 @@ typedef struct {
   bool cont;                // Continue flag
 } waveform_command_t;
 
-// Structure to pass data to the DAC streaming thread
+struct dac_waveform_stream; // Waveform word source (dac_waveform.h)
+
+// Parameters of a DAC command stream (dac_stream_engine.h)
 typedef struct {
   command_context_t* ctx;
   uint8_t board;
   char file_path[1024];
   volatile bool* should_stop;
-  waveform_command_t* commands;
-  int command_count;
+  struct dac_waveform_stream* waveform; // Open waveform (owned by the stream once started)
   int iterations;       // Number of times to iterate through the waveform
 } dac_command_stream_params_t;
 
@@ -60,6 +61,11 @@ int cmd_dac_zero(const char** args, int arg_count, const command_flag_t* flags,
 // DAC command streaming operations (streaming commands from files)
 int cmd_stream_dac_commands_from_file(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
 int cmd_stop_dac_cmd_stream(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+int cmd_dac_stream_status(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+// Compile a waveform text file to packed DAC command FIFO words
+int cmd_compile_waveform(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+// Check DAC waveform and ADC command file timing and FIFO occupancy before a run
+int cmd_validate_waveform(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
 
 // DAC debug streaming operations (streaming debug data to files)
 int cmd_stream_dac_debug(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
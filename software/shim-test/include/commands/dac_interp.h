@@ -0,0 +1,55 @@
+#ifndef DAC_INTERP_H
+#define DAC_INTERP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//////////////////// DAC Interpolation Definitions ////////////////////
+// Generates the 8-channel DAC frames between two waveform points, so waveforms can be
+// stored at a low rate and the board driven at a high rate. A segment of N steps goes
+// from point "from" (not repeated) to point "to" (the last frame, exactly):
+//   - linear:        straight line
+//   - raised cosine: (1 - cos(pi t)) / 2 easing, zero slope at both ends
+//   - cubic:         Catmull-Rom spline through the points before and after the
+//                    segment (continuous slope from one segment to the next)
+// Each frame is computed as two 4-channel vectors with compiler vector extensions (NEON
+// on the Zynq, SSE on x86), rounded to nearest and clamped to the DAC range of
+// amps_to_dac (cubic segments can overshoot their points).
+//
+// Waveform text files use it through the interpolation lines (dac_waveform.c):
+//   IL <delay> <steps> <ch0> ... <ch7>   linear
+//   IR <delay> <steps> <ch0> ... <ch7>   raised cosine
+//   IC <delay> <steps> <ch0> ... <ch7>   cubic
+// Each line expands to <steps> delayed DAC writes, <delay> cycles apart, from the
+// values of the previous D/T/I line (zero at the start of the file) to the line's values.
+
+#define DAC_INTERP_MAX_CODE     32767    // amps_to_dac(5.0); -32767 at -5.0 A
+#define DAC_INTERP_MAX_STEPS    1000000  // Longest segment
+#define DAC_INTERP_BLOCK_FRAMES 64       // Frames generated per call by the waveform parser
+
+//////////////////////////////////////////////////////////////////
+
+// Interpolation curves
+typedef enum {
+  DAC_INTERP_LINEAR,
+  DAC_INTERP_COSINE,
+  DAC_INTERP_CUBIC
+} dac_interp_mode_t;
+
+// One segment being generated
+typedef struct {
+  dac_interp_mode_t mode;
+  int16_t points[4][8];  // Before, from, to, after (before/after used by cubic only)
+  uint32_t steps;
+  uint32_t next;         // Next step to generate (1 to steps)
+} dac_interp_t;
+
+// Start a segment of steps frames from "from" to "to" (before/after may be NULL: the segment's own end is used)
+void dac_interp_init(dac_interp_t* interp, dac_interp_mode_t mode, const int16_t before[8], const int16_t from[8],
+                     const int16_t to[8], const int16_t after[8], uint32_t steps);
+// Generate up to max_frames of the remaining frames (returns the number generated)
+uint32_t dac_interp_generate(dac_interp_t* interp, int16_t (*frames)[8], uint32_t max_frames);
+// True once every frame of the segment has been generated
+bool dac_interp_done(const dac_interp_t* interp);
+
+#endif // DAC_INTERP_H
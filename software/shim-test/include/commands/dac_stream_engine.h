@@ -0,0 +1,137 @@
+#ifndef DAC_STREAM_ENGINE_H
+#define DAC_STREAM_ENGINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <pthread.h>
+#include "command_helper.h"
+#include "dac_commands.h"
+#include "dac_waveform.h"
+#include "poll_sched.h"
+
+//////////////////// DAC Stream Engine Definitions ////////////////////
+// All DAC command streams share one feeder thread. Each board keeps a timeline of the
+// commands it has queued: the FIFO words and SPI cycles of every command written and
+// not yet taken by the DAC core. Each pass reads every streaming board's command FIFO
+// status once, drops the commands the core has taken, and sums the cycles of the rest:
+// the board's slack, i.e. how long until its FIFO runs dry. Boards are then refilled
+// earliest deadline first (least slack), each as far as its free space allows.
+//
+// Trigger waits count as no time (the trigger may already be there), and the command
+// the core is executing is no longer in the FIFO, so slack is a lower bound.
+//
+// Between passes the thread sleeps until a board is predicted to have a batch of free
+// space (poll_sched.h), but never longer than DAC_STREAM_SLACK_SLEEP_PCT of the least
+// slack. With no active streams it blocks on a condition variable. The feeder publishes
+// its counters under the engine lock once per pass, so status output copies them there
+// and prints with the lock released.
+
+#define DAC_STREAM_QUEUE_COMMANDS   DAC_CMD_FIFO_WORDCOUNT // Queued commands tracked per board (at least one word each)
+#define DAC_STREAM_SLACK_SLEEP_PCT  50      // Longest sleep as a percentage of the least slack
+#define DAC_STREAM_LOW_SLACK_US     1000    // Services with less slack than this are counted as at risk
+
+//////////////////////////////////////////////////////////////////
+
+// One command in a board's FIFO
+typedef struct {
+  uint32_t words;
+  uint32_t cycles;             // dac_waveform_cmd_cycles()
+} dac_stream_queued_t;
+
+// Slack seen at each service of one board (microseconds)
+typedef struct {
+  uint64_t services;           // Status reads while streaming
+  double current_us;           // At the last service, before refilling
+  double min_us;               // Least at any service after the first
+  double sum_us;               // For the mean
+  uint64_t low_services;       // Services with less than DAC_STREAM_LOW_SLACK_US
+  uint64_t empty_services;     // Services that found the FIFO empty mid-stream (underflow risk)
+} dac_stream_slack_t;
+
+// Session counters published for status output (protected by the engine lock)
+typedef struct {
+  int current_iteration;
+  uint64_t commands_sent;
+  uint64_t words_sent;
+  uint64_t bursts;
+} dac_stream_session_status_t;
+
+// Feeder statistics published for status output (protected by the engine lock)
+typedef struct {
+  uint64_t passes;
+  uint64_t idle_passes;
+  uint64_t reordered;
+  uint64_t status_polls;
+  uint64_t words_sent;
+  poll_stats_t poll;
+} dac_stream_engine_status_t;
+
+// Per-board stream session (waveform -> command FIFO)
+typedef struct {
+  uint8_t board;
+  char file_path[1024];
+  dac_waveform_stream_t* waveform; // Owned by the session
+  int iterations;
+  int current_iteration;
+  volatile bool* should_stop;
+  bool gaps_checked;           // Trigger gaps checked (text waveforms: after the first pass)
+  bool failed;
+  bool done;                   // Last word written, stopped or failed; retired at the end of the pass
+  uint32_t min_delay;          // Minimum DAC delay in SPI cycles
+  double spi_hz;
+
+  // Queued command timeline (ring of commands still in the FIFO)
+  dac_stream_queued_t* queue;
+  uint32_t queue_head;
+  uint32_t queue_count;
+  uint64_t queued_words;
+  uint64_t queued_cycles;
+
+  uint32_t words_free;         // Free FIFO words at the last service, less the safety margin
+  uint64_t sts_not_before_ns;  // Last refill (a sampled FIFO level must be newer, see sts_sampler.h)
+  uint32_t words_needed;       // Words in the next command
+  dac_stream_slack_t slack;
+
+  uint64_t commands_sent;
+  uint64_t words_sent;
+  uint64_t bursts;
+  poll_sched_t poll;           // Drain rate estimate and poll statistics for this board
+} dac_stream_session_t;
+
+// Shared feeder (one per command context, created on first use)
+typedef struct dac_stream_engine {
+  command_context_t* ctx;
+  pthread_mutex_t lock;              // Protects sessions[], active_count and shutdown
+  pthread_cond_t wake;               // Signalled when a session is attached or on shutdown
+  pthread_cond_t session_retired;    // Broadcast when the feeder retires a session
+  dac_stream_session_t* sessions[8]; // Active session per board (NULL = not streaming)
+  int active_count;
+  bool shutdown;
+  pthread_t feeder_thread;
+
+  // Feeder statistics (since the engine was created)
+  uint64_t passes;                   // Status sweeps over the streaming boards
+  uint64_t idle_passes;              // Sweeps that wrote nothing
+  uint64_t reordered;                // Sweeps that refilled boards out of board order (earliest deadline first)
+  poll_sched_t poll;                 // Sleep/spin statistics between sweeps
+  uint64_t status_polls;
+  uint64_t words_sent;
+  dac_stream_engine_status_t status; // Published copy of the feeder statistics above
+
+  // Slack of each board's current stream, or the last one once it retires (protected by lock)
+  dac_stream_slack_t board_slack[8];
+  bool board_slack_valid[8];
+  dac_stream_session_status_t board_status[8]; // Counters of each board's current stream
+} dac_stream_engine_t;
+
+// Start streaming an open waveform to a board (takes ownership of params->waveform; creates the engine on first use)
+int dac_stream_engine_start_session(command_context_t* ctx, const dac_command_stream_params_t* params);
+// Signal a board's stream to stop and wait until it is retired
+void dac_stream_engine_stop_session(command_context_t* ctx, uint8_t board);
+// Stop all streams and the feeder thread (call once at exit)
+void dac_stream_engine_shutdown(command_context_t* ctx);
+// Print feeder and per-board slack statistics
+void dac_stream_engine_print_status(command_context_t* ctx);
+
+#endif // DAC_STREAM_ENGINE_H
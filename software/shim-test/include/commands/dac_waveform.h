@@ -0,0 +1,200 @@
+#ifndef DAC_WAVEFORM_H
+#define DAC_WAVEFORM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "dac_commands.h"
+#include "dac_ctrl.h"
+#include "dac_interp.h"
+
+//////////////////// Compiled DAC Waveform Definitions ////////////////////
+// A waveform compiled to the exact words the DAC command FIFO takes: one word
+// per NO_OP, a command word plus 4 channel data words per DAC_WR. Every command
+// is encoded with CONT set; the streamer clears it on the final command of the
+// final iteration. Streaming is then a bulk copy of whole commands into the FIFO,
+// sized by its free space, with no per-command encoding or validation.
+//
+// Delta encoding (opt-in, --delta): each DAC_WR is compared with the values the
+// previous DAC_WR left on the board, and sent in fewer words where the timing is
+// unchanged:
+//   - no channel changes: a NO_OP with the same wait (1 word). Trigger waits of
+//     0 are kept, as a DAC_WR then lasts as long as its write.
+//   - one channel changes after a delay: a NO_OP delay shortened by the
+//     single-channel write time, then a DAC_WR_CH (2 words). The DAC_WR writes
+//     at the end of its delay (pre-delay), so the update lands at the same time.
+//     The NO_OP must still meet the minimum delay.
+// Other changes, any change on a trigger wait (DAC_WR_CH cannot wait for one),
+// and the first DAC_WR of each iteration (the board's values are unknown there)
+// are sent in full.
+// DAC_WR_CH has no CONT bit, so an underflow right after one halts the DAC
+// quietly instead of raising STS_DAC_CMD_BUF_UNDERFLOW; a starved stream then
+// looks like the end of the waveform, which is why full writes are the default.
+// The single-channel timing also relies on do_dac_pre_delay = 1 (the HDL default);
+// delta encoding is refused when the register reads 0.
+//
+// File layout (all fields little-endian):
+//   dac_waveform_header_t   (fixed DAC_WAVEFORM_HEADER_SIZE bytes)
+//   uint32_t words[word_count]
+//
+// Both text and compiled files are read through mmap. A compiled file is
+// streamed straight from the mapping. A text file is parsed one line at a time
+// into a fixed look-ahead window of encoded words, so memory use does not depend
+// on the waveform length and streaming starts after the first window. The window
+// is topped up one small slice per FIFO burst, keeping each pause in FIFO
+// service short. A text file that fits in the window is kept there and replayed
+// on later iterations without parsing again. Text parsing must outpace the DAC;
+// compile dense waveforms (short delays, few triggers) ahead of time instead.
+//
+// Interpolation lines (IL, IR, IC; see dac_interp.h) are expanded by the parser into
+// delayed DAC_WRs, a block of frames at a time, so both streaming and compiling see
+// ordinary commands.
+
+#define DAC_WAVEFORM_MAGIC         "SHIMDAC"  // 8 bytes including the terminator
+#define DAC_WAVEFORM_VERSION       1
+#define DAC_WAVEFORM_HEADER_SIZE   512
+#define DAC_WAVEFORM_WINDOW_WORDS  (1 << 16)  // Text look-ahead window (256 KB, 8x the DAC command FIFO)
+#define DAC_WAVEFORM_REFILL_WORDS  2048       // Words parsed per top-up between FIFO bursts
+#define DAC_WAVEFORM_MAX_LINE      512        // Longest waveform text line
+
+//////////////////////////////////////////////////////////////////
+
+// File header (padded to DAC_WAVEFORM_HEADER_SIZE bytes)
+typedef struct {
+  char magic[8];                 // DAC_WAVEFORM_MAGIC
+  uint16_t version;              // DAC_WAVEFORM_VERSION
+  uint16_t header_size;          // DAC_WAVEFORM_HEADER_SIZE
+  uint32_t command_count;
+  uint32_t word_count;           // FIFO words per iteration
+  uint32_t last_cmd_offset;      // Word offset of the final command
+  uint32_t trigger_count;        // Commands that wait for a trigger
+  uint32_t max_trigger_gap;      // Most words queued from one trigger wait to the next (or end)
+  uint32_t words_crc;            // CRC-32 of the words
+  uint32_t delta_min_delay;      // Minimum DAC delay the delta encoding assumed (0 = not delta encoded)
+  uint64_t source_hash;          // FNV-1a 64 of the source waveform file
+  char source_path[256];         // Source waveform file path (informational)
+  uint32_t plain_word_count;     // FIFO words per iteration without delta encoding (0 in older files)
+  uint32_t delta_count;          // DAC_WRs sent as a hold or single-channel write
+  uint8_t reserved1[DAC_WAVEFORM_HEADER_SIZE - 312];
+} dac_waveform_header_t;
+
+// Incremental parser over a mapped waveform text file
+typedef struct {
+  const char* text;
+  size_t size;
+  size_t offset;                 // Next byte to parse
+  int line_num;                  // Lines consumed so far
+
+  // Interpolation lines
+  int16_t points[2][8];          // Values of the last two D/T/I lines, oldest first (zero at the start)
+  dac_interp_t interp;           // Segment being expanded
+  uint32_t interp_delay;         // Delay of each step of the segment
+  int16_t frames[DAC_INTERP_BLOCK_FRAMES][8];
+  uint32_t frame_count;          // Frames generated in frames[]
+  uint32_t frame_pos;            // Next frame to return
+} dac_waveform_parser_t;
+
+// Waveform statistics gathered while encoding (same meaning as the header fields)
+typedef struct {
+  uint64_t command_count;
+  uint64_t word_count;
+  uint64_t trigger_count;
+  uint64_t max_trigger_gap;
+  uint64_t words_since_trigger;
+  uint64_t plain_word_count;     // Words with every DAC_WR sent in full
+  uint64_t delta_count;          // DAC_WRs sent as a hold or single-channel write
+} dac_waveform_summary_t;
+
+// Delta encoder state for one board
+typedef struct {
+  uint32_t min_delay;            // Minimum DAC delay in SPI cycles (0 = send every DAC_WR in full)
+  bool known;                    // ch_vals holds the values the previous DAC_WR left on the board
+  int16_t ch_vals[8];
+} dac_waveform_encoder_t;
+
+// Streaming source of encoded FIFO words (one per DAC command stream)
+typedef struct dac_waveform_stream {
+  char path[1024];
+  void* map;                     // File mapping
+  size_t map_size;
+  bool compiled;                 // Words come straight from a compiled file's mapping
+  dac_waveform_parser_t parser;  // Text files only
+  dac_waveform_encoder_t encoder; // Text files only
+
+  const uint32_t* words;         // Mapped words (compiled) or window (text)
+  uint32_t* window;              // Text files only: DAC_WAVEFORM_WINDOW_WORDS encoded words
+  size_t count;                  // Words available in words[]
+  size_t pos;                    // Next word to write
+  bool at_end;                   // words[] holds the rest of the iteration
+  size_t last_cmd_pos;           // Final command in words[] (valid once at_end)
+  bool resident;                 // The whole waveform is in words[] (rewind without parsing)
+  uint32_t final_cmd[5];         // Final command with CONT cleared
+  bool error;                    // Parse error (already printed)
+
+  dac_waveform_summary_t summary; // Complete once summary_done
+  bool summary_done;
+} dac_waveform_stream_t;
+
+// FIFO words taken by the command starting with this word
+static inline uint32_t dac_waveform_cmd_words(uint32_t cmd_word) {
+  return ((cmd_word >> DAC_CMD_CMD_LSB) == DAC_CMD_DAC_WR) ? 5 : 1;
+}
+
+// SPI cycles the command starting with this word keeps the DAC busy, not counting trigger waits
+// (a triggered DAC_WR writes for one minimum delay, then waits; a delayed command lasts its delay)
+static inline uint32_t dac_waveform_cmd_cycles(uint32_t cmd_word, uint32_t min_delay) {
+  bool trig = (cmd_word >> DAC_CMD_TRIG_BIT) & 0x1;
+  switch (cmd_word >> DAC_CMD_CMD_LSB) {
+    case DAC_CMD_NO_OP:     return trig ? 0 : (cmd_word & 0x1FFFFFF);
+    case DAC_CMD_DAC_WR:    return trig ? min_delay : (cmd_word & 0x1FFFFFF);
+    case DAC_CMD_DAC_WR_CH: return DAC_CH_WRITE_CYCLES(min_delay);
+    default:                return 0;
+  }
+}
+
+// True if this command starts a waveform command (a DAC_WR_CH completes the NO_OP before it)
+static inline bool dac_waveform_cmd_starts_line(uint32_t cmd_word) {
+  return (cmd_word >> DAC_CMD_CMD_LSB) != DAC_CMD_DAC_WR_CH;
+}
+
+// Start parsing mapped text
+void dac_waveform_parser_init(dac_waveform_parser_t* parser, const char* text, size_t size);
+// Parse the next command: 1 = command parsed, 0 = end of text, -1 = invalid line (error printed)
+int dac_waveform_parse_next(dac_waveform_parser_t* parser, waveform_command_t* cmd);
+// Skip blank and comment lines; true if no command follows
+bool dac_waveform_parser_at_end(dac_waveform_parser_t* parser);
+// Reset a delta encoder (min_delay 0 disables delta encoding)
+void dac_waveform_encoder_init(dac_waveform_encoder_t* encoder, uint32_t min_delay);
+// Encode a command with CONT set into words (returns the word count: 1, 2 or 5)
+uint32_t dac_waveform_encode(dac_waveform_encoder_t* encoder, const waveform_command_t* cmd, uint32_t words[5]);
+// Add an encoded command to a summary
+void dac_waveform_summary_add(dac_waveform_summary_t* summary, const waveform_command_t* cmd, uint32_t cmd_words);
+// Print the FIFO words delta encoding saved
+void dac_waveform_print_savings(const dac_waveform_summary_t* summary, const char* prefix);
+// Warn if the FIFO words between triggers (or the whole waveform, without triggers) exceed the DAC command FIFO
+void dac_waveform_check_trigger_gaps(const dac_waveform_summary_t* summary, bool verbose);
+
+// Compile a waveform text file to a compiled file with bounded memory (header returned if not NULL).
+// min_delay is the hardware minimum DAC delay for delta encoding (0 = no delta encoding).
+int dac_waveform_compile_file(const char* text_path, const char* out_path, uint32_t min_delay, dac_waveform_header_t* header);
+// Check whether a file starts with the compiled waveform magic
+bool dac_waveform_is_compiled(const char* path);
+
+// Open a text or compiled waveform for streaming (parses the first window of a text file).
+// min_delay is the hardware minimum DAC delay; text is delta encoded if delta is set.
+int dac_waveform_stream_open(dac_waveform_stream_t* stream, const char* path, uint32_t min_delay, bool delta);
+// Words in the next command (0 once the iteration is done or on error)
+uint32_t dac_waveform_stream_next_words(dac_waveform_stream_t* stream);
+// Next run of whole commands that fits in max_words (0 if none fits or on error)
+uint32_t dac_waveform_stream_peek(dac_waveform_stream_t* stream, uint32_t max_words, bool last_iteration,
+                                  const uint32_t** words, uint32_t* commands);
+// Mark peeked words as written (tops up the text window)
+void dac_waveform_stream_consume(dac_waveform_stream_t* stream, uint32_t words);
+// True once every word of the current iteration has been consumed
+bool dac_waveform_stream_iteration_done(const dac_waveform_stream_t* stream);
+// Start the next iteration
+int dac_waveform_stream_rewind(dac_waveform_stream_t* stream);
+// Unmap the file and free the window
+void dac_waveform_stream_close(dac_waveform_stream_t* stream);
+
+#endif // DAC_WAVEFORM_H
@@ -0,0 +1,81 @@
+#ifndef FIFO_RECORDER_H
+#define FIFO_RECORDER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sys_sts.h"
+
+//////////////////// FIFO Occupancy Recorder Definitions ////////////////////
+// Fixed-rate time series of FIFO occupancy during a run (fifo_record command).
+//
+// One thread wakes every 1/rate_hz on an absolute schedule and reads, in one pass
+// (sys_sts_snapshot_words), the hardware status, trigger counter, trigger data FIFO and
+// the DAC command and ADC data FIFOs of the boards connected when recording started.
+// Each sample is stored in a preallocated in-memory ring that keeps the last
+// rate_hz * seconds samples; nothing is written to disk until the recording stops, so
+// the recorder adds no file I/O to the run. At stop (or exit) the ring is written out
+// oldest first.
+//
+// Layout (all fields little-endian):
+//   fifo_record_header_t   (fixed FIFO_RECORD_HEADER_SIZE bytes)
+//   fifo_record_sample_t   (sample_count samples, oldest first)
+//
+// Levels are FIFO word counts (FIFO_STS_WORD_COUNT), saturated at FIFO_RECORD_LEVEL_MAX;
+// boards not connected read FIFO_RECORD_ABSENT. The FIFO depths are in the header, so
+// peak occupancy can be compared against the depths set in block_design.tcl. Use
+// docs/fifo_record_to_csv.py to convert a recording.
+
+#define FIFO_RECORD_MAGIC         "SHIMFOR"  // 8 bytes including the terminator
+#define FIFO_RECORD_VERSION       1
+#define FIFO_RECORD_HEADER_SIZE   128
+#define FIFO_RECORD_LEVEL_MAX     0xFFFE     // Highest storable level
+#define FIFO_RECORD_ABSENT        0xFFFF     // Level of a board that is not connected
+
+#define FIFO_RECORD_DEFAULT_RATE_HZ   10000
+#define FIFO_RECORD_MAX_RATE_HZ       50000
+#define FIFO_RECORD_DEFAULT_SECONDS   30
+#define FIFO_RECORD_MAX_BYTES         (256u << 20)  // Largest ring (256 MB)
+
+//////////////////////////////////////////////////////////////////
+
+// File header (padded to FIFO_RECORD_HEADER_SIZE bytes)
+typedef struct {
+  char magic[8];                 // FIFO_RECORD_MAGIC
+  uint16_t version;              // FIFO_RECORD_VERSION
+  uint16_t header_size;          // FIFO_RECORD_HEADER_SIZE
+  uint16_t sample_size;          // sizeof(fifo_record_sample_t)
+  uint8_t board_mask;            // Boards recorded (bit n = board n)
+  uint8_t reserved0;
+  uint32_t rate_hz;              // Requested sample rate
+  uint32_t dac_cmd_fifo_words;   // FIFO depths in words
+  uint32_t adc_data_fifo_words;
+  uint32_t trig_data_fifo_words;
+  uint64_t start_realtime_ns;    // CLOCK_REALTIME at the first sample
+  uint64_t start_monotonic_ns;   // CLOCK_MONOTONIC at the first sample (time_us 0)
+  uint64_t sample_count;         // Samples in the file
+  uint64_t samples_taken;        // Samples taken (more than sample_count if the ring wrapped)
+  uint64_t missed_periods;       // Periods skipped because the thread woke too late
+  uint8_t reserved1[FIFO_RECORD_HEADER_SIZE - 72];
+} fifo_record_header_t;
+
+// One sample (48 bytes)
+typedef struct {
+  uint32_t time_us;              // Since start_monotonic_ns (wraps after about 71 minutes)
+  uint32_t trig_counter;         // Trigger counter (sys_sts_get_trig_counter)
+  uint32_t hw_status;            // Raw hardware status word (HW_STS_STATE, HW_STS_CODE, HW_STS_BOARD)
+  uint16_t dac_cmd[8];           // Words in each DAC command FIFO
+  uint16_t adc_data[8];          // Words in each ADC data FIFO
+  uint16_t trig_data;            // Words in the trigger data FIFO
+  uint16_t missed;               // Periods skipped just before this sample
+} fifo_record_sample_t;
+
+// Start recording to memory (file_path is written when the recording stops; -1 on failure)
+int fifo_recorder_start(struct sys_sts_t* sys_sts, const char* file_path, uint32_t rate_hz, uint32_t seconds);
+// Stop recording and write the file (-1 if it could not be written; 0 if nothing was recording)
+int fifo_recorder_stop(void);
+// True while recording
+bool fifo_recorder_running(void);
+// Print the recording state
+void fifo_recorder_print_status(void);
+
+#endif // FIFO_RECORDER_H
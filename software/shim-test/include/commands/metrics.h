@@ -0,0 +1,95 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "poll_sched.h"
+
+//////////////////// Metrics Definitions ////////////////////
+// Run metrics of every FIFO stream and file writer, exported as Prometheus text.
+//
+// Each FIFO (stream and board) and each output file has a fixed series that only the
+// thread servicing it writes, so counters are updated with plain relaxed loads and
+// stores (no locked read-modify-write) and nothing is shared between threads on the
+// hot path. Readers load and format the series on demand; a value read while a stream
+// runs may be one update behind. FIFO series are fed by poll_sched (poll_sched_track):
+// every level a loop observes and every word it moves. The DAC feeder adds its slack
+// and the ADC and trigger writers their write times.
+//
+// The metrics command prints the text; "metrics export <file>" rewrites a file with it
+// every period (written to <file>.tmp and renamed, so a scraper never reads half a file).
+// Series and histograms are cumulative since start or the last "metrics reset". A reset
+// stores zeros over series their writers may be updating, so it is only allowed while no
+// stream runs (the metrics command refuses otherwise).
+
+#define METRICS_OCCUPANCY_BUCKETS   10     // FIFO occupancy histogram buckets (tenths of the depth)
+#define METRICS_LATENCY_BUCKETS     10     // Write latency histogram buckets (metrics_latency_bucket_us)
+#define METRICS_EXPORT_DEFAULT_MS   1000   // Export period set by "metrics export <file>"
+#define METRICS_EXPORT_MIN_MS       100
+#define METRICS_EXPORT_MAX_MS       3600000
+
+//////////////////////////////////////////////////////////////////
+
+// Output files with write metrics
+typedef enum {
+  METRICS_WRITER_ADC,        // ADC data files (one per board)
+  METRICS_WRITER_TRIG,       // Trigger data file (board 0)
+  METRICS_WRITER_COUNT
+} metrics_writer_kind_t;
+
+// One FIFO's series (written only by the thread servicing it)
+typedef struct metrics_fifo {
+  _Atomic uint64_t words;            // Words moved (read from data FIFOs, written to command FIFOs)
+  _Atomic uint64_t polls;            // Levels observed
+  _Atomic uint64_t stalls;           // Polls at the FIFO limit (full data FIFO, empty command FIFO)
+  _Atomic uint64_t occupancy_hist[METRICS_OCCUPANCY_BUCKETS]; // Polls by words in the FIFO
+  _Atomic uint64_t occupancy_sum;    // Sum of observed occupancies in words
+  _Atomic uint32_t capacity;         // FIFO depth in words (set by poll_sched_track)
+  _Atomic uint64_t slack_samples;    // Slack measurements (DAC command FIFOs)
+  _Atomic uint64_t min_slack_ns;     // Least time before the FIFO would run dry
+} metrics_fifo_t;
+
+// One output file's series (written only by its writer thread)
+typedef struct {
+  _Atomic uint64_t bytes;            // Bytes written
+  _Atomic uint64_t writes;           // Batches written
+  _Atomic uint64_t latency_hist[METRICS_LATENCY_BUCKETS]; // Batches by time to write and flush
+  _Atomic uint64_t latency_sum_ns;
+  _Atomic uint64_t max_latency_ns;
+} metrics_writer_t;
+
+// Upper bound of each write latency bucket in microseconds (the last is open-ended)
+extern const uint32_t metrics_latency_bucket_us[METRICS_LATENCY_BUCKETS];
+
+// Series of a FIFO (board 0-7)
+metrics_fifo_t* metrics_fifo(poll_stream_t stream, uint8_t board);
+// Series of an output file (board 0-7)
+metrics_writer_t* metrics_writer(metrics_writer_kind_t kind, uint8_t board);
+
+// Add to a single-writer counter
+static inline void metrics_add(_Atomic uint64_t* counter, uint64_t n) {
+  atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + n, memory_order_relaxed);
+}
+
+// Record an observed FIFO occupancy in words (stall = the FIFO was at its limit)
+void metrics_fifo_observe(metrics_fifo_t* fifo, uint32_t occupancy, bool stall);
+// Record a slack measurement in nanoseconds (keeps the least)
+void metrics_fifo_slack(metrics_fifo_t* fifo, uint64_t slack_ns);
+// Record one written batch and how long it took to write and flush
+void metrics_writer_record(metrics_writer_t* writer, uint64_t bytes, uint64_t latency_ns);
+
+// Clear every series (FIFO depths are kept, as they are set when a stream starts; streams must be idle)
+void metrics_reset(void);
+// Write every series that has seen activity in Prometheus text format
+void metrics_write_text(FILE* out);
+
+// Rewrite a file with the metrics every period_ms (replaces a running export; -1 on failure)
+int metrics_export_start(const char* file_path, uint32_t period_ms);
+// Stop the periodic export (the file is written a last time)
+void metrics_export_stop(void);
+// True while a periodic export runs (its file path is copied to file_path if not NULL)
+bool metrics_export_running(char* file_path, size_t size);
+
+#endif // METRICS_H
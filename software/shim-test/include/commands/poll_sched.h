@@ -0,0 +1,114 @@
+#ifndef POLL_SCHED_H
+#define POLL_SCHED_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sys_sts.h"
+
+//////////////////// Poll Scheduling Definitions ////////////////////
+// Adaptive sleep policy shared by the FIFO service loops.
+//
+// A loop reports each FIFO level it reads ("available" = words ready to read for
+// data FIFOs, free words for command FIFOs) and how many words it serviced. The
+// scheduler keeps a smoothed estimate of how fast work arrives and sleeps with
+// clock_nanosleep until the policy's batch target is predicted to be ready,
+// waking one spin window early and spin-polling the rest of the way. A sleep is
+// never longer than the policy maximum, nor longer than a headroom fraction of
+// the time the FIFO would take to reach its limit (full data FIFO, empty command
+// FIFO) at the fastest rate the SPI clock allows.
+
+#define POLL_SCHED_RATE_WEIGHT    0.25   // EWMA weight of each new rate sample
+#define POLL_SCHED_MIN_SAMPLE_NS  50000  // Shortest interval used as a rate sample (50 us)
+#define POLL_WAKE_BUCKETS         10     // Wake latency histogram buckets (poll_wake_bucket_us)
+
+struct metrics_fifo;
+
+// Streams with their own policy
+typedef enum {
+  POLL_STREAM_ADC_DATA,
+  POLL_STREAM_ADC_CMD,
+  POLL_STREAM_DAC_CMD,
+  POLL_STREAM_DAC_DEBUG,
+  POLL_STREAM_TRIG_DATA,
+  POLL_STREAM_TRIG_MONITOR,
+  POLL_STREAM_COUNT
+} poll_stream_t;
+
+// Per-stream policy (copied when a stream starts)
+typedef struct {
+  const char* name;          // Stream name used by the poll_policy command
+  uint32_t max_sleep_us;     // Longest single sleep (bounds stop and rate-change latency)
+  uint32_t spin_us;          // Spin-poll instead of sleeping when the deadline is this close
+  uint32_t threshold_pct;    // Batch target as a percentage of the FIFO depth (0 = just what is needed)
+  uint32_t headroom_pct;     // Sleep at most this percentage of the time to the FIFO limit at max rate
+} poll_policy_t;
+
+// Poll statistics
+typedef struct {
+  uint64_t polls;            // Levels observed
+  uint64_t wasted_polls;     // Polls that found too little to service
+  uint64_t limit_hits;       // Polls that found the FIFO at its limit (overflow/underrun risk)
+  uint64_t sleeps;           // clock_nanosleep calls
+  uint64_t spins;            // Waits that spin-polled instead of sleeping
+  uint64_t sleep_ns;         // Total time asleep
+  uint64_t oversleep_ns;     // Total time woken past the requested deadline
+  uint64_t max_oversleep_ns; // Longest time woken past a deadline
+  uint64_t wake_hist[POLL_WAKE_BUCKETS]; // Sleeps by time woken past the deadline
+} poll_stats_t;
+
+// Scheduler state for one FIFO
+typedef struct {
+  poll_stream_t stream;
+  poll_policy_t policy;
+  uint32_t capacity;         // FIFO limit in words (0 = no limit)
+  double max_rate;           // Fastest possible rate in words/ns (0 = unknown)
+  double rate;               // Smoothed observed rate in words/ns
+  int64_t sample_level;      // Level at the start of the current rate sample, less words serviced since
+  uint64_t sample_time_ns;
+  bool have_sample;
+  poll_stats_t stats;
+  struct metrics_fifo* metrics; // Run metrics fed by each observation (NULL = none, see poll_sched_track)
+  int board;                    // Board of a tracked FIFO (-1 = none), for traces
+} poll_sched_t;
+
+// Current policies (defaults set in poll_sched.c, changed with the poll_policy command)
+extern poll_policy_t poll_policies[POLL_STREAM_COUNT];
+// Upper bound of each wake latency bucket in microseconds (the last is open-ended)
+extern const uint32_t poll_wake_bucket_us[POLL_WAKE_BUCKETS];
+
+// Start scheduling a FIFO with the stream's current policy
+void poll_sched_init(poll_sched_t* sched, poll_stream_t stream, uint32_t capacity, double max_words_per_sec);
+// Feed a board's FIFO metrics (metrics.h) with this scheduler's observations
+void poll_sched_track(poll_sched_t* sched, uint8_t board);
+// Record a FIFO level read from hardware (needed = words the loop must see to do any work)
+void poll_sched_observe(poll_sched_t* sched, uint32_t available, uint32_t needed);
+// Record words serviced since the last observation
+void poll_sched_consumed(poll_sched_t* sched, uint32_t words);
+// Predicted time until the batch target is ready (0 if it already is)
+uint64_t poll_sched_predict_ns(const poll_sched_t* sched, uint32_t available, uint32_t needed);
+// Sleep for a predicted interval (spins, i.e. returns at once, inside the spin window)
+void poll_sched_sleep_ns(poll_sched_t* sched, uint64_t ns);
+// Predict and sleep in one step
+void poll_sched_wait(poll_sched_t* sched, uint32_t available, uint32_t needed);
+// Add a finished stream's statistics to the per-stream totals
+void poll_sched_finish(poll_sched_t* sched);
+
+// Accumulate statistics
+void poll_stats_add(poll_stats_t* total, const poll_stats_t* stats);
+// Copy the totals for a stream
+void poll_stats_get_totals(poll_stream_t stream, poll_stats_t* totals);
+// Clear the totals of every stream
+void poll_stats_reset_totals(void);
+// Print statistics on one line after a prefix
+void poll_stats_print(const char* prefix, const poll_stats_t* stats);
+// Print the wake latency histogram on one line after a prefix
+void poll_stats_print_wake_hist(const char* prefix, const poll_stats_t* stats);
+// Look up a stream by policy name (-1 if unknown)
+int poll_stream_from_name(const char* name);
+
+// Fastest fill/drain rates (words/s) from the SPI clock and minimum command delays (0 = unknown)
+double poll_max_rate_adc_data(struct sys_sts_t* sys_sts);
+double poll_max_rate_adc_cmd(struct sys_sts_t* sys_sts);
+double poll_max_rate_dac_cmd(struct sys_sts_t* sys_sts);
+
+#endif // POLL_SCHED_H
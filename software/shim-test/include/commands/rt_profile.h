@@ -0,0 +1,62 @@
+#ifndef RT_PROFILE_H
+#define RT_PROFILE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+
+//////////////////// Real-Time Profile Definitions ////////////////////
+// Optional real-time execution profile for the stream threads, off by default.
+//
+// Each stream thread belongs to a class with its own SCHED_FIFO priority (0 = the
+// normal time-shared scheduler) and CPU (-1 = any). By default the FIFO feeders and
+// drains run at high priority pinned to core 1, away from the command loop, terminal
+// output and file writers on core 0. Enabling the profile locks the program's current
+// memory (mlockall MCL_CURRENT); threads started afterwards get their class attributes
+// and a locked, pre-faulted stack, and stream buffers are locked as they are allocated.
+// MCL_FUTURE is not used, as it would pin every mapped waveform and capture file.
+//
+// Enabling fails cleanly (profile stays off) if memory cannot be locked or SCHED_FIFO
+// is not permitted (needs root or CAP_SYS_NICE and CAP_IPC_LOCK). Threads already
+// running keep their attributes; the profile applies to streams started from then on.
+// Compare the wake latency histograms (poll_sched.h) with the profile on and off.
+
+#define RT_STACK_BYTES  (256 * 1024)   // Stack size of profiled threads (locked and pre-faulted)
+
+//////////////////////////////////////////////////////////////////
+
+// Stream thread classes
+typedef enum {
+  RT_CLASS_FEED,     // Command FIFO feeders (DAC feeder, ADC command streams)
+  RT_CLASS_DRAIN,    // Data FIFO drains (ADC drain, trigger data, DAC debug)
+  RT_CLASS_WRITER,   // File writers (ADC writer)
+  RT_CLASS_MONITOR,  // Monitors and experiment loops
+  RT_CLASS_COUNT
+} rt_class_t;
+
+// Per-class scheduling (changed with the rt_profile command)
+typedef struct {
+  const char* name;  // Class name used by the rt_profile command
+  int priority;      // SCHED_FIFO priority (1-99, 0 = SCHED_OTHER)
+  int cpu;           // CPU to pin to (-1 = any)
+} rt_class_policy_t;
+
+// Current class policies (defaults set in rt_profile.c)
+extern rt_class_policy_t rt_policies[RT_CLASS_COUNT];
+
+// Lock memory and check SCHED_FIFO is permitted, then apply the profile to new threads (-1 if not permitted)
+int rt_profile_enable(void);
+// Unlock memory and create new threads with default attributes again
+void rt_profile_disable(void);
+// True while the profile is enabled
+bool rt_profile_enabled(void);
+// Look up a class by name (-1 if unknown)
+int rt_class_from_name(const char* name);
+
+// Create a stream thread with its class attributes (default attributes while the profile is off)
+int rt_thread_create(pthread_t* thread, rt_class_t cls, void* (*start)(void*), void* arg);
+// Lock and fault in a stream buffer while the profile is enabled
+void rt_prefault(void* buffer, size_t bytes);
+
+#endif // RT_PROFILE_H
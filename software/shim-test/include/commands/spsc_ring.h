@@ -0,0 +1,48 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+// Lock-free single-producer/single-consumer ring of 32-bit words.
+// The producer and consumer each own one index; the other side only reads it.
+// Regions are handed out as contiguous spans so FIFO bursts and file writes
+// can go straight into/out of the ring without an intermediate copy.
+
+#define SPSC_RING_CACHE_LINE 64
+
+typedef struct {
+  uint32_t* buffer;  // Ring storage (capacity words, cache line aligned)
+  size_t capacity;   // Capacity in words (power of two)
+  size_t mask;       // capacity - 1
+
+  // Producer-owned index and statistics
+  _Alignas(SPSC_RING_CACHE_LINE) atomic_size_t head;
+  size_t high_water;       // Maximum fill level seen by the producer (words)
+  uint64_t full_stalls;    // Times the producer found no free space
+
+  // Consumer-owned index
+  _Alignas(SPSC_RING_CACHE_LINE) atomic_size_t tail;
+} spsc_ring_t;
+
+// Allocate a ring of at least capacity_words words (rounded up to a power of two)
+int spsc_ring_init(spsc_ring_t* ring, size_t capacity_words);
+// Free ring storage
+void spsc_ring_free(spsc_ring_t* ring);
+
+// Number of words currently in the ring
+size_t spsc_ring_used(spsc_ring_t* ring);
+
+// Producer: get a contiguous writable span (returns its length in words, 0 if full)
+size_t spsc_ring_write_span(spsc_ring_t* ring, uint32_t** span);
+// Producer: publish count words written into the span
+void spsc_ring_commit(spsc_ring_t* ring, size_t count);
+
+// Consumer: get a contiguous readable span (returns its length in words, 0 if empty)
+size_t spsc_ring_read_span(spsc_ring_t* ring, uint32_t** span);
+// Consumer: release count words read from the span
+void spsc_ring_release(spsc_ring_t* ring, size_t count);
+
+#endif // SPSC_RING_H
@@ -0,0 +1,46 @@
+#ifndef STREAM_BARRIER_H
+#define STREAM_BARRIER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "command_helper.h"
+
+//////////////////// Stream Start Barrier Definitions ////////////////////
+// Start barrier for multi-board runs. Every board's DAC and ADC command streams fill
+// their FIFOs behind a trigger-wait stopper, so nothing is consumed yet; the barrier
+// waits until each of those FIFOs holds a watermark percentage of the words its stream
+// can always fit (the FIFO depth less the safety word and the rest of a largest command),
+// and only then is the sync trigger sent and external triggers expected. A FIFO whose
+// stream has already written its last word also counts as ready, as short waveforms
+// never reach the watermark. Every board then starts with the same full lead over its
+// FIFO, instead of whatever each feeder managed before the first trigger.
+
+#define STREAM_PREFILL_DEFAULT_PCT  90     // Default watermark (prefill_watermark command)
+#define STREAM_PREFILL_TIMEOUT_MS   5000   // Longest wait before asking whether to start anyway
+#define STREAM_PREFILL_POLL_US      1000   // FIFO level poll interval while waiting
+
+//////////////////////////////////////////////////////////////////
+
+// Current watermark in percent (0 = only wait for the first command)
+extern uint32_t stream_prefill_pct;
+
+// FIFO levels seen by the barrier
+typedef struct {
+  bool boards[8];            // Boards waited for
+  uint32_t dac_target;       // DAC command FIFO words needed
+  uint32_t adc_target;       // ADC command FIFO words needed
+  uint32_t dac_words[8];
+  uint32_t adc_words[8];
+  bool dac_ready[8];
+  bool adc_ready[8];
+  double wait_ms;
+} stream_prefill_t;
+
+// Wait until every board's command FIFOs reach the watermark or their streams finish
+// writing (true if all were ready before the timeout)
+bool stream_prefill_wait(command_context_t* ctx, const bool boards[8], uint32_t watermark_pct,
+                         uint32_t timeout_ms, stream_prefill_t* prefill);
+// Print each board's FIFO levels against the watermark
+void stream_prefill_print(const stream_prefill_t* prefill);
+
+#endif // STREAM_BARRIER_H
@@ -0,0 +1,64 @@
+#ifndef STS_SAMPLER_H
+#define STS_SAMPLER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sys_sts.h"
+
+//////////////////// Status Sampler Definitions ////////////////////
+// Shared status sampler, off by default (sts_sampler command). While it runs, one thread
+// reads, every period, the status words that were asked for in the last period in one
+// pass (sys_sts_snapshot_words), and publishes them through a seqlock; the stream threads
+// read their FIFO levels from the published copy with no MMIO and no lock, and all of
+// them see the same instant of every FIFO they watch. An idle sampler reads nothing.
+//
+// A copy is only used if it was taken at or after the reader's not_before_ns and is at
+// most STS_SAMPLER_MAX_AGE_PERIODS periods old; otherwise the word is read directly
+// (one MMIO read, not published). A loop passes the time of its own last access to the
+// FIFO, so a level is never from before words it has since moved: a stale data FIFO
+// level can only be low and a stale command FIFO level only high, and both are safe.
+// sts_sampler_refresh() takes and publishes a snapshot at once for code that needs the
+// whole block now.
+//
+// A word's first read in a period is direct, so it takes a period to start being served
+// from the copy. Worth it when streams poll faster than the period or several threads
+// watch the same FIFO: each watched word then costs one AXI read per period however
+// often it is polled.
+
+#define STS_SAMPLER_DEFAULT_PERIOD_US 200    // Period set by "sts_sampler on"
+#define STS_SAMPLER_MIN_PERIOD_US     20
+#define STS_SAMPLER_MAX_PERIOD_US     100000
+#define STS_SAMPLER_MAX_AGE_PERIODS   2      // Oldest usable copy, in periods
+#define STS_SAMPLER_ALL_WORDS         ((1ull << SYS_STS_WORDCOUNT) - 1)
+
+//////////////////////////////////////////////////////////////////
+
+// Sampler statistics (since the sampler was last started)
+typedef struct {
+  uint64_t samples;       // Samples published by the sampler thread
+  uint64_t skipped;       // Periods skipped because no word was read
+  uint64_t refreshes;     // Snapshots published by sts_sampler_refresh
+  uint64_t cached_reads;  // Words served from the published copy
+  uint64_t direct_reads;  // Words read directly (sampler off, word not sampled, or copy too old)
+  uint64_t retries;       // Direct reads because a snapshot was being published (in direct_reads)
+} sts_sampler_stats_t;
+
+// Start the sampler thread with a period in microseconds (restarts it if running; -1 on failure)
+int sts_sampler_start(struct sys_sts_t* sys_sts, uint32_t period_us);
+// Stop the sampler thread (readers fall back to direct reads)
+void sts_sampler_stop(void);
+// True while the sampler thread runs
+bool sts_sampler_running(void);
+// Current period in microseconds
+uint32_t sts_sampler_period_us(void);
+
+// Status word at a *_OFFSET in sys_sts.h, from the published copy if it is recent enough, else read directly
+uint32_t sts_sampler_word(struct sys_sts_t* sys_sts, uint32_t offset, uint64_t not_before_ns);
+// Take a snapshot now and publish it (also copied to snap if not NULL)
+void sts_sampler_refresh(struct sys_sts_t* sys_sts, struct sys_sts_snapshot_t* snap);
+// CLOCK_MONOTONIC time in nanoseconds (for not_before_ns)
+uint64_t sts_sampler_now_ns(void);
+// Copy the statistics
+void sts_sampler_get_stats(sts_sampler_stats_t* stats);
+
+#endif // STS_SAMPLER_H
@@ -30,6 +30,18 @@ int cmd_invert_miso_clk(const char** args, int arg_count, const command_flag_t*
 // SPI clock frequency and timing commands
 int cmd_spi_clk_freq(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
 int cmd_get_min_delay_times(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+// Show or change the adaptive poll policy of FIFO stream types
+int cmd_poll_policy(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+int cmd_rt_profile(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+int cmd_prefill_watermark(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+// Start, stop or show the shared status sampler
+int cmd_sts_sampler(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+// Print, clear or export the run metrics
+int cmd_metrics(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+// Start, stop, clear or dump the hot-path trace
+int cmd_trace(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
+// Start or stop the FIFO occupancy recorder
+int cmd_fifo_record(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
 
 // Integrator configuration commands
 int cmd_set_integ_window(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx);
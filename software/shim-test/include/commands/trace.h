@@ -0,0 +1,93 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <time.h>
+
+//////////////////// Trace Definitions ////////////////////
+// Hot-path timeline of the stream threads, off by default (trace command).
+//
+// Each thread that records an event claims its own ring of the last TRACE_RING_EVENTS
+// events and is the only writer of it: an event is two CLOCK_MONOTONIC_RAW reads and
+// one store, with no lock and no shared cache line. A full ring overwrites its oldest
+// events, so a dump after an underflow shows what every thread was doing just before.
+// "trace dump <file>" writes Chrome trace JSON (chrome://tracing, ui.perfetto.dev), one
+// track per thread, while streams keep running; events overwritten during the dump
+// are left out.
+//
+// While tracing is off each site costs one relaxed load. Build with -DSHIM_TRACE_DISABLE
+// to compile the sites out entirely. Rings are allocated by the first "trace on" and kept;
+// threads claim one on their first event, and once all TRACE_MAX_THREADS are claimed,
+// further threads are not traced until "trace clear".
+
+#define TRACE_RING_EVENTS   8192    // Events kept per thread (power of two, 24 bytes each)
+#define TRACE_MAX_THREADS   32      // Rings allocated by the first "trace on"
+#define TRACE_NAME_LENGTH   32      // Longest thread name
+
+//////////////////////////////////////////////////////////////////
+
+// Traced regions
+typedef enum {
+  TRACE_FIFO_POLL,     // FIFO status read (value = words available or free)
+  TRACE_FIFO_READ,     // Burst read from a data FIFO (value = words)
+  TRACE_FIFO_WRITE,    // Burst write to a command FIFO (value = words)
+  TRACE_FILE_WRITE,    // Write and flush of an output file batch (value = words ready to write)
+  TRACE_SLEEP,         // poll_sched sleep (value = requested microseconds)
+  TRACE_EVENT_COUNT
+} trace_event_t;
+
+// One complete event (start and duration)
+typedef struct {
+  uint64_t start_ns;   // CLOCK_MONOTONIC_RAW
+  uint32_t duration_ns;
+  uint16_t event;      // trace_event_t
+  int8_t stream;       // poll_stream_t (-1 = none)
+  int8_t board;        // -1 = none
+  uint32_t value;
+} trace_record_t;
+
+extern atomic_bool trace_enabled;
+
+// CLOCK_MONOTONIC_RAW time in nanoseconds
+static inline uint64_t trace_now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Start of a region (0 while tracing is off)
+static inline uint64_t trace_begin(void) {
+  return atomic_load_explicit(&trace_enabled, memory_order_relaxed) ? trace_now_ns() : 0;
+}
+
+// Record a region started with trace_begin into the calling thread's ring
+void trace_record(uint64_t start_ns, trace_event_t event, int stream, int board, uint32_t value);
+// Name the calling thread's track (printf format; applies when the thread claims its ring)
+void trace_thread_name(const char* format, ...) __attribute__((format(printf, 1, 2)));
+
+// Allocate the rings and start recording (-1 on failure)
+int trace_start(void);
+// Stop recording (the rings keep their events until cleared or restarted)
+void trace_stop(void);
+// Drop every event and release the threads' rings
+void trace_clear(void);
+// Write the recorded events as Chrome trace JSON (-1 on failure)
+int trace_dump(const char* file_path);
+// Print recording state and per-thread event counts
+void trace_print_status(void);
+
+#ifndef SHIM_TRACE_DISABLE
+#define TRACE_BEGIN(start)                          uint64_t start = trace_begin()
+#define TRACE_END(start, event, stream, board, value) \
+  do { if (start != 0) trace_record(start, event, stream, board, value); } while (0)
+#define TRACE_THREAD(...)                           trace_thread_name(__VA_ARGS__)
+#else
+#define TRACE_BEGIN(start)
+#define TRACE_END(start, event, stream, board, value) do { } while (0)
+#define TRACE_THREAD(...)                           do { } while (0)
+#endif
+
+#endif // TRACE_H
@@ -3,6 +3,27 @@
 
 #include "command_helper.h"
 
+//////////////////// Trigger Data Stream Definitions ////////////////////
+// The trigger data stream drains every complete sample in the data FIFO at each status
+// read with one burst read, writes the batch in one go, and flushes the file once
+// TRIG_STREAM_FLUSH_BYTES are pending or TRIG_STREAM_FLUSH_MS after the oldest unflushed
+// sample, rather than after every sample. Between reads it sleeps until the poll
+// scheduler predicts the next sample (poll_sched.h, trig_data policy).
+//
+// Sustained rate: the FIFO holds 512 samples, so on average triggers must not arrive
+// faster than 512 per longest gap between status reads. With the default 10 ms
+// trig_data sleep limit that is 51,200 triggers/s; lower the limit (poll_policy) for
+// faster trains, e.g. 200 us for up to 2.5 M/s. The worst scheduling delay of the
+// thread then sets the limit (see rt_profile). In the emulator, with the real-time
+// profile on and a 200 us limit, the stream kept up with 1 M triggers/s to ASCII and
+// binary files; reading one sample per status read, it overflowed above 400 k/s.
+
+#define TRIG_STREAM_BATCH_SAMPLES  (TRIG_DATA_FIFO_WORDCOUNT / 2) // Most samples read per status read (whole FIFO)
+#define TRIG_STREAM_FLUSH_BYTES    (64 * 1024)  // Flush once this much output is pending
+#define TRIG_STREAM_FLUSH_MS       250          // Flush at most this long after the oldest unflushed sample
+
+//////////////////////////////////////////////////////////////////
+
 // Structure to pass data to the trigger data streaming thread (for reading trigger timestamps to file)
 typedef struct {
   command_context_t* ctx;
@@ -10,6 +31,7 @@ typedef struct {
   uint64_t sample_count;           // Number of trigger samples to read (64-bit each)
   volatile bool* should_stop;
   bool binary_mode;                // true for binary format, false for ASCII format
+  bool chunked;                    // Chunked capture container (implies binary)
 } trigger_data_stream_params_t;
 
 // Structure for trigger monitoring thread
@@ -0,0 +1,102 @@
+#ifndef WAVEFORM_TIMING_H
+#define WAVEFORM_TIMING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+//////////////////// Waveform Timing Check Definitions ////////////////////
+// Static timing check of the FIFO words a DAC waveform or ADC command file will
+// send, run before any hardware is touched.
+//
+// Each command is placed on a timeline of SPI clock cycles the way the DAC and
+// ADC cores execute it: a delay lasts its value, a triggered DAC write takes one
+// minimum delay before its trigger wait, a triggered ADC read waits alongside its
+// read, a single-channel DAC write takes DAC_CH_WRITE_CYCLES, and a repeated ADC
+// read repeats its timing. A delay below
+// the minimum delay readback is a timing violation (the core halts with
+// STS_*_DELAY_TOO_SHORT).
+//
+// Trigger waits last trigger_cycles per trigger. With trigger_cycles 0 their
+// length is unknown: they take no time, and the host is assumed to catch up
+// during each one (as the trigger gap check assumes).
+//
+// Each FIFO is then checked against a host that services it every
+// service_cycles, refilling a command FIFO or draining a data FIFO completely.
+// Any window of one service period that needs more words than the FIFO holds
+// will underflow (command) or overflow (data) at some service phase. The
+// timeline wraps into the next iteration, as streams usually repeat.
+
+#define TIMING_PROFILE_BUCKETS  10   // Occupancy profile resolution (tenths of an iteration)
+#define TIMING_MAX_REPORTS      10   // Violations and risky segments printed per file
+#define TIMING_READ_BATCH       64   // Repeated ADC reads folded into one timeline event
+
+//////////////////////////////////////////////////////////////////
+
+// One point on the timeline where FIFO words move
+typedef struct {
+  uint64_t cycle;            // Cycle the words move (trigger waits as configured)
+  uint64_t trigger_waits;    // Trigger waits before this point
+  uint32_t cmd_words;        // Command FIFO words taken
+  uint32_t data_words;       // ADC data words produced
+  uint32_t command;          // Source command number (1-based)
+} timing_event_t;
+
+// Timeline of one iteration of a DAC waveform or ADC command file
+typedef struct {
+  const char* name;          // "DAC" or "ADC" (violation messages)
+  uint32_t min_delay;        // Minimum delay in SPI cycles
+  uint64_t trigger_cycles;   // Cycles per trigger (0 = unknown, host catches up)
+  timing_event_t* events;
+  size_t count;
+  size_t capacity;
+  uint64_t cycle;            // Iteration length so far
+  uint64_t trigger_waits;
+  uint32_t commands;
+  uint64_t cmd_words;
+  uint64_t data_words;
+  uint64_t violations;       // Commands below the minimum delay
+  bool error;                // Allocation failure (already printed)
+} timing_trace_t;
+
+// Range of commands whose service period needs more words than the FIFO holds
+typedef struct {
+  uint32_t first_command;
+  uint32_t last_command;
+  uint64_t start_cycle;
+  uint64_t peak_words;
+  bool wraps;                // Ends in the next iteration
+} timing_segment_t;
+
+// FIFO check result
+typedef struct {
+  bool data;                 // ADC data FIFO (fills) rather than a command FIFO (drains)
+  uint32_t capacity;         // Usable FIFO words
+  uint64_t service_cycles;
+  uint64_t iteration_cycles;
+  uint64_t total_words;      // Words per iteration
+  uint64_t peak_words;       // Most words in one service period
+  uint32_t peak_command;     // Command starting that period
+  uint64_t cover_cycles;     // Shortest time a full (command) or empty (data) FIFO lasts (UINT64_MAX = longer than an iteration)
+  uint64_t risky_count;      // Risky segments found
+  timing_segment_t risky[TIMING_MAX_REPORTS];
+  int64_t level[TIMING_PROFILE_BUCKETS]; // Lowest queued (command) or highest queued (data) words per bucket (INT64_MIN = none moved)
+  uint64_t faults;           // Simulated underflows or overflows with services at multiples of the period
+} timing_fifo_report_t;
+
+// Start an empty timeline
+void timing_trace_init(timing_trace_t* trace, const char* name, uint32_t min_delay, uint64_t trigger_cycles);
+// Free the timeline
+void timing_trace_free(timing_trace_t* trace);
+// Add one DAC command starting at words[0] (returns false on a timing violation, printed up to TIMING_MAX_REPORTS)
+bool timing_trace_add_dac(timing_trace_t* trace, const uint32_t* words, uint32_t command);
+// Add one ADC command starting at words[0] (returns false on a timing violation, printed up to TIMING_MAX_REPORTS)
+bool timing_trace_add_adc(timing_trace_t* trace, const uint32_t* words, uint32_t command);
+
+// Check a command FIFO (data false) or the ADC data FIFO (data true) of a timeline
+void timing_check_fifo(const timing_trace_t* trace, bool data, uint32_t capacity, uint64_t service_cycles,
+                       timing_fifo_report_t* report);
+// Print a FIFO check (true if no service period needs more words than the FIFO holds)
+bool timing_print_fifo(const timing_fifo_report_t* report, const char* name, double spi_hz);
+
+#endif // WAVEFORM_TIMING_H
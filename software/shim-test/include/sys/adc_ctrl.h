@@ -68,6 +68,7 @@ typedef enum {
 // ADC control structure
 struct adc_ctrl_t {
   volatile uint32_t *buffer[8];  // ADC FIFO (command and data)
+  uint8_t channel_order[8][8];   // Last channel order sent to each board with SET_ORD (default 0-7)
 };
 
 // Function declarations
@@ -75,6 +76,10 @@ struct adc_ctrl_t {
 struct adc_ctrl_t create_adc_ctrl(bool verbose);
 // Read ADC data word from a specific board
 uint32_t adc_read_word(struct adc_ctrl_t *adc_ctrl, uint8_t board);
+// Read count ADC data words from a specific board into dst (caller checks FIFO word count first)
+uint32_t adc_read_burst(struct adc_ctrl_t *adc_ctrl, uint8_t board, uint32_t *dst, uint32_t count);
+// Write count pre-encoded command FIFO words to a specific board (caller checks free space first)
+uint32_t adc_write_burst(struct adc_ctrl_t *adc_ctrl, uint8_t board, const uint32_t *src, uint32_t count);
 // Interpret and format ADC value as debug information
 char* adc_format_debug(uint32_t adc_value, bool verbose);
 // Interpret and format the ADC state
@@ -86,6 +91,20 @@ char* adc_format_pair(uint32_t data_word, bool verbose);
 // Convert and format a single ADC sample from a 32-bit word
 char* adc_format_single(uint32_t data_word, bool verbose);
 
+// ADC command word encoding (no validation; value and repeat_count are masked to 25 bits)
+uint32_t adc_encode_noop(adc_wait_mode_t trig, adc_continue_mode_t cont, uint32_t value);
+// Encode an ADC_RD command word and its repeat count word into words[2] (returns the word count, 1 or 2)
+uint32_t adc_encode_adc_rd(uint32_t words[2], adc_wait_mode_t trig, adc_continue_mode_t cont, uint32_t value, uint32_t repeat_count);
+uint32_t adc_encode_set_ord(const uint8_t channel_order[8]);
+// Decode the channel order of a SET_ORD command word
+void adc_decode_set_ord(uint32_t cmd_word, uint8_t channel_order[8]);
+
+// FIFO words taken by the command starting with this word (ADC_RD and ADC_RD_CH carry a repeat count word when REPEAT is set)
+static inline uint32_t adc_cmd_words(uint32_t cmd_word) {
+  uint32_t cmd = cmd_word >> ADC_CMD_CMD_LSB;
+  return ((cmd == ADC_CMD_ADC_RD || cmd == ADC_CMD_ADC_RD_CH) && ((cmd_word >> ADC_CMD_REPEAT_BIT) & 0x1)) ? 2 : 1;
+}
+
 // ADC command word functions
 void adc_cmd_noop(struct adc_ctrl_t *adc_ctrl, uint8_t board, adc_wait_mode_t trig, adc_continue_mode_t cont, uint32_t value, bool verbose);
 void adc_cmd_adc_rd(struct adc_ctrl_t *adc_ctrl, uint8_t board, adc_wait_mode_t trig, adc_continue_mode_t cont, uint32_t value, uint32_t repeat_count, bool verbose);
@@ -61,6 +61,10 @@ typedef enum {
 #define DAC_CMD_CONT_BIT 27
 #define DAC_CMD_LDAC_BIT 26
 
+// DAC_WR_CH write time in SPI clock cycles. The minimum DAC delay covers the
+// eight channel writes of a DAC_WR; a single-channel write takes one of them.
+#define DAC_CH_WRITE_CYCLES(min_delay) (((min_delay) + 7) / 8)
+
 // DAC data codes
 #define DAC_DATA_CODE(word)       (((word) >> 28) & 0x0F) // Top 4 bits for debug code
 #define DAC_DBG_MISO_DATA         1
@@ -94,11 +98,20 @@ struct dac_ctrl_t {
 struct dac_ctrl_t create_dac_ctrl(bool verbose);
 // Read DAC data from a specific board
 uint32_t dac_read_data(struct dac_ctrl_t *dac_ctrl, uint8_t board);
+// Write count pre-encoded command FIFO words to a specific board (caller checks free space first)
+uint32_t dac_write_burst(struct dac_ctrl_t *dac_ctrl, uint8_t board, const uint32_t *src, uint32_t count);
 // Interpret and format DAC data word as calibration or debug information
 char* dac_format_data(uint32_t dac_value, bool verbose);
 // Interpret and format the DAC state
 char* dac_format_state(uint8_t state_code, bool verbose);
 
+// DAC command word encoding (no validation; value is masked to 25 bits)
+uint32_t dac_encode_noop(dac_wait_mode_t trig, dac_continue_mode_t cont, dac_ldac_mode_t ldac, uint32_t value);
+// Encode a DAC_WR command word and its 4 channel data words into words[5]
+void dac_encode_dac_wr(uint32_t words[5], const int16_t ch_vals[8], dac_wait_mode_t trig, dac_continue_mode_t cont, dac_ldac_mode_t ldac, uint32_t value);
+// Encode a DAC_WR_CH command word (immediate single-channel write; channel is masked to 3 bits)
+uint32_t dac_encode_dac_wr_ch(uint8_t ch, int16_t ch_val);
+
 // DAC command word functions
 void dac_cmd_noop(struct dac_ctrl_t *dac_ctrl, uint8_t board, dac_wait_mode_t trig, dac_continue_mode_t cont, dac_ldac_mode_t ldac, uint32_t value, bool verbose);
 void dac_cmd_dac_wr(struct dac_ctrl_t *dac_ctrl, uint8_t board, int16_t ch_vals[8], dac_wait_mode_t trig, dac_continue_mode_t cont, dac_ldac_mode_t ldac, uint32_t value, bool verbose);
@@ -1,9 +1,114 @@
 #ifndef MAP_MEMORY_H
 #define MAP_MEMORY_H
 
+#include <stddef.h>
 #include <stdint.h>
+#include <stdbool.h>
+
+//////////////////// MMIO Backend Definitions ////////////////////
+// All register and FIFO accesses go through mmio_read32()/mmio_write32().
+// With no backend installed these are plain volatile accesses to /dev/mem
+// mappings. A backend (e.g. the software shim emulator) can be installed
+// before any create_*() call to redirect both mapping and accesses.
+
+// MMIO backend interface
+typedef struct mmio_backend_t {
+  const char *name;
+  // Map a region of wordcount 32-bit words at a physical base address
+  uint32_t *(*map)(uint32_t base_addr, size_t wordcount, const char *name, bool verbose);
+  // Read a 32-bit word from a mapped address (may have side effects, e.g. FIFO pop)
+  uint32_t (*read32)(volatile uint32_t *addr);
+  // Write a 32-bit word to a mapped address (may have side effects, e.g. FIFO push)
+  void (*write32)(volatile uint32_t *addr, uint32_t value);
+  // Optional: read count words from the same address in one call (NULL = use read32)
+  void (*read32_burst)(volatile uint32_t *addr, uint32_t *dst, size_t count);
+  // Optional: write count words to the same address in one call (NULL = use write32)
+  void (*write32_burst)(volatile uint32_t *addr, const uint32_t *src, size_t count);
+  // Optional: read count consecutive registers starting at addr in one call (NULL = use read32)
+  void (*read32_block)(volatile uint32_t *addr, uint32_t *dst, size_t count);
+} mmio_backend_t;
+
+// Active backend (NULL = direct /dev/mem access)
+extern const mmio_backend_t *mmio_backend;
+
+//////////////////////////////////////////////////////////////////
+
+// Install an MMIO backend (NULL restores direct /dev/mem access)
+void mmio_set_backend(const mmio_backend_t *backend);
+// Get the name of the active MMIO backend
+const char *mmio_backend_name(void);
 
 // Function declaration for mapping 32-bit memory regions
-uint32_t *map_32bit_memory(uint32_t base_addr, uint32_t size, char *name, int verbose);
+uint32_t *map_32bit_memory(uint32_t base_addr, size_t wordcount, char *name, bool verbose);
+
+// Read a 32-bit word from a mapped register or FIFO
+static inline uint32_t mmio_read32(volatile uint32_t *addr) {
+  if (mmio_backend != NULL) return mmio_backend->read32(addr);
+  return *addr;
+}
+
+// Read count words from the same mapped FIFO address into dst
+static inline void mmio_read32_burst(volatile uint32_t *addr, uint32_t *dst, size_t count) {
+  if (mmio_backend != NULL) {
+    if (mmio_backend->read32_burst != NULL) {
+      mmio_backend->read32_burst(addr, dst, count);
+    } else {
+      for (size_t i = 0; i < count; i++) dst[i] = mmio_backend->read32(addr);
+    }
+    return;
+  }
+  // Unrolled so the AXI reads issue back to back
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    dst[i]     = *addr;
+    dst[i + 1] = *addr;
+    dst[i + 2] = *addr;
+    dst[i + 3] = *addr;
+  }
+  for (; i < count; i++) dst[i] = *addr;
+}
+
+// Read count consecutive registers (not FIFOs) starting at addr into dst
+static inline void mmio_read32_block(volatile uint32_t *addr, uint32_t *dst, size_t count) {
+  if (mmio_backend != NULL) {
+    if (mmio_backend->read32_block != NULL) {
+      mmio_backend->read32_block(addr, dst, count);
+    } else {
+      for (size_t i = 0; i < count; i++) dst[i] = mmio_backend->read32(addr + i);
+    }
+    return;
+  }
+  for (size_t i = 0; i < count; i++) dst[i] = addr[i];
+}
+
+// Write a 32-bit word to a mapped register or FIFO
+static inline void mmio_write32(volatile uint32_t *addr, uint32_t value) {
+  if (mmio_backend != NULL) {
+    mmio_backend->write32(addr, value);
+    return;
+  }
+  *addr = value;
+}
+
+// Write count words from src to the same mapped FIFO address
+static inline void mmio_write32_burst(volatile uint32_t *addr, const uint32_t *src, size_t count) {
+  if (mmio_backend != NULL) {
+    if (mmio_backend->write32_burst != NULL) {
+      mmio_backend->write32_burst(addr, src, count);
+    } else {
+      for (size_t i = 0; i < count; i++) mmio_backend->write32(addr, src[i]);
+    }
+    return;
+  }
+  // Unrolled so the AXI writes issue back to back
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    *addr = src[i];
+    *addr = src[i + 1];
+    *addr = src[i + 2];
+    *addr = src[i + 3];
+  }
+  for (; i < count; i++) *addr = src[i];
+}
 
 #endif // MAP_MEMORY_H
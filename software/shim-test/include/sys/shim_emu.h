@@ -0,0 +1,61 @@
+#ifndef SHIM_EMU_H
+#define SHIM_EMU_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "map_memory.h"
+
+//////////////////// Shim Emulator Definitions ////////////////////
+// Software model of the shim register map for off-target runs.
+// Emulates SYS_CTRL, SYS_STS (hardware status, FIFO status words, SPI clock,
+// trigger counter, delay-too-short registers), the 8 DAC/ADC command and data
+// FIFOs and the trigger FIFOs. The DAC, ADC and trigger cores consume their
+// command FIFOs in emulated SPI clock cycles derived from CLOCK_MONOTONIC, so
+// host-side stream threads see realistic fill/drain rates and underflow/overflow
+// halts.
+
+// Default emulator settings
+#define SHIM_EMU_DEFAULT_SPI_CLK_FREQ_HZ  (uint32_t) 50000000 // 50 MHz SPI clock
+#define SHIM_EMU_DEFAULT_EXT_TRIG_FREQ_HZ (uint32_t) 1000     // 1 kHz external triggers
+#define SHIM_EMU_DEFAULT_DAC_MIN_CYCLES   (uint32_t) 50       // Minimum DAC_WR delay (SPI cycles)
+#define SHIM_EMU_DEFAULT_ADC_MIN_CYCLES   (uint32_t) 250      // Minimum ADC_RD delay (SPI cycles)
+
+// FIFO almost-full/almost-empty thresholds (in words from the respective end)
+#define SHIM_EMU_FIFO_ALMOST_MARGIN (uint32_t) 4
+
+//////////////////////////////////////////////////////////////////
+
+// Emulator configuration
+typedef struct {
+  uint32_t spi_clk_freq_hz;  // Emulated SPI clock rate (sets command timing)
+  uint32_t ext_trig_freq_hz; // Rate of emulated external triggers (0 = never)
+  uint32_t dac_min_cycles;   // Minimum DAC_WR delay before STS_DAC_DELAY_TOO_SHORT
+  uint32_t adc_min_cycles;   // Minimum ADC_RD delay before STS_ADC_DELAY_TOO_SHORT
+  uint8_t board_mask;        // Bit N set = board N present (FIFO_PRESENT)
+  bool verbose;              // Print emulator events (halts, resets)
+} shim_emu_config_t;
+
+// Emulator counters
+typedef struct {
+  uint64_t mmio_reads;          // Total emulated register/FIFO reads
+  uint64_t mmio_writes;         // Total emulated register/FIFO writes
+  uint64_t dac_cmds[8];         // DAC commands executed per board
+  uint64_t adc_words[8];        // ADC data words produced per board
+  uint64_t trig_words;          // Trigger data words produced
+  uint64_t spi_cycles;          // Emulated SPI cycles since power-on
+} shim_emu_stats_t;
+
+// Fill a configuration with the default settings
+void shim_emu_default_config(shim_emu_config_t *config);
+// Initialize the emulator and return its MMIO backend (install with mmio_set_backend)
+const mmio_backend_t *shim_emu_init(const shim_emu_config_t *config);
+// Change the emulated SPI clock rate at runtime
+void shim_emu_set_spi_clk_freq(uint32_t freq_hz);
+// Change the emulated external trigger rate at runtime (0 = never)
+void shim_emu_set_ext_trig_freq(uint32_t freq_hz);
+// Copy the emulator counters
+void shim_emu_get_stats(shim_emu_stats_t *stats);
+// Print the emulator configuration and counters
+void shim_emu_print_stats(void);
+
+#endif // SHIM_EMU_H
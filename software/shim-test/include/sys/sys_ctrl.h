@@ -10,7 +10,7 @@
 
 // System control and configuration register
 #define SYS_CTRL_BASE                  (uint32_t) 0x40000000
-#define SYS_CTRL_WORDCOUNT             (uint32_t) 10 // Size in 32-bit words
+#define SYS_CTRL_WORDCOUNT             (uint32_t) 13 // Size in 32-bit words
 // 32-bit offsets within the system control and configuration register 
 #define CTRL_ENABLE_OFFSET             (uint32_t) 0
 #define POWER_ENABLE_OFFSET            (uint32_t) 1
@@ -23,6 +23,7 @@
 #define DEBUG_OFFSET                   (uint32_t) 8
 #define MOSI_SCK_POL_OFFSET            (uint32_t) 9
 #define MISO_SCK_POL_OFFSET            (uint32_t) 10
+#define DO_DAC_PRE_DELAY_OFFSET        (uint32_t) 12
 
 //////////////////////////////////////////////////////////////////
 
@@ -39,6 +40,7 @@ struct sys_ctrl_t {
   volatile uint32_t *debug;                   // Debug
   volatile uint32_t *mosi_sck_pol;            // MOSI SCK polarity
   volatile uint32_t *miso_sck_pol;            // MISO SCK polarity
+  volatile uint32_t *do_dac_pre_delay;        // DAC pre-delay (1 = delayed DAC writes land at the end of the delay)
 };
 
 // Create a system control structure
@@ -67,6 +69,8 @@ void sys_ctrl_set_integ_window(struct sys_ctrl_t *sys_ctrl, uint32_t value, bool
 void sys_ctrl_set_integ_threshold_average(struct sys_ctrl_t *sys_ctrl, uint32_t value, bool verbose);
 // Set the integrator enable register to a 32-bit value
 void sys_ctrl_set_integ_enable(struct sys_ctrl_t *sys_ctrl, uint32_t value, bool verbose);
+// Read the DAC pre-delay register (true = delayed DAC writes land at the end of the delay)
+bool sys_ctrl_get_dac_pre_delay(struct sys_ctrl_t *sys_ctrl, bool verbose);
 
 
 #endif // SYS_CTRL_H
@@ -4,11 +4,12 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <pthread.h>
+#include "map_memory.h"
 
 //////////////////// System Status Definitions ////////////////////
 // Status register
 #define SYS_STS           (uint32_t) 0x40100000
-#define SYS_STS_WORDCOUNT (uint32_t) 1 + (3 * 8) + 2 // Size in 32-bit words
+#define SYS_STS_WORDCOUNT (uint32_t) 40 // Size in 32-bit words (hardware status through ADC "delay too short" time)
 // 32-bit offsets within the status register
 #define HW_STS_REG_OFFSET (uint32_t) 0 // Hardware status register
 // Command FIFO status offset for DAC board (in 32-bit words)
@@ -117,6 +118,13 @@
 #define FIFO_STS_ALMOST_EMPTY(sts) (((sts) >> 30) & 0x1) // FIFO almost empty flag
 #define FIFO_PRESENT(sts)          (((sts) >> 31) & 0x1) // FIFO present flag
 
+// Status snapshots
+// sys_sts_snapshot() copies the whole status block (all SYS_STS_WORDCOUNT words) in one
+// tight pass of consecutive reads, stamped with CLOCK_MONOTONIC. Code that needs several
+// status words (board discovery, buffer resets, prefill checks) reads them from one
+// snapshot instead of a separate uncached read per word, and sees all of them from the
+// same moment. Polling loops that only need one or two words should keep reading those
+// words directly: a snapshot is 40 reads.
 
 //////////////////////////////////////////////////////////////////
 
@@ -136,9 +144,60 @@ struct sys_sts_t {
   volatile uint32_t *adc_delay_too_short_time; // ADC "delay too short" time in SPI clock cycles
 };
 
+// Copy of the whole status block (decode with the sys_sts_snap_* helpers)
+struct sys_sts_snapshot_t {
+  uint64_t timestamp_ns;             // CLOCK_MONOTONIC time the copy was taken
+  uint32_t words[SYS_STS_WORDCOUNT]; // Raw status words, indexed by the *_OFFSET definitions
+};
+
 // Structure initialization function
 struct sys_sts_t create_sys_sts(bool verbose);
 
+// Copy the whole status block into a snapshot in one pass
+void sys_sts_snapshot(struct sys_sts_t *sys_sts, struct sys_sts_snapshot_t *snap);
+// Copy only the words in mask (bit n = word n) into a snapshot in one pass (others are left as they were)
+void sys_sts_snapshot_words(struct sys_sts_t *sys_sts, struct sys_sts_snapshot_t *snap, uint64_t mask);
+// Bitmask of boards (bit n = board n) whose DAC and ADC command and data FIFOs are all present
+uint8_t sys_sts_snap_connected_boards(const struct sys_sts_snapshot_t *snap);
+
+// Snapshot decode helpers (board must be 0-7)
+static inline uint32_t sys_sts_snap_hw_status(const struct sys_sts_snapshot_t *snap) {
+  return snap->words[HW_STS_REG_OFFSET];
+}
+static inline uint32_t sys_sts_snap_dac_cmd_fifo_status(const struct sys_sts_snapshot_t *snap, uint8_t board) {
+  return snap->words[DAC_CMD_FIFO_STS_OFFSET(board)];
+}
+static inline uint32_t sys_sts_snap_dac_data_fifo_status(const struct sys_sts_snapshot_t *snap, uint8_t board) {
+  return snap->words[DAC_DATA_FIFO_STS_OFFSET(board)];
+}
+static inline uint32_t sys_sts_snap_adc_cmd_fifo_status(const struct sys_sts_snapshot_t *snap, uint8_t board) {
+  return snap->words[ADC_CMD_FIFO_STS_OFFSET(board)];
+}
+static inline uint32_t sys_sts_snap_adc_data_fifo_status(const struct sys_sts_snapshot_t *snap, uint8_t board) {
+  return snap->words[ADC_DATA_FIFO_STS_OFFSET(board)];
+}
+static inline uint32_t sys_sts_snap_trig_cmd_fifo_status(const struct sys_sts_snapshot_t *snap) {
+  return snap->words[TRIG_CMD_FIFO_STS_OFFSET];
+}
+static inline uint32_t sys_sts_snap_trig_data_fifo_status(const struct sys_sts_snapshot_t *snap) {
+  return snap->words[TRIG_DATA_FIFO_STS_OFFSET];
+}
+static inline uint32_t sys_sts_snap_spi_clk_freq_hz(const struct sys_sts_snapshot_t *snap) {
+  return snap->words[SPI_CLK_FREQ_OFFSET];
+}
+static inline uint32_t sys_sts_snap_trig_counter(const struct sys_sts_snapshot_t *snap) {
+  return snap->words[TRIG_COUNTER_OFFSET];
+}
+static inline uint32_t sys_sts_snap_debug(const struct sys_sts_snapshot_t *snap) {
+  return snap->words[DEBUG_REG_OFFSET];
+}
+static inline uint32_t sys_sts_snap_dac_delay_too_short_time(const struct sys_sts_snapshot_t *snap) {
+  return snap->words[DEBUG_DAC_DELAY_TOO_SHORT_TIME_OFFSET];
+}
+static inline uint32_t sys_sts_snap_adc_delay_too_short_time(const struct sys_sts_snapshot_t *snap) {
+  return snap->words[DEBUG_ADC_DELAY_TOO_SHORT_TIME_OFFSET];
+}
+
 // Get hardware status register value
 uint32_t sys_sts_get_hw_status(struct sys_sts_t *sys_sts, bool verbose);
 // Get SPI clock frequency in Hz
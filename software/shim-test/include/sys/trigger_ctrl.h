@@ -38,6 +38,8 @@ struct trigger_ctrl_t create_trigger_ctrl(bool verbose);
 
 // Read 64-bit trigger data from FIFO as a pair of 32-bit words
 uint64_t trigger_read(struct trigger_ctrl_t *trigger_ctrl);
+// Read count 64-bit trigger samples into dst (the FIFO must hold at least 2 * count words)
+uint32_t trigger_read_burst(struct trigger_ctrl_t *trigger_ctrl, uint64_t *dst, uint32_t count);
 
 // Trigger command functions
 void trigger_cmd_sync_ch(struct trigger_ctrl_t *trigger_ctrl, bool log, bool verbose);
@@ -16,7 +16,13 @@
 #include "spi_clk_ctrl.h"
 #include "sys_sts.h"
 #include "trigger_ctrl.h"
+#include "shim_emu.h"
 #include "command_handler.h"
+#include "adc_stream_engine.h"
+#include "dac_stream_engine.h"
+#include "sts_sampler.h"
+#include "metrics.h"
+#include "fifo_recorder.h"
 
 //////////////////// Main ////////////////////
 int main(int argc, char *argv[])
@@ -33,10 +39,37 @@ int main(int argc, char *argv[])
   struct adc_ctrl_t adc_ctrl;         // ADC command and data FIFOs (all boards)
   struct trigger_ctrl_t trigger_ctrl; // Trigger command and data FIFOs
 
-  // Parse optional verbose argument
+  // Parse optional arguments
   bool verbose = false;
-  if (argc == 2 && strcmp(argv[1], "--verbose") == 0) {
-    verbose = true;
+  bool emulate = false;
+  shim_emu_config_t emu_config;
+  shim_emu_default_config(&emu_config);
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--verbose") == 0) {
+      verbose = true;
+    } else if (strcmp(argv[i], "--emulate") == 0) {
+      emulate = true;
+    } else if (strncmp(argv[i], "--emulate=", 10) == 0) {
+      // Emulated SPI clock rate in Hz
+      emulate = true;
+      char *endptr;
+      unsigned long freq_hz = strtoul(argv[i] + 10, &endptr, 0);
+      if (*endptr != '\0' || freq_hz == 0 || freq_hz > UINT32_MAX) {
+        fprintf(stderr, "Invalid emulated SPI clock frequency: '%s'\n", argv[i] + 10);
+        return EXIT_FAILURE;
+      }
+      emu_config.spi_clk_freq_hz = (uint32_t)freq_hz;
+    } else {
+      fprintf(stderr, "Usage: %s [--verbose] [--emulate[=<spi_clk_hz>]]\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Redirect all register and FIFO access to the software shim emulator
+  if (emulate) {
+    emu_config.verbose = verbose;
+    mmio_set_backend(shim_emu_init(&emu_config));
+    printf("Using software shim emulator (SPI clock %" PRIu32 " Hz)\n", emu_config.spi_clk_freq_hz);
   }
 
   // Initialize hardware control structures
@@ -81,11 +114,12 @@ int main(int argc, char *argv[])
     .trigger_ctrl = &trigger_ctrl,
     .verbose = &verbose,
     .should_exit = &should_exit,
-    .adc_data_stream_threads = {0},    // Initialize thread handles to 0
+    .adc_stream_engine = NULL,          // ADC stream engine is created by the first data stream
     .adc_data_stream_running = {false}, // Initialize all data streams as not running
     .adc_data_stream_stop = {false},    // Initialize all data stream stop flags as false
     .adc_cmd_stream_running = {false},  // Initialize all command streams as not running
     .adc_cmd_stream_stop = {false},     // Initialize all command stream stop flags as false
+    .dac_stream_engine = NULL,          // DAC stream engine is created by the first command stream
     .dac_cmd_stream_running = {false},  // Initialize all DAC command streams as not running
     .dac_cmd_stream_stop = {false},     // Initialize all DAC command stream stop flags as false
     .trig_data_stream_running = false,  // Initialize trigger data stream as not running
@@ -133,12 +167,8 @@ int main(int argc, char *argv[])
   for (int i = 0; i < 8; i++) {
     if (cmd_ctx.adc_data_stream_running[i]) {
       printf("Stopping ADC data stream for board %d...\n", i);
-      cmd_ctx.adc_data_stream_stop[i] = true;
-      if (pthread_join(cmd_ctx.adc_data_stream_threads[i], NULL) != 0) {
-        fprintf(stderr, "Failed to join ADC data streaming thread for board %d\n", i);
-      } else {
-        printf("ADC data stream for board %d stopped.\n", i);
-      }
+      adc_stream_engine_stop_session(&cmd_ctx, (uint8_t)i);
+      printf("ADC data stream for board %d stopped.\n", i);
     }
     if (cmd_ctx.adc_cmd_stream_running[i]) {
       printf("Stopping ADC command stream for board %d...\n", i);
@@ -151,15 +181,15 @@ int main(int argc, char *argv[])
     }
     if (cmd_ctx.dac_cmd_stream_running[i]) {
       printf("Stopping DAC command stream for board %d...\n", i);
-      cmd_ctx.dac_cmd_stream_stop[i] = true;
-      if (pthread_join(cmd_ctx.dac_cmd_stream_threads[i], NULL) != 0) {
-        fprintf(stderr, "Failed to join DAC command streaming thread for board %d\n", i);
-      } else {
-        printf("DAC command stream for board %d stopped.\n", i);
-      }
+      dac_stream_engine_stop_session(&cmd_ctx, (uint8_t)i);
+      printf("DAC command stream for board %d stopped.\n", i);
     }
   }
   
+  // Stop the ADC stream engine threads and the DAC feeder
+  adc_stream_engine_shutdown(&cmd_ctx);
+  dac_stream_engine_shutdown(&cmd_ctx);
+  
   // Stop trigger data stream if running
   if (cmd_ctx.trig_data_stream_running) {
     printf("Stopping trigger data stream...\n");
@@ -181,6 +211,13 @@ int main(int argc, char *argv[])
       printf("Fieldmap data collection stopped.\n");
     }
   }
+
+  // Stop the status sampler once nothing reads from it
+  sts_sampler_stop();
+  // Write the metrics file a last time with the final counts
+  metrics_export_stop();
+  // Write out a FIFO recording still in progress
+  fifo_recorder_stop();
   
   // Close log file if logging is active
   if (cmd_ctx.logging_enabled && cmd_ctx.log_file != NULL) {
@@ -193,5 +230,9 @@ int main(int argc, char *argv[])
   sys_ctrl_turn_off(&sys_ctrl, verbose);
   printf("System turned off.\n");
 
+  if (emulate) {
+    shim_emu_print_stats();
+  }
+
   return 0; // Exit the program
 }
@@ -0,0 +1,78 @@
+#include <stdint.h>
+#include <string.h>
+#include "adc_ascii.h"
+
+// "00" .. "99" digit pairs
+static const char digit_pairs[200] = {
+  '0','0','0','1','0','2','0','3','0','4','0','5','0','6','0','7','0','8','0','9',
+  '1','0','1','1','1','2','1','3','1','4','1','5','1','6','1','7','1','8','1','9',
+  '2','0','2','1','2','2','2','3','2','4','2','5','2','6','2','7','2','8','2','9',
+  '3','0','3','1','3','2','3','3','3','4','3','5','3','6','3','7','3','8','3','9',
+  '4','0','4','1','4','2','4','3','4','4','4','5','4','6','4','7','4','8','4','9',
+  '5','0','5','1','5','2','5','3','5','4','5','5','5','6','5','7','5','8','5','9',
+  '6','0','6','1','6','2','6','3','6','4','6','5','6','6','6','7','6','8','6','9',
+  '7','0','7','1','7','2','7','3','7','4','7','5','7','6','7','7','7','8','7','9',
+  '8','0','8','1','8','2','8','3','8','4','8','5','8','6','8','7','8','8','8','9',
+  '9','0','9','1','9','2','9','3','9','4','9','5','9','6','9','7','9','8','9','9'
+};
+
+// Write one signed 16-bit sample in decimal, return pointer past the last character
+static inline char* format_sample(char* p, int16_t sample) {
+  uint32_t v = (uint32_t)sample;
+  if (sample < 0) {
+    *p++ = '-';
+    v = (uint32_t)(-(int32_t)sample);
+  }
+
+  // At most 5 digits (32768): emit the odd leading digit, then pairs
+  if (v >= 10000) {
+    uint32_t hi = v / 10000;        // 1..3
+    uint32_t lo = v - hi * 10000;
+    *p++ = (char)('0' + hi);
+    memcpy(p, &digit_pairs[(lo / 100) * 2], 2);
+    memcpy(p + 2, &digit_pairs[(lo % 100) * 2], 2);
+    return p + 4;
+  } else if (v >= 1000) {
+    memcpy(p, &digit_pairs[(v / 100) * 2], 2);
+    memcpy(p + 2, &digit_pairs[(v % 100) * 2], 2);
+    return p + 4;
+  } else if (v >= 100) {
+    uint32_t hi = v / 100;
+    *p++ = (char)('0' + hi);
+    memcpy(p, &digit_pairs[(v - hi * 100) * 2], 2);
+    return p + 2;
+  } else if (v >= 10) {
+    memcpy(p, &digit_pairs[v * 2], 2);
+    return p + 2;
+  }
+  *p++ = (char)('0' + v);
+  return p;
+}
+
+// Format count ADC words into out, 8 samples per line
+size_t adc_ascii_format_words(char* out, const uint32_t* words, size_t count, int* samples_on_line) {
+  char* p = out;
+  int on_line = *samples_on_line;
+
+  for (size_t i = 0; i < count; i++) {
+    uint32_t word = words[i];
+    int16_t samples[2] = {
+      (int16_t)(word & 0xFFFF),         // Bits 15:0
+      (int16_t)((word >> 16) & 0xFFFF)  // Bits 31:16
+    };
+
+    for (int s = 0; s < 2; s++) {
+      if (on_line > 0) {
+        *p++ = ' ';
+      }
+      p = format_sample(p, samples[s]);
+      if (++on_line >= ADC_ASCII_SAMPLES_PER_LINE) {
+        *p++ = '\n';
+        on_line = 0;
+      }
+    }
+  }
+
+  *samples_on_line = on_line;
+  return (size_t)(p - out);
+}
@@ -0,0 +1,186 @@
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include "adc_codec.h"
+
+//////////////////// Bit I/O ////////////////////
+
+// LSB-first bit writer
+typedef struct {
+  uint8_t* out;
+  uint64_t acc;
+  int bits;
+} bit_writer_t;
+
+static inline void bw_put(bit_writer_t* bw, uint32_t value, int width) {
+  bw->acc |= (uint64_t)value << bw->bits;
+  bw->bits += width;
+  if (bw->bits >= 32) {
+    uint32_t low = (uint32_t)bw->acc;
+    memcpy(bw->out, &low, 4);
+    bw->out += 4;
+    bw->acc >>= 32;
+    bw->bits -= 32;
+  }
+}
+
+static inline void bw_flush(bit_writer_t* bw) {
+  while (bw->bits > 0) {
+    *bw->out++ = (uint8_t)bw->acc;
+    bw->acc >>= 8;
+    bw->bits -= 8;
+  }
+  bw->bits = 0;
+}
+
+// LSB-first bit reader (reads past the end return zeros and set overrun)
+typedef struct {
+  const uint8_t* in;
+  const uint8_t* end;
+  uint64_t acc;
+  int bits;
+  bool overrun;
+} bit_reader_t;
+
+static inline uint32_t br_get(bit_reader_t* br, int width) {
+  if (br->bits < width) {
+    if (br->end - br->in >= 4) {
+      uint32_t next;
+      memcpy(&next, br->in, 4);
+      br->in += 4;
+      br->acc |= (uint64_t)next << br->bits;
+      br->bits += 32;
+    } else {
+      while (br->bits < width) {
+        if (br->in < br->end) {
+          br->acc |= (uint64_t)(*br->in++) << br->bits;
+        } else {
+          br->overrun = true;
+        }
+        br->bits += 8;
+      }
+    }
+  }
+  uint32_t value = (uint32_t)(br->acc & ((1ull << width) - 1));
+  br->acc >>= width;
+  br->bits -= width;
+  return value;
+}
+
+//////////////////// Codec ////////////////////
+
+static inline uint16_t zigzag16(uint16_t sample, uint16_t previous) {
+  int16_t delta = (int16_t)(sample - previous);
+  return (uint16_t)(((uint16_t)delta << 1) ^ (uint16_t)(delta >> 15));
+}
+
+static inline uint16_t unzigzag16(uint16_t zz, uint16_t previous) {
+  uint16_t delta = (uint16_t)((zz >> 1) ^ (uint16_t)-(int16_t)(zz & 1));
+  return (uint16_t)(previous + delta);
+}
+
+static inline int bit_width16(uint32_t value) {
+  return value ? 32 - __builtin_clz(value) : 0;
+}
+
+// Encode word_count words into out
+size_t adc_codec_encode(const uint32_t* words, size_t word_count, uint8_t* out) {
+  bit_writer_t bw = {out, 0, 0};
+  uint16_t previous[ADC_CODEC_CHANNELS] = {0};
+  size_t sample_count = word_count * 2;
+  size_t block_count = sample_count / ADC_CODEC_BLOCK_SAMPLES;
+  uint16_t residuals[ADC_CODEC_CHANNELS][ADC_CODEC_BLOCK_FRAMES];
+
+  for (size_t block = 0; block < block_count; block++) {
+    const uint32_t* block_words = words + block * (ADC_CODEC_BLOCK_SAMPLES / 2);
+    uint32_t any_bits[ADC_CODEC_CHANNELS] = {0};
+
+    // De-interleave and predict: frame f holds channel slot c in word 4f + c/2, half c%2
+    for (int f = 0; f < ADC_CODEC_BLOCK_FRAMES; f++) {
+      for (int w = 0; w < ADC_CODEC_CHANNELS / 2; w++) {
+        uint32_t word = block_words[f * (ADC_CODEC_CHANNELS / 2) + w];
+        uint16_t lo = (uint16_t)(word & 0xFFFF);
+        uint16_t hi = (uint16_t)(word >> 16);
+        uint16_t zlo = zigzag16(lo, previous[2 * w]);
+        uint16_t zhi = zigzag16(hi, previous[2 * w + 1]);
+        previous[2 * w] = lo;
+        previous[2 * w + 1] = hi;
+        residuals[2 * w][f] = zlo;
+        residuals[2 * w + 1][f] = zhi;
+        any_bits[2 * w] |= zlo;
+        any_bits[2 * w + 1] |= zhi;
+      }
+    }
+
+    // Widths first, then each channel's residuals at its width
+    int widths[ADC_CODEC_CHANNELS];
+    for (int c = 0; c < ADC_CODEC_CHANNELS; c++) {
+      widths[c] = bit_width16(any_bits[c]);
+      bw_put(&bw, (uint32_t)widths[c], 5);
+    }
+    for (int c = 0; c < ADC_CODEC_CHANNELS; c++) {
+      int width = widths[c];
+      if (width == 0) continue;
+      for (int f = 0; f < ADC_CODEC_BLOCK_FRAMES; f++) {
+        bw_put(&bw, residuals[c][f], width);
+      }
+    }
+  }
+
+  // Tail samples stored verbatim
+  for (size_t i = block_count * ADC_CODEC_BLOCK_SAMPLES; i < sample_count; i++) {
+    uint32_t word = words[i / 2];
+    bw_put(&bw, (i & 1) ? (word >> 16) : (word & 0xFFFF), 16);
+  }
+
+  bw_flush(&bw);
+  return (size_t)(bw.out - out);
+}
+
+// Decode exactly word_count words from in
+int adc_codec_decode(const uint8_t* in, size_t in_bytes, uint32_t* words, size_t word_count) {
+  bit_reader_t br = {in, in + in_bytes, 0, 0, false};
+  uint16_t previous[ADC_CODEC_CHANNELS] = {0};
+  size_t sample_count = word_count * 2;
+  size_t block_count = sample_count / ADC_CODEC_BLOCK_SAMPLES;
+  uint16_t block[ADC_CODEC_BLOCK_FRAMES][ADC_CODEC_CHANNELS];
+
+  for (size_t b = 0; b < block_count; b++) {
+    int widths[ADC_CODEC_CHANNELS];
+    for (int c = 0; c < ADC_CODEC_CHANNELS; c++) {
+      widths[c] = (int)br_get(&br, 5);
+      if (widths[c] > 16) {
+        return -1;
+      }
+    }
+    for (int c = 0; c < ADC_CODEC_CHANNELS; c++) {
+      int width = widths[c];
+      uint16_t value = previous[c];
+      for (int f = 0; f < ADC_CODEC_BLOCK_FRAMES; f++) {
+        uint16_t zz = width ? (uint16_t)br_get(&br, width) : 0;
+        value = unzigzag16(zz, value);
+        block[f][c] = value;
+      }
+      previous[c] = value;
+    }
+
+    // Re-interleave into words
+    uint32_t* block_words = words + b * (ADC_CODEC_BLOCK_SAMPLES / 2);
+    for (int f = 0; f < ADC_CODEC_BLOCK_FRAMES; f++) {
+      for (int w = 0; w < ADC_CODEC_CHANNELS / 2; w++) {
+        block_words[f * (ADC_CODEC_CHANNELS / 2) + w] = (uint32_t)block[f][2 * w] | ((uint32_t)block[f][2 * w + 1] << 16);
+      }
+    }
+  }
+
+  for (size_t i = block_count * ADC_CODEC_BLOCK_SAMPLES; i < sample_count; i++) {
+    uint32_t value = br_get(&br, 16);
+    if (i & 1) {
+      words[i / 2] |= value << 16;
+    } else {
+      words[i / 2] = value;
+    }
+  }
+
+  return br.overrun ? -1 : 0;
+}
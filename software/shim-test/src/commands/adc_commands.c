@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 #include <inttypes.h>
 #include <unistd.h>
 #include <pwd.h>
@@ -9,14 +10,23 @@
 #include <errno.h>
 #include <pthread.h>
 #include <glob.h>
+#include <time.h>
+#include <stdatomic.h>
 #include "adc_commands.h"
+#include "adc_stream_engine.h"
+#include "poll_sched.h"
+#include "adc_ascii.h"
+#include "capture_file.h"
+#include "adc_codec.h"
+#include "adc_stats.h"
 #include "command_helper.h"
 #include "sys_sts.h"
 #include "adc_ctrl.h"
 #include "map_memory.h"
+#include "rt_profile.h"
+#include "trace.h"
 
 // Forward declarations for helper functions
-static void* adc_data_stream_thread(void* arg);
 static void* adc_cmd_stream_thread(void* arg);
 static int parse_adc_command_file(const char* file_path, adc_command_t** commands, int* command_count);
 
@@ -335,144 +345,6 @@ int cmd_do_adc_rd_ch(const char** args, int arg_count, const command_flag_t* fla
   return 0;
 }
 
-// Thread function for ADC data streaming
-static void* adc_data_stream_thread(void* arg) {
-  adc_data_stream_params_t* stream_data = (adc_data_stream_params_t*)arg;
-  command_context_t* ctx = stream_data->ctx;
-  uint8_t board = stream_data->board;
-  const char* file_path = stream_data->file_path;
-  uint64_t word_count = stream_data->word_count;
-  volatile bool* should_stop = stream_data->should_stop;
-  bool binary_mode = stream_data->binary_mode;
-  bool verbose = *(ctx->verbose);
-  
-  if (verbose) {
-    printf("ADC Data Stream Thread[%d]: Starting to write %llu words to file '%s' (%s format)\n", 
-           board, word_count, file_path, binary_mode ? "binary" : "ASCII");
-  }
-  
-  // Open file for writing (binary or text mode based on format)
-  FILE* file = fopen(file_path, binary_mode ? "wb" : "w");
-  if (file == NULL) {
-    fprintf(stderr, "ADC Data Stream Thread[%d]: Failed to open file '%s' for writing: %s\n", 
-           board, file_path, strerror(errno));
-    goto cleanup;
-  }
-  
-  uint64_t words_written = 0;
-  uint32_t write_buffer[256]; // Buffer for writing data
-  int samples_on_line = 0; // Track samples per line for formatting (ASCII mode only)
-  
-  while (words_written < word_count && !(*should_stop)) {
-    // Check data FIFO status
-    uint32_t data_status = sys_sts_get_adc_data_fifo_status(ctx->sys_sts, board, false);
-    
-    if (FIFO_PRESENT(data_status) == 0) {
-      fprintf(stderr, "ADC Data Stream Thread[%d]: Data FIFO not present, stopping stream\n", board);
-      break;
-    }
-    
-    uint32_t words_available = FIFO_STS_WORD_COUNT(data_status);
-    
-    if (words_available > 0) {
-      // Determine how many words to read (up to buffer size and remaining count)
-      uint32_t words_to_read = words_available;
-      if (words_to_read > 256) {
-        words_to_read = 256;
-      }
-      if (words_written + words_to_read > word_count) {
-        words_to_read = (uint32_t)(word_count - words_written);
-      }
-      
-      // Read data from FIFO
-      for (uint32_t i = 0; i < words_to_read; i++) {
-        write_buffer[i] = adc_read_word(ctx->adc_ctrl, board);
-      }
-      
-      // Write data based on format mode
-      if (binary_mode) {
-        // Binary mode: write raw 32-bit words directly
-        size_t written = fwrite(write_buffer, sizeof(uint32_t), words_to_read, file);
-        if (written != words_to_read) {
-          fprintf(stderr, "ADC Data Stream Thread[%d]: Failed to write to file: %s\n", 
-                 board, strerror(errno));
-          break;
-        }
-      } else {
-        // ASCII mode: convert and write samples as text
-        for (uint32_t i = 0; i < words_to_read; i++) {
-          uint32_t word = write_buffer[i];
-          
-          // Extract two 16-bit samples from the 32-bit word
-          int16_t sample1 = (int16_t)(word & 0xFFFF);        // Bits 15:0
-          int16_t sample2 = (int16_t)((word >> 16) & 0xFFFF); // Bits 31:16
-          
-          // Write sample1
-          if (samples_on_line > 0) {
-            fprintf(file, " ");
-          }
-          fprintf(file, "%d", sample1);
-          samples_on_line++;
-          
-          // Check if we need a new line
-          if (samples_on_line >= 8) {
-            fprintf(file, "\n");
-            samples_on_line = 0;
-          }
-          
-          // Write sample2
-          if (samples_on_line > 0) {
-            fprintf(file, " ");
-          }
-          fprintf(file, "%d", sample2);
-          samples_on_line++;
-          
-          // Check if we need a new line
-          if (samples_on_line >= 8) {
-            fprintf(file, "\n");
-            samples_on_line = 0;
-          }
-        }
-      }
-      
-      // Flush the file to ensure data is written
-      fflush(file);
-      
-      words_written += words_to_read;
-      
-      if (verbose && words_written % 10000 == 0) {
-        printf("ADC Data Stream Thread[%d]: Written %llu/%llu words (%.1f%%)\n",
-               board, words_written, word_count,
-               (double)words_written / word_count * 100.0);
-      }
-    } else {
-      // No data available, sleep briefly
-      usleep(100);
-    }
-  }
-  
-  if (file) {
-    // Add final newline if needed (ASCII mode only, if last line has samples but isn't complete)
-    if (!binary_mode && samples_on_line > 0) {
-      fprintf(file, "\n");
-    }
-    fclose(file);
-  }
-  
-  if (*should_stop) {
-    printf("ADC Data Stream Thread[%d]: Stream stopped by user after writing %llu words\n",
-           board, words_written);
-  } else {
-    printf("ADC Data Stream Thread[%d]: Stream completed, wrote %llu words to file '%s'\n",
-           board, words_written, file_path);
-  }
-  
-cleanup:
-  ctx->adc_data_stream_running[board] = false;
-  free(stream_data);
-  return NULL;
-}
-
 int cmd_stream_adc_data_to_file(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
   // Parse board number
   int board = parse_board_number(args[0]);
@@ -491,6 +363,22 @@ int cmd_stream_adc_data_to_file(const char** args, int arg_count, const command_
   
   // Check for binary mode flag
   bool binary_mode = has_flag(flags, flag_count, FLAG_BIN);
+  // Legacy fprintf text path (kept for comparison with the fast formatter)
+  bool fprintf_ascii = has_flag(flags, flag_count, FLAG_FPRINTF);
+  // Chunked capture container (binary, self-describing, indexed)
+  bool chunked = has_flag(flags, flag_count, FLAG_CHUNKED);
+  // Lossless ADC codec inside the chunked container
+  bool compress = has_flag(flags, flag_count, FLAG_COMPRESS);
+  if (compress) {
+    chunked = true;
+  }
+  if (chunked) {
+    binary_mode = true;
+  }
+  if (binary_mode && fprintf_ascii) {
+    fprintf(stderr, "Flag --fprintf cannot be combined with --bin, --chunked or --compress for stream_adc_data_to_file.\n");
+    return -1;
+  }
   
   // Check if stream is already running
   if (ctx->adc_data_stream_running[board]) {
@@ -528,7 +416,9 @@ int cmd_stream_adc_data_to_file(const char** args, int arg_count, const command_
   // Check if there's a dot after the last slash (or no slash at all)
   if (dot == NULL || (slash != NULL && dot < slash)) {
     // No extension, add default
-    if (binary_mode) {
+    if (chunked) {
+      strcat(final_path, ".cap");
+    } else if (binary_mode) {
       strcat(final_path, ".dat");
     } else {
       strcat(final_path, ".csv");
@@ -541,50 +431,36 @@ int cmd_stream_adc_data_to_file(const char** args, int arg_count, const command_
            args[2], final_path, binary_mode ? "binary" : "ASCII");
   }
   
-  // Allocate thread data structure
-  adc_data_stream_params_t* stream_data = malloc(sizeof(adc_data_stream_params_t));
-  if (stream_data == NULL) {
-    fprintf(stderr, "Failed to allocate memory for stream data\n");
-    return -1;
-  }
-  
-  if (*(ctx->verbose)) {
-    printf("Allocated stream data structure, setting up parameters...\n");
-  }
-  
-  stream_data->ctx = ctx;
-  stream_data->board = (uint8_t)board;
-  snprintf(stream_data->file_path, sizeof(stream_data->file_path), "%s", final_path);
-  stream_data->word_count = word_count;
-  stream_data->should_stop = &(ctx->adc_data_stream_stop[board]);
-  stream_data->binary_mode = binary_mode;
+  adc_data_stream_params_t stream_data;
+  stream_data.board = (uint8_t)board;
+  snprintf(stream_data.file_path, sizeof(stream_data.file_path), "%s", final_path);
+  stream_data.word_count = word_count;
+  stream_data.should_stop = &(ctx->adc_data_stream_stop[board]);
+  stream_data.binary_mode = binary_mode;
+  stream_data.fprintf_ascii = fprintf_ascii;
+  stream_data.chunked = chunked;
+  stream_data.compress = compress;
   
   if (*(ctx->verbose)) {
     printf("Stream parameters: board=%d, word_count=%llu, file='%s', format=%s\n", 
            board, word_count, final_path, binary_mode ? "binary" : "ASCII");
   }
   
-  // Set file permissions for group access
-  set_file_permissions(final_path, *(ctx->verbose));
-  
   // Initialize stop flag and mark stream as running
   ctx->adc_data_stream_stop[board] = false;
   ctx->adc_data_stream_running[board] = true;
   
-  if (*(ctx->verbose)) {
-    printf("Initialized stream flags, creating pthread...\n");
-  }
-  
-  // Create the streaming thread
-  if (pthread_create(&(ctx->adc_data_stream_threads[board]), NULL, adc_data_stream_thread, stream_data) != 0) {
-    fprintf(stderr, "Failed to create ADC data streaming thread for board %d: %s\n", board, strerror(errno));
+  // Hand the board to the shared drain/writer engine (opens the file)
+  if (adc_stream_engine_start_session(ctx, &stream_data) != 0) {
+    fprintf(stderr, "Failed to start ADC data streaming for board %d\n", board);
     ctx->adc_data_stream_running[board] = false;
-    free(stream_data);
     return -1;
   }
   
+  // Set file permissions for group access
+  set_file_permissions(final_path, *(ctx->verbose));
+  
   if (*(ctx->verbose)) {
-    printf("Successfully created streaming thread for board %d\n", board);
     printf("Started ADC data streaming for board %d to file '%s' (%llu words, %s format)\n", 
            board, final_path, word_count, binary_mode ? "binary" : "ASCII");
   }
@@ -607,19 +483,32 @@ int cmd_stop_adc_data_stream(const char** args, int arg_count, const command_fla
   
   printf("Stopping ADC data streaming for board %d...\n", board);
   
-  // Signal the thread to stop
-  ctx->adc_data_stream_stop[board] = true;
-  
-  // Wait for the thread to finish
-  if (pthread_join(ctx->adc_data_stream_threads[board], NULL) != 0) {
-    fprintf(stderr, "Failed to join ADC data streaming thread for board %d: %s\n", board, strerror(errno));
-    return -1;
-  }
+  // Signal the stream to stop and wait for its file to be closed
+  adc_stream_engine_stop_session(ctx, (uint8_t)board);
   
   printf("ADC data streaming for board %d has been stopped.\n", board);
   return 0;
 }
 
+// Show the shared ADC stream engine statistics
+int cmd_adc_stream_status(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  adc_stream_engine_print_status(ctx);
+  return 0;
+}
+
+// Show per-channel statistics of the current or last ADC data stream
+int cmd_adc_stats(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  int board = -1;
+  if (arg_count > 0 && strcmp(args[0], "all") != 0) {
+    board = parse_board_number(args[0]);
+    if (board < 0) {
+      fprintf(stderr, "Invalid board number for adc_stats: '%s'. Must be 0-7 or 'all'.\n", args[0]);
+      return -1;
+    }
+  }
+  return adc_stream_engine_print_channel_stats(ctx, board);
+}
+
 // Function to validate and parse an ADC command file
 static int parse_adc_command_file(const char* file_path, adc_command_t** commands, int* command_count) {
   FILE* file = fopen(file_path, "r");
@@ -795,41 +684,105 @@ static int parse_adc_command_file(const char* file_path, adc_command_t** command
   return 0;
 }
 
+// Encode parsed ADC commands into the FIFO words of one iteration
+// Every command is sent without CONT, so all iterations are identical and are
+// replayed from the same buffer. Returns a malloc'd buffer (NULL on failure).
+static uint32_t* encode_adc_commands(const adc_command_t* commands, int command_count, size_t* word_count) {
+  uint32_t* words = malloc((size_t)command_count * 2 * sizeof(uint32_t));
+  if (words == NULL) {
+    fprintf(stderr, "Failed to allocate memory for encoded ADC commands\n");
+    return NULL;
+  }
+  
+  size_t count = 0;
+  for (int i = 0; i < command_count; i++) {
+    const adc_command_t* cmd = &commands[i];
+    switch (cmd->type) {
+      case ADC_TRIGGER_CMD:
+        count += adc_encode_adc_rd(&words[count], ADC_TRIGGER_WAIT, ADC_NO_CONTINUE, cmd->value, cmd->repeat_count);
+        break;
+      case ADC_DELAY_CMD:
+        count += adc_encode_adc_rd(&words[count], ADC_DELAY_WAIT, ADC_NO_CONTINUE, cmd->value, cmd->repeat_count);
+        break;
+      case ADC_ORDER_CMD:
+        words[count++] = adc_encode_set_ord(cmd->order);
+        break;
+      case ADC_NOOP_TRIGGER_CMD:
+        words[count++] = adc_encode_noop(ADC_TRIGGER_WAIT, ADC_NO_CONTINUE, cmd->value);
+        break;
+      case ADC_NOOP_DELAY_CMD:
+        words[count++] = adc_encode_noop(ADC_DELAY_WAIT, ADC_NO_CONTINUE, cmd->value);
+        break;
+      default:
+        fprintf(stderr, "Invalid ADC command type %d\n", cmd->type);
+        free(words);
+        return NULL;
+    }
+  }
+  
+  *word_count = count;
+  return words;
+}
+
+// Longest run of whole commands from words[pos] that fits in max_words.
+// Counts the commands in the run and returns the offset of its last SET_ORD (or -1).
+static size_t adc_cmd_run(const uint32_t* words, size_t word_count, size_t pos, uint32_t max_words,
+                          uint32_t* commands, long* last_set_ord) {
+  size_t end = pos;
+  *commands = 0;
+  *last_set_ord = -1;
+  while (end < word_count) {
+    uint32_t cmd_words = adc_cmd_words(words[end]);
+    if (end + cmd_words - pos > max_words) break;
+    if ((words[end] >> ADC_CMD_CMD_LSB) == ADC_CMD_SET_ORD) {
+      *last_set_ord = (long)end;
+    }
+    end += cmd_words;
+    (*commands)++;
+  }
+  return end - pos;
+}
+
 // ADC command streaming thread function (for streaming commands from file)
+// The iteration body is encoded once; each FIFO service then writes the longest
+// run of whole commands that fits in the free space with one burst, so the cost
+// per iteration is a status read per burst and a copy of the words.
 static void* adc_cmd_stream_thread(void* arg) {
   adc_command_stream_params_t* stream_data = (adc_command_stream_params_t*)arg;
   command_context_t* ctx = stream_data->ctx;
   uint8_t board = stream_data->board;
   const char* file_path = stream_data->file_path;
   volatile bool* should_stop = stream_data->should_stop;
-  adc_command_t* commands = stream_data->commands;
+  const uint32_t* words = stream_data->words;
+  size_t word_count = stream_data->word_count;
   int command_count = stream_data->command_count;
   int iterations = stream_data->iterations;
-  bool simple_mode = stream_data->simple_mode;
   bool verbose = *(ctx->verbose);
+  TRACE_THREAD("adc_cmd[%d]", board);
 
   if (verbose) {
-    printf("ADC Command Stream Thread[%d]: Started streaming from file '%s' (%d commands, %d iteration%s)\n",
-           board, file_path, command_count, iterations, iterations == 1 ? "" : "s");
+    printf("ADC Command Stream Thread[%d]: Started streaming from file '%s' (%d commands, %zu words, %d iteration%s)\n",
+           board, file_path, command_count, word_count, iterations, iterations == 1 ? "" : "s");
   }
 
-  int total_commands_sent = 0;
-  int total_words_sent = 0;
+  uint64_t total_commands_sent = 0;
+  uint64_t total_words_sent = 0;
+  uint64_t total_bursts = 0;
   int current_iteration = 0;
+  
+  // Free space grows as the board consumes commands; wait for it adaptively
+  poll_sched_t poll;
+  poll_sched_init(&poll, POLL_STREAM_ADC_CMD, ADC_CMD_FIFO_WORDCOUNT - 1, poll_max_rate_adc_cmd(ctx->sys_sts));
+  poll_sched_track(&poll, board);
 
   while (!(*should_stop) && current_iteration < iterations) {
-    int cmd_index = 0;
-    int commands_sent_this_iteration = 0;
-
-    while (!(*should_stop) && cmd_index < command_count) {
-      adc_command_t* cmd = &commands[cmd_index];
-
-      // Calculate words needed for this command
-      // Noop commands (ADC_NOOP_TRIGGER_CMD and ADC_NOOP_DELAY_CMD) always need 1 word
-      uint32_t words_needed = ((cmd->type == ADC_DELAY_CMD) && (cmd->repeat_count > 0)) ? 2 : 1;
+    size_t pos = 0;
 
+    while (!(*should_stop) && pos < word_count) {
       // Check ADC command FIFO status
+      TRACE_BEGIN(trace_poll_ns);
       uint32_t fifo_status = sys_sts_get_adc_cmd_fifo_status(ctx->sys_sts, board, false);
+      TRACE_END(trace_poll_ns, TRACE_FIFO_POLL, POLL_STREAM_ADC_CMD, board, FIFO_STS_WORD_COUNT(fifo_status));
 
       if (FIFO_PRESENT(fifo_status) == 0) {
         fprintf(stderr, "ADC Command Stream Thread[%d]: FIFO not present, stopping stream\n", board);
@@ -837,45 +790,38 @@ static void* adc_cmd_stream_thread(void* arg) {
       }
 
       uint32_t words_used = FIFO_STS_WORD_COUNT(fifo_status) + 1; // +1 for safety margin
-      uint32_t words_available = ADC_CMD_FIFO_WORDCOUNT - words_used;
+      uint32_t words_available = (words_used < ADC_CMD_FIFO_WORDCOUNT) ? ADC_CMD_FIFO_WORDCOUNT - words_used : 0;
+      uint32_t words_needed = adc_cmd_words(words[pos]);
+      poll_sched_observe(&poll, words_available, words_needed);
 
       if (words_available >= words_needed) {
-        // Send the command
-        switch (cmd->type) {
-          case ADC_TRIGGER_CMD:
-            adc_cmd_adc_rd(ctx->adc_ctrl, board, ADC_TRIGGER_WAIT, ADC_NO_CONTINUE, cmd->value, cmd->repeat_count, false);
-            break;
-          case ADC_DELAY_CMD:
-            adc_cmd_adc_rd(ctx->adc_ctrl, board, ADC_DELAY_WAIT, ADC_NO_CONTINUE, cmd->value, cmd->repeat_count, false);
-            break;
-          case ADC_ORDER_CMD:
-            adc_cmd_set_ord(ctx->adc_ctrl, board, cmd->order, false);
-            break;
-          case ADC_NOOP_TRIGGER_CMD:
-            adc_cmd_noop(ctx->adc_ctrl, board, ADC_TRIGGER_WAIT, ADC_NO_CONTINUE, cmd->value, false);
-            break;
-          case ADC_NOOP_DELAY_CMD:
-            adc_cmd_noop(ctx->adc_ctrl, board, ADC_DELAY_WAIT, ADC_NO_CONTINUE, cmd->value, false);
-            break;
-          default:
-            fprintf(stderr, "ADC Command Stream Thread[%d]: Invalid command type %d\n", board, cmd->type);
-            break;
+        // Send every whole command that fits in one burst
+        uint32_t run_commands;
+        long last_set_ord;
+        size_t run = adc_cmd_run(words, word_count, pos, words_available, &run_commands, &last_set_ord);
+        TRACE_BEGIN(trace_write_ns);
+        adc_write_burst(ctx->adc_ctrl, board, &words[pos], (uint32_t)run);
+        TRACE_END(trace_write_ns, TRACE_FIFO_WRITE, POLL_STREAM_ADC_CMD, board, (uint32_t)run);
+
+        // Data streams and captures read the board's channel order
+        if (last_set_ord >= 0) {
+          adc_decode_set_ord(words[last_set_ord], ctx->adc_ctrl->channel_order[board]);
         }
 
-        commands_sent_this_iteration++;
-        total_commands_sent++;
-        total_words_sent += words_needed;
-        cmd_index++;
+        poll_sched_consumed(&poll, (uint32_t)run);
+        pos += run;
+        total_commands_sent += run_commands;
+        total_words_sent += run;
+        total_bursts++;
 
         if (verbose) {
-          const char* type_names[] = {"ADC_DELAY_CMD", "ADC_TRIGGER_CMD", "ADC_ORDER_CMD", "ADC_NOOP_TRIGGER_CMD", "ADC_NOOP_DELAY_CMD"};
-          printf("ADC Command Stream Thread[%d]: Iteration %d/%d, Sent command %d/%d (type=%s, value=%u, repeat=%u) [FIFO: %u/%u words, %d needed]\n",
-                 board, current_iteration + 1, iterations, commands_sent_this_iteration, command_count,
-                 type_names[cmd->type], cmd->value, cmd->repeat_count, words_used, ADC_CMD_FIFO_WORDCOUNT, words_needed);
+          printf("ADC Command Stream Thread[%d]: Iteration %d/%d, sent %u command%s (%zu words, %zu/%zu) [FIFO: %u/%u words]\n",
+                 board, current_iteration + 1, iterations, run_commands, run_commands == 1 ? "" : "s",
+                 run, pos, word_count, words_used, ADC_CMD_FIFO_WORDCOUNT);
         }
       } else {
-        // Not enough space in FIFO, sleep and try again
-        usleep(1000); // 1ms
+        // Not enough space in FIFO, sleep until enough is predicted to drain
+        poll_sched_wait(&poll, words_available, words_needed);
       }
     }
 
@@ -888,15 +834,21 @@ static void* adc_cmd_stream_thread(void* arg) {
 
 cleanup:
   if (*should_stop) {
-    printf("ADC Command Stream Thread[%d]: Stopping (user requested), sent %d total commands (%d total words)\n",
-           board, total_commands_sent, total_words_sent);
+    printf("ADC Command Stream Thread[%d]: Stopping (user requested), sent %llu total commands (%llu total words in %llu bursts)\n",
+           board, total_commands_sent, total_words_sent, total_bursts);
   } else {
-    printf("ADC Command Stream Thread[%d]: Completed, sent %d total commands (%d total words, %d iteration%s)\n",
-           board, total_commands_sent, total_words_sent, iterations, iterations == 1 ? "" : "s");
+    printf("ADC Command Stream Thread[%d]: Completed, sent %llu total commands (%llu total words in %llu bursts, %d iteration%s)\n",
+           board, total_commands_sent, total_words_sent, total_bursts, iterations, iterations == 1 ? "" : "s");
+  }
+  if (verbose) {
+    char prefix[48];
+    snprintf(prefix, sizeof(prefix), "ADC Command Stream Thread[%d]: ", board);
+    poll_stats_print(prefix, &poll.stats);
   }
+  poll_sched_finish(&poll);
 
   ctx->adc_cmd_stream_running[board] = false;
-  free(stream_data->commands);
+  free(stream_data->words);
   free(stream_data);
   return NULL;
 }
@@ -953,18 +905,32 @@ int cmd_stream_adc_commands_from_file(const char** args, int arg_count, const co
     return -1; // Error already printed by parse_adc_command_file
   }
   
+  // Encode the iteration body once; the thread replays it
+  size_t word_count = 0;
+  uint32_t* words = encode_adc_commands(commands, command_count, &word_count);
+  free(commands);
+  if (words == NULL) {
+    return -1;
+  }
+  rt_prefault(words, word_count * sizeof(uint32_t));
+  
   if (*(ctx->verbose)) {
-    printf("Parsed %d commands from ADC command file '%s'\n", command_count, full_path);
+    printf("Parsed %d commands from ADC command file '%s' (%zu FIFO words per iteration)\n", command_count, full_path, word_count);
     if (simple_mode) {
       printf("Using simple mode (unrolling repeats)\n");
     }
   }
   
+  // Record the command file so chunked ADC captures of this board can identify it
+  ctx->adc_cmd_file_hash[board] = capture_hash_file(full_path);
+  ctx->adc_cmd_words_per_iteration[board] = calculate_expected_adc_words(full_path, 1, false);
+  snprintf(ctx->adc_cmd_file_path[board], sizeof(ctx->adc_cmd_file_path[board]), "%s", full_path);
+  
   // Allocate thread data structure
   adc_command_stream_params_t* stream_data = malloc(sizeof(adc_command_stream_params_t));
   if (stream_data == NULL) {
     fprintf(stderr, "Failed to allocate memory for ADC stream data\n");
-    free(commands);
+    free(words);
     return -1;
   }
   
@@ -972,7 +938,8 @@ int cmd_stream_adc_commands_from_file(const char** args, int arg_count, const co
   stream_data->board = (uint8_t)board;
   snprintf(stream_data->file_path, sizeof(stream_data->file_path), "%s", full_path);
   stream_data->should_stop = &(ctx->adc_cmd_stream_stop[board]);
-  stream_data->commands = commands;
+  stream_data->words = words;
+  stream_data->word_count = word_count;
   stream_data->command_count = command_count;
   stream_data->iterations = iterations;
   stream_data->simple_mode = simple_mode;
@@ -982,10 +949,10 @@ int cmd_stream_adc_commands_from_file(const char** args, int arg_count, const co
   ctx->adc_cmd_stream_running[board] = true;
   
   // Create the streaming thread
-  if (pthread_create(&(ctx->adc_cmd_stream_threads[board]), NULL, adc_cmd_stream_thread, stream_data) != 0) {
+  if (rt_thread_create(&(ctx->adc_cmd_stream_threads[board]), RT_CLASS_FEED, adc_cmd_stream_thread, stream_data) != 0) {
     fprintf(stderr, "Failed to create ADC command streaming thread for board %d: %s\n", board, strerror(errno));
     ctx->adc_cmd_stream_running[board] = false;
-    free(commands);
+    free(words);
     free(stream_data);
     return -1;
   }
@@ -1027,6 +994,17 @@ int cmd_stop_adc_cmd_stream(const char** args, int arg_count, const command_flag
   return 0;
 }
 
+// Parse an ADC command file and encode one iteration of its FIFO words
+uint32_t* adc_command_file_words(const char* file_path, size_t* word_count, int* command_count) {
+  adc_command_t* commands = NULL;
+  if (parse_adc_command_file(file_path, &commands, command_count) != 0) {
+    return NULL;
+  }
+  uint32_t* words = encode_adc_commands(commands, *command_count, word_count);
+  free(commands);
+  return words;
+}
+
 // Helper function to calculate expected number of ADC words from an ADC command file
 uint64_t calculate_expected_adc_words(const char* file_path, int iterations, bool verbose) {
   // Parse the ADC command file using existing parser
@@ -1073,3 +1051,484 @@ uint64_t calculate_expected_adc_words(const char* file_path, int iterations, boo
   
   return total_adc_words;
 }
+
+// Benchmark the ASCII writers: legacy fprintf path vs. table-driven formatter
+int cmd_bench_adc_ascii(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  uint64_t word_count = 1 << 20;
+  if (arg_count > 0) {
+    char* endptr;
+    word_count = parse_value(args[0], &endptr);
+    if (*endptr != '\0' || word_count == 0) {
+      fprintf(stderr, "Invalid word count for bench_adc_ascii: '%s'. Must be a positive integer.\n", args[0]);
+      return -1;
+    }
+  }
+  
+  uint32_t* words = malloc(word_count * sizeof(uint32_t));
+  char* text_buffer = malloc(ADC_STREAM_TEXT_CHUNK_WORDCOUNT * ADC_ASCII_MAX_BYTES_PER_WORD);
+  FILE* files[2] = {tmpfile(), tmpfile()};
+  if (words == NULL || text_buffer == NULL || files[0] == NULL || files[1] == NULL) {
+    fprintf(stderr, "Failed to allocate benchmark buffers: %s\n", strerror(errno));
+    free(words);
+    free(text_buffer);
+    if (files[0] != NULL) fclose(files[0]);
+    if (files[1] != NULL) fclose(files[1]);
+    return -1;
+  }
+  
+  // Full-range pseudo-random samples (xorshift32) so every digit count is exercised
+  uint32_t state = 0x12345678;
+  for (uint64_t i = 0; i < word_count; i++) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    words[i] = state;
+  }
+  
+  const char* names[2] = {"fprintf", "formatter"};
+  double seconds[2];
+  long bytes[2];
+  for (int path = 0; path < 2; path++) {
+    int samples_on_line = 0;
+    struct timespec start_time, end_time;
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+    int64_t result = (path == 0)
+      ? adc_fprintf_ascii_words(files[path], words, word_count, &samples_on_line)
+      : adc_write_ascii_words(files[path], text_buffer, words, word_count, &samples_on_line);
+    fflush(files[path]);
+    clock_gettime(CLOCK_MONOTONIC, &end_time);
+    if (result < 0) {
+      fprintf(stderr, "Benchmark write failed (%s path)\n", names[path]);
+    }
+    seconds[path] = (end_time.tv_sec - start_time.tv_sec) + (end_time.tv_nsec - start_time.tv_nsec) / 1e9;
+    bytes[path] = ftell(files[path]);
+    printf("  %-10s %10.3f ms  %8.1f Mwords/s  %8.1f MB/s  (%ld bytes)\n", names[path],
+           seconds[path] * 1e3, word_count / seconds[path] / 1e6, bytes[path] / seconds[path] / 1e6, bytes[path]);
+  }
+  
+  // Both paths must produce identical text
+  bool identical = (bytes[0] == bytes[1]);
+  rewind(files[0]);
+  rewind(files[1]);
+  while (identical) {
+    char a[4096], b[4096];
+    size_t na = fread(a, 1, sizeof(a), files[0]);
+    size_t nb = fread(b, 1, sizeof(b), files[1]);
+    if (na != nb || memcmp(a, b, na) != 0) identical = false;
+    if (na == 0) break;
+  }
+  printf("Formatter speedup: %.1fx over %llu words, output %s\n",
+         seconds[0] / seconds[1], word_count, identical ? "identical" : "MISMATCH");
+  
+  fclose(files[0]);
+  fclose(files[1]);
+  free(text_buffer);
+  free(words);
+  return identical ? 0 : -1;
+}
+
+// Show the header and index of a chunked capture file (ADC or trigger)
+int cmd_capture_info(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  char full_path[1024];
+  clean_and_expand_path(args[0], full_path, sizeof(full_path));
+  
+  capture_reader_t reader;
+  if (capture_reader_open(&reader, full_path, true) != 0) {
+    return -1;
+  }
+  
+  const capture_file_header_t* header = &reader.header;
+  printf("Capture file '%s' (version %u)\n", full_path, header->version);
+  if (header->stream_type == CAPTURE_STREAM_ADC) {
+    printf("  Stream:          ADC board %u\n", header->board);
+    printf("  Channel order:   [%u,%u,%u,%u,%u,%u,%u,%u]\n",
+           header->channel_order[0], header->channel_order[1], header->channel_order[2], header->channel_order[3],
+           header->channel_order[4], header->channel_order[5], header->channel_order[6], header->channel_order[7]);
+  } else if (header->stream_type == CAPTURE_STREAM_TRIG) {
+    printf("  Stream:          trigger\n");
+  } else {
+    printf("  Stream:          unknown type %u\n", header->stream_type);
+  }
+  printf("  SPI clock:       %u Hz\n", header->spi_clk_freq_hz);
+  if (header->codec != ADC_CODEC_NONE) {
+    printf("  Codec:           %s\n", header->codec == ADC_CODEC_DELTA_PACK ? "delta + bit-pack" : "unknown");
+  }
+  if (header->cmd_file_hash != 0) {
+    printf("  Command file:    '%s' (FNV-1a 0x%016" PRIx64 ")\n", header->cmd_file_path, header->cmd_file_hash);
+  }
+  if (header->words_per_iteration != 0) {
+    printf("  Iterations:      %llu words each, %.2f iterations captured\n",
+           header->words_per_iteration, (double)reader.total_words / header->words_per_iteration);
+  }
+  time_t start_sec = (time_t)(header->start_realtime_ns / 1000000000ull);
+  printf("  Started:         %s", ctime(&start_sec));
+  printf("  Chunks:          %llu x %u words%s\n", reader.chunk_count, header->chunk_words,
+         reader.index_rebuilt ? " (index rebuilt, capture was not closed)" : "");
+  printf("  Total words:     %llu\n", reader.total_words);
+  if (reader.chunk_count > 0) {
+    uint64_t last_ns = reader.index[reader.chunk_count - 1].timestamp_ns;
+    printf("  Duration:        %.3f s to last chunk\n", (last_ns - header->start_monotonic_ns) / 1e9);
+  }
+  
+  int result = 0;
+  if (has_flag(flags, flag_count, FLAG_ALL) && reader.chunk_count > 0) {
+    uint32_t* chunk_words = malloc((size_t)header->chunk_words * sizeof(uint32_t));
+    if (chunk_words == NULL) {
+      fprintf(stderr, "Failed to allocate chunk buffer\n");
+      capture_reader_close(&reader);
+      return -1;
+    }
+    uint64_t bad_chunks = 0;
+    for (uint64_t chunk = 0; chunk < reader.chunk_count; chunk++) {
+      if (capture_reader_read_chunk(&reader, chunk, chunk_words, NULL) < 0) {
+        bad_chunks++;
+      }
+    }
+    printf("  Verified:        %llu/%llu chunks OK\n", reader.chunk_count - bad_chunks, reader.chunk_count);
+    free(chunk_words);
+    result = (bad_chunks == 0) ? 0 : -1;
+  }
+  
+  capture_reader_close(&reader);
+  return result;
+}
+
+// Benchmark the lossless ADC codec on synthetic data shaped like a slow capture
+int cmd_bench_adc_codec(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  uint64_t word_count = 1 << 20;
+  if (arg_count > 0) {
+    char* endptr;
+    word_count = parse_value(args[0], &endptr);
+    if (*endptr != '\0' || word_count == 0) {
+      fprintf(stderr, "Invalid word count for bench_adc_codec: '%s'. Must be a positive integer.\n", args[0]);
+      return -1;
+    }
+  }
+  
+  // Chunk-sized pieces, as the capture writer encodes them
+  size_t chunk_words = CAPTURE_ADC_CHUNK_WORDS;
+  uint32_t* words = malloc(word_count * sizeof(uint32_t));
+  uint32_t* decoded = malloc(word_count * sizeof(uint32_t));
+  uint8_t* encoded = malloc(ADC_CODEC_MAX_ENCODED_BYTES(chunk_words));
+  if (words == NULL || decoded == NULL || encoded == NULL) {
+    fprintf(stderr, "Failed to allocate benchmark buffers\n");
+    free(words);
+    free(decoded);
+    free(encoded);
+    return -1;
+  }
+  
+  // Offset-binary samples: a slow ramp per channel plus a few LSBs of noise
+  uint32_t state = 0x12345678;
+  for (uint64_t i = 0; i < word_count; i++) {
+    uint32_t halves[2];
+    for (int h = 0; h < 2; h++) {
+      uint64_t sample = 2 * i + h;
+      uint64_t frame = sample / 8;
+      int channel = (int)(sample % 8);
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+      int32_t value = 32767 + (int32_t)(((frame * (channel + 1)) / 64) % 4096) - 2048 + (int32_t)(state & 0xF) - 8;
+      halves[h] = (uint32_t)value & 0xFFFF;
+    }
+    words[i] = halves[0] | (halves[1] << 16);
+  }
+  
+  double encode_seconds = 0.0, decode_seconds = 0.0;
+  uint64_t encoded_bytes = 0;
+  bool lossless = true;
+  for (uint64_t start = 0; start < word_count; start += chunk_words) {
+    size_t count = (word_count - start < chunk_words) ? (size_t)(word_count - start) : chunk_words;
+    struct timespec t0, t1, t2;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    size_t bytes = adc_codec_encode(words + start, count, encoded);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    if (adc_codec_decode(encoded, bytes, decoded + start, count) != 0) {
+      lossless = false;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t2);
+    encode_seconds += (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+    decode_seconds += (t2.tv_sec - t1.tv_sec) + (t2.tv_nsec - t1.tv_nsec) / 1e9;
+    encoded_bytes += bytes;
+  }
+  if (memcmp(words, decoded, word_count * sizeof(uint32_t)) != 0) {
+    lossless = false;
+  }
+  
+  double raw_mb = word_count * sizeof(uint32_t) / 1e6;
+  printf("ADC codec: %llu words, %.2f MB -> %.2f MB (ratio %.2f)\n",
+         word_count, raw_mb, encoded_bytes / 1e6, raw_mb * 1e6 / encoded_bytes);
+  printf("  encode %8.1f MB/s, decode %8.1f MB/s, round trip %s\n",
+         raw_mb / encode_seconds, raw_mb / decode_seconds, lossless ? "lossless" : "MISMATCH");
+  
+  free(words);
+  free(decoded);
+  free(encoded);
+  return lossless ? 0 : -1;
+}
+
+// Benchmark the per-channel statistics against a two-pass reference
+int cmd_bench_adc_stats(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  uint64_t word_count = 1 << 22;
+  if (arg_count > 0) {
+    char* endptr;
+    word_count = parse_value(args[0], &endptr);
+    if (*endptr != '\0' || word_count == 0) {
+      fprintf(stderr, "Invalid word count for bench_adc_stats: '%s'. Must be a positive integer.\n", args[0]);
+      return -1;
+    }
+  }
+  
+  uint32_t* words = malloc(word_count * sizeof(uint32_t));
+  if (words == NULL) {
+    fprintf(stderr, "Failed to allocate benchmark buffer\n");
+    return -1;
+  }
+  
+  // Each channel gets its own offset and noise amplitude; channel 7 clips at both rails
+  uint32_t state = 0x12345678;
+  for (uint64_t i = 0; i < word_count; i++) {
+    uint32_t halves[2];
+    for (int h = 0; h < 2; h++) {
+      int channel = (int)((2 * i + h) % 8);
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+      int32_t noise = (int32_t)(state & 0xFFFF) - 32768;
+      int32_t value = (channel - 4) * 4000 + noise / (1 << (7 - channel));
+      if (value > INT16_MAX) value = INT16_MAX;
+      if (value < INT16_MIN) value = INT16_MIN;
+      halves[h] = (uint32_t)value & 0xFFFF;
+    }
+    words[i] = halves[0] | (halves[1] << 16);
+  }
+  
+  // Feed the statistics in writer-batch pieces with an odd split, as ring spans arrive
+  const uint8_t order[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+  adc_stats_t stats;
+  adc_stats_init(&stats, order);
+  struct timespec t0, t1;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (uint64_t start = 0; start < word_count; ) {
+    size_t count = ADC_STREAM_WRITE_BATCH_WORDCOUNT - 1;
+    if (word_count - start < count) count = (size_t)(word_count - start);
+    adc_stats_update(&stats, words + start, count);
+    start += count;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  double seconds = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+  
+  // Two-pass reference
+  double sum[8] = {0}, m2[8] = {0};
+  uint64_t count[8] = {0};
+  for (uint64_t i = 0; i < 2 * word_count; i++) {
+    int16_t sample = (int16_t)(words[i / 2] >> ((i % 2) * 16));
+    sum[i % 8] += sample;
+    count[i % 8]++;
+  }
+  for (uint64_t i = 0; i < 2 * word_count; i++) {
+    int16_t sample = (int16_t)(words[i / 2] >> ((i % 2) * 16));
+    double d = sample - sum[i % 8] / count[i % 8];
+    m2[i % 8] += d * d;
+  }
+  bool match = true;
+  for (int ch = 0; ch < 8; ch++) {
+    double mean = sum[ch] / count[ch];
+    double stddev = count[ch] > 1 ? sqrt(m2[ch] / (count[ch] - 1)) : 0.0;
+    if (stats.channel[ch].count != count[ch] ||
+        fabs(stats.channel[ch].mean - mean) > 1e-6 * (1.0 + fabs(mean)) ||
+        fabs(adc_channel_stats_stddev(&stats.channel[ch]) - stddev) > 1e-6 * (1.0 + stddev)) {
+      match = false;
+    }
+  }
+  
+  adc_stats_print(&stats, 0, "  ");
+  double samples_per_sec = 2.0 * word_count / seconds;
+  printf("ADC stats: %llu words in %.3f s, %.1f Msamples/s, reference %s\n",
+         word_count, seconds, samples_per_sec / 1e6, match ? "match" : "MISMATCH");
+  double max_words_per_sec = poll_max_rate_adc_data(ctx->sys_sts);
+  if (max_words_per_sec > 0.0) {
+    printf("  8 boards at full rate need %.1f Msamples/s (%.1f%% of this core)\n",
+           16.0 * max_words_per_sec / 1e6, 100.0 * 16.0 * max_words_per_sec / samples_per_sec);
+  }
+  
+  free(words);
+  return match ? 0 : -1;
+}
+
+// MMIO sink for bench_adc_cmd_stream: FIFO status reads report an empty FIFO,
+// writes are counted and hashed so both paths can be checked word for word
+static uint64_t bench_sink_reads;
+static uint64_t bench_sink_writes;
+static uint64_t bench_sink_hash;
+
+static uint32_t* bench_sink_map(uint32_t base_addr, size_t wordcount, const char* name, bool verbose) {
+  return NULL;
+}
+
+static uint32_t bench_sink_read32(volatile uint32_t* addr) {
+  bench_sink_reads++;
+  return 1u << 31; // FIFO present, 0 words used
+}
+
+static void bench_sink_write32(volatile uint32_t* addr, uint32_t value) {
+  bench_sink_writes++;
+  bench_sink_hash = (bench_sink_hash ^ value) * 0x100000001b3ULL;
+}
+
+static void bench_sink_write32_burst(volatile uint32_t* addr, const uint32_t* src, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    bench_sink_write32(addr, src[i]);
+  }
+}
+
+static const mmio_backend_t bench_sink_backend = {
+  .name = "bench-sink",
+  .map = bench_sink_map,
+  .read32 = bench_sink_read32,
+  .write32 = bench_sink_write32,
+  .read32_burst = NULL,
+  .write32_burst = bench_sink_write32_burst,
+};
+
+// Reset the sink counters
+static void bench_sink_reset(void) {
+  bench_sink_reads = 0;
+  bench_sink_writes = 0;
+  bench_sink_hash = 0xcbf29ce484222325ULL;
+}
+
+// Thread CPU time in seconds
+static double bench_cpu_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Benchmark the ADC command stream: per-command encoding and writes against
+// replay of the pre-encoded iteration in FIFO-sized bursts
+int cmd_bench_adc_cmd_stream(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  int iterations = 1000;
+  if (arg_count > 1) {
+    char* endptr;
+    iterations = (int)parse_value(args[1], &endptr);
+    if (*endptr != '\0' || iterations < 1) {
+      fprintf(stderr, "Invalid iteration count for bench_adc_cmd_stream: '%s'. Must be a positive integer.\n", args[1]);
+      return -1;
+    }
+  }
+  
+  // The sink replaces the MMIO backend for every thread while the benchmark runs
+  for (int board = 0; board < 8; board++) {
+    if (ctx->adc_cmd_stream_running[board] || ctx->adc_data_stream_running[board] ||
+        ctx->dac_cmd_stream_running[board]) {
+      fprintf(stderr, "bench_adc_cmd_stream cannot run while streams are active. Stop all streams first.\n");
+      return -1;
+    }
+  }
+  if (ctx->trig_data_stream_running || ctx->fieldmap_running) {
+    fprintf(stderr, "bench_adc_cmd_stream cannot run while streams are active. Stop all streams first.\n");
+    return -1;
+  }
+  
+  char resolved_path[1024];
+  if (resolve_file_pattern(args[0], resolved_path, sizeof(resolved_path)) != 0) {
+    return -1;
+  }
+  char full_path[1024];
+  clean_and_expand_path(resolved_path, full_path, sizeof(full_path));
+  
+  adc_command_t* commands = NULL;
+  int command_count = 0;
+  if (parse_adc_command_file(full_path, &commands, &command_count) != 0) {
+    return -1;
+  }
+  size_t word_count = 0;
+  uint32_t* words = encode_adc_commands(commands, command_count, &word_count);
+  if (words == NULL) {
+    free(commands);
+    return -1;
+  }
+  
+  const uint8_t board = 0;
+  uint8_t saved_order[8];
+  memcpy(saved_order, ctx->adc_ctrl->channel_order[board], sizeof(saved_order));
+  const mmio_backend_t* saved_backend = mmio_backend;
+  mmio_set_backend(&bench_sink_backend);
+  
+  // Per command: a status read, then encode and write the command
+  bench_sink_reset();
+  double t0 = bench_cpu_seconds();
+  for (int it = 0; it < iterations; it++) {
+    for (int i = 0; i < command_count; i++) {
+      adc_command_t* cmd = &commands[i];
+      uint32_t fifo_status = sys_sts_get_adc_cmd_fifo_status(ctx->sys_sts, board, false);
+      if (FIFO_PRESENT(fifo_status) == 0) continue;
+      switch (cmd->type) {
+        case ADC_TRIGGER_CMD:
+          adc_cmd_adc_rd(ctx->adc_ctrl, board, ADC_TRIGGER_WAIT, ADC_NO_CONTINUE, cmd->value, cmd->repeat_count, false);
+          break;
+        case ADC_DELAY_CMD:
+          adc_cmd_adc_rd(ctx->adc_ctrl, board, ADC_DELAY_WAIT, ADC_NO_CONTINUE, cmd->value, cmd->repeat_count, false);
+          break;
+        case ADC_ORDER_CMD:
+          adc_cmd_set_ord(ctx->adc_ctrl, board, cmd->order, false);
+          break;
+        case ADC_NOOP_TRIGGER_CMD:
+          adc_cmd_noop(ctx->adc_ctrl, board, ADC_TRIGGER_WAIT, ADC_NO_CONTINUE, cmd->value, false);
+          break;
+        case ADC_NOOP_DELAY_CMD:
+          adc_cmd_noop(ctx->adc_ctrl, board, ADC_DELAY_WAIT, ADC_NO_CONTINUE, cmd->value, false);
+          break;
+      }
+    }
+  }
+  double legacy_seconds = bench_cpu_seconds() - t0;
+  uint64_t legacy_reads = bench_sink_reads;
+  uint64_t legacy_writes = bench_sink_writes;
+  uint64_t legacy_hash = bench_sink_hash;
+  
+  // Replay: a status read per burst of whole commands
+  bench_sink_reset();
+  uint64_t bursts = 0;
+  t0 = bench_cpu_seconds();
+  for (int it = 0; it < iterations; it++) {
+    for (size_t pos = 0; pos < word_count; ) {
+      uint32_t fifo_status = sys_sts_get_adc_cmd_fifo_status(ctx->sys_sts, board, false);
+      uint32_t words_used = FIFO_STS_WORD_COUNT(fifo_status) + 1;
+      uint32_t run_commands;
+      long last_set_ord;
+      size_t run = adc_cmd_run(words, word_count, pos, ADC_CMD_FIFO_WORDCOUNT - words_used, &run_commands, &last_set_ord);
+      adc_write_burst(ctx->adc_ctrl, board, &words[pos], (uint32_t)run);
+      if (last_set_ord >= 0) {
+        adc_decode_set_ord(words[last_set_ord], ctx->adc_ctrl->channel_order[board]);
+      }
+      pos += run;
+      bursts++;
+    }
+  }
+  double replay_seconds = bench_cpu_seconds() - t0;
+  uint64_t replay_reads = bench_sink_reads;
+  uint64_t replay_writes = bench_sink_writes;
+  bool match = (bench_sink_hash == legacy_hash) && (replay_writes == legacy_writes);
+  
+  mmio_set_backend(saved_backend);
+  memcpy(ctx->adc_ctrl->channel_order[board], saved_order, sizeof(saved_order));
+  
+  printf("ADC command stream: %d commands, %zu words per iteration, %d iterations\n",
+         command_count, word_count, iterations);
+  printf("  Per command: %8.3f us/iteration, %llu status reads, %llu FIFO writes\n",
+         1e6 * legacy_seconds / iterations, legacy_reads, legacy_writes);
+  printf("  Replay:      %8.3f us/iteration, %llu status reads, %llu FIFO writes (%llu bursts)\n",
+         1e6 * replay_seconds / iterations, replay_reads, replay_writes, bursts);
+  if (replay_seconds > 0.0) {
+    printf("  Speedup: %.1fx, words %s\n", legacy_seconds / replay_seconds, match ? "match" : "MISMATCH");
+  } else {
+    printf("  Words %s\n", match ? "match" : "MISMATCH");
+  }
+  
+  free(words);
+  free(commands);
+  return match ? 0 : -1;
+}
@@ -0,0 +1,187 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "adc_stats.h"
+
+// Whole frames accumulated before folding into the channel statistics. Keeps the
+// integer sums exact: 65536 * 65535^2 < 2^48.
+#define ADC_STATS_BLOCK_FRAMES 65536
+
+// Per-slot integer accumulators for one block
+typedef struct {
+  int32_t shift[8];          // Subtracted from each sample before summing
+  int64_t sum[8];
+  int64_t sumsq[8];
+  int32_t min[8];
+  int32_t max[8];
+  uint32_t saturated[8];
+  uint32_t count[8];
+} adc_stats_block_t;
+
+// Start a block, shifting each slot by its channel's running mean
+static void block_begin(adc_stats_block_t* block, const adc_stats_t* stats) {
+  memset(block, 0, sizeof(*block));
+  for (int slot = 0; slot < 8; slot++) {
+    const adc_channel_stats_t* channel = &stats->channel[stats->order[slot]];
+    block->shift[slot] = (channel->count > 0) ? (int32_t)lrint(channel->mean) : 0;
+    block->min[slot] = ADC_STATS_SAMPLE_MAX;
+    block->max[slot] = ADC_STATS_SAMPLE_MIN;
+  }
+}
+
+// Add one sample to a slot (frame edges only)
+static void block_add_sample(adc_stats_block_t* block, int slot, int16_t sample) {
+  int32_t d = sample - block->shift[slot];
+  block->sum[slot] += d;
+  block->sumsq[slot] += (int64_t)d * d;
+  if (sample < block->min[slot]) block->min[slot] = sample;
+  if (sample > block->max[slot]) block->max[slot] = sample;
+  block->saturated[slot] += (sample == ADC_STATS_SAMPLE_MIN) | (sample == ADC_STATS_SAMPLE_MAX);
+  block->count[slot]++;
+}
+
+// Accumulate whole frames. The slot loop has a fixed width of 8 and no
+// cross-slot dependencies, so it vectorizes; samples are read as the
+// little-endian int16 pairs the FIFO words hold.
+static void block_add_frames(adc_stats_block_t* block, const uint32_t* words, size_t frames) {
+  int32_t shift[8], min[8], max[8];
+  int64_t sum[8], sumsq[8];
+  uint32_t saturated[8];
+  memcpy(shift, block->shift, sizeof(shift));
+  memcpy(min, block->min, sizeof(min));
+  memcpy(max, block->max, sizeof(max));
+  memcpy(sum, block->sum, sizeof(sum));
+  memcpy(sumsq, block->sumsq, sizeof(sumsq));
+  memcpy(saturated, block->saturated, sizeof(saturated));
+
+  for (size_t f = 0; f < frames; f++) {
+    int16_t samples[8];
+    memcpy(samples, &words[f * 4], sizeof(samples));
+    for (int slot = 0; slot < 8; slot++) {
+      int32_t s = samples[slot];
+      int32_t d = s - shift[slot];
+      sum[slot] += d;
+      sumsq[slot] += (int64_t)d * d;
+      min[slot] = (s < min[slot]) ? s : min[slot];
+      max[slot] = (s > max[slot]) ? s : max[slot];
+      saturated[slot] += (s == ADC_STATS_SAMPLE_MIN) | (s == ADC_STATS_SAMPLE_MAX);
+    }
+  }
+
+  memcpy(block->min, min, sizeof(min));
+  memcpy(block->max, max, sizeof(max));
+  memcpy(block->sum, sum, sizeof(sum));
+  memcpy(block->sumsq, sumsq, sizeof(sumsq));
+  memcpy(block->saturated, saturated, sizeof(saturated));
+  for (int slot = 0; slot < 8; slot++) {
+    block->count[slot] += (uint32_t)frames;
+  }
+}
+
+// Fold a block into the channel statistics (Chan et al. pairwise merge)
+static void block_fold(adc_stats_t* stats, const adc_stats_block_t* block) {
+  for (int slot = 0; slot < 8; slot++) {
+    if (block->count[slot] == 0) continue;
+    adc_channel_stats_t* channel = &stats->channel[stats->order[slot]];
+
+    double n_b = block->count[slot];
+    double sum = (double)block->sum[slot];
+    double mean_b = block->shift[slot] + sum / n_b;
+    double m2_b = (double)block->sumsq[slot] - sum * sum / n_b;
+    if (m2_b < 0.0) m2_b = 0.0;
+
+    if (channel->count == 0) {
+      channel->mean = mean_b;
+      channel->m2 = m2_b;
+      channel->min = (int16_t)block->min[slot];
+      channel->max = (int16_t)block->max[slot];
+    } else {
+      double n_a = (double)channel->count;
+      double n = n_a + n_b;
+      double delta = mean_b - channel->mean;
+      channel->mean += delta * n_b / n;
+      channel->m2 += m2_b + delta * delta * n_a * n_b / n;
+      if (block->min[slot] < channel->min) channel->min = (int16_t)block->min[slot];
+      if (block->max[slot] > channel->max) channel->max = (int16_t)block->max[slot];
+    }
+    channel->count += block->count[slot];
+    channel->saturated += block->saturated[slot];
+  }
+}
+
+// Reset statistics and set the channel order
+void adc_stats_init(adc_stats_t* stats, const uint8_t order[8]) {
+  memset(stats, 0, sizeof(*stats));
+  adc_stats_set_order(stats, order);
+}
+
+// Change the channel order for the following samples
+void adc_stats_set_order(adc_stats_t* stats, const uint8_t order[8]) {
+  for (int slot = 0; slot < 8; slot++) {
+    stats->order[slot] = order[slot] & 0x7;
+  }
+}
+
+// Accumulate a run of ADC data words
+void adc_stats_update(adc_stats_t* stats, const uint32_t* words, size_t count) {
+  if (count == 0) return;
+  adc_stats_block_t block;
+  block_begin(&block, stats);
+  stats->words += count;
+
+  // Finish a frame left open by the previous run
+  while (count > 0 && stats->slot != 0) {
+    block_add_sample(&block, stats->slot, (int16_t)(*words & 0xFFFF));
+    block_add_sample(&block, stats->slot + 1, (int16_t)(*words >> 16));
+    stats->slot = (stats->slot + 2) & 0x7;
+    words++;
+    count--;
+  }
+
+  // Whole frames, folded every ADC_STATS_BLOCK_FRAMES
+  size_t frames = count / 4;
+  while (frames > 0) {
+    size_t n = (frames > ADC_STATS_BLOCK_FRAMES) ? ADC_STATS_BLOCK_FRAMES : frames;
+    block_add_frames(&block, words, n);
+    words += n * 4;
+    count -= n * 4;
+    frames -= n;
+    if (frames > 0) {
+      block_fold(stats, &block);
+      block_begin(&block, stats);
+    }
+  }
+
+  // Start of the next frame
+  while (count > 0) {
+    block_add_sample(&block, stats->slot, (int16_t)(*words & 0xFFFF));
+    block_add_sample(&block, stats->slot + 1, (int16_t)(*words >> 16));
+    stats->slot = (stats->slot + 2) & 0x7;
+    words++;
+    count--;
+  }
+
+  block_fold(stats, &block);
+}
+
+// Sample standard deviation of a channel (0 with fewer than two samples)
+double adc_channel_stats_stddev(const adc_channel_stats_t* channel) {
+  return (channel->count > 1) ? sqrt(channel->m2 / (double)(channel->count - 1)) : 0.0;
+}
+
+// Print a per-channel table (channels numbered board * 8 + channel)
+void adc_stats_print(const adc_stats_t* stats, uint8_t board, const char* prefix) {
+  printf("%sChannel statistics over %llu words (order %d %d %d %d %d %d %d %d):\n",
+         prefix, stats->words,
+         stats->order[0], stats->order[1], stats->order[2], stats->order[3],
+         stats->order[4], stats->order[5], stats->order[6], stats->order[7]);
+  printf("%s  Ch   Samples        Mean     StdDev     Min     Max  Saturated\n", prefix);
+  for (int ch = 0; ch < 8; ch++) {
+    const adc_channel_stats_t* channel = &stats->channel[ch];
+    if (channel->count == 0) continue;
+    printf("%s  %02d %10llu %11.3f %10.3f %7d %7d %10llu\n",
+           prefix, board * 8 + ch, channel->count, channel->mean,
+           adc_channel_stats_stddev(channel), channel->min, channel->max,
+           channel->saturated);
+  }
+}
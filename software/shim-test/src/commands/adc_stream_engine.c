@@ -0,0 +1,732 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "adc_stream_engine.h"
+#include "adc_ascii.h"
+#include "adc_codec.h"
+#include "sys_sts.h"
+#include "adc_ctrl.h"
+#include "rt_profile.h"
+#include "sts_sampler.h"
+#include "metrics.h"
+#include "trace.h"
+
+// Seconds between two CLOCK_MONOTONIC timestamps
+static double elapsed_seconds(const struct timespec* start, const struct timespec* end) {
+  return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+//////////////////// Sinks ////////////////////
+
+// Write ADC words as text with fprintf, 8 samples per line (samples_on_line carries across calls; returns bytes written or -1)
+int64_t adc_fprintf_ascii_words(FILE* file, const uint32_t* words, size_t count, int* samples_on_line) {
+  int64_t written = 0;
+  for (size_t i = 0; i < count; i++) {
+    uint32_t word = words[i];
+
+    // Extract two 16-bit samples from the 32-bit word
+    int16_t samples[2] = {
+      (int16_t)(word & 0xFFFF),         // Bits 15:0
+      (int16_t)((word >> 16) & 0xFFFF)  // Bits 31:16
+    };
+
+    for (int s = 0; s < 2; s++) {
+      if (*samples_on_line > 0) {
+        written += fprintf(file, " ");
+      }
+      written += fprintf(file, "%d", samples[s]);
+      (*samples_on_line)++;
+
+      // Check if we need a new line
+      if (*samples_on_line >= 8) {
+        written += fprintf(file, "\n");
+        *samples_on_line = 0;
+      }
+    }
+  }
+  return ferror(file) ? -1 : written;
+}
+
+// Write ADC words as text through the table-driven formatter, one fwrite per chunk (returns bytes written or -1)
+int64_t adc_write_ascii_words(FILE* file, char* text_buffer, const uint32_t* words, size_t count, int* samples_on_line) {
+  int64_t written = 0;
+  while (count > 0) {
+    size_t chunk = count < ADC_STREAM_TEXT_CHUNK_WORDCOUNT ? count : ADC_STREAM_TEXT_CHUNK_WORDCOUNT;
+    size_t bytes = adc_ascii_format_words(text_buffer, words, chunk, samples_on_line);
+    if (fwrite(text_buffer, 1, bytes, file) != bytes) {
+      return -1;
+    }
+    written += (int64_t)bytes;
+    words += chunk;
+    count -= chunk;
+  }
+  return written;
+}
+
+// Write full capture chunks from the ring, plus the final partial chunk once the drain is done
+static void write_capture_chunks(adc_stream_session_t* session, bool drain_done) {
+  size_t chunk_words = session->capture.header.chunk_words;
+  size_t used;
+
+  while (!session->write_error && (used = spsc_ring_used(&session->ring)) > 0) {
+    if (used < chunk_words && !drain_done) {
+      break; // Only the last chunk may be short
+    }
+    size_t count = (used < chunk_words) ? used : chunk_words;
+    uint32_t* first;
+    size_t first_count = spsc_ring_read_span(&session->ring, &first);
+    if (first_count > count) first_count = count;
+    adc_stats_update(&session->stats, first, first_count);
+    adc_stats_update(&session->stats, session->ring.buffer, count - first_count);
+    // A chunk that crosses the end of the ring continues at its start
+    if (capture_writer_write_chunk(&session->capture, first, first_count,
+                                   session->ring.buffer, count - first_count) < 0) {
+      session->write_error = true;
+    }
+    spsc_ring_release(&session->ring, count);
+    session->words_written += count;
+  }
+}
+
+// Copy a session's channel statistics to the engine, where commands can read them
+static void publish_stats(adc_stream_engine_t* engine, adc_stream_session_t* session) {
+  pthread_mutex_lock(&engine->lock);
+  engine->board_stats[session->board] = session->stats;
+  engine->board_stats_valid[session->board] = true;
+  pthread_mutex_unlock(&engine->lock);
+}
+
+// Move one session's ring into its file if a batch is ready; returns true if anything was written
+static bool write_session(adc_stream_engine_t* engine, adc_stream_session_t* session, bool drain_done) {
+  size_t used = spsc_ring_used(&session->ring);
+  if (used == 0) {
+    return false;
+  }
+
+  // Wait for a full batch unless the drain is finished or data has waited too long
+  // (chunked captures always wait for a full chunk so chunk sizes stay fixed)
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  double waited_ms = elapsed_seconds(&session->last_write, &now) * 1e3;
+  if (session->chunked) {
+    if (used < session->capture.header.chunk_words && !drain_done) {
+      return false;
+    }
+  } else if (used < ADC_STREAM_WRITE_BATCH_WORDCOUNT && !drain_done && waited_ms < ADC_STREAM_WRITE_MAX_LATENCY_MS) {
+    return false;
+  }
+
+  TRACE_BEGIN(trace_write_ns);
+
+  // Samples are attributed with the order in effect when they are written
+  if (memcmp(session->stats.order, session->channel_order, sizeof(session->stats.order)) != 0) {
+    adc_stats_set_order(&session->stats, session->channel_order);
+  }
+
+  uint32_t* span;
+  size_t span_words;
+  uint64_t batch_bytes = 0;    // Bytes this batch added to the file (write metrics)
+  if (session->chunked) {
+    uint64_t offset_before = session->capture.file_offset;
+    write_capture_chunks(session, drain_done);
+    batch_bytes = session->capture.file_offset - offset_before;
+  } else {
+    // Write everything available (at most two contiguous spans around the wrap)
+    while (!session->write_error && (span_words = spsc_ring_read_span(&session->ring, &span)) > 0) {
+      adc_stats_update(&session->stats, span, span_words);
+      int64_t span_bytes;
+      if (session->binary_mode) {
+        // Binary mode: write raw 32-bit words directly
+        span_bytes = (fwrite(span, sizeof(uint32_t), span_words, session->file) == span_words)
+                     ? (int64_t)(span_words * sizeof(uint32_t)) : -1;
+      } else if (session->fprintf_ascii) {
+        span_bytes = adc_fprintf_ascii_words(session->file, span, span_words, &session->samples_on_line);
+      } else {
+        span_bytes = adc_write_ascii_words(session->file, session->text_buffer, span, span_words, &session->samples_on_line);
+      }
+      if (span_bytes < 0) {
+        session->write_error = true;
+      } else {
+        batch_bytes += (uint64_t)span_bytes;
+      }
+      spsc_ring_release(&session->ring, span_words);
+      session->words_written += span_words;
+    }
+  }
+
+  // Flush once per batch so the file stays current without a syscall per chunk
+  fflush(session->file);
+  TRACE_END(trace_write_ns, TRACE_FILE_WRITE, POLL_STREAM_ADC_DATA, session->board, (uint32_t)used);
+  session->write_batches++;
+  clock_gettime(CLOCK_MONOTONIC, &session->last_write);
+  publish_stats(engine, session);
+
+  metrics_writer_record(metrics_writer(METRICS_WRITER_ADC, session->board), batch_bytes,
+                        (uint64_t)(elapsed_seconds(&now, &session->last_write) * 1e9));
+
+  if (session->write_error) {
+    fprintf(stderr, "ADC Data Stream[%d]: Failed to write to file: %s\n",
+            session->board, strerror(errno));
+    // Keep consuming so the drain never stalls on a dead file
+    while ((span_words = spsc_ring_read_span(&session->ring, &span)) > 0) {
+      spsc_ring_release(&session->ring, span_words);
+    }
+  }
+  return true;
+}
+
+//////////////////// Sessions ////////////////////
+
+// Free a session and everything it owns (the file must already be closed)
+static void free_session(adc_stream_session_t* session) {
+  free(session->text_buffer);
+  free(session->file_buffer);
+  spsc_ring_free(&session->ring);
+  free(session);
+}
+
+// Finish a drained session: close its file and report, then detach it from the engine
+static void retire_session(adc_stream_engine_t* engine, adc_stream_session_t* session) {
+  command_context_t* ctx = engine->ctx;
+  uint8_t board = session->board;
+
+  if (session->chunked) {
+    // Command file metadata is refreshed in case the command stream started after the data stream
+    capture_file_header_t* header = &session->capture.header;
+    memcpy(header->channel_order, ctx->adc_ctrl->channel_order[board], sizeof(header->channel_order));
+    header->cmd_file_hash = ctx->adc_cmd_file_hash[board];
+    header->words_per_iteration = ctx->adc_cmd_words_per_iteration[board];
+    snprintf(header->cmd_file_path, sizeof(header->cmd_file_path), "%s", ctx->adc_cmd_file_path[board]);
+    if (session->compress && session->capture.stored_bytes > 0) {
+      printf("ADC Data Stream[%d]: Compressed %.2f MB to %.2f MB (ratio %.2f), encoder %.1f MB/s\n",
+             board, session->capture.raw_bytes / 1e6, session->capture.stored_bytes / 1e6,
+             (double)session->capture.raw_bytes / session->capture.stored_bytes,
+             session->capture.encode_seconds > 0.0 ? session->capture.raw_bytes / session->capture.encode_seconds / 1e6 : 0.0);
+    }
+    capture_writer_close(&session->capture);
+  }
+
+  // Add final newline if needed (ASCII mode only, if last line has samples but isn't complete)
+  if (!session->binary_mode && session->samples_on_line > 0) {
+    fprintf(session->file, "\n");
+  }
+  fclose(session->file);
+
+  if (*(session->should_stop)) {
+    printf("ADC Data Stream[%d]: Stream stopped by user after writing %llu words\n",
+           board, session->words_written);
+  } else {
+    printf("ADC Data Stream[%d]: Stream completed, wrote %llu words to file '%s'\n",
+           board, session->words_written, session->file_path);
+  }
+  double elapsed_sec = elapsed_seconds(&session->start_time, &session->end_time);
+  if (elapsed_sec > 0.0) {
+    printf("ADC Data Stream[%d]: %.0f words/s over %.3f s (%llu bursts, %.1f words/burst, %llu status polls)\n",
+           board, session->words_drained / elapsed_sec, elapsed_sec, session->bursts,
+           session->bursts > 0 ? (double)session->words_drained / session->bursts : 0.0, session->status_polls);
+  }
+  printf("ADC Data Stream[%d]: Ring high-water %zu/%zu words (%.1f%%), %llu ring-full stalls, %llu file writes\n",
+         board, session->ring.high_water, session->ring.capacity,
+         100.0 * session->ring.high_water / session->ring.capacity,
+         session->ring.full_stalls, session->write_batches);
+  char prefix[48];
+  snprintf(prefix, sizeof(prefix), "ADC Data Stream[%d]: ", board);
+  poll_stats_print(prefix, &session->poll.stats);
+  poll_sched_finish(&session->poll);
+  if (session->almost_full_services > 0 || session->full_services > 0) {
+    printf("ADC Data Stream[%d]: FIFO almost full on %llu services, full on %llu\n",
+           board, session->almost_full_services, session->full_services);
+  }
+  if (session->stats.words > 0) {
+    adc_stats_print(&session->stats, board, prefix);
+  }
+
+  pthread_mutex_lock(&engine->lock);
+  engine->sessions[board] = NULL;
+  engine->active_count--;
+  ctx->adc_data_stream_running[board] = false;
+  pthread_cond_broadcast(&engine->session_retired);
+  pthread_mutex_unlock(&engine->lock);
+
+  free_session(session);
+}
+
+// Mark a session's drain finished; the drain thread never touches it again
+static void finish_drain(adc_stream_session_t* session) {
+  clock_gettime(CLOCK_MONOTONIC, &session->end_time);
+  atomic_store_explicit(&session->drain_done, true, memory_order_release);
+}
+
+//////////////////// Engine threads ////////////////////
+
+// Publish the drain thread's counters for status output (engine->lock held)
+static void publish_drain_status(adc_stream_engine_t* engine) {
+  engine->status.passes = engine->passes;
+  engine->status.idle_sleeps = engine->idle_sleeps;
+  engine->status.status_polls = engine->status_polls;
+  engine->status.words_drained = engine->words_drained;
+  engine->status.poll = engine->poll.stats;
+  for (int board = 0; board < 8; board++) {
+    adc_stream_session_t* session = engine->sessions[board];
+    if (session == NULL) continue;
+    session->status.words_drained = session->words_drained;
+    session->status.bursts = session->bursts;
+    session->status.almost_full_services = session->almost_full_services;
+    session->status.full_services = session->full_services;
+  }
+}
+
+// Drain thread: one status sweep per pass, then burst the FIFOs most-full first
+static void* drain_thread(void* arg) {
+  adc_stream_engine_t* engine = (adc_stream_engine_t*)arg;
+  command_context_t* ctx = engine->ctx;
+  adc_stream_session_t* polled[8];   // Sessions still draining (NULL once finished this pass)
+  TRACE_THREAD("adc_drain");
+  int draining[8];                   // Indexes into polled[] of FIFOs with data, most urgent first
+  uint32_t fill[8];
+  bool almost_full[8];
+
+  while (true) {
+    // Collect the sessions still draining (sleep while there are none)
+    int count = 0;
+    pthread_mutex_lock(&engine->lock);
+    publish_drain_status(engine);
+    while (true) {
+      count = 0;
+      for (int board = 0; board < 8; board++) {
+        adc_stream_session_t* session = engine->sessions[board];
+        if (session != NULL && !atomic_load_explicit(&session->drain_done, memory_order_relaxed)) {
+          polled[count++] = session;
+        }
+      }
+      if (count > 0 || engine->shutdown) break;
+      pthread_cond_wait(&engine->wake, &engine->lock);
+    }
+    pthread_mutex_unlock(&engine->lock);
+    if (count == 0) break; // Shutdown with nothing left to drain
+
+    // Read each FIFO's fill level once
+    int ready = 0;
+    for (int i = 0; i < count; i++) {
+      adc_stream_session_t* session = polled[i];
+      if (*(session->should_stop) || session->words_drained >= session->word_count) {
+        finish_drain(session);
+        polled[i] = NULL; // The writer may retire it from here on
+        continue;
+      }
+
+      TRACE_BEGIN(trace_poll_ns);
+      uint32_t data_status = sts_sampler_word(ctx->sys_sts, ADC_DATA_FIFO_STS_OFFSET(session->board),
+                                              session->sts_not_before_ns);
+      TRACE_END(trace_poll_ns, TRACE_FIFO_POLL, POLL_STREAM_ADC_DATA, session->board, FIFO_STS_WORD_COUNT(data_status));
+      session->status_polls++;
+      engine->status_polls++;
+      if (FIFO_PRESENT(data_status) == 0) {
+        fprintf(stderr, "ADC Data Stream[%d]: Data FIFO not present, stopping stream\n", session->board);
+        finish_drain(session);
+        polled[i] = NULL;
+        continue;
+      }
+
+      uint32_t words_available = FIFO_STS_WORD_COUNT(data_status);
+      poll_sched_observe(&session->poll, words_available, 1);
+      session->fifo_level = words_available;
+      session->ring_full = false;
+      if (words_available == 0) {
+        continue;
+      }
+      if (FIFO_STS_FULL(data_status)) session->full_services++;
+      if (FIFO_STS_ALMOST_FULL(data_status)) session->almost_full_services++;
+
+      // Insert by urgency: almost-full FIFOs first, then by fill level
+      int pos = ready++;
+      bool urgent = FIFO_STS_ALMOST_FULL(data_status);
+      while (pos > 0 && (urgent > almost_full[pos - 1] ||
+                         (urgent == almost_full[pos - 1] && words_available > fill[pos - 1]))) {
+        draining[pos] = draining[pos - 1];
+        fill[pos] = fill[pos - 1];
+        almost_full[pos] = almost_full[pos - 1];
+        pos--;
+      }
+      draining[pos] = i;
+      fill[pos] = words_available;
+      almost_full[pos] = urgent;
+    }
+    engine->passes++;
+
+    // Burst each ready FIFO into its ring, most urgent first
+    uint64_t pass_words = 0;
+    for (int i = 0; i < ready; i++) {
+      adc_stream_session_t* session = polled[draining[i]];
+      uint64_t words_to_read = fill[i];
+      if (session->words_drained + words_to_read > session->word_count) {
+        words_to_read = session->word_count - session->words_drained;
+      }
+
+      // Burst straight into the ring (two spans if the burst crosses the wrap)
+      while (words_to_read > 0) {
+        uint32_t* span;
+        size_t span_words = spsc_ring_write_span(&session->ring, &span);
+        if (span_words == 0) {
+          session->ring_full = true;
+          break; // Ring full: leave the rest in the FIFO until the writer catches up
+        }
+        if (span_words > words_to_read) span_words = (size_t)words_to_read;
+        if (span_words > ADC_STREAM_BURST_WORDCOUNT) span_words = ADC_STREAM_BURST_WORDCOUNT;
+
+        TRACE_BEGIN(trace_read_ns);
+        adc_read_burst(ctx->adc_ctrl, session->board, span, (uint32_t)span_words);
+        TRACE_END(trace_read_ns, TRACE_FIFO_READ, POLL_STREAM_ADC_DATA, session->board, (uint32_t)span_words);
+        spsc_ring_commit(&session->ring, span_words);
+        poll_sched_consumed(&session->poll, (uint32_t)span_words);
+        session->fifo_level -= (uint32_t)span_words;
+        words_to_read -= span_words;
+        session->words_drained += span_words;
+        session->bursts++;
+        pass_words += span_words;
+        session->sts_not_before_ns = sts_sampler_now_ns();
+      }
+
+      if (*(ctx->verbose) && session->words_drained >= session->next_progress_report) {
+        printf("ADC Data Stream[%d]: Drained %llu/%llu words (%.1f%%)\n",
+               session->board, session->words_drained, session->word_count,
+               (double)session->words_drained / session->word_count * 100.0);
+        session->next_progress_report = (session->words_drained / 10000 + 1) * 10000;
+      }
+      if (session->words_drained >= session->word_count) {
+        finish_drain(session);
+        polled[draining[i]] = NULL;
+      }
+    }
+    engine->words_drained += pass_words;
+    if (pass_words == 0) {
+      engine->idle_sleeps++;
+    }
+
+    // Sleep until the first board is predicted to reach its batch target
+    uint64_t sleep_ns = UINT64_MAX;
+    for (int i = 0; i < count; i++) {
+      adc_stream_session_t* session = polled[i];
+      if (session == NULL) {
+        continue;
+      }
+      uint64_t eta_ns = session->ring_full ? ADC_STREAM_RING_FULL_RETRY_NS
+                                           : poll_sched_predict_ns(&session->poll, session->fifo_level, 1);
+      if (eta_ns < sleep_ns) {
+        sleep_ns = eta_ns;
+      }
+    }
+    if (sleep_ns != UINT64_MAX) {
+      poll_sched_sleep_ns(&engine->poll, sleep_ns);
+    }
+  }
+  return NULL;
+}
+
+// Writer thread: services every session's ring and retires sessions whose drain is done
+static void* writer_thread(void* arg) {
+  adc_stream_engine_t* engine = (adc_stream_engine_t*)arg;
+  adc_stream_session_t* sessions[8];
+  TRACE_THREAD("adc_writer");
+
+  while (true) {
+    int count = 0;
+    pthread_mutex_lock(&engine->lock);
+    while (engine->active_count == 0 && !engine->shutdown) {
+      pthread_cond_wait(&engine->wake, &engine->lock);
+    }
+    if (engine->active_count == 0) {
+      pthread_mutex_unlock(&engine->lock);
+      break; // Shutdown with nothing left to write
+    }
+    for (int board = 0; board < 8; board++) {
+      if (engine->sessions[board] != NULL) {
+        sessions[count++] = engine->sessions[board];
+        engine->sessions[board]->status.words_written = engine->sessions[board]->words_written;
+      }
+    }
+    pthread_mutex_unlock(&engine->lock);
+
+    bool busy = false;
+    for (int i = 0; i < count; i++) {
+      // Read drain_done before the ring so the final commit is visible
+      bool drain_done = atomic_load_explicit(&sessions[i]->drain_done, memory_order_acquire);
+      busy |= write_session(engine, sessions[i], drain_done);
+      if (drain_done && spsc_ring_used(&sessions[i]->ring) == 0) {
+        retire_session(engine, sessions[i]);
+        busy = true;
+      }
+    }
+    if (!busy) {
+      usleep(ADC_STREAM_WRITER_IDLE_US);
+    }
+  }
+  return NULL;
+}
+
+// Create the engine and start its threads
+static adc_stream_engine_t* create_engine(command_context_t* ctx) {
+  adc_stream_engine_t* engine = calloc(1, sizeof(adc_stream_engine_t));
+  if (engine == NULL) {
+    fprintf(stderr, "ADC Stream Engine: Failed to allocate engine\n");
+    return NULL;
+  }
+  engine->ctx = ctx;
+  poll_sched_init(&engine->poll, POLL_STREAM_ADC_DATA, 0, 0.0);
+  pthread_mutex_init(&engine->lock, NULL);
+  pthread_cond_init(&engine->wake, NULL);
+  pthread_cond_init(&engine->session_retired, NULL);
+
+  if (rt_thread_create(&engine->drain_thread, RT_CLASS_DRAIN, drain_thread, engine) != 0) {
+    fprintf(stderr, "ADC Stream Engine: Failed to create drain thread: %s\n", strerror(errno));
+    free(engine);
+    return NULL;
+  }
+  if (rt_thread_create(&engine->writer_thread, RT_CLASS_WRITER, writer_thread, engine) != 0) {
+    fprintf(stderr, "ADC Stream Engine: Failed to create writer thread: %s\n", strerror(errno));
+    pthread_mutex_lock(&engine->lock);
+    engine->shutdown = true;
+    pthread_cond_broadcast(&engine->wake);
+    pthread_mutex_unlock(&engine->lock);
+    pthread_join(engine->drain_thread, NULL);
+    free(engine);
+    return NULL;
+  }
+  if (*(ctx->verbose)) {
+    printf("ADC Stream Engine: Started drain and writer threads\n");
+  }
+  return engine;
+}
+
+//////////////////// Public interface ////////////////////
+
+// Start streaming a board through the engine (creates the engine on first use)
+int adc_stream_engine_start_session(command_context_t* ctx, const adc_data_stream_params_t* params) {
+  uint8_t board = params->board;
+  bool verbose = *(ctx->verbose);
+
+  if (ctx->adc_stream_engine == NULL) {
+    ctx->adc_stream_engine = create_engine(ctx);
+    if (ctx->adc_stream_engine == NULL) {
+      return -1;
+    }
+  }
+  adc_stream_engine_t* engine = ctx->adc_stream_engine;
+
+  adc_stream_session_t* session = calloc(1, sizeof(adc_stream_session_t));
+  if (session == NULL || spsc_ring_init(&session->ring, ADC_STREAM_RING_WORDCOUNT) != 0) {
+    fprintf(stderr, "ADC Data Stream[%d]: Failed to allocate stream ring buffer\n", board);
+    free(session);
+    return -1;
+  }
+  rt_prefault(session->ring.buffer, session->ring.capacity * sizeof(uint32_t));
+  session->board = board;
+  snprintf(session->file_path, sizeof(session->file_path), "%s", params->file_path);
+  session->binary_mode = params->binary_mode;
+  session->fprintf_ascii = params->fprintf_ascii;
+  session->chunked = params->chunked;
+  session->compress = params->compress;
+  session->word_count = params->word_count;
+  session->should_stop = params->should_stop;
+  session->next_progress_report = 10000;
+  poll_sched_init(&session->poll, POLL_STREAM_ADC_DATA, ADC_DATA_FIFO_WORDCOUNT, poll_max_rate_adc_data(ctx->sys_sts));
+  poll_sched_track(&session->poll, board);
+  session->channel_order = ctx->adc_ctrl->channel_order[board];
+  adc_stats_init(&session->stats, session->channel_order);
+  atomic_init(&session->drain_done, false);
+
+  if (verbose) {
+    printf("ADC Data Stream[%d]: Starting to write %llu words to file '%s' (%s format)\n",
+           board, session->word_count, session->file_path,
+           session->compress ? "compressed chunked binary" : session->chunked ? "chunked binary" :
+           session->binary_mode ? "binary" : (session->fprintf_ascii ? "ASCII, fprintf" : "ASCII"));
+  }
+
+  if (!session->binary_mode && !session->fprintf_ascii) {
+    session->text_buffer = malloc(ADC_STREAM_TEXT_CHUNK_WORDCOUNT * ADC_ASCII_MAX_BYTES_PER_WORD);
+    if (session->text_buffer == NULL) {
+      fprintf(stderr, "ADC Data Stream[%d]: Failed to allocate text buffer\n", board);
+      free_session(session);
+      return -1;
+    }
+  }
+
+  // Open file for writing (binary or text mode based on format)
+  session->file = capture_file_open(session->file_path, session->binary_mode ? "wb" : "w");
+  if (session->file == NULL) {
+    fprintf(stderr, "ADC Data Stream[%d]: Failed to open file '%s' for writing: %s\n",
+            board, session->file_path, strerror(errno));
+    free_session(session);
+    return -1;
+  }
+
+  // Large stdio buffer so ASCII output reaches the disk in big sequential writes
+  session->file_buffer = malloc(ADC_STREAM_FILE_BUFFER_SIZE);
+  if (session->file_buffer != NULL) {
+    setvbuf(session->file, session->file_buffer, _IOFBF, ADC_STREAM_FILE_BUFFER_SIZE);
+  }
+
+  if (session->chunked) {
+    // Describe the capture; command file metadata is refreshed when the session retires
+    capture_file_header_t header;
+    capture_header_init(&header, CAPTURE_STREAM_ADC, board, CAPTURE_ADC_CHUNK_WORDS);
+    header.codec = session->compress ? ADC_CODEC_DELTA_PACK : ADC_CODEC_NONE;
+    memcpy(header.channel_order, ctx->adc_ctrl->channel_order[board], sizeof(header.channel_order));
+    header.spi_clk_freq_hz = sys_sts_get_spi_clk_freq_hz(ctx->sys_sts, false);
+    header.cmd_file_hash = ctx->adc_cmd_file_hash[board];
+    header.words_per_iteration = ctx->adc_cmd_words_per_iteration[board];
+    snprintf(header.cmd_file_path, sizeof(header.cmd_file_path), "%s", ctx->adc_cmd_file_path[board]);
+    if (capture_writer_open(&session->capture, session->file, &header) != 0) {
+      fprintf(stderr, "ADC Data Stream[%d]: Failed to start chunked capture\n", board);
+      fclose(session->file);
+      free_session(session);
+      return -1;
+    }
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &session->start_time);
+  session->last_write = session->start_time;
+
+  // Hand the session to the engine threads
+  pthread_mutex_lock(&engine->lock);
+  engine->board_stats[board] = session->stats;
+  engine->board_stats_valid[board] = true;
+  engine->sessions[board] = session;
+  engine->active_count++;
+  pthread_cond_broadcast(&engine->wake);
+  pthread_mutex_unlock(&engine->lock);
+  return 0;
+}
+
+// Signal a board's stream to stop and wait until its file is closed
+void adc_stream_engine_stop_session(command_context_t* ctx, uint8_t board) {
+  adc_stream_engine_t* engine = ctx->adc_stream_engine;
+  ctx->adc_data_stream_stop[board] = true;
+  if (engine == NULL) {
+    return;
+  }
+
+  pthread_mutex_lock(&engine->lock);
+  while (engine->sessions[board] != NULL) {
+    pthread_cond_wait(&engine->session_retired, &engine->lock);
+  }
+  pthread_mutex_unlock(&engine->lock);
+}
+
+// Stop all streams and the engine threads (call once at exit)
+void adc_stream_engine_shutdown(command_context_t* ctx) {
+  adc_stream_engine_t* engine = ctx->adc_stream_engine;
+  if (engine == NULL) {
+    return;
+  }
+
+  for (int board = 0; board < 8; board++) {
+    adc_stream_engine_stop_session(ctx, (uint8_t)board);
+  }
+
+  pthread_mutex_lock(&engine->lock);
+  engine->shutdown = true;
+  pthread_cond_broadcast(&engine->wake);
+  pthread_mutex_unlock(&engine->lock);
+  pthread_join(engine->drain_thread, NULL);
+  pthread_join(engine->writer_thread, NULL);
+  poll_sched_finish(&engine->poll);
+
+  pthread_cond_destroy(&engine->session_retired);
+  pthread_cond_destroy(&engine->wake);
+  pthread_mutex_destroy(&engine->lock);
+  free(engine);
+  ctx->adc_stream_engine = NULL;
+}
+
+// Print engine and per-board stream statistics
+void adc_stream_engine_print_status(command_context_t* ctx) {
+  adc_stream_engine_t* engine = ctx->adc_stream_engine;
+  if (engine == NULL) {
+    printf("ADC stream engine not started (no ADC data stream since launch).\n");
+    return;
+  }
+
+  // Copy the published counters under the lock, print outside it so the drain is never held up by the terminal
+  int active_count;
+  adc_stream_engine_status_t status;
+  bool live[8];
+  adc_stream_session_status_t sessions[8];
+  uint64_t word_count[8];
+  size_t ring_used[8];
+  size_t ring_capacity[8];
+  bool drain_done[8];
+  pthread_mutex_lock(&engine->lock);
+  active_count = engine->active_count;
+  status = engine->status;
+  for (int board = 0; board < 8; board++) {
+    adc_stream_session_t* session = engine->sessions[board];
+    live[board] = (session != NULL);
+    if (session == NULL) continue;
+    sessions[board] = session->status;
+    word_count[board] = session->word_count;
+    ring_used[board] = spsc_ring_used(&session->ring);
+    ring_capacity[board] = session->ring.capacity;
+    drain_done[board] = atomic_load(&session->drain_done);
+  }
+  pthread_mutex_unlock(&engine->lock);
+
+  printf("ADC stream engine: %d active stream(s)\n", active_count);
+  printf("  Drain passes:  %llu (%llu idle, %.1f%%)\n", status.passes, status.idle_sleeps,
+         status.passes > 0 ? 100.0 * status.idle_sleeps / status.passes : 0.0);
+  printf("  Status polls:  %llu\n", status.status_polls);
+  poll_stats_print("  Between passes: ", &status.poll);
+  printf("  Words drained: %llu\n", status.words_drained);
+  for (int board = 0; board < 8; board++) {
+    if (!live[board]) continue;
+    printf("  Board %d: %llu/%llu words drained, %llu written, ring %zu/%zu words, "
+           "%llu bursts, almost full %llu, full %llu%s\n",
+           board, sessions[board].words_drained, word_count[board], sessions[board].words_written,
+           ring_used[board], ring_capacity[board], sessions[board].bursts,
+           sessions[board].almost_full_services, sessions[board].full_services,
+           drain_done[board] ? " (draining done, writing)" : "");
+  }
+}
+
+// Print per-channel statistics of a board's current or last stream (board -1 = all boards)
+int adc_stream_engine_print_channel_stats(command_context_t* ctx, int board) {
+  adc_stream_engine_t* engine = ctx->adc_stream_engine;
+  if (engine == NULL) {
+    printf("No ADC channel statistics (no ADC data stream since launch).\n");
+    return 0;
+  }
+
+  // Copy under the lock, print outside it so the writer is never held up by the terminal
+  adc_stats_t stats[8];
+  bool valid[8];
+  bool live[8];
+  pthread_mutex_lock(&engine->lock);
+  memcpy(stats, engine->board_stats, sizeof(stats));
+  memcpy(valid, engine->board_stats_valid, sizeof(valid));
+  for (int b = 0; b < 8; b++) {
+    live[b] = (engine->sessions[b] != NULL);
+  }
+  pthread_mutex_unlock(&engine->lock);
+
+  int printed = 0;
+  for (int b = 0; b < 8; b++) {
+    if ((board >= 0 && b != board) || !valid[b]) continue;
+    char prefix[48];
+    snprintf(prefix, sizeof(prefix), "Board %d (%s): ", b, live[b] ? "streaming" : "last stream");
+    adc_stats_print(&stats[b], (uint8_t)b, prefix);
+    printed++;
+  }
+  if (printed == 0) {
+    if (board >= 0) {
+      printf("No ADC channel statistics for board %d.\n", board);
+    } else {
+      printf("No ADC channel statistics.\n");
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,494 @@
+#define _FILE_OFFSET_BITS 64  // Captures can exceed 2 GB on the 32-bit Zynq
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include "capture_file.h"
+#include "adc_codec.h"
+
+_Static_assert(sizeof(capture_file_header_t) == CAPTURE_HEADER_SIZE, "capture header size");
+_Static_assert(sizeof(capture_chunk_header_t) == 40, "capture chunk header size");
+
+//////////////////// CRC-32 ////////////////////
+
+// Slice-by-4 tables for the reflected IEEE polynomial
+static uint32_t crc_table[4][256];
+static pthread_once_t crc_table_once = PTHREAD_ONCE_INIT;
+
+static void crc_table_init(void) {
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t c = i;
+    for (int k = 0; k < 8; k++) {
+      c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+    }
+    crc_table[0][i] = c;
+  }
+  for (uint32_t i = 0; i < 256; i++) {
+    for (int t = 1; t < 4; t++) {
+      crc_table[t][i] = (crc_table[t - 1][i] >> 8) ^ crc_table[0][crc_table[t - 1][i] & 0xFF];
+    }
+  }
+}
+
+// CRC-32 over len bytes, continuing from crc (start with 0)
+uint32_t capture_crc32(uint32_t crc, const void* data, size_t len) {
+  pthread_once(&crc_table_once, crc_table_init);
+  const uint8_t* p = (const uint8_t*)data;
+  crc = ~crc;
+
+  // Four bytes per step once aligned
+  while (len > 0 && ((uintptr_t)p & 3) != 0) {
+    crc = crc_table[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    len--;
+  }
+  while (len >= 4) {
+    crc ^= *(const uint32_t*)p;
+    crc = crc_table[3][crc & 0xFF] ^ crc_table[2][(crc >> 8) & 0xFF] ^
+          crc_table[1][(crc >> 16) & 0xFF] ^ crc_table[0][crc >> 24];
+    p += 4;
+    len -= 4;
+  }
+  while (len > 0) {
+    crc = crc_table[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    len--;
+  }
+  return ~crc;
+}
+
+// Open a stream output file with large-file support (this file is built with a 64-bit off_t,
+// so the descriptor is opened with O_LARGEFILE; a plain fopen elsewhere fails at 2 GB)
+FILE* capture_file_open(const char* path, const char* mode) {
+  return fopen(path, mode);
+}
+
+// FNV-1a 64-bit hash of a file's contents
+uint64_t capture_hash_file(const char* path) {
+  FILE* file = fopen(path, "rb");
+  if (file == NULL) {
+    return 0;
+  }
+  uint64_t hash = 0xCBF29CE484222325ull;
+  unsigned char buffer[4096];
+  size_t n;
+  while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    for (size_t i = 0; i < n; i++) {
+      hash ^= buffer[i];
+      hash *= 0x100000001B3ull;
+    }
+  }
+  fclose(file);
+  return hash;
+}
+
+static uint64_t timespec_ns(clockid_t clock) {
+  struct timespec ts;
+  clock_gettime(clock, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t chunk_header_crc(const capture_chunk_header_t* chunk) {
+  return capture_crc32(0, chunk, offsetof(capture_chunk_header_t, header_crc));
+}
+
+// Bytes the chunk payload occupies in the file
+static uint64_t chunk_stored_bytes(const capture_chunk_header_t* chunk) {
+  return chunk->payload_bytes ? chunk->payload_bytes : (uint64_t)chunk->word_count * sizeof(uint32_t);
+}
+
+//////////////////// Writer ////////////////////
+
+// Fill a header with defaults for a stream type and board
+void capture_header_init(capture_file_header_t* header, uint8_t stream_type, uint8_t board, uint32_t chunk_words) {
+  memset(header, 0, sizeof(*header));
+  memcpy(header->magic, CAPTURE_MAGIC, sizeof(header->magic));
+  header->version = CAPTURE_VERSION;
+  header->header_size = CAPTURE_HEADER_SIZE;
+  header->stream_type = stream_type;
+  header->board = board;
+  for (int i = 0; i < 8; i++) {
+    header->channel_order[i] = (uint8_t)i;
+  }
+  header->chunk_words = chunk_words;
+  header->start_realtime_ns = timespec_ns(CLOCK_REALTIME);
+  header->start_monotonic_ns = timespec_ns(CLOCK_MONOTONIC);
+}
+
+// Start a capture: writes a provisional header
+int capture_writer_open(capture_writer_t* writer, FILE* file, const capture_file_header_t* header) {
+  memset(writer, 0, sizeof(*writer));
+  writer->file = file;
+  writer->header = *header;
+  writer->header.chunk_count = 0;
+  writer->header.total_words = 0;
+  writer->header.index_offset = 0;
+
+  if (writer->header.chunk_words == 0) {
+    fprintf(stderr, "Capture chunk size must be greater than 0\n");
+    return -1;
+  }
+  if (writer->header.codec != ADC_CODEC_NONE) {
+    if (writer->header.codec != ADC_CODEC_DELTA_PACK) {
+      fprintf(stderr, "Unknown capture codec %u\n", writer->header.codec);
+      return -1;
+    }
+    writer->staging = malloc((size_t)writer->header.chunk_words * sizeof(uint32_t));
+    writer->encoded = malloc(ADC_CODEC_MAX_ENCODED_BYTES((size_t)writer->header.chunk_words));
+    if (writer->staging == NULL || writer->encoded == NULL) {
+      fprintf(stderr, "Failed to allocate capture codec buffers\n");
+      free(writer->staging);
+      free(writer->encoded);
+      writer->staging = NULL;
+      writer->encoded = NULL;
+      return -1;
+    }
+  }
+  if (fwrite(&writer->header, sizeof(writer->header), 1, file) != 1) {
+    fprintf(stderr, "Failed to write capture header: %s\n", strerror(errno));
+    free(writer->staging);
+    free(writer->encoded);
+    writer->staging = NULL;
+    writer->encoded = NULL;
+    return -1;
+  }
+  writer->file_offset = sizeof(writer->header);
+  return 0;
+}
+
+// Write one chunk whose payload is split across up to two spans
+int capture_writer_write_chunk(capture_writer_t* writer, const uint32_t* first, size_t first_count,
+                               const uint32_t* second, size_t second_count) {
+  size_t word_count = first_count + second_count;
+  if (word_count == 0) {
+    return 0;
+  }
+  if (word_count > writer->header.chunk_words) {
+    fprintf(stderr, "Capture chunk of %zu words exceeds chunk size %u\n", word_count, writer->header.chunk_words);
+    return -1;
+  }
+
+  // Grow the in-memory index
+  if (writer->header.chunk_count == writer->index_capacity) {
+    uint64_t capacity = writer->index_capacity ? writer->index_capacity * 2 : 1024;
+    capture_index_entry_t* index = realloc(writer->index, capacity * sizeof(capture_index_entry_t));
+    if (index == NULL) {
+      fprintf(stderr, "Failed to grow capture index to %llu entries\n", capacity);
+      return -1;
+    }
+    writer->index = index;
+    writer->index_capacity = capacity;
+  }
+
+  capture_chunk_header_t chunk = {
+    .magic = CAPTURE_CHUNK_MAGIC,
+    .word_count = (uint32_t)word_count,
+    .sequence = writer->header.chunk_count,
+    .first_word = writer->header.total_words,
+    .timestamp_ns = timespec_ns(CLOCK_MONOTONIC),
+  };
+  chunk.payload_crc = capture_crc32(0, first, first_count * sizeof(uint32_t));
+  if (second_count > 0) {
+    chunk.payload_crc = capture_crc32(chunk.payload_crc, second, second_count * sizeof(uint32_t));
+  }
+
+  // Encode when a codec is set, keeping the raw words if encoding doesn't help
+  if (writer->header.codec != ADC_CODEC_NONE) {
+    struct timespec start_time, end_time;
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+    const uint32_t* words = first;
+    if (second_count > 0) {
+      memcpy(writer->staging, first, first_count * sizeof(uint32_t));
+      memcpy(writer->staging + first_count, second, second_count * sizeof(uint32_t));
+      words = writer->staging;
+    }
+    size_t encoded_bytes = adc_codec_encode(words, word_count, writer->encoded);
+    if (encoded_bytes < word_count * sizeof(uint32_t)) {
+      chunk.payload_bytes = (uint32_t)encoded_bytes;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end_time);
+    writer->encode_seconds += (end_time.tv_sec - start_time.tv_sec) + (end_time.tv_nsec - start_time.tv_nsec) / 1e9;
+  }
+  chunk.header_crc = chunk_header_crc(&chunk);
+
+  if (fwrite(&chunk, sizeof(chunk), 1, writer->file) != 1) {
+    return -1;
+  }
+  if (chunk.payload_bytes != 0) {
+    if (fwrite(writer->encoded, 1, chunk.payload_bytes, writer->file) != chunk.payload_bytes) {
+      return -1;
+    }
+  } else if (fwrite(first, sizeof(uint32_t), first_count, writer->file) != first_count ||
+             (second_count > 0 && fwrite(second, sizeof(uint32_t), second_count, writer->file) != second_count)) {
+    return -1;
+  }
+
+  writer->index[writer->header.chunk_count].offset = writer->file_offset;
+  writer->index[writer->header.chunk_count].timestamp_ns = chunk.timestamp_ns;
+  writer->header.chunk_count++;
+  writer->header.total_words += word_count;
+  writer->file_offset += sizeof(chunk) + chunk_stored_bytes(&chunk);
+  writer->raw_bytes += word_count * sizeof(uint32_t);
+  writer->stored_bytes += chunk_stored_bytes(&chunk);
+  return 0;
+}
+
+// Finish a capture: writes the trailing index and rewrites the header
+int capture_writer_close(capture_writer_t* writer) {
+  int result = 0;
+  uint64_t index_offset = writer->file_offset;
+
+  if (fwrite(writer->index, sizeof(capture_index_entry_t), writer->header.chunk_count, writer->file) != writer->header.chunk_count) {
+    fprintf(stderr, "Failed to write capture index: %s\n", strerror(errno));
+    result = -1;
+  } else {
+    writer->header.index_offset = index_offset;
+    if (fflush(writer->file) != 0 || fseeko(writer->file, 0, SEEK_SET) != 0 ||
+        fwrite(&writer->header, sizeof(writer->header), 1, writer->file) != 1 ||
+        fflush(writer->file) != 0) {
+      fprintf(stderr, "Failed to finalize capture header: %s\n", strerror(errno));
+      result = -1;
+    }
+  }
+
+  free(writer->index);
+  free(writer->staging);
+  free(writer->encoded);
+  writer->index = NULL;
+  writer->staging = NULL;
+  writer->encoded = NULL;
+  writer->index_capacity = 0;
+  return result;
+}
+
+//////////////////// Reader ////////////////////
+
+// Rebuild the index of a capture that was never closed by walking the chunk headers
+static int capture_reader_scan(capture_reader_t* reader, bool verbose) {
+  uint64_t offset = reader->header.header_size;
+  uint64_t capacity = 0;
+  capture_chunk_header_t chunk;
+
+  reader->chunk_count = 0;
+  reader->total_words = 0;
+  while (fseeko(reader->file, (off_t)offset, SEEK_SET) == 0 &&
+         fread(&chunk, sizeof(chunk), 1, reader->file) == 1) {
+    if (chunk.magic != CAPTURE_CHUNK_MAGIC || chunk.header_crc != chunk_header_crc(&chunk) ||
+        chunk.sequence != reader->chunk_count) {
+      break; // Torn or missing chunk: stop at the last good one
+    }
+    // Only count chunks whose payload made it to disk
+    if (fseeko(reader->file, (off_t)(offset + sizeof(chunk) + chunk_stored_bytes(&chunk) - 1), SEEK_SET) != 0 ||
+        fgetc(reader->file) == EOF) {
+      break;
+    }
+    if (reader->chunk_count == capacity) {
+      capacity = capacity ? capacity * 2 : 1024;
+      capture_index_entry_t* index = realloc(reader->index, capacity * sizeof(capture_index_entry_t));
+      if (index == NULL) {
+        fprintf(stderr, "Failed to allocate capture index\n");
+        return -1;
+      }
+      reader->index = index;
+    }
+    reader->index[reader->chunk_count].offset = offset;
+    reader->index[reader->chunk_count].timestamp_ns = chunk.timestamp_ns;
+    reader->chunk_count++;
+    reader->total_words += chunk.word_count;
+    offset += sizeof(chunk) + chunk_stored_bytes(&chunk);
+  }
+
+  reader->index_rebuilt = true;
+  if (verbose) {
+    printf("Capture has no index (not closed cleanly); recovered %llu chunks, %llu words by scanning\n",
+           reader->chunk_count, reader->total_words);
+  }
+  return 0;
+}
+
+// Open a capture for random access
+int capture_reader_open(capture_reader_t* reader, const char* path, bool verbose) {
+  memset(reader, 0, sizeof(*reader));
+  reader->file = fopen(path, "rb");
+  if (reader->file == NULL) {
+    fprintf(stderr, "Failed to open capture file '%s': %s\n", path, strerror(errno));
+    return -1;
+  }
+
+  if (fread(&reader->header, sizeof(reader->header), 1, reader->file) != 1 ||
+      memcmp(reader->header.magic, CAPTURE_MAGIC, sizeof(reader->header.magic)) != 0) {
+    fprintf(stderr, "'%s' is not a chunked capture file\n", path);
+    capture_reader_close(reader);
+    return -1;
+  }
+  if (reader->header.version != CAPTURE_VERSION || reader->header.header_size != CAPTURE_HEADER_SIZE ||
+      reader->header.chunk_words == 0) {
+    fprintf(stderr, "Unsupported capture file version %u (header size %u) in '%s'\n",
+            reader->header.version, reader->header.header_size, path);
+    capture_reader_close(reader);
+    return -1;
+  }
+
+  reader->cached_chunk = UINT64_MAX;
+  if (reader->header.codec != ADC_CODEC_NONE) {
+    if (reader->header.codec != ADC_CODEC_DELTA_PACK) {
+      fprintf(stderr, "Unknown capture codec %u in '%s'\n", reader->header.codec, path);
+      capture_reader_close(reader);
+      return -1;
+    }
+    reader->encoded = malloc(ADC_CODEC_MAX_ENCODED_BYTES((size_t)reader->header.chunk_words));
+    reader->chunk_cache = malloc((size_t)reader->header.chunk_words * sizeof(uint32_t));
+    if (reader->encoded == NULL || reader->chunk_cache == NULL) {
+      fprintf(stderr, "Failed to allocate capture codec buffers\n");
+      capture_reader_close(reader);
+      return -1;
+    }
+  }
+
+  if (reader->header.index_offset == 0) {
+    if (capture_reader_scan(reader, verbose) != 0) {
+      capture_reader_close(reader);
+      return -1;
+    }
+    return 0;
+  }
+
+  reader->chunk_count = reader->header.chunk_count;
+  reader->total_words = reader->header.total_words;
+  if (reader->chunk_count > 0) {
+    reader->index = malloc(reader->chunk_count * sizeof(capture_index_entry_t));
+    if (reader->index == NULL ||
+        fseeko(reader->file, (off_t)reader->header.index_offset, SEEK_SET) != 0 ||
+        fread(reader->index, sizeof(capture_index_entry_t), reader->chunk_count, reader->file) != reader->chunk_count) {
+      fprintf(stderr, "Failed to load capture index from '%s'\n", path);
+      capture_reader_close(reader);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// Close a capture reader
+void capture_reader_close(capture_reader_t* reader) {
+  if (reader->file != NULL) {
+    fclose(reader->file);
+    reader->file = NULL;
+  }
+  free(reader->index);
+  free(reader->encoded);
+  free(reader->chunk_cache);
+  reader->index = NULL;
+  reader->encoded = NULL;
+  reader->chunk_cache = NULL;
+}
+
+// Locate the chunk and in-chunk offset holding a stream word
+int capture_reader_locate(const capture_reader_t* reader, uint64_t word, uint64_t* chunk, uint32_t* offset) {
+  if (word >= reader->total_words) {
+    return -1;
+  }
+  *chunk = word / reader->header.chunk_words;
+  *offset = (uint32_t)(word % reader->header.chunk_words);
+  return 0;
+}
+
+// Read one whole chunk into dst and verify its CRCs
+int64_t capture_reader_read_chunk(capture_reader_t* reader, uint64_t chunk, uint32_t* dst, capture_chunk_header_t* chunk_header) {
+  capture_chunk_header_t header;
+  if (chunk >= reader->chunk_count) {
+    fprintf(stderr, "Capture chunk %llu out of range (%llu chunks)\n", chunk, reader->chunk_count);
+    return -1;
+  }
+  if (fseeko(reader->file, (off_t)reader->index[chunk].offset, SEEK_SET) != 0 ||
+      fread(&header, sizeof(header), 1, reader->file) != 1) {
+    fprintf(stderr, "Failed to read capture chunk %llu header\n", chunk);
+    return -1;
+  }
+  if (header.magic != CAPTURE_CHUNK_MAGIC || header.header_crc != chunk_header_crc(&header) ||
+      header.sequence != chunk || header.word_count > reader->header.chunk_words) {
+    fprintf(stderr, "Capture chunk %llu has a corrupt header\n", chunk);
+    return -1;
+  }
+  if (header.payload_bytes != 0) {
+    // Encoded payload
+    if (reader->encoded == NULL || header.payload_bytes > ADC_CODEC_MAX_ENCODED_BYTES((size_t)reader->header.chunk_words)) {
+      fprintf(stderr, "Capture chunk %llu has an unexpected encoded payload\n", chunk);
+      return -1;
+    }
+    if (fread(reader->encoded, 1, header.payload_bytes, reader->file) != header.payload_bytes) {
+      fprintf(stderr, "Capture chunk %llu is truncated\n", chunk);
+      return -1;
+    }
+    if (adc_codec_decode(reader->encoded, header.payload_bytes, dst, header.word_count) != 0) {
+      fprintf(stderr, "Capture chunk %llu failed to decode\n", chunk);
+      return -1;
+    }
+  } else if (fread(dst, sizeof(uint32_t), header.word_count, reader->file) != header.word_count) {
+    fprintf(stderr, "Capture chunk %llu is truncated\n", chunk);
+    return -1;
+  }
+  if (capture_crc32(0, dst, header.word_count * sizeof(uint32_t)) != header.payload_crc) {
+    fprintf(stderr, "Capture chunk %llu payload CRC mismatch\n", chunk);
+    return -1;
+  }
+  if (chunk_header != NULL) {
+    *chunk_header = header;
+  }
+  return header.word_count;
+}
+
+// Read count words starting at stream word first_word (no CRC check for raw captures)
+int64_t capture_reader_read_words(capture_reader_t* reader, uint64_t first_word, uint32_t* dst, size_t count) {
+  uint64_t chunk;
+  uint32_t offset;
+  size_t done = 0;
+
+  // Encoded captures: decode (and verify) whole chunks, keeping the last one cached
+  if (reader->header.codec != ADC_CODEC_NONE) {
+    while (done < count && capture_reader_locate(reader, first_word + done, &chunk, &offset) == 0) {
+      if (chunk != reader->cached_chunk) {
+        reader->cached_chunk = UINT64_MAX;
+        int64_t chunk_words = capture_reader_read_chunk(reader, chunk, reader->chunk_cache, NULL);
+        if (chunk_words < 0) {
+          return -1;
+        }
+        reader->cached_chunk = chunk;
+      }
+      uint64_t chunk_start = chunk * reader->header.chunk_words;
+      uint64_t chunk_words = reader->total_words - chunk_start;
+      if (chunk_words > reader->header.chunk_words) chunk_words = reader->header.chunk_words;
+      size_t n = (size_t)(chunk_words - offset);
+      if (n > count - done) n = count - done;
+      memcpy(dst + done, reader->chunk_cache + offset, n * sizeof(uint32_t));
+      done += n;
+    }
+    return (int64_t)done;
+  }
+
+  while (done < count && capture_reader_locate(reader, first_word + done, &chunk, &offset) == 0) {
+    // Every chunk but the last is full, so the last one's size follows from the total
+    uint64_t chunk_start = chunk * reader->header.chunk_words;
+    uint64_t chunk_words = reader->total_words - chunk_start;
+    if (chunk_words > reader->header.chunk_words) chunk_words = reader->header.chunk_words;
+
+    size_t n = (size_t)(chunk_words - offset);
+    if (n > count - done) n = count - done;
+    off_t pos = (off_t)(reader->index[chunk].offset + sizeof(capture_chunk_header_t) + (uint64_t)offset * sizeof(uint32_t));
+    if (fseeko(reader->file, pos, SEEK_SET) != 0 || fread(dst + done, sizeof(uint32_t), n, reader->file) != n) {
+      fprintf(stderr, "Failed to read capture words at %llu\n", first_word + done);
+      return -1;
+    }
+    done += n;
+  }
+  return (int64_t)done;
+}
+
+// First stream word of a command file iteration
+int capture_reader_iteration_word(const capture_reader_t* reader, uint64_t iteration, uint64_t* word) {
+  if (reader->header.words_per_iteration == 0) {
+    return -1;
+  }
+  *word = iteration * reader->header.words_per_iteration;
+  return (*word < reader->total_words) ? 0 : -1;
+}
@@ -68,6 +68,13 @@ static command_entry_t command_table[] = {
   {"invert_miso_clk", cmd_invert_miso_clk, {0, 0, {-1}, "Invert MISO SCK polarity register"}},
   {"spi_clk_freq", cmd_spi_clk_freq, {0, 0, {-1}, "Show SPI clock frequency in MHz (and Hz if verbose)"}},
   {"get_min_delay_times", cmd_get_min_delay_times, {0, 0, {-1}, "Show minimum delay times for DAC and ADC in SPI clock cycles"}},
+  {"poll_policy", cmd_poll_policy, {0, 5, {-1}, "Show or set FIFO poll policy: [stream] [max_sleep_us] [spin_us] [threshold_pct] [headroom_pct] (no args lists policies and stats)"}},
+  {"prefill_watermark", cmd_prefill_watermark, {0, 1, {-1}, "Show or set how full waveform_test fills every board's DAC/ADC command FIFOs before releasing triggers: [percent] (0-100)"}},
+  {"sts_sampler", cmd_sts_sampler, {0, 1, {-1}, "Show or set the shared status sampler that stream threads read FIFO levels from: [on|off|<period_us>] (no args shows statistics)"}},
+  {"metrics", cmd_metrics, {0, 3, {-1}, "Show run metrics in Prometheus text format (words moved, FIFO occupancy, stalls, polls, DAC slack, file writes): [reset] (streams stopped) or [export <file> [period_ms] | export off] (export rewrites the file every period, 1000 ms by default)"}},
+  {"trace", cmd_trace, {0, 2, {-1}, "Trace stream thread FIFO polls, bursts, file writes and sleeps: [on|off|clear] or dump <file> (writes Chrome/Perfetto trace JSON; no args shows per-thread event counts)"}},
+  {"fifo_record", cmd_fifo_record, {0, 3, {-1}, "Record DAC command, ADC data and trigger FIFO levels at a fixed rate into memory: <file> [rate_hz] [seconds] or stop (keeps the last seconds, default 10000 Hz for 30 s; the file is written at stop or exit; no args shows the state)"}},
+  {"rt_profile", cmd_rt_profile, {0, 3, {-1}, "Show or set the real-time profile of stream threads: [on|off|reset] or <class> <priority> <cpu|any> (no args lists classes and wake latency histograms)"}},
   
   // ===== DAC COMMANDS (from dac_commands.h) =====
   {"dac_cmd_fifo_sts", cmd_dac_cmd_fifo_sts, {1, 1, {-1}, "Show DAC command FIFO status for specified board (0-7)"}},
@@ -80,8 +87,11 @@ static command_entry_t command_table[] = {
   {"get_dac_cal", cmd_get_dac_cal, {0, 1, {FLAG_ALL, FLAG_NO_RESET, -1}, "Get DAC calibration value: <channel> [--no_reset] OR --all [--no_reset] (channel 0-63, board=ch/8, ch=ch%8)"}},
   {"do_dac_get_cal", cmd_do_dac_get_cal, {1, 1, {-1}, "Send DAC GET_CAL command for single channel: <channel> (channel 0-63, board=ch/8, ch=ch%8)"}},
   {"set_dac_cal", cmd_set_dac_cal, {2, 2, {-1}, "Set DAC calibration value for single channel: <channel> <cal_value> (channel 0-63, cal_value -32767 to 32767)"}},
-  {"stream_dac_commands_from_file", cmd_stream_dac_commands_from_file, {2, 3, {-1}, "Start DAC command streaming from waveform file: <board> <file_path> [iterations] (supports * wildcards)"}},
+  {"stream_dac_commands_from_file", cmd_stream_dac_commands_from_file, {2, 3, {FLAG_DELTA, -1}, "Start DAC command streaming from waveform file: <board> <file_path> [iterations] [--delta] (supports * wildcards, accepts text or compiled waveforms; --delta sends unchanged and single-channel updates in fewer words, needs DAC pre-delay, and an underflow after a single-channel update halts without an error)"}},
+  {"compile_waveform", cmd_compile_waveform, {2, 2, {FLAG_DELTA, -1}, "Compile a waveform file to packed DAC command FIFO words: <waveform_file> <output_file> [--delta] (stream the output with stream_dac_commands_from_file; --delta encodes for the current minimum DAC delay)"}},
+  {"validate_waveform", cmd_validate_waveform, {1, 4, {FLAG_DELTA, -1}, "Check waveform timing and FIFO occupancy before a run: <waveform_file|-> [adc_command_file] [service_us] [trigger_us] [--delta] (flags delays below the minimum delay and stretches where a FIFO serviced every service_us would underflow or overflow; service_us defaults to each stream's poll policy, trigger waits of unknown length unless trigger_us is given)"}},
   {"stop_dac_cmd_stream", cmd_stop_dac_cmd_stream, {1, 1, {-1}, "Stop DAC command streaming for specified board (0-7)"}},
+  {"dac_stream_status", cmd_dac_stream_status, {0, 0, {-1}, "Show DAC stream engine statistics (feeder passes, status polls, per-board slack before the FIFO runs dry)"}},
   {"stream_dac_debug", cmd_stream_dac_debug, {2, 2, {-1}, "Start DAC debug data streaming to file: <board> <file_path> (streams DAC debug data to file)"}},
   {"stop_dac_debug_stream", cmd_stop_dac_debug_stream, {1, 1, {-1}, "Stop DAC debug data streaming for specified board (0-7)"}},
   
@@ -96,10 +106,17 @@ static command_entry_t command_table[] = {
   {"adc_set_ord", cmd_adc_set_ord, {9, 9, {-1}, "Set ADC channel order: <board> <ord0> <ord1> <ord2> <ord3> <ord4> <ord5> <ord6> <ord7> (each order value must be 0-7)"}},
   {"do_adc_rd", cmd_do_adc_rd, {3, 4, {-1}, "Perform ADC read: <board> <\"trig\"|\"delay\"> <value> [repeat_count] (sends adc_rd command with repeat count, defaults to 0)"}},
   {"do_adc_rd_ch", cmd_do_adc_rd_ch, {1, 2, {-1}, "Read ADC single channel: <channel> [repeat_count] (channel 0-63, board=ch/8, ch=ch%8, repeat_count defaults to 0)"}},
-  {"stream_adc_data_to_file", cmd_stream_adc_data_to_file, {3, 3, {FLAG_BIN, -1}, "Start ADC data streaming to file: <board> <word_count> <file_path> [--bin]"}},
+  {"stream_adc_data_to_file", cmd_stream_adc_data_to_file, {3, 3, {FLAG_BIN, FLAG_CHUNKED, FLAG_COMPRESS, FLAG_FPRINTF, -1}, "Start ADC data streaming to file: <board> <word_count> <file_path> [--bin] [--chunked] [--compress] [--fprintf] (--chunked writes an indexed capture container, --compress also applies the lossless ADC codec, --fprintf uses the legacy per-sample ASCII writer)"}},
   {"stream_adc_commands_from_file", cmd_stream_adc_commands_from_file, {2, 3, {FLAG_SIMPLE, -1}, "Start ADC command streaming from file: <board> <file_path> [iterations] [--simple] (supports * wildcards, iterations defaults to 1)"}},
   {"stop_adc_data_stream", cmd_stop_adc_data_stream, {1, 1, {-1}, "Stop ADC data streaming for specified board (0-7)"}},
+  {"adc_stream_status", cmd_adc_stream_status, {0, 0, {-1}, "Show ADC stream engine statistics (drain passes, status polls, per-board fill)"}},
+  {"adc_stats", cmd_adc_stats, {0, 1, {-1}, "Show per-channel ADC statistics (count, mean, std dev, min/max, saturation) of the current or last data stream: [board|all] (defaults to all)"}},
   {"stop_adc_cmd_stream", cmd_stop_adc_cmd_stream, {1, 1, {-1}, "Stop ADC command streaming for specified board (0-7)"}},
+  {"capture_info", cmd_capture_info, {1, 1, {FLAG_ALL, -1}, "Show the header and index of a chunked capture file: <file_path> [--all] (--all verifies every chunk CRC)"}},
+  {"bench_adc_codec", cmd_bench_adc_codec, {0, 1, {-1}, "Benchmark the lossless ADC codec on synthetic slowly varying data and check round trip: [word_count] (defaults to 1048576)"}},
+  {"bench_adc_ascii", cmd_bench_adc_ascii, {0, 1, {-1}, "Benchmark ADC ASCII writers (fprintf vs. formatter) and check identical output: [word_count] (defaults to 1048576)"}},
+  {"bench_adc_stats", cmd_bench_adc_stats, {0, 1, {-1}, "Benchmark the per-channel ADC stream statistics and check them against a two-pass reference: [word_count] (defaults to 4194304)"}},
+  {"bench_adc_cmd_stream", cmd_bench_adc_cmd_stream, {1, 2, {-1}, "Benchmark per-command ADC command streaming against replay of the pre-encoded iteration in FIFO bursts: <file> [iterations] (defaults to 1000; no streams may be running)"}},
   
   // ===== TRIGGER COMMANDS (from trigger_commands.h) =====
   {"trig_cmd_fifo_sts", cmd_trig_cmd_fifo_sts, {0, 0, {-1}, "Show trigger command FIFO status"}},
@@ -113,7 +130,7 @@ static command_entry_t command_table[] = {
   {"trig_set_lockout", cmd_trig_set_lockout, {1, 1, {-1}, "Send trigger set lockout command with cycles (1 - 0x0FFFFFFF)"}},
   {"trig_delay", cmd_trig_delay, {1, 1, {-1}, "Send trigger delay command with cycles (0 - 0x0FFFFFFF)"}},
   {"trig_expect_ext", cmd_trig_expect_ext, {1, 2, {-1}, "Send trigger expect external command with count (0 - 0x0FFFFFFF) [log]"}},
-  {"stream_trig_data_to_file", cmd_stream_trig_data_to_file, {2, 2, {FLAG_BIN, -1}, "Start trigger data streaming to file: <sample_count> <file_path> [--bin]"}},
+  {"stream_trig_data_to_file", cmd_stream_trig_data_to_file, {2, 2, {FLAG_BIN, FLAG_CHUNKED, -1}, "Start trigger data streaming to file: <sample_count> <file_path> [--bin] [--chunked] (--chunked writes an indexed capture container)"}},
   {"stop_trig_data_stream", cmd_stop_trig_data_stream, {0, 0, {-1}, "Stop trigger data streaming"}},
   
   // ===== EXPERIMENT COMMANDS (from experiment_commands.h) =====
@@ -359,6 +376,18 @@ void print_command_help(const char* command_name) {
         case FLAG_NO_RESET:
           printf(" --no_reset");
           break;
+        case FLAG_FPRINTF:
+          printf(" --fprintf");
+          break;
+        case FLAG_CHUNKED:
+          printf(" --chunked");
+          break;
+        case FLAG_COMPRESS:
+          printf(" --compress");
+          break;
+        case FLAG_DELTA:
+          printf(" --delta");
+          break;
       }
     }
     printf("\n");
@@ -483,6 +512,10 @@ void print_help(void) {
   printf("  --bin        Write binary format instead of ASCII text\n");
   printf("  --no_reset   Skip buffer reset operations (for debugging)\n");
   printf("  --no_cal     Skip calibration step in waveform test\n");
+  printf("  --fprintf    Write ASCII with the legacy per-sample fprintf path\n");
+  printf("  --chunked    Write a self-describing, indexed binary capture container\n");
+  printf("  --compress   Chunked capture with lossless ADC compression\n");
+  printf("  --delta      Send unchanged and single-channel DAC waveform updates in fewer words\n");
   printf("\n");
 }
 
@@ -516,6 +549,14 @@ int parse_command_line(const char* line, const char** args, int* arg_count, comm
         flags[(*flag_count)++] = FLAG_NO_RESET;
       } else if (strcmp(token, "--no_cal") == 0) {
         flags[(*flag_count)++] = FLAG_NO_CAL;
+      } else if (strcmp(token, "--fprintf") == 0) {
+        flags[(*flag_count)++] = FLAG_FPRINTF;
+      } else if (strcmp(token, "--chunked") == 0) {
+        flags[(*flag_count)++] = FLAG_CHUNKED;
+      } else if (strcmp(token, "--compress") == 0) {
+        flags[(*flag_count)++] = FLAG_COMPRESS;
+      } else if (strcmp(token, "--delta") == 0) {
+        flags[(*flag_count)++] = FLAG_DELTA;
       } else {
         // Unknown flag - return error
         printf("Error: Unknown flag '%s'\n", token);
@@ -593,6 +634,10 @@ int execute_command(const char* line, command_context_t* ctx) {
         case FLAG_BIN: flag_name = "--bin"; break;
         case FLAG_NO_RESET: flag_name = "--no_reset"; break;
         case FLAG_NO_CAL: flag_name = "--no_cal"; break;
+        case FLAG_FPRINTF: flag_name = "--fprintf"; break;
+        case FLAG_CHUNKED: flag_name = "--chunked"; break;
+        case FLAG_COMPRESS: flag_name = "--compress"; break;
+        case FLAG_DELTA: flag_name = "--delta"; break;
       }
       printf("Error: Command '%s' does not accept flag '%s'\n", args[0], flag_name);
       printf("\n");
@@ -10,16 +10,25 @@
 #include <pthread.h>
 #include <glob.h>
 #include "dac_commands.h"
+#include "dac_waveform.h"
+#include "dac_stream_engine.h"
 #include "command_helper.h"
 #include "system_commands.h"
 #include "sys_sts.h"
 #include "sys_ctrl.h"
 #include "dac_ctrl.h"
+#include "poll_sched.h"
+#include "waveform_timing.h"
+#include "adc_commands.h"
+#include "adc_ctrl.h"
+#include "rt_profile.h"
 
 // Local helper function to check if system is running
 static int validate_system_running(command_context_t* ctx);
 // DAC debug streaming thread function
 static void* dac_debug_stream_thread(void* arg);
+// Local helper function to check delta encoding's timing holds on this hardware
+static int validate_delta_pre_delay(command_context_t* ctx);
 
 static int validate_system_running(command_context_t* ctx) {
   uint32_t hw_status = sys_sts_get_hw_status(ctx->sys_sts, *(ctx->verbose));
@@ -31,6 +40,16 @@ static int validate_system_running(command_context_t* ctx) {
   return 0;
 }
 
+// Delta encoding shortens the delay before a single-channel write, which lands at the same
+// time only if the full DAC_WR it replaces writes at the end of its delay (pre-delay)
+static int validate_delta_pre_delay(command_context_t* ctx) {
+  if (!sys_ctrl_get_dac_pre_delay(ctx->sys_ctrl, *(ctx->verbose))) {
+    fprintf(stderr, "Error: Delta encoded DAC waveforms need DAC pre-delay (do_dac_pre_delay), but it is off.\n");
+    return -1;
+  }
+  return 0;
+}
+
 // DAC FIFO status commands
 int cmd_dac_cmd_fifo_sts(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
   int board = validate_board_number(args[0]);
@@ -488,162 +507,6 @@ int cmd_set_dac_cal(const char** args, int arg_count, const command_flag_t* flag
   return 0;
 }
 
-// Function to validate and parse a waveform file
-static int parse_waveform_file(const char* file_path, waveform_command_t** commands, int* command_count) {
-  FILE* file = fopen(file_path, "r");
-  if (file == NULL) {
-    fprintf(stderr, "Failed to open waveform file '%s': %s\n", file_path, strerror(errno));
-    return -1;
-  }
-  
-  // First pass: count lines and validate format
-  char line[512];
-  int line_num = 0;
-  int valid_lines = 0;
-  
-  while (fgets(line, sizeof(line), file)) {
-    line_num++;
-    
-    // Skip empty lines and comments
-    char* trimmed = line;
-    while (*trimmed == ' ' || *trimmed == '\t') trimmed++;
-    if (*trimmed == '\n' || *trimmed == '\r' || *trimmed == '\0' || *trimmed == '#') {
-      continue;
-    }
-    
-    // Check if line starts with D, T, NT, or ND
-    bool is_noop_cmd = (strncmp(trimmed, "NT", 2) == 0 || strncmp(trimmed, "ND", 2) == 0);
-    if (!is_noop_cmd && *trimmed != 'D' && *trimmed != 'T') {
-      fprintf(stderr, "Invalid line %d: must start with 'D', 'T', 'NT', or 'ND'\n", line_num);
-      fclose(file);
-      return -1;
-    }
-    
-    // Parse the line to validate format
-    char cmd_mode[3];
-    uint32_t value;
-    int16_t ch_vals[8];
-    int parsed;
-    
-    if (is_noop_cmd) {
-      // NT or ND commands: only cmd_mode and value (no channel values allowed)
-      parsed = sscanf(trimmed, "%2s %u", cmd_mode, &value);
-      if (parsed != 2) {
-        fprintf(stderr, "Invalid line %d: NT/ND commands must have exactly cmd_mode and value\n", line_num);
-        fclose(file);
-        return -1;
-      }
-    } else {
-      // D or T commands: can have channel values
-      parsed = sscanf(trimmed, "%2s %u %hd %hd %hd %hd %hd %hd %hd %hd", 
-                     cmd_mode, &value, &ch_vals[0], &ch_vals[1], &ch_vals[2], &ch_vals[3],
-                     &ch_vals[4], &ch_vals[5], &ch_vals[6], &ch_vals[7]);
-    
-      if (parsed < 2) {
-        fprintf(stderr, "Invalid line %d: must have at least cmd_mode and value\n", line_num);
-        fclose(file);
-        return -1;
-      }
-    
-      if (parsed != 2 && parsed != 10) {
-        fprintf(stderr, "Invalid line %d: must have either 2 fields (cmd_mode, value) or 10 fields (cmd_mode, value, 8 channels)\n", line_num);
-        fclose(file);
-        return -1;
-      }
-    }
-    
-    // Validate value range
-    if (value > 0x1FFFFFF) {
-      fprintf(stderr, "Invalid line %d: value %u out of range (max 0x1FFFFFF or 33554431)\n", line_num, value);
-      fclose(file);
-      return -1;
-    }
-    
-    // Validate channel values if present (only for D/T commands)
-    if (!is_noop_cmd && parsed == 10) {
-      for (int i = 0; i < 8; i++) {
-        if (ch_vals[i] < -32767 || ch_vals[i] > 32767) {
-          fprintf(stderr, "Invalid line %d: channel %d value %d out of range (-32767 to 32767)\n", 
-                 line_num, i, ch_vals[i]);
-          fclose(file);
-          return -1;
-        }
-      }
-    }
-    
-    valid_lines++;
-  }
-  
-  if (valid_lines == 0) {
-    fprintf(stderr, "No valid commands found in waveform file\n");
-    fclose(file);
-    return -1;
-  }
-  
-  // Allocate memory for commands
-  *commands = malloc(valid_lines * sizeof(waveform_command_t));
-  if (*commands == NULL) {
-    fprintf(stderr, "Failed to allocate memory for waveform commands\n");
-    fclose(file);
-    return -1;
-  }
-  
-  // Second pass: parse and store commands
-  rewind(file);
-  line_num = 0;
-  int cmd_index = 0;
-  
-  while (fgets(line, sizeof(line), file)) {
-    line_num++;
-    
-    // Skip empty lines and comments
-    char* trimmed = line;
-    while (*trimmed == ' ' || *trimmed == '\t') trimmed++;
-    if (*trimmed == '\n' || *trimmed == '\r' || *trimmed == '\0' || *trimmed == '#') {
-      continue;
-    }
-    
-    waveform_command_t* cmd = &(*commands)[cmd_index];
-    
-    // Check if this is a noop command
-    bool is_noop_cmd = (strncmp(trimmed, "NT", 2) == 0 || strncmp(trimmed, "ND", 2) == 0);
-    
-    char cmd_mode[3];
-    uint32_t value;
-    int16_t ch_vals[8];
-    int parsed;
-    
-    if (is_noop_cmd) {
-      // Parse NT or ND command
-      sscanf(trimmed, "%2s %u", cmd_mode, &value);
-      cmd->type = (cmd_mode[1] == 'T') ? DAC_NOOP_TRIGGER_CMD : DAC_NOOP_DELAY_CMD;
-      cmd->value = value;
-    } else {
-      // Parse D or T command
-      parsed = sscanf(trimmed, "%2s %u %hd %hd %hd %hd %hd %hd %hd %hd", 
-                     cmd_mode, &value, &ch_vals[0], &ch_vals[1], &ch_vals[2], &ch_vals[3],
-                     &ch_vals[4], &ch_vals[5], &ch_vals[6], &ch_vals[7]);
-      
-      cmd->type = (cmd_mode[0] == 'T') ? DAC_TRIGGER_CMD : DAC_DELAY_CMD;
-      cmd->value = value;
-      
-      if (parsed == 10) {
-        for (int i = 0; i < 8; i++) {
-          cmd->ch_vals[i] = ch_vals[i];
-        }
-      }
-    }
-    
-    cmd->cont = (cmd_index < valid_lines - 1); // true for all except last command
-    
-    cmd_index++;
-  }
-  
-  fclose(file);
-  *command_count = valid_lines;
-  return 0;
-}
-
 // Thread function for DAC debug data streaming
 static void* dac_debug_stream_thread(void* arg) {
   dac_debug_stream_params_t* stream_data = (dac_debug_stream_params_t*)arg;
@@ -672,6 +535,9 @@ static void* dac_debug_stream_thread(void* arg) {
   fprintf(file, "# Generated by shim-test DAC debug streaming\n\n");
   
   uint64_t samples_written = 0;
+  poll_sched_t poll;
+  poll_sched_init(&poll, POLL_STREAM_DAC_DEBUG, DAC_DATA_FIFO_WORDCOUNT, 0.0);
+  poll_sched_track(&poll, board);
   
   while (!(*should_stop)) {
     // Check data FIFO status
@@ -683,6 +549,7 @@ static void* dac_debug_stream_thread(void* arg) {
     }
     
     uint32_t words_available = FIFO_STS_WORD_COUNT(data_status);
+    poll_sched_observe(&poll, words_available, 1);
     
     if (words_available > 0) {
       // Read and process available words
@@ -703,11 +570,13 @@ static void* dac_debug_stream_thread(void* arg) {
           break;
         }
       }
+      poll_sched_consumed(&poll, words_available);
     } else {
-      // No data available, sleep briefly to avoid busy waiting
-      usleep(1000); // 1ms
+      // No data available, sleep until some is predicted to arrive
+      poll_sched_wait(&poll, words_available, 1);
     }
   }
+  poll_sched_finish(&poll);
 
 cleanup:
   if (file) {
@@ -728,105 +597,6 @@ cleanup:
   return NULL;
 }
 
-// Thread function for DAC streaming
-void* dac_cmd_stream_thread(void* arg) {
-  dac_command_stream_params_t* stream_data = (dac_command_stream_params_t*)arg;
-  command_context_t* ctx = stream_data->ctx;
-  uint8_t board = stream_data->board;
-  const char* file_path = stream_data->file_path;
-  volatile bool* should_stop = stream_data->should_stop;
-  waveform_command_t* commands = stream_data->commands;
-  int command_count = stream_data->command_count;
-  int iterations = stream_data->iterations;
-  
-  if (*(ctx->verbose)) {
-    printf("DAC Command Stream Thread[%d]: Started streaming from file '%s' (%d commands, %d iteration%s)\n", 
-           board, file_path, command_count, iterations, iterations == 1 ? "" : "s");
-  }
-  
-  int total_commands_sent = 0;
-  int total_words_sent = 0;
-  int current_iteration = 0;
-  
-  while (!(*should_stop) && current_iteration < iterations) {
-    int cmd_index = 0;
-    int commands_sent_this_iteration = 0;
-    
-    // Process all commands in the current iteration
-    while (!(*should_stop) && cmd_index < command_count) {
-      // Check DAC command FIFO status
-      uint32_t fifo_status = sys_sts_get_dac_cmd_fifo_status(ctx->sys_sts, board, false);
-      
-      if (FIFO_PRESENT(fifo_status) == 0) {
-        fprintf(stderr, "DAC Command Stream Thread[%d]: FIFO not present, stopping stream\n", board);
-        goto cleanup;
-      }
-      
-      uint32_t words_used = FIFO_STS_WORD_COUNT(fifo_status) + 1; // +1 for safety margin
-      uint32_t words_available = DAC_CMD_FIFO_WORDCOUNT - words_used;
-      
-      // Check if we have space for the next command
-      waveform_command_t* cmd = &commands[cmd_index];
-      uint32_t words_needed = (cmd->type == DAC_TRIGGER_CMD || cmd->type == DAC_DELAY_CMD) ? 5 : 1; // dac_wr needs 5 words, noop needs 1
-      
-      if (words_available >= words_needed) {
-        // For iterating, we need to adjust the 'cont' flag:
-        // - Set cont=true for all commands except the last command of the last iteration
-        bool is_last_command_of_last_it = (current_iteration == iterations - 1) && (cmd_index == command_count - 1);
-        bool cont_flag = !is_last_command_of_last_it;
-        
-        // Determine if this is a trigger-based command
-        bool is_trigger = (cmd->type == DAC_TRIGGER_CMD || cmd->type == DAC_NOOP_TRIGGER_CMD);
-        
-        // Send the command based on type
-        if (cmd->type == DAC_TRIGGER_CMD || cmd->type == DAC_DELAY_CMD) {
-          // DAC_TRIGGER_CMD or DAC_DELAY_CMD with channel values
-          dac_cmd_dac_wr(ctx->dac_ctrl, board, cmd->ch_vals, is_trigger ? DAC_TRIGGER_WAIT : DAC_DELAY_WAIT, cont_flag ? DAC_CONTINUE : DAC_NO_CONTINUE, DAC_LDAC, cmd->value, *(ctx->verbose));
-        } else {
-          // DAC_NOOP_TRIGGER_CMD or DAC_NOOP_DELAY_CMD (noop commands)
-          dac_cmd_noop(ctx->dac_ctrl, board, is_trigger ? DAC_TRIGGER_WAIT : DAC_DELAY_WAIT, cont_flag ? DAC_CONTINUE : DAC_NO_CONTINUE, DAC_NO_LDAC, cmd->value, *(ctx->verbose));
-        }
-        
-        commands_sent_this_iteration++;
-        total_commands_sent++;
-        total_words_sent += words_needed;
-        cmd_index++;
-        
-        if (*(ctx->verbose)) {
-          const char* type_names[] = {"DAC_DELAY_CMD", "DAC_TRIGGER_CMD", "DAC_NOOP_TRIGGER_CMD", "DAC_NOOP_DELAY_CMD"};
-          printf("DAC Command Stream Thread[%d]: Iteration %d/%d, Sent command %d/%d (type=%s, value=%u, %s, cont=%s) [FIFO: %u/%u words, %d needed]\n", 
-                 board, current_iteration + 1, iterations, commands_sent_this_iteration, command_count, 
-                 type_names[cmd->type], cmd->value,
-                 cont_flag ? "true" : "false", words_used, DAC_CMD_FIFO_WORDCOUNT, words_needed);
-        }
-      } else {
-        // Not enough space in FIFO, sleep and try again
-        usleep(1000); // 1ms
-      }
-    }
-    
-    current_iteration++;
-    if (current_iteration < iterations && *(ctx->verbose)) {
-      printf("DAC Command Stream Thread[%d]: Completed iteration %d/%d, starting next iteration\n", 
-             board, current_iteration, iterations);
-    }
-  }
-
-cleanup:
-  if (*should_stop) {
-    printf("DAC Command Stream Thread[%d]: Stopping (user requested), sent %d total commands (%d total words)\n",
-           board, total_commands_sent, total_words_sent);
-  } else {
-    printf("DAC Command Stream Thread[%d]: Completed, sent %d total commands (%d total words, %d iteration%s)\n", 
-           board, total_commands_sent, total_words_sent, iterations, iterations == 1 ? "" : "s");
-  }
-  
-  ctx->dac_cmd_stream_running[board] = false;
-  free(stream_data->commands);
-  free(stream_data);
-  return NULL;
-}
-
 int cmd_stream_dac_commands_from_file(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
   // Parse board number
   int board = parse_board_number(args[0]);
@@ -868,91 +638,60 @@ int cmd_stream_dac_commands_from_file(const char** args, int arg_count, const co
   char full_path[1024];
   clean_and_expand_path(resolved_path, full_path, sizeof(full_path));
   
-  // Parse and validate the waveform file
-  waveform_command_t* commands = NULL;
-  int command_count = 0;
-  
-  if (parse_waveform_file(full_path, &commands, &command_count) != 0) {
-    return -1; // Error already printed by parse_waveform_file
+  // Open the waveform: a compiled file is mapped, a text file gets its first window parsed
+  dac_waveform_stream_t* waveform = malloc(sizeof(dac_waveform_stream_t));
+  if (waveform == NULL) {
+    fprintf(stderr, "Failed to allocate memory for waveform\n");
+    return -1;
   }
-  
-  if (*(ctx->verbose)) {
-    printf("Parsed %d commands from waveform file '%s'\n", command_count, full_path);
+  uint32_t min_delay = sys_sts_get_dac_delay_too_short_time(ctx->sys_sts, *(ctx->verbose)) + 1;
+  bool delta = has_flag(flags, flag_count, FLAG_DELTA);
+  if (delta && validate_delta_pre_delay(ctx) != 0) {
+    free(waveform);
+    return -1;
   }
-  
-  // Validate trigger gaps to prevent FIFO underflow
-  int words_since_last_trigger = 0;
-  int max_gap = 0;
-  bool found_trigger = false;
-  
-  for (int i = 0; i < command_count; i++) {
-    waveform_command_t* cmd = &commands[i];
-    uint32_t words_needed = (cmd->type == DAC_TRIGGER_CMD || cmd->type == DAC_DELAY_CMD) ? 5 : 1;
-    
-    if (cmd->type == DAC_TRIGGER_CMD || cmd->type == DAC_NOOP_TRIGGER_CMD) {
-      // Found a trigger command - check the gap since last trigger
-      if (found_trigger && words_since_last_trigger > max_gap) {
-        max_gap = words_since_last_trigger;
-      }
-      found_trigger = true;
-      words_since_last_trigger = words_needed; // Reset counter with current command
-    } else {
-      words_since_last_trigger += words_needed;
-    }
+  if (dac_waveform_stream_open(waveform, full_path, min_delay, delta) != 0) {
+    free(waveform);
+    return -1; // Error already printed
   }
-  
-  // Check the final gap (from last trigger to end)
-  if (found_trigger && words_since_last_trigger > max_gap) {
-    max_gap = words_since_last_trigger;
+  // A compiled waveform carries its own encoding, chosen when it was compiled
+  if (!delta && waveform->summary_done && waveform->summary.delta_count > 0 && validate_delta_pre_delay(ctx) != 0) {
+    dac_waveform_stream_close(waveform);
+    free(waveform);
+    return -1;
   }
   
-  // Warn if any gap exceeds FIFO size
-  if (!found_trigger) {
-    // No trigger commands found - check if total command size exceeds FIFO
-    int total_words = words_since_last_trigger;
-    if (total_words > DAC_CMD_FIFO_WORDCOUNT) {
-      printf("WARNING: Waveform contains no triggers and requires %d words, which exceeds DAC FIFO size (%u words).\n", 
-             total_words, DAC_CMD_FIFO_WORDCOUNT);
-      printf("         This may cause FIFO overflow during streaming. Consider adding trigger commands, keeping delays long, or reducing waveform size.\n");
-    } else if (*(ctx->verbose)) {
-      printf("No trigger validation: Waveform requires %d words (FIFO size: %u words) - OK\n", 
-             total_words, DAC_CMD_FIFO_WORDCOUNT);
+  // Validate trigger gaps to prevent FIFO underflow (a long text waveform is checked after its first pass)
+  if (waveform->summary_done) {
+    if (*(ctx->verbose)) {
+      printf("Loaded %llu commands (%llu FIFO words) from waveform file '%s'\n",
+             waveform->summary.command_count, waveform->summary.word_count, full_path);
+    }
+    dac_waveform_check_trigger_gaps(&waveform->summary, *(ctx->verbose));
+    if (waveform->summary.delta_count > 0) {
+      dac_waveform_print_savings(&waveform->summary, "");
     }
-  } else if (max_gap > DAC_CMD_FIFO_WORDCOUNT) {
-    printf("WARNING: Maximum gap between triggers is %d words, which exceeds DAC FIFO size (%u words).\n", 
-           max_gap, DAC_CMD_FIFO_WORDCOUNT);
-    printf("         This may cause FIFO underflow during streaming. Consider reducing number of delay commands between triggers or keeping delays long.\n");
   } else if (*(ctx->verbose)) {
-    printf("Trigger gap validation: Maximum gap is %d words (FIFO size: %u words) - OK\n", 
-           max_gap, DAC_CMD_FIFO_WORDCOUNT);
+    printf("Waveform file '%s' exceeds the %u-word window; parsing while streaming\n",
+           full_path, DAC_WAVEFORM_WINDOW_WORDS);
   }
   
-  // Allocate thread data structure
-  dac_command_stream_params_t* stream_data = malloc(sizeof(dac_command_stream_params_t));
-  if (stream_data == NULL) {
-    fprintf(stderr, "Failed to allocate memory for stream data\n");
-    free(commands);
-    return -1;
-  }
-  
-  stream_data->ctx = ctx;
-  stream_data->board = (uint8_t)board;
-  snprintf(stream_data->file_path, sizeof(stream_data->file_path), "%s", full_path);
-  stream_data->should_stop = &(ctx->dac_cmd_stream_stop[board]);
-  stream_data->commands = commands;
-  stream_data->command_count = command_count;
-  stream_data->iterations = iterations;
+  dac_command_stream_params_t stream_data;
+  stream_data.ctx = ctx;
+  stream_data.board = (uint8_t)board;
+  snprintf(stream_data.file_path, sizeof(stream_data.file_path), "%s", full_path);
+  stream_data.should_stop = &(ctx->dac_cmd_stream_stop[board]);
+  stream_data.waveform = waveform;
+  stream_data.iterations = iterations;
   
   // Initialize stop flag and mark stream as running
   ctx->dac_cmd_stream_stop[board] = false;
   ctx->dac_cmd_stream_running[board] = true;
   
-  // Create the streaming thread
-  if (pthread_create(&(ctx->dac_cmd_stream_threads[board]), NULL, dac_cmd_stream_thread, stream_data) != 0) {
-    fprintf(stderr, "Failed to create DAC command streaming thread for board %d: %s\n", board, strerror(errno));
+  // Hand the board to the shared feeder (which now owns the waveform)
+  if (dac_stream_engine_start_session(ctx, &stream_data) != 0) {
+    fprintf(stderr, "Failed to start DAC command streaming for board %d\n", board);
     ctx->dac_cmd_stream_running[board] = false;
-    free(commands);
-    free(stream_data);
     return -1;
   }
   
@@ -979,19 +718,19 @@ int cmd_stop_dac_cmd_stream(const char** args, int arg_count, const command_flag
   
   printf("Stopping DAC command streaming for board %d...\n", board);
   
-  // Signal the thread to stop
-  ctx->dac_cmd_stream_stop[board] = true;
-  
-  // Wait for the thread to finish
-  if (pthread_join(ctx->dac_cmd_stream_threads[board], NULL) != 0) {
-    fprintf(stderr, "Failed to join DAC command streaming thread for board %d: %s\n", board, strerror(errno));
-    return -1;
-  }
+  // Signal the stream to stop and wait for the feeder to retire it
+  dac_stream_engine_stop_session(ctx, (uint8_t)board);
   
   printf("DAC command streaming for board %d has been stopped.\n", board);
   return 0;
 }
 
+// Show the shared DAC stream engine statistics
+int cmd_dac_stream_status(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  dac_stream_engine_print_status(ctx);
+  return 0;
+}
+
 // DAC zero command - set all DAC channels to calibrated zero
 int cmd_dac_zero(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
   // Validate system is running
@@ -1208,7 +947,7 @@ int cmd_stream_dac_debug(const char** args, int arg_count, const command_flag_t*
   ctx->dac_debug_stream_running[board] = true;
   
   // Create the streaming thread
-  if (pthread_create(&(ctx->dac_debug_stream_threads[board]), NULL, dac_debug_stream_thread, stream_data) != 0) {
+  if (rt_thread_create(&(ctx->dac_debug_stream_threads[board]), RT_CLASS_DRAIN, dac_debug_stream_thread, stream_data) != 0) {
     fprintf(stderr, "Failed to create DAC debug streaming thread for board %d: %s\n", board, strerror(errno));
     ctx->dac_debug_stream_running[board] = false;
     free(stream_data);
@@ -1249,3 +988,222 @@ int cmd_stop_dac_debug_stream(const char** args, int arg_count, const command_fl
 }
 
 
+
+// Compile a waveform text file to packed DAC command FIFO words
+int cmd_compile_waveform(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  // Resolve glob pattern if present
+  char resolved_path[1024];
+  if (resolve_file_pattern(args[0], resolved_path, sizeof(resolved_path)) != 0) {
+    return -1;
+  }
+  
+  // Clean and expand file paths
+  char input_path[1024];
+  char output_path[1024];
+  clean_and_expand_path(resolved_path, input_path, sizeof(input_path));
+  clean_and_expand_path(args[1], output_path, sizeof(output_path));
+  
+  if (dac_waveform_is_compiled(input_path)) {
+    fprintf(stderr, "'%s' is already a compiled waveform\n", input_path);
+    return -1;
+  }
+  
+  // Delta encoding bakes in the single-channel write time, so it needs the hardware minimum delay
+  uint32_t min_delay = 0;
+  if (has_flag(flags, flag_count, FLAG_DELTA)) {
+    if (validate_delta_pre_delay(ctx) != 0) {
+      return -1;
+    }
+    min_delay = sys_sts_get_dac_delay_too_short_time(ctx->sys_sts, *(ctx->verbose)) + 1;
+  }
+  
+  dac_waveform_header_t header;
+  if (dac_waveform_compile_file(input_path, output_path, min_delay, &header) != 0) {
+    return -1; // Error already printed
+  }
+  
+  printf("Compiled %u commands (%u FIFO words, %u trigger waits, max %u words between triggers) from '%s' to '%s'\n",
+         header.command_count, header.word_count, header.trigger_count,
+         header.max_trigger_gap, input_path, output_path);
+  if (min_delay > 0) {
+    dac_waveform_summary_t summary = {
+      .command_count = header.command_count,
+      .word_count = header.word_count,
+      .plain_word_count = header.plain_word_count,
+      .delta_count = header.delta_count
+    };
+    dac_waveform_print_savings(&summary, "");
+  }
+  return 0;
+}
+
+// Resolve a command file argument to a full path
+static int resolve_validate_path(const char* arg, char* full_path, size_t size) {
+  char resolved_path[1024];
+  if (resolve_file_pattern(arg, resolved_path, sizeof(resolved_path)) != 0) {
+    return -1;
+  }
+  clean_and_expand_path(resolved_path, full_path, size);
+  return 0;
+}
+
+// Timing check of a DAC waveform as it would be streamed
+static bool validate_dac_timing(const char* path, uint32_t min_delay, bool delta, uint64_t service_cycles,
+                                uint64_t trigger_cycles, double spi_hz) {
+  dac_waveform_stream_t* waveform = malloc(sizeof(dac_waveform_stream_t));
+  if (waveform == NULL) {
+    fprintf(stderr, "Failed to allocate memory for waveform\n");
+    return false;
+  }
+  if (dac_waveform_stream_open(waveform, path, min_delay, delta) != 0) {
+    free(waveform);
+    return false; // Error already printed
+  }
+  
+  printf("DAC waveform '%s':\n", path);
+  timing_trace_t trace;
+  timing_trace_init(&trace, "DAC", min_delay, trigger_cycles);
+  uint32_t command = 0;
+  while (!dac_waveform_stream_iteration_done(waveform)) {
+    const uint32_t* run;
+    uint32_t run_commands;
+    uint32_t run_words = dac_waveform_stream_peek(waveform, DAC_WAVEFORM_REFILL_WORDS, false, &run, &run_commands);
+    if (run_words == 0) break;
+    for (uint32_t pos = 0; pos < run_words; pos += dac_waveform_cmd_words(run[pos])) {
+      if (dac_waveform_cmd_starts_line(run[pos])) command++;
+      timing_trace_add_dac(&trace, &run[pos], command);
+    }
+    dac_waveform_stream_consume(waveform, run_words);
+  }
+  bool ok = !waveform->error && !trace.error;
+  dac_waveform_stream_close(waveform);
+  free(waveform);
+  if (!ok) {
+    timing_trace_free(&trace);
+    return false;
+  }
+  
+  printf("  %u commands, %.3f ms per iteration, %llu trigger wait%s\n",
+         trace.commands, trace.cycle / spi_hz * 1e3, trace.trigger_waits, trace.trigger_waits == 1 ? "" : "s");
+  if (trace.violations > 0) {
+    printf("  Timing: %llu command%s below the %u-cycle minimum DAC delay (the DAC would halt)\n",
+           trace.violations, trace.violations == 1 ? "" : "s", min_delay);
+  } else {
+    printf("  Timing: every delay meets the %u-cycle minimum DAC delay\n", min_delay);
+  }
+  timing_fifo_report_t report;
+  timing_check_fifo(&trace, false, DAC_CMD_FIFO_WORDCOUNT - 1, service_cycles, &report);
+  ok = timing_print_fifo(&report, "Command FIFO", spi_hz) && trace.violations == 0;
+  timing_trace_free(&trace);
+  return ok;
+}
+
+// Timing check of an ADC command file, including the data it produces
+static bool validate_adc_timing(const char* path, uint32_t min_delay, uint64_t cmd_service_cycles,
+                                uint64_t data_service_cycles, uint64_t trigger_cycles, double spi_hz) {
+  size_t word_count = 0;
+  int command_count = 0;
+  uint32_t* words = adc_command_file_words(path, &word_count, &command_count);
+  if (words == NULL) {
+    return false; // Error already printed
+  }
+  
+  printf("ADC command file '%s':\n", path);
+  timing_trace_t trace;
+  timing_trace_init(&trace, "ADC", min_delay, trigger_cycles);
+  uint32_t command = 0;
+  for (size_t pos = 0; pos < word_count; pos += adc_cmd_words(words[pos])) {
+    timing_trace_add_adc(&trace, &words[pos], ++command);
+  }
+  free(words);
+  if (trace.error) {
+    timing_trace_free(&trace);
+    return false;
+  }
+  
+  printf("  %u commands, %.3f ms per iteration, %llu trigger wait%s\n",
+         trace.commands, trace.cycle / spi_hz * 1e3, trace.trigger_waits, trace.trigger_waits == 1 ? "" : "s");
+  if (trace.violations > 0) {
+    printf("  Timing: %llu command%s below the %u-cycle minimum ADC delay (the ADC would halt)\n",
+           trace.violations, trace.violations == 1 ? "" : "s", min_delay);
+  } else {
+    printf("  Timing: every delay meets the %u-cycle minimum ADC delay\n", min_delay);
+  }
+  timing_fifo_report_t report;
+  timing_check_fifo(&trace, false, ADC_CMD_FIFO_WORDCOUNT - 1, cmd_service_cycles, &report);
+  bool ok = timing_print_fifo(&report, "Command FIFO", spi_hz);
+  timing_check_fifo(&trace, true, ADC_DATA_FIFO_WORDCOUNT, data_service_cycles, &report);
+  ok = timing_print_fifo(&report, "Data FIFO", spi_hz) && ok && trace.violations == 0;
+  timing_trace_free(&trace);
+  return ok;
+}
+
+// Check DAC waveform and ADC command file timing and FIFO occupancy before a run
+int cmd_validate_waveform(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  bool has_dac = strcmp(args[0], "-") != 0;
+  bool has_adc = arg_count > 1 && strcmp(args[1], "-") != 0;
+  if (!has_dac && !has_adc) {
+    fprintf(stderr, "validate_waveform needs a DAC waveform file, an ADC command file, or both.\n");
+    return -1;
+  }
+  
+  // Optional service period (default: each stream's poll policy maximum sleep) and trigger period
+  uint32_t service_us = 0;
+  uint32_t trigger_us = 0;
+  if (arg_count > 2) {
+    char* endptr;
+    service_us = parse_value(args[2], &endptr);
+    if (*endptr != '\0' || service_us == 0) {
+      fprintf(stderr, "Invalid service period for validate_waveform: '%s'. Must be a positive number of microseconds.\n", args[2]);
+      return -1;
+    }
+  }
+  if (arg_count > 3) {
+    char* endptr;
+    trigger_us = parse_value(args[3], &endptr);
+    if (*endptr != '\0') {
+      fprintf(stderr, "Invalid trigger period for validate_waveform: '%s'. Must be a number of microseconds.\n", args[3]);
+      return -1;
+    }
+  }
+  
+  // Clock and minimum delays from the status readback
+  double spi_hz = sys_sts_get_spi_clk_freq_hz(ctx->sys_sts, *(ctx->verbose));
+  if (spi_hz <= 0.0) {
+    fprintf(stderr, "SPI clock frequency reads 0 Hz. Turn the system on before validate_waveform.\n");
+    return -1;
+  }
+  uint32_t dac_min_delay = sys_sts_get_dac_delay_too_short_time(ctx->sys_sts, *(ctx->verbose)) + 1;
+  uint32_t adc_min_delay = sys_sts_get_adc_delay_too_short_time(ctx->sys_sts, *(ctx->verbose)) + 1;
+  double cycles_per_us = spi_hz / 1e6;
+  uint64_t trigger_cycles = (uint64_t)(trigger_us * cycles_per_us);
+  uint32_t dac_cmd_us = service_us ? service_us : poll_policies[POLL_STREAM_DAC_CMD].max_sleep_us;
+  uint32_t adc_cmd_us = service_us ? service_us : poll_policies[POLL_STREAM_ADC_CMD].max_sleep_us;
+  uint32_t adc_data_us = service_us ? service_us : poll_policies[POLL_STREAM_ADC_DATA].max_sleep_us;
+  
+  printf("Timing check at %.3f MHz SPI clock (minimum delay: DAC %u cycles, ADC %u cycles)\n",
+         spi_hz / 1e6, dac_min_delay, adc_min_delay);
+  if (trigger_us > 0) {
+    printf("Trigger waits: %u us per trigger\n", trigger_us);
+  } else {
+    printf("Trigger waits: unknown length, the host catches up during each one\n");
+  }
+  
+  bool ok = true;
+  char path[1024];
+  if (has_dac) {
+    if (resolve_validate_path(args[0], path, sizeof(path)) != 0) return -1;
+    bool delta = has_flag(flags, flag_count, FLAG_DELTA);
+    if (delta && validate_delta_pre_delay(ctx) != 0) return -1;
+    ok = validate_dac_timing(path, dac_min_delay, delta, (uint64_t)(dac_cmd_us * cycles_per_us),
+                             trigger_cycles, spi_hz) && ok;
+  }
+  if (has_adc) {
+    if (resolve_validate_path(args[1], path, sizeof(path)) != 0) return -1;
+    ok = validate_adc_timing(path, adc_min_delay, (uint64_t)(adc_cmd_us * cycles_per_us),
+                             (uint64_t)(adc_data_us * cycles_per_us), trigger_cycles, spi_hz) && ok;
+  }
+  
+  printf("Result: %s\n", ok ? "PASS" : "FAIL");
+  return ok ? 0 : -1;
+}
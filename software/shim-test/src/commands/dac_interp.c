@@ -0,0 +1,85 @@
+#include <string.h>
+#include <math.h>
+#include "dac_interp.h"
+
+// Half a frame (4 channels) per 128-bit vector (NEON on the Zynq, SSE on x86)
+typedef float interp_vec_t __attribute__((vector_size(4 * sizeof(float))));
+typedef int32_t interp_mask_t __attribute__((vector_size(4 * sizeof(int32_t))));
+typedef int16_t interp_half_t __attribute__((vector_size(4 * sizeof(int16_t))));
+
+// Widen half a point to floats
+static interp_vec_t load_half(const int16_t vals[4]) {
+  interp_half_t half;
+  memcpy(&half, vals, sizeof(half));
+  return __builtin_convertvector(half, interp_vec_t);
+}
+
+// Clamp to the DAC range, round half away from zero and narrow to half a frame
+static void store_half(interp_vec_t x, int16_t vals[4]) {
+  const interp_vec_t max = (interp_vec_t){0} + (float)DAC_INTERP_MAX_CODE;
+  const interp_mask_t sign = (interp_mask_t){0} + INT32_MIN;
+  interp_mask_t over = x > max;
+  interp_mask_t under = x < -max;
+  x = (interp_vec_t)(((interp_mask_t)x & ~(over | under)) | ((interp_mask_t)max & over) | ((interp_mask_t)-max & under));
+
+  interp_vec_t half = (interp_vec_t)(((interp_mask_t)x & sign) | (interp_mask_t)((interp_vec_t){0} + 0.5f));
+  interp_half_t out = __builtin_convertvector(__builtin_convertvector(x + half, interp_mask_t), interp_half_t);
+  memcpy(vals, &out, sizeof(out));
+}
+
+// Start a segment of steps frames from "from" to "to" (before/after may be NULL: the segment's own end is used)
+void dac_interp_init(dac_interp_t* interp, dac_interp_mode_t mode, const int16_t before[8], const int16_t from[8],
+                     const int16_t to[8], const int16_t after[8], uint32_t steps) {
+  interp->mode = mode;
+  memcpy(interp->points[0], (before != NULL) ? before : from, sizeof(interp->points[0]));
+  memcpy(interp->points[1], from, sizeof(interp->points[1]));
+  memcpy(interp->points[2], to, sizeof(interp->points[2]));
+  memcpy(interp->points[3], (after != NULL) ? after : to, sizeof(interp->points[3]));
+  interp->steps = steps;
+  interp->next = 1;
+}
+
+// Generate up to max_frames of the remaining frames (returns the number generated)
+uint32_t dac_interp_generate(dac_interp_t* interp, int16_t (*frames)[8], uint32_t max_frames) {
+  interp_vec_t p[4][2];
+  for (int i = 0; i < 4; i++) {
+    p[i][0] = load_half(&interp->points[i][0]);
+    p[i][1] = load_half(&interp->points[i][4]);
+  }
+
+  uint32_t count = 0;
+  while (count < max_frames && interp->next <= interp->steps) {
+    float t = (float)interp->next / (float)interp->steps;
+    float w0 = 0.0f, w1, w2, w3 = 0.0f;
+    switch (interp->mode) {
+      case DAC_INTERP_COSINE:
+        w2 = (1.0f - cosf((float)M_PI * t)) * 0.5f;
+        w1 = 1.0f - w2;
+        break;
+      case DAC_INTERP_CUBIC: {
+        float t2 = t * t;
+        float t3 = t2 * t;
+        w0 = (-t3 + 2.0f * t2 - t) * 0.5f;
+        w1 = (3.0f * t3 - 5.0f * t2 + 2.0f) * 0.5f;
+        w2 = (-3.0f * t3 + 4.0f * t2 + t) * 0.5f;
+        w3 = (t3 - t2) * 0.5f;
+        break;
+      }
+      default:
+        w2 = t;
+        w1 = 1.0f - t;
+        break;
+    }
+    for (int h = 0; h < 2; h++) {
+      store_half(w0 * p[0][h] + w1 * p[1][h] + w2 * p[2][h] + w3 * p[3][h], &frames[count][4 * h]);
+    }
+    interp->next++;
+    count++;
+  }
+  return count;
+}
+
+// True once every frame of the segment has been generated
+bool dac_interp_done(const dac_interp_t* interp) {
+  return interp->next > interp->steps;
+}
@@ -0,0 +1,524 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include "dac_stream_engine.h"
+#include "sys_sts.h"
+#include "dac_ctrl.h"
+#include "rt_profile.h"
+#include "sts_sampler.h"
+#include "metrics.h"
+#include "trace.h"
+
+//////////////////// Queued command timeline ////////////////////
+
+// Drop the commands the DAC core has taken, leaving fifo_words queued
+static void queue_sync(dac_stream_session_t* session, uint32_t fifo_words) {
+  while (session->queue_count > 0 && session->queued_words > fifo_words) {
+    // The core has at least started the oldest command; its remaining time is not counted
+    const dac_stream_queued_t* cmd = &session->queue[session->queue_head];
+    session->queued_words -= cmd->words;
+    session->queued_cycles -= cmd->cycles;
+    session->queue_head = (session->queue_head + 1) % DAC_STREAM_QUEUE_COMMANDS;
+    session->queue_count--;
+  }
+}
+
+// Add a run of written commands to the timeline
+static void queue_push(dac_stream_session_t* session, const uint32_t* words, uint32_t word_count) {
+  uint32_t pos = 0;
+  while (pos < word_count) {
+    uint32_t cmd_words = dac_waveform_cmd_words(words[pos]);
+    dac_stream_queued_t* cmd = &session->queue[(session->queue_head + session->queue_count) % DAC_STREAM_QUEUE_COMMANDS];
+    cmd->words = cmd_words;
+    cmd->cycles = dac_waveform_cmd_cycles(words[pos], session->min_delay);
+    session->queue_count++;
+    session->queued_words += cmd_words;
+    session->queued_cycles += cmd->cycles;
+    pos += cmd_words;
+  }
+}
+
+// Time until the queued commands run out
+static uint64_t queue_slack_ns(const dac_stream_session_t* session) {
+  return (uint64_t)((double)session->queued_cycles * 1e9 / session->spi_hz);
+}
+
+// Record the slack found at a service (the first service, with nothing queued yet, is not counted)
+static void slack_record(dac_stream_slack_t* slack, double slack_us, bool empty) {
+  slack->current_us = slack_us;
+  if (slack->services++ == 0) {
+    return;
+  }
+  if (slack->services == 2 || slack_us < slack->min_us) {
+    slack->min_us = slack_us;
+  }
+  slack->sum_us += slack_us;
+  if (slack_us < DAC_STREAM_LOW_SLACK_US) {
+    slack->low_services++;
+  }
+  if (empty) {
+    slack->empty_services++;
+  }
+}
+
+// Print slack statistics on one line after a prefix
+static void slack_print(const char* prefix, const dac_stream_slack_t* slack) {
+  if (slack->services < 2) {
+    printf("%sSlack: not enough services to measure\n", prefix);
+    return;
+  }
+  printf("%sSlack: current %.0f us, min %.0f us, mean %.0f us over %llu services; "
+         "%llu below %u us, %llu found the FIFO empty\n",
+         prefix, slack->current_us, slack->min_us, slack->sum_us / (slack->services - 1),
+         slack->services - 1, slack->low_services, DAC_STREAM_LOW_SLACK_US, slack->empty_services);
+}
+
+//////////////////// Sessions ////////////////////
+
+// Free a session and everything it owns
+static void free_session(dac_stream_session_t* session) {
+  if (session->waveform != NULL) {
+    dac_waveform_stream_close(session->waveform);
+    free(session->waveform);
+  }
+  free(session->queue);
+  free(session);
+}
+
+// Report a finished session, then detach it from the engine
+static void retire_session(dac_stream_engine_t* engine, dac_stream_session_t* session) {
+  command_context_t* ctx = engine->ctx;
+  uint8_t board = session->board;
+  char prefix[48];
+  snprintf(prefix, sizeof(prefix), "DAC Command Stream[%d]: ", board);
+
+  if (*(session->should_stop)) {
+    printf("%sStopping (user requested), sent %llu total commands (%llu total words)\n",
+           prefix, session->commands_sent, session->words_sent);
+  } else if (session->failed) {
+    printf("%sStopped early, sent %llu total commands (%llu total words)\n",
+           prefix, session->commands_sent, session->words_sent);
+  } else {
+    printf("%sCompleted, sent %llu total commands (%llu total words, %d iteration%s)\n",
+           prefix, session->commands_sent, session->words_sent,
+           session->iterations, session->iterations == 1 ? "" : "s");
+  }
+  if (*(ctx->verbose)) {
+    printf("%s%llu bursts, %.1f words/burst\n", prefix, session->bursts,
+           session->bursts > 0 ? (double)session->words_sent / session->bursts : 0.0);
+    poll_stats_print(prefix, &session->poll.stats);
+  }
+  if (*(ctx->verbose) || session->slack.empty_services > 0) {
+    slack_print(prefix, &session->slack);
+  }
+  poll_sched_finish(&session->poll);
+
+  pthread_mutex_lock(&engine->lock);
+  engine->board_slack[board] = session->slack;
+  engine->sessions[board] = NULL;
+  engine->active_count--;
+  ctx->dac_cmd_stream_running[board] = false;
+  pthread_cond_broadcast(&engine->session_retired);
+  pthread_mutex_unlock(&engine->lock);
+
+  free_session(session);
+}
+
+// Move a session past a finished iteration (marks it done after the last one)
+static void next_iteration(command_context_t* ctx, dac_stream_session_t* session) {
+  dac_waveform_stream_t* waveform = session->waveform;
+
+  // A waveform parsed while streaming is only fully known after its first pass
+  if (!session->gaps_checked && waveform->summary_done) {
+    char prefix[48];
+    snprintf(prefix, sizeof(prefix), "DAC Command Stream[%d]: ", session->board);
+    dac_waveform_check_trigger_gaps(&waveform->summary, *(ctx->verbose));
+    if (waveform->summary.delta_count > 0) {
+      dac_waveform_print_savings(&waveform->summary, prefix);
+    }
+    session->gaps_checked = true;
+  }
+
+  session->current_iteration++;
+  if (session->current_iteration >= session->iterations || *(session->should_stop)) {
+    session->done = true;
+    return;
+  }
+  if (dac_waveform_stream_rewind(waveform) != 0) {
+    fprintf(stderr, "DAC Command Stream[%d]: Stopping at invalid waveform data in '%s'\n",
+            session->board, session->file_path);
+    session->failed = true;
+    session->done = true;
+    return;
+  }
+  if (*(ctx->verbose)) {
+    printf("DAC Command Stream[%d]: Completed iteration %d/%d, starting next iteration\n",
+           session->board, session->current_iteration, session->iterations);
+  }
+}
+
+// Write the next run of whole commands that fits in the free space
+// (the final command of the final iteration goes out with its CONT bit cleared)
+static uint32_t refill_session(command_context_t* ctx, dac_stream_session_t* session) {
+  dac_waveform_stream_t* waveform = session->waveform;
+  bool last_iteration = (session->current_iteration == session->iterations - 1);
+
+  const uint32_t* run;
+  uint32_t run_commands;
+  uint32_t run_words = dac_waveform_stream_peek(waveform, session->words_free, last_iteration, &run, &run_commands);
+  if (run_words == 0) {
+    return 0;
+  }
+  TRACE_BEGIN(trace_write_ns);
+  dac_write_burst(ctx->dac_ctrl, session->board, run, run_words);
+  TRACE_END(trace_write_ns, TRACE_FIFO_WRITE, POLL_STREAM_DAC_CMD, session->board, run_words);
+  queue_push(session, run, run_words);
+  dac_waveform_stream_consume(waveform, run_words);
+
+  poll_sched_consumed(&session->poll, run_words);
+  session->words_free -= run_words;
+  session->bursts++;
+  session->commands_sent += run_commands;
+  session->words_sent += run_words;
+
+  if (*(ctx->verbose)) {
+    printf("DAC Command Stream[%d]: Iteration %d/%d, wrote %u commands (%u words) [FIFO: %llu/%u words, slack %.0f us]\n",
+           session->board, session->current_iteration + 1, session->iterations, run_commands, run_words,
+           session->queued_words, DAC_CMD_FIFO_WORDCOUNT, queue_slack_ns(session) / 1e3);
+  }
+  return run_words;
+}
+
+//////////////////// Feeder thread ////////////////////
+
+// Feeder thread: one status sweep per pass, then refill the boards earliest deadline first
+static void* feeder_thread(void* arg) {
+  dac_stream_engine_t* engine = (dac_stream_engine_t*)arg;
+  command_context_t* ctx = engine->ctx;
+  dac_stream_session_t* polled[8];   // Sessions still streaming
+  dac_stream_session_t* order[8];    // Sessions with room for their next command, least slack first
+  TRACE_THREAD("dac_feeder");
+
+  while (true) {
+    // Collect the active sessions (sleep while there are none)
+    int count = 0;
+    pthread_mutex_lock(&engine->lock);
+    engine->status.passes = engine->passes;
+    engine->status.idle_passes = engine->idle_passes;
+    engine->status.reordered = engine->reordered;
+    engine->status.status_polls = engine->status_polls;
+    engine->status.words_sent = engine->words_sent;
+    engine->status.poll = engine->poll.stats;
+    while (true) {
+      count = 0;
+      for (int board = 0; board < 8; board++) {
+        if (engine->sessions[board] != NULL) {
+          polled[count++] = engine->sessions[board];
+        }
+      }
+      if (count > 0 || engine->shutdown) break;
+      pthread_cond_wait(&engine->wake, &engine->lock);
+    }
+    pthread_mutex_unlock(&engine->lock);
+    if (count == 0) break; // Shutdown with nothing left to stream
+
+    // Read each FIFO's level once and work out each board's slack
+    int ready = 0;
+    for (int i = 0; i < count; i++) {
+      dac_stream_session_t* session = polled[i];
+      if (*(session->should_stop)) {
+        session->done = true;
+        continue;
+      }
+
+      TRACE_BEGIN(trace_poll_ns);
+      uint32_t fifo_status = sts_sampler_word(ctx->sys_sts, DAC_CMD_FIFO_STS_OFFSET(session->board),
+                                              session->sts_not_before_ns);
+      TRACE_END(trace_poll_ns, TRACE_FIFO_POLL, POLL_STREAM_DAC_CMD, session->board, FIFO_STS_WORD_COUNT(fifo_status));
+      engine->status_polls++;
+      if (FIFO_PRESENT(fifo_status) == 0) {
+        fprintf(stderr, "DAC Command Stream[%d]: FIFO not present, stopping stream\n", session->board);
+        session->failed = true;
+        session->done = true;
+        continue;
+      }
+
+      uint32_t fifo_words = FIFO_STS_WORD_COUNT(fifo_status);
+      queue_sync(session, fifo_words);
+      uint64_t slack_ns = queue_slack_ns(session);
+      slack_record(&session->slack, slack_ns / 1e3, fifo_words == 0);
+      if (session->slack.services > 1) {
+        metrics_fifo_slack(session->poll.metrics, slack_ns);
+      }
+
+      session->words_free = DAC_CMD_FIFO_WORDCOUNT - (fifo_words + 1); // +1 for safety margin
+      session->words_needed = dac_waveform_stream_next_words(session->waveform);
+      if (session->waveform->error) {
+        fprintf(stderr, "DAC Command Stream[%d]: Stopping at invalid waveform data in '%s'\n",
+                session->board, session->file_path);
+        session->failed = true;
+        session->done = true;
+        continue;
+      }
+      poll_sched_observe(&session->poll, session->words_free, session->words_needed);
+      if (session->words_free < session->words_needed) {
+        continue;
+      }
+
+      // Insert by deadline: least slack first
+      int pos = ready++;
+      while (pos > 0 && slack_ns < queue_slack_ns(order[pos - 1])) {
+        order[pos] = order[pos - 1];
+        pos--;
+      }
+      order[pos] = session;
+    }
+    engine->passes++;
+
+    // Refill each board in deadline order
+    uint64_t pass_words = 0;
+    bool reordered = false;
+    for (int i = 0; i < ready; i++) {
+      dac_stream_session_t* session = order[i];
+      reordered |= (i > 0 && session->board < order[i - 1]->board);
+      uint32_t written = refill_session(ctx, session);
+      if (written > 0) {
+        session->sts_not_before_ns = sts_sampler_now_ns();
+      }
+      if (session->waveform->error) {
+        fprintf(stderr, "DAC Command Stream[%d]: Stopping at invalid waveform data in '%s'\n",
+                session->board, session->file_path);
+        session->failed = true;
+        session->done = true;
+        continue;
+      }
+      pass_words += written;
+      if (dac_waveform_stream_iteration_done(session->waveform)) {
+        next_iteration(ctx, session);
+      }
+    }
+    engine->words_sent += pass_words;
+    if (reordered) {
+      engine->reordered++;
+    }
+    if (pass_words == 0) {
+      engine->idle_passes++;
+    }
+
+    // Publish slack, retire finished sessions, and find the next deadline
+    uint64_t sleep_ns = UINT64_MAX;
+    for (int i = 0; i < count; i++) {
+      dac_stream_session_t* session = polled[i];
+      if (session->done) {
+        retire_session(engine, session);
+        continue;
+      }
+      pthread_mutex_lock(&engine->lock);
+      engine->board_slack[session->board] = session->slack;
+      dac_stream_session_status_t* status = &engine->board_status[session->board];
+      status->current_iteration = session->current_iteration;
+      status->commands_sent = session->commands_sent;
+      status->words_sent = session->words_sent;
+      status->bursts = session->bursts;
+      pthread_mutex_unlock(&engine->lock);
+
+      // Wake for a batch of free space, or well before the queued commands run out
+      // (a queue of trigger waits alone has no known deadline; the drain rate estimate covers it)
+      uint64_t eta_ns = poll_sched_predict_ns(&session->poll, session->words_free, session->words_needed);
+      if (session->queued_cycles > 0) {
+        uint64_t slack_ns = queue_slack_ns(session) * DAC_STREAM_SLACK_SLEEP_PCT / 100;
+        if (slack_ns < eta_ns) {
+          eta_ns = slack_ns;
+        }
+      }
+      if (eta_ns < sleep_ns) {
+        sleep_ns = eta_ns;
+      }
+    }
+    if (sleep_ns != UINT64_MAX) {
+      poll_sched_sleep_ns(&engine->poll, sleep_ns);
+    }
+  }
+  return NULL;
+}
+
+// Create the engine and start its thread
+static dac_stream_engine_t* create_engine(command_context_t* ctx) {
+  dac_stream_engine_t* engine = calloc(1, sizeof(dac_stream_engine_t));
+  if (engine == NULL) {
+    fprintf(stderr, "DAC Stream Engine: Failed to allocate engine\n");
+    return NULL;
+  }
+  engine->ctx = ctx;
+  poll_sched_init(&engine->poll, POLL_STREAM_DAC_CMD, 0, 0.0);
+  pthread_mutex_init(&engine->lock, NULL);
+  pthread_cond_init(&engine->wake, NULL);
+  pthread_cond_init(&engine->session_retired, NULL);
+
+  if (rt_thread_create(&engine->feeder_thread, RT_CLASS_FEED, feeder_thread, engine) != 0) {
+    fprintf(stderr, "DAC Stream Engine: Failed to create feeder thread: %s\n", strerror(errno));
+    free(engine);
+    return NULL;
+  }
+  if (*(ctx->verbose)) {
+    printf("DAC Stream Engine: Started feeder thread\n");
+  }
+  return engine;
+}
+
+//////////////////// Public interface ////////////////////
+
+// Start streaming an open waveform to a board (takes ownership of params->waveform; creates the engine on first use)
+int dac_stream_engine_start_session(command_context_t* ctx, const dac_command_stream_params_t* params) {
+  uint8_t board = params->board;
+
+  dac_stream_session_t* session = calloc(1, sizeof(dac_stream_session_t));
+  if (session != NULL) {
+    session->queue = malloc(DAC_STREAM_QUEUE_COMMANDS * sizeof(dac_stream_queued_t));
+  }
+  if (session == NULL || session->queue == NULL) {
+    fprintf(stderr, "DAC Command Stream[%d]: Failed to allocate command timeline\n", board);
+    free(session);
+    dac_waveform_stream_close(params->waveform);
+    free(params->waveform);
+    return -1;
+  }
+  session->board = board;
+  snprintf(session->file_path, sizeof(session->file_path), "%s", params->file_path);
+  session->waveform = params->waveform;
+  rt_prefault(session->queue, DAC_STREAM_QUEUE_COMMANDS * sizeof(dac_stream_queued_t));
+  rt_prefault(session->waveform->window, session->waveform->window != NULL ? DAC_WAVEFORM_WINDOW_WORDS * sizeof(uint32_t) : 0);
+  session->iterations = params->iterations;
+  session->should_stop = params->should_stop;
+  session->gaps_checked = params->waveform->summary_done; // Checked before the stream started
+  session->min_delay = sys_sts_get_dac_delay_too_short_time(ctx->sys_sts, false) + 1;
+  session->spi_hz = sys_sts_get_spi_clk_freq_hz(ctx->sys_sts, false);
+  if (session->spi_hz <= 0.0) {
+    fprintf(stderr, "DAC Command Stream[%d]: SPI clock frequency reads 0 Hz; is the SPI clock running?\n", board);
+    free_session(session);
+    return -1;
+  }
+  poll_sched_init(&session->poll, POLL_STREAM_DAC_CMD, DAC_CMD_FIFO_WORDCOUNT - 1, poll_max_rate_dac_cmd(ctx->sys_sts));
+  poll_sched_track(&session->poll, board);
+
+  if (ctx->dac_stream_engine == NULL) {
+    ctx->dac_stream_engine = create_engine(ctx);
+    if (ctx->dac_stream_engine == NULL) {
+      free_session(session);
+      return -1;
+    }
+  }
+  dac_stream_engine_t* engine = ctx->dac_stream_engine;
+
+  if (*(ctx->verbose)) {
+    dac_waveform_stream_t* waveform = session->waveform;
+    printf("DAC Command Stream[%d]: Started streaming from file '%s' (%s, %d iteration%s)\n",
+           board, session->file_path,
+           waveform->compiled ? "compiled" : waveform->resident ? "text, parsed" : "text, parsed while streaming",
+           session->iterations, session->iterations == 1 ? "" : "s");
+  }
+
+  // Hand the session to the feeder
+  pthread_mutex_lock(&engine->lock);
+  memset(&engine->board_slack[board], 0, sizeof(engine->board_slack[board]));
+  memset(&engine->board_status[board], 0, sizeof(engine->board_status[board]));
+  engine->board_slack_valid[board] = true;
+  engine->sessions[board] = session;
+  engine->active_count++;
+  pthread_cond_broadcast(&engine->wake);
+  pthread_mutex_unlock(&engine->lock);
+  return 0;
+}
+
+// Signal a board's stream to stop and wait until it is retired
+void dac_stream_engine_stop_session(command_context_t* ctx, uint8_t board) {
+  dac_stream_engine_t* engine = ctx->dac_stream_engine;
+  ctx->dac_cmd_stream_stop[board] = true;
+  if (engine == NULL) {
+    return;
+  }
+
+  pthread_mutex_lock(&engine->lock);
+  while (engine->sessions[board] != NULL) {
+    pthread_cond_wait(&engine->session_retired, &engine->lock);
+  }
+  pthread_mutex_unlock(&engine->lock);
+}
+
+// Stop all streams and the feeder thread (call once at exit)
+void dac_stream_engine_shutdown(command_context_t* ctx) {
+  dac_stream_engine_t* engine = ctx->dac_stream_engine;
+  if (engine == NULL) {
+    return;
+  }
+
+  for (int board = 0; board < 8; board++) {
+    dac_stream_engine_stop_session(ctx, (uint8_t)board);
+  }
+
+  pthread_mutex_lock(&engine->lock);
+  engine->shutdown = true;
+  pthread_cond_broadcast(&engine->wake);
+  pthread_mutex_unlock(&engine->lock);
+  pthread_join(engine->feeder_thread, NULL);
+  poll_sched_finish(&engine->poll);
+
+  pthread_cond_destroy(&engine->session_retired);
+  pthread_cond_destroy(&engine->wake);
+  pthread_mutex_destroy(&engine->lock);
+  free(engine);
+  ctx->dac_stream_engine = NULL;
+}
+
+// Print feeder and per-board slack statistics
+void dac_stream_engine_print_status(command_context_t* ctx) {
+  dac_stream_engine_t* engine = ctx->dac_stream_engine;
+  if (engine == NULL) {
+    printf("DAC stream engine not started (no DAC command stream since launch).\n");
+    return;
+  }
+
+  // Copy the published counters under the lock, print outside it so the feeder is never held up by the terminal
+  int active_count;
+  dac_stream_engine_status_t status;
+  dac_stream_slack_t slack[8];
+  bool valid[8];
+  bool live[8];
+  dac_stream_session_status_t sessions[8];
+  int iterations[8];
+  pthread_mutex_lock(&engine->lock);
+  active_count = engine->active_count;
+  status = engine->status;
+  memcpy(slack, engine->board_slack, sizeof(slack));
+  memcpy(valid, engine->board_slack_valid, sizeof(valid));
+  memcpy(sessions, engine->board_status, sizeof(sessions));
+  for (int board = 0; board < 8; board++) {
+    live[board] = (engine->sessions[board] != NULL);
+    iterations[board] = live[board] ? engine->sessions[board]->iterations : 0;
+  }
+  pthread_mutex_unlock(&engine->lock);
+
+  printf("DAC stream engine: %d active stream(s)\n", active_count);
+  printf("  Feeder passes: %llu (%llu idle, %.1f%%), %llu refilled out of board order\n",
+         status.passes, status.idle_passes,
+         status.passes > 0 ? 100.0 * status.idle_passes / status.passes : 0.0, status.reordered);
+  printf("  Status polls:  %llu\n", status.status_polls);
+  poll_stats_print("  Between passes: ", &status.poll);
+  printf("  Words sent:    %llu\n", status.words_sent);
+  for (int board = 0; board < 8; board++) {
+    if (!valid[board]) continue;
+    char prefix[48];
+    if (live[board]) {
+      printf("  Board %d: iteration %d/%d, %llu commands (%llu words) sent, %llu bursts\n",
+             board, sessions[board].current_iteration + 1, iterations[board],
+             sessions[board].commands_sent, sessions[board].words_sent, sessions[board].bursts);
+      snprintf(prefix, sizeof(prefix), "    ");
+    } else {
+      snprintf(prefix, sizeof(prefix), "  Board %d (last stream): ", board);
+    }
+    slack_print(prefix, &slack[board]);
+  }
+}
@@ -0,0 +1,714 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "dac_waveform.h"
+#include "capture_file.h"
+
+_Static_assert(sizeof(dac_waveform_header_t) == DAC_WAVEFORM_HEADER_SIZE, "DAC waveform header size");
+
+// Map a whole file read-only for sequential access (an empty file maps to NULL)
+static int map_file(const char* path, void** map, size_t* size) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    fprintf(stderr, "Failed to open waveform file '%s': %s\n", path, strerror(errno));
+    return -1;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    fprintf(stderr, "Failed to stat waveform file '%s': %s\n", path, strerror(errno));
+    close(fd);
+    return -1;
+  }
+  *size = (size_t)st.st_size;
+  *map = NULL;
+  if (*size > 0) {
+    *map = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (*map == MAP_FAILED) {
+      fprintf(stderr, "Failed to map waveform file '%s': %s\n", path, strerror(errno));
+      *map = NULL;
+      close(fd);
+      return -1;
+    }
+    madvise(*map, *size, MADV_SEQUENTIAL);
+  }
+  close(fd);
+  return 0;
+}
+
+//////////////////// Parsing and encoding ////////////////////
+
+// Start parsing mapped text
+void dac_waveform_parser_init(dac_waveform_parser_t* parser, const char* text, size_t size) {
+  parser->text = text;
+  parser->size = size;
+  parser->offset = 0;
+  parser->line_num = 0;
+  memset(parser->points, 0, sizeof(parser->points));
+  parser->interp.steps = 0;
+  parser->interp.next = 1;
+  parser->frame_count = 0;
+  parser->frame_pos = 0;
+}
+
+// Copy the line at the parser offset (truncated to DAC_WAVEFORM_MAX_LINE - 1 characters)
+// and return the offset of the following line
+static size_t peek_line(const dac_waveform_parser_t* parser, char line[DAC_WAVEFORM_MAX_LINE]) {
+  const char* start = parser->text + parser->offset;
+  size_t remaining = parser->size - parser->offset;
+  const char* eol = memchr(start, '\n', remaining);
+  size_t len = (eol != NULL) ? (size_t)(eol - start) : remaining;
+  size_t copy = (len < DAC_WAVEFORM_MAX_LINE - 1) ? len : DAC_WAVEFORM_MAX_LINE - 1;
+  memcpy(line, start, copy);
+  line[copy] = '\0';
+  return parser->offset + len + (eol != NULL ? 1 : 0);
+}
+
+// First non-blank character of a line, or NULL for empty and comment lines
+static char* line_content(char* line) {
+  char* trimmed = line;
+  while (*trimmed == ' ' || *trimmed == '\t') trimmed++;
+  if (*trimmed == '\r' || *trimmed == '\0' || *trimmed == '#') {
+    return NULL;
+  }
+  return trimmed;
+}
+
+// Remember the values of a D/T/I line as the start of the next interpolation
+static void push_point(dac_waveform_parser_t* parser, const int16_t ch_vals[8]) {
+  memcpy(parser->points[0], parser->points[1], sizeof(parser->points[0]));
+  memcpy(parser->points[1], ch_vals, sizeof(parser->points[1]));
+}
+
+// Values of the next D/T/I line after the parser offset (false if another command or the end comes first)
+static bool peek_next_point(const dac_waveform_parser_t* parser, int16_t ch_vals[8]) {
+  char line[DAC_WAVEFORM_MAX_LINE];
+  dac_waveform_parser_t ahead = {.text = parser->text, .size = parser->size, .offset = parser->offset};
+  while (ahead.offset < ahead.size) {
+    ahead.offset = peek_line(&ahead, line);
+    char* trimmed = line_content(line);
+    if (trimmed == NULL || strncmp(trimmed, "NT", 2) == 0 || strncmp(trimmed, "ND", 2) == 0) {
+      continue;
+    }
+    char cmd_mode[3];
+    uint32_t value, steps;
+    memset(ch_vals, 0, 8 * sizeof(int16_t));
+    if (*trimmed == 'I') {
+      return sscanf(trimmed, "%2s %u %u %hd %hd %hd %hd %hd %hd %hd %hd", cmd_mode, &value, &steps,
+                    &ch_vals[0], &ch_vals[1], &ch_vals[2], &ch_vals[3],
+                    &ch_vals[4], &ch_vals[5], &ch_vals[6], &ch_vals[7]) == 11;
+    }
+    if (*trimmed == 'D' || *trimmed == 'T') {
+      int parsed = sscanf(trimmed, "%2s %u %hd %hd %hd %hd %hd %hd %hd %hd", cmd_mode, &value,
+                          &ch_vals[0], &ch_vals[1], &ch_vals[2], &ch_vals[3],
+                          &ch_vals[4], &ch_vals[5], &ch_vals[6], &ch_vals[7]);
+      return parsed == 2 || parsed == 10;
+    }
+    return false;
+  }
+  return false;
+}
+
+// Return the next interpolated frame as a delayed DAC_WR (false if the segment is finished)
+static bool next_frame(dac_waveform_parser_t* parser, waveform_command_t* cmd) {
+  if (parser->frame_pos == parser->frame_count) {
+    parser->frame_count = dac_interp_generate(&parser->interp, parser->frames, DAC_INTERP_BLOCK_FRAMES);
+    parser->frame_pos = 0;
+    if (parser->frame_count == 0) {
+      return false;
+    }
+  }
+  cmd->type = DAC_DELAY_CMD;
+  cmd->value = parser->interp_delay;
+  memcpy(cmd->ch_vals, parser->frames[parser->frame_pos++], sizeof(cmd->ch_vals));
+  cmd->cont = true;
+  return true;
+}
+
+// Parse an interpolation line and start expanding it: 0 = started, -1 = invalid line (error printed)
+static int start_interpolation(dac_waveform_parser_t* parser, const char* trimmed, int line_num) {
+  dac_interp_mode_t mode;
+  switch (trimmed[1]) {
+    case 'L': mode = DAC_INTERP_LINEAR; break;
+    case 'R': mode = DAC_INTERP_COSINE; break;
+    case 'C': mode = DAC_INTERP_CUBIC; break;
+    default:
+      fprintf(stderr, "Invalid line %d: interpolation must be 'IL' (linear), 'IR' (raised cosine) or 'IC' (cubic)\n", line_num);
+      return -1;
+  }
+
+  char cmd_mode[3];
+  uint32_t delay, steps;
+  int16_t ch_vals[8];
+  int parsed = sscanf(trimmed, "%2s %u %u %hd %hd %hd %hd %hd %hd %hd %hd", cmd_mode, &delay, &steps,
+                      &ch_vals[0], &ch_vals[1], &ch_vals[2], &ch_vals[3],
+                      &ch_vals[4], &ch_vals[5], &ch_vals[6], &ch_vals[7]);
+  if (parsed != 11) {
+    fprintf(stderr, "Invalid line %d: interpolation lines must have 11 fields (cmd_mode, delay, steps, 8 channels)\n", line_num);
+    return -1;
+  }
+  if (delay > 0x1FFFFFF) {
+    fprintf(stderr, "Invalid line %d: delay %u out of range (max 0x1FFFFFF or 33554431)\n", line_num, delay);
+    return -1;
+  }
+  if (steps < 1 || steps > DAC_INTERP_MAX_STEPS) {
+    fprintf(stderr, "Invalid line %d: steps %u out of range (1 to %u)\n", line_num, steps, DAC_INTERP_MAX_STEPS);
+    return -1;
+  }
+  for (int i = 0; i < 8; i++) {
+    if (ch_vals[i] < -32767 || ch_vals[i] > 32767) {
+      fprintf(stderr, "Invalid line %d: channel %d value %d out of range (-32767 to 32767)\n",
+              line_num, i, ch_vals[i]);
+      return -1;
+    }
+  }
+
+  // A cubic segment also needs the point after it (its own end if none follows)
+  int16_t after[8];
+  bool has_after = (mode == DAC_INTERP_CUBIC) && peek_next_point(parser, after);
+  dac_interp_init(&parser->interp, mode, parser->points[0], parser->points[1], ch_vals,
+                  has_after ? after : NULL, steps);
+  parser->interp_delay = delay;
+  parser->frame_count = 0;
+  parser->frame_pos = 0;
+  push_point(parser, ch_vals);
+  return 0;
+}
+
+// Parse the next command: 1 = command parsed, 0 = end of text, -1 = invalid line (error printed)
+int dac_waveform_parse_next(dac_waveform_parser_t* parser, waveform_command_t* cmd) {
+  char line[DAC_WAVEFORM_MAX_LINE];
+
+  if (next_frame(parser, cmd)) {
+    return 1;
+  }
+
+  while (parser->offset < parser->size) {
+    parser->offset = peek_line(parser, line);
+    parser->line_num++;
+    int line_num = parser->line_num;
+
+    // Skip empty lines and comments
+    char* trimmed = line_content(line);
+    if (trimmed == NULL) {
+      continue;
+    }
+
+    // Interpolation lines expand to delayed DAC_WRs
+    if (*trimmed == 'I') {
+      if (start_interpolation(parser, trimmed, line_num) != 0) {
+        return -1;
+      }
+      next_frame(parser, cmd);
+      return 1;
+    }
+
+    // Check if line starts with D, T, NT, or ND
+    bool is_noop_cmd = (strncmp(trimmed, "NT", 2) == 0 || strncmp(trimmed, "ND", 2) == 0);
+    if (!is_noop_cmd && *trimmed != 'D' && *trimmed != 'T') {
+      fprintf(stderr, "Invalid line %d: must start with 'D', 'T', 'NT', 'ND', or 'I'\n", line_num);
+      return -1;
+    }
+
+    char cmd_mode[3];
+    uint32_t value;
+    int16_t ch_vals[8] = {0};
+    int parsed;
+
+    if (is_noop_cmd) {
+      // NT or ND commands: only cmd_mode and value (no channel values allowed)
+      parsed = sscanf(trimmed, "%2s %u", cmd_mode, &value);
+      if (parsed != 2) {
+        fprintf(stderr, "Invalid line %d: NT/ND commands must have exactly cmd_mode and value\n", line_num);
+        return -1;
+      }
+    } else {
+      // D or T commands: can have channel values
+      parsed = sscanf(trimmed, "%2s %u %hd %hd %hd %hd %hd %hd %hd %hd",
+                      cmd_mode, &value, &ch_vals[0], &ch_vals[1], &ch_vals[2], &ch_vals[3],
+                      &ch_vals[4], &ch_vals[5], &ch_vals[6], &ch_vals[7]);
+      if (parsed < 2) {
+        fprintf(stderr, "Invalid line %d: must have at least cmd_mode and value\n", line_num);
+        return -1;
+      }
+      if (parsed != 2 && parsed != 10) {
+        fprintf(stderr, "Invalid line %d: must have either 2 fields (cmd_mode, value) or 10 fields (cmd_mode, value, 8 channels)\n", line_num);
+        return -1;
+      }
+    }
+
+    // Validate value range
+    if (value > 0x1FFFFFF) {
+      fprintf(stderr, "Invalid line %d: value %u out of range (max 0x1FFFFFF or 33554431)\n", line_num, value);
+      return -1;
+    }
+
+    // Validate channel values if present (only for D/T commands); a line without them writes zeros
+    if (!is_noop_cmd && parsed == 10) {
+      for (int i = 0; i < 8; i++) {
+        if (ch_vals[i] < -32767 || ch_vals[i] > 32767) {
+          fprintf(stderr, "Invalid line %d: channel %d value %d out of range (-32767 to 32767)\n",
+                  line_num, i, ch_vals[i]);
+          return -1;
+        }
+      }
+    }
+
+    if (is_noop_cmd) {
+      cmd->type = (cmd_mode[1] == 'T') ? DAC_NOOP_TRIGGER_CMD : DAC_NOOP_DELAY_CMD;
+    } else {
+      cmd->type = (cmd_mode[0] == 'T') ? DAC_TRIGGER_CMD : DAC_DELAY_CMD;
+      push_point(parser, ch_vals);
+    }
+    cmd->value = value;
+    memcpy(cmd->ch_vals, ch_vals, sizeof(cmd->ch_vals));
+    cmd->cont = true;
+    return 1;
+  }
+  return 0;
+}
+
+// Skip blank and comment lines; true if no command follows
+bool dac_waveform_parser_at_end(dac_waveform_parser_t* parser) {
+  char line[DAC_WAVEFORM_MAX_LINE];
+  if (parser->frame_pos < parser->frame_count || !dac_interp_done(&parser->interp)) {
+    return false;
+  }
+  while (parser->offset < parser->size) {
+    size_t next = peek_line(parser, line);
+    if (line_content(line) != NULL) {
+      return false;
+    }
+    parser->offset = next;
+    parser->line_num++;
+  }
+  return true;
+}
+
+// Reset a delta encoder (min_delay 0 disables delta encoding)
+void dac_waveform_encoder_init(dac_waveform_encoder_t* encoder, uint32_t min_delay) {
+  memset(encoder, 0, sizeof(*encoder));
+  encoder->min_delay = min_delay;
+}
+
+// Encode a command with CONT set into words (returns the word count: 1, 2 or 5)
+uint32_t dac_waveform_encode(dac_waveform_encoder_t* encoder, const waveform_command_t* cmd, uint32_t words[5]) {
+  bool is_trigger = (cmd->type == DAC_TRIGGER_CMD || cmd->type == DAC_NOOP_TRIGGER_CMD);
+  dac_wait_mode_t wait = is_trigger ? DAC_TRIGGER_WAIT : DAC_DELAY_WAIT;
+  if (cmd->type != DAC_TRIGGER_CMD && cmd->type != DAC_DELAY_CMD) {
+    words[0] = dac_encode_noop(wait, DAC_CONTINUE, DAC_NO_LDAC, cmd->value);
+    return 1;
+  }
+
+  if (encoder->min_delay > 0 && encoder->known) {
+    int changed_ch = -1;
+    int changed = 0;
+    for (int ch = 0; ch < 8; ch++) {
+      if (cmd->ch_vals[ch] != encoder->ch_vals[ch]) {
+        changed_ch = ch;
+        changed++;
+      }
+    }
+    // Nothing changes: hold for the same wait
+    if (changed == 0 && (is_trigger ? cmd->value > 0 : cmd->value >= encoder->min_delay)) {
+      words[0] = dac_encode_noop(wait, DAC_CONTINUE, DAC_NO_LDAC, cmd->value);
+      return 1;
+    }
+    // One channel changes after a delay: wait out the delay less the write, then write the channel
+    uint32_t ch_write_cycles = DAC_CH_WRITE_CYCLES(encoder->min_delay);
+    if (changed == 1 && !is_trigger && cmd->value >= encoder->min_delay + ch_write_cycles) {
+      words[0] = dac_encode_noop(DAC_DELAY_WAIT, DAC_CONTINUE, DAC_NO_LDAC, cmd->value - ch_write_cycles);
+      words[1] = dac_encode_dac_wr_ch((uint8_t)changed_ch, cmd->ch_vals[changed_ch]);
+      encoder->ch_vals[changed_ch] = cmd->ch_vals[changed_ch];
+      return 2;
+    }
+  }
+
+  dac_encode_dac_wr(words, cmd->ch_vals, wait, DAC_CONTINUE, DAC_LDAC, cmd->value);
+  memcpy(encoder->ch_vals, cmd->ch_vals, sizeof(encoder->ch_vals));
+  encoder->known = true;
+  return 5;
+}
+
+// Add an encoded command to a summary
+void dac_waveform_summary_add(dac_waveform_summary_t* summary, const waveform_command_t* cmd, uint32_t cmd_words) {
+  // Longest stretch the FIFO must hold from one trigger wait to the next
+  if (cmd->type == DAC_TRIGGER_CMD || cmd->type == DAC_NOOP_TRIGGER_CMD) {
+    if (summary->trigger_count > 0 && summary->words_since_trigger > summary->max_trigger_gap) {
+      summary->max_trigger_gap = summary->words_since_trigger;
+    }
+    summary->trigger_count++;
+    summary->words_since_trigger = cmd_words;
+  } else {
+    summary->words_since_trigger += cmd_words;
+  }
+  uint32_t plain_words = (cmd->type == DAC_TRIGGER_CMD || cmd->type == DAC_DELAY_CMD) ? 5 : 1;
+  summary->delta_count += (cmd_words != plain_words);
+  summary->command_count++;
+  summary->word_count += cmd_words;
+  summary->plain_word_count += plain_words;
+}
+
+// Print the FIFO words delta encoding saved
+void dac_waveform_print_savings(const dac_waveform_summary_t* summary, const char* prefix) {
+  uint64_t saved = summary->plain_word_count - summary->word_count;
+  printf("%sDelta encoding: %llu of %llu commands sent as holds or single-channel writes, "
+         "%llu FIFO words per iteration instead of %llu (%llu saved, %.1f%%)\n",
+         prefix, summary->delta_count, summary->command_count, summary->word_count,
+         summary->plain_word_count, saved,
+         summary->plain_word_count > 0 ? 100.0 * (double)saved / (double)summary->plain_word_count : 0.0);
+}
+
+// Warn when the FIFO must hold more words between trigger waits than it can
+void dac_waveform_check_trigger_gaps(const dac_waveform_summary_t* summary, bool verbose) {
+  if (summary->trigger_count == 0) {
+    // No trigger commands found - check if total command size exceeds FIFO
+    if (summary->word_count > DAC_CMD_FIFO_WORDCOUNT) {
+      printf("WARNING: Waveform contains no triggers and requires %llu words, which exceeds DAC FIFO size (%u words).\n", 
+             summary->word_count, DAC_CMD_FIFO_WORDCOUNT);
+      printf("         This may cause FIFO overflow during streaming. Consider adding trigger commands, keeping delays long, or reducing waveform size.\n");
+    } else if (verbose) {
+      printf("No trigger validation: Waveform requires %llu words (FIFO size: %u words) - OK\n", 
+             summary->word_count, DAC_CMD_FIFO_WORDCOUNT);
+    }
+  } else if (summary->max_trigger_gap > DAC_CMD_FIFO_WORDCOUNT) {
+    printf("WARNING: Maximum gap between triggers is %llu words, which exceeds DAC FIFO size (%u words).\n", 
+           summary->max_trigger_gap, DAC_CMD_FIFO_WORDCOUNT);
+    printf("         This may cause FIFO underflow during streaming. Consider reducing number of delay commands between triggers or keeping delays long.\n");
+  } else if (verbose) {
+    printf("Trigger gap validation: Maximum gap is %llu words (FIFO size: %u words) - OK\n", 
+           summary->max_trigger_gap, DAC_CMD_FIFO_WORDCOUNT);
+  }
+}
+
+// Offset of the last FIFO command in an encoded waveform command (the DAC_WR_CH of a pair)
+static uint32_t last_fifo_cmd_offset(uint32_t cmd_words) {
+  return (cmd_words == 2) ? 1 : 0;
+}
+
+// Close a summary at the end of the waveform (the last stretch runs to the end)
+static void summary_finish(dac_waveform_summary_t* summary) {
+  if (summary->words_since_trigger > summary->max_trigger_gap) {
+    summary->max_trigger_gap = summary->words_since_trigger;
+  }
+}
+
+//////////////////// Compiled files ////////////////////
+
+// Compile a waveform text file to a compiled file with bounded memory (header returned if not NULL)
+int dac_waveform_compile_file(const char* text_path, const char* out_path, uint32_t min_delay, dac_waveform_header_t* header_out) {
+  void* map;
+  size_t size;
+  if (map_file(text_path, &map, &size) != 0) {
+    return -1;
+  }
+
+  FILE* file = fopen(out_path, "wb");
+  if (file == NULL) {
+    fprintf(stderr, "Failed to open '%s' for writing: %s\n", out_path, strerror(errno));
+    if (map != NULL) munmap(map, size);
+    return -1;
+  }
+
+  // Provisional header, rewritten once the counts are known
+  dac_waveform_header_t header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, DAC_WAVEFORM_MAGIC, sizeof(header.magic));
+  header.version = DAC_WAVEFORM_VERSION;
+  header.header_size = DAC_WAVEFORM_HEADER_SIZE;
+  header.delta_min_delay = min_delay;
+  snprintf(header.source_path, sizeof(header.source_path), "%s", text_path);
+  bool ok = (fwrite(&header, sizeof(header), 1, file) == 1);
+
+  dac_waveform_parser_t parser;
+  dac_waveform_parser_init(&parser, map, size);
+  dac_waveform_encoder_t encoder;
+  dac_waveform_encoder_init(&encoder, min_delay);
+  dac_waveform_summary_t summary;
+  memset(&summary, 0, sizeof(summary));
+  waveform_command_t cmd;
+  int result;
+  uint32_t crc = 0;
+  while (ok && (result = dac_waveform_parse_next(&parser, &cmd)) > 0) {
+    uint32_t words[5];
+    uint32_t cmd_words = dac_waveform_encode(&encoder, &cmd, words);
+    if (summary.plain_word_count + 5 > UINT32_MAX) {
+      fprintf(stderr, "Waveform file '%s' is too long to compile (over %u words)\n", text_path, UINT32_MAX);
+      ok = false;
+      break;
+    }
+    header.last_cmd_offset = (uint32_t)summary.word_count + last_fifo_cmd_offset(cmd_words);
+    dac_waveform_summary_add(&summary, &cmd, cmd_words);
+    crc = capture_crc32(crc, words, cmd_words * sizeof(uint32_t));
+    if (fwrite(words, sizeof(uint32_t), cmd_words, file) != cmd_words) {
+      fprintf(stderr, "Failed to write compiled waveform '%s': %s\n", out_path, strerror(errno));
+      ok = false;
+    }
+  }
+  if (ok && result < 0) {
+    ok = false; // Error already printed by the parser
+  }
+  if (ok && summary.command_count == 0) {
+    fprintf(stderr, "No valid commands found in waveform file\n");
+    ok = false;
+  }
+  if (map != NULL) munmap(map, size);
+
+  if (ok) {
+    summary_finish(&summary);
+    header.command_count = (uint32_t)summary.command_count;
+    header.word_count = (uint32_t)summary.word_count;
+    header.trigger_count = (uint32_t)summary.trigger_count;
+    header.max_trigger_gap = (uint32_t)summary.max_trigger_gap;
+    header.plain_word_count = (uint32_t)summary.plain_word_count;
+    header.delta_count = (uint32_t)summary.delta_count;
+    header.words_crc = crc;
+    header.source_hash = capture_hash_file(text_path);
+    if (fseek(file, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, file) != 1) {
+      fprintf(stderr, "Failed to write compiled waveform header to '%s': %s\n", out_path, strerror(errno));
+      ok = false;
+    }
+  }
+  if (fclose(file) != 0 && ok) {
+    fprintf(stderr, "Failed to close compiled waveform '%s': %s\n", out_path, strerror(errno));
+    ok = false;
+  }
+  if (!ok) {
+    remove(out_path);
+    return -1;
+  }
+  if (header_out != NULL) {
+    *header_out = header;
+  }
+  return 0;
+}
+
+// Check whether a file starts with the compiled waveform magic
+bool dac_waveform_is_compiled(const char* path) {
+  char magic[8];
+  FILE* file = fopen(path, "rb");
+  if (file == NULL) {
+    return false;
+  }
+  bool compiled = (fread(magic, sizeof(magic), 1, file) == 1 &&
+                   memcmp(magic, DAC_WAVEFORM_MAGIC, sizeof(magic)) == 0);
+  fclose(file);
+  return compiled;
+}
+
+//////////////////// Streaming ////////////////////
+
+// Keep a copy of the final command with CONT cleared (words[] must be at its end)
+static void stream_set_final(dac_waveform_stream_t* stream) {
+  uint32_t cmd_words = dac_waveform_cmd_words(stream->words[stream->last_cmd_pos]);
+  memcpy(stream->final_cmd, &stream->words[stream->last_cmd_pos], cmd_words * sizeof(uint32_t));
+  stream->final_cmd[0] &= ~(1u << DAC_CMD_CONT_BIT);
+}
+
+// Parse up to max_words of text into the window (stops early when it is full or the iteration ends)
+static int stream_fill(dac_waveform_stream_t* stream, size_t max_words) {
+  // Slide unwritten words to the front once half the window has been written
+  if (stream->pos >= DAC_WAVEFORM_WINDOW_WORDS / 2 || stream->pos == stream->count) {
+    memmove(stream->window, stream->window + stream->pos, (stream->count - stream->pos) * sizeof(uint32_t));
+    stream->count -= stream->pos;
+    stream->pos = 0;
+  }
+
+  waveform_command_t cmd;
+  size_t limit = stream->count + max_words;
+  while (!stream->at_end && stream->count + 5 <= DAC_WAVEFORM_WINDOW_WORDS && stream->count < limit) {
+    int result = dac_waveform_parse_next(&stream->parser, &cmd);
+    if (result < 0) {
+      stream->error = true;
+      return -1;
+    }
+    if (result == 0) {
+      // Only reached when the file holds no command at all
+      fprintf(stderr, "No valid commands found in waveform file\n");
+      stream->error = true;
+      return -1;
+    }
+    size_t cmd_pos = stream->count;
+    uint32_t cmd_words = dac_waveform_encode(&stream->encoder, &cmd, &stream->window[cmd_pos]);
+    stream->count += cmd_words;
+    if (!stream->summary_done) {
+      dac_waveform_summary_add(&stream->summary, &cmd, cmd_words);
+    }
+    if (dac_waveform_parser_at_end(&stream->parser)) {
+      stream->at_end = true;
+      stream->last_cmd_pos = cmd_pos + last_fifo_cmd_offset(cmd_words);
+      stream_set_final(stream);
+      if (!stream->summary_done) {
+        summary_finish(&stream->summary);
+        stream->summary_done = true;
+      }
+    }
+  }
+  return 0;
+}
+
+// Open a compiled file's mapping for streaming
+static int stream_open_compiled(dac_waveform_stream_t* stream, uint32_t min_delay) {
+  const dac_waveform_header_t* header = (const dac_waveform_header_t*)stream->map;
+  if (stream->map_size < sizeof(*header) ||
+      header->version != DAC_WAVEFORM_VERSION || header->header_size != DAC_WAVEFORM_HEADER_SIZE) {
+    fprintf(stderr, "Unsupported compiled waveform in '%s'\n", stream->path);
+    return -1;
+  }
+  const uint32_t* words = (const uint32_t*)((const char*)stream->map + DAC_WAVEFORM_HEADER_SIZE);
+  if (header->word_count == 0 ||
+      stream->map_size < DAC_WAVEFORM_HEADER_SIZE + (size_t)header->word_count * sizeof(uint32_t) ||
+      header->last_cmd_offset >= header->word_count ||
+      header->last_cmd_offset + dac_waveform_cmd_words(words[header->last_cmd_offset]) != header->word_count) {
+    fprintf(stderr, "Compiled waveform '%s' is truncated or inconsistent\n", stream->path);
+    return -1;
+  }
+  // Delta-encoded delays depend on the single-channel write time
+  if (header->delta_min_delay != 0 && header->delta_min_delay != min_delay) {
+    fprintf(stderr, "Compiled waveform '%s' was delta encoded for a minimum DAC delay of %u cycles, "
+            "but the hardware minimum is %u; compile it again\n", stream->path, header->delta_min_delay, min_delay);
+    return -1;
+  }
+
+  stream->compiled = true;
+  stream->words = words;
+  stream->count = header->word_count;
+  stream->at_end = true;
+  stream->resident = true;
+  stream->last_cmd_pos = header->last_cmd_offset;
+  stream_set_final(stream);
+  stream->summary.command_count = header->command_count;
+  stream->summary.word_count = header->word_count;
+  stream->summary.trigger_count = header->trigger_count;
+  stream->summary.max_trigger_gap = header->max_trigger_gap;
+  stream->summary.plain_word_count = (header->plain_word_count != 0) ? header->plain_word_count : header->word_count;
+  stream->summary.delta_count = header->delta_count;
+  stream->summary_done = true;
+  return 0;
+}
+
+// Open a text or compiled waveform for streaming (parses the first window of a text file)
+int dac_waveform_stream_open(dac_waveform_stream_t* stream, const char* path, uint32_t min_delay, bool delta) {
+  memset(stream, 0, sizeof(*stream));
+  snprintf(stream->path, sizeof(stream->path), "%s", path);
+  if (map_file(path, &stream->map, &stream->map_size) != 0) {
+    return -1;
+  }
+
+  if (stream->map_size >= 8 && memcmp(stream->map, DAC_WAVEFORM_MAGIC, 8) == 0) {
+    if (stream_open_compiled(stream, min_delay) != 0) {
+      dac_waveform_stream_close(stream);
+      return -1;
+    }
+    return 0;
+  }
+
+  stream->window = malloc(DAC_WAVEFORM_WINDOW_WORDS * sizeof(uint32_t));
+  if (stream->window == NULL) {
+    fprintf(stderr, "Failed to allocate waveform window\n");
+    dac_waveform_stream_close(stream);
+    return -1;
+  }
+  stream->words = stream->window;
+  dac_waveform_parser_init(&stream->parser, stream->map, stream->map_size);
+  dac_waveform_encoder_init(&stream->encoder, delta ? min_delay : 0);
+  if (stream_fill(stream, DAC_WAVEFORM_WINDOW_WORDS) != 0) {
+    dac_waveform_stream_close(stream);
+    return -1;
+  }
+  // Small enough to replay from the window on every iteration
+  stream->resident = stream->at_end;
+  return 0;
+}
+
+// Words in the next command (0 once the iteration is done or on error)
+uint32_t dac_waveform_stream_next_words(dac_waveform_stream_t* stream) {
+  if (stream->error || stream->pos >= stream->count) {
+    return 0;
+  }
+  return dac_waveform_cmd_words(stream->words[stream->pos]);
+}
+
+// Next run of whole commands that fits in max_words (0 if none fits or on error)
+uint32_t dac_waveform_stream_peek(dac_waveform_stream_t* stream, uint32_t max_words, bool last_iteration,
+                                  const uint32_t** words, uint32_t* commands) {
+  *commands = 0;
+  if (stream->error || stream->pos >= stream->count) {
+    return 0;
+  }
+
+  // The final command of the final iteration goes out with CONT cleared
+  bool final_pending = last_iteration && stream->at_end;
+  if (final_pending && stream->pos == stream->last_cmd_pos) {
+    uint32_t cmd_words = (uint32_t)(stream->count - stream->pos);
+    if (cmd_words > max_words) {
+      return 0;
+    }
+    *words = stream->final_cmd;
+    *commands = dac_waveform_cmd_starts_line(stream->final_cmd[0]) ? 1 : 0;
+    return cmd_words;
+  }
+
+  size_t end = final_pending ? stream->last_cmd_pos : stream->count;
+  size_t limit = (end - stream->pos < max_words) ? end : stream->pos + max_words;
+  size_t pos = stream->pos;
+  uint32_t count = 0;
+  while (pos < limit) {
+    uint32_t cmd_words = dac_waveform_cmd_words(stream->words[pos]);
+    if (pos + cmd_words > limit) {
+      if (pos + cmd_words > end && count == 0) {
+        // Only a corrupt compiled file has a command running past its end
+        fprintf(stderr, "Compiled waveform '%s' has inconsistent command boundaries at word %zu\n",
+                stream->path, pos);
+        stream->error = true;
+      }
+      break;
+    }
+    count += dac_waveform_cmd_starts_line(stream->words[pos]) ? 1 : 0;
+    pos += cmd_words;
+  }
+  *words = &stream->words[stream->pos];
+  *commands = count;
+  return (uint32_t)(pos - stream->pos);
+}
+
+// Mark peeked words as written (tops up the text window)
+void dac_waveform_stream_consume(dac_waveform_stream_t* stream, uint32_t words) {
+  stream->pos += words;
+  if (!stream->at_end) {
+    stream_fill(stream, DAC_WAVEFORM_REFILL_WORDS);
+  }
+}
+
+// True once every word of the current iteration has been consumed
+bool dac_waveform_stream_iteration_done(const dac_waveform_stream_t* stream) {
+  return stream->at_end && stream->pos >= stream->count;
+}
+
+// Start the next iteration
+int dac_waveform_stream_rewind(dac_waveform_stream_t* stream) {
+  stream->pos = 0;
+  if (stream->resident) {
+    return 0;
+  }
+  stream->count = 0;
+  stream->at_end = false;
+  dac_waveform_parser_init(&stream->parser, stream->map, stream->map_size);
+  dac_waveform_encoder_init(&stream->encoder, stream->encoder.min_delay);
+  return stream_fill(stream, DAC_WAVEFORM_REFILL_WORDS);
+}
+
+// Unmap the file and free the window
+void dac_waveform_stream_close(dac_waveform_stream_t* stream) {
+  if (stream->map != NULL) {
+    munmap(stream->map, stream->map_size);
+    stream->map = NULL;
+  }
+  free(stream->window);
+  stream->window = NULL;
+  stream->words = NULL;
+}
@@ -14,6 +14,8 @@
 #include "experiment_commands.h"
 #include "command_helper.h"
 #include "adc_commands.h"
+#include "adc_stream_engine.h"
+#include "dac_stream_engine.h"
 #include "dac_commands.h"
 #include "trigger_commands.h"
 #include "system_commands.h"
@@ -24,6 +26,9 @@
 #include "adc_ctrl.h"
 #include "map_memory.h"
 #include "trigger_ctrl.h"
+#include "rt_profile.h"
+#include "stream_barrier.h"
+#include "sts_sampler.h"
 
 // Forward declarations for helper functions
 static int validate_system_running(command_context_t* ctx);
@@ -354,16 +359,11 @@ int cmd_channel_cal(const char** args, int arg_count, const command_flag_t* flag
     int connected_count = 0;
     printf("Checking connected boards...\n");
     
+    struct sys_sts_snapshot_t snap;
+    sys_sts_snapshot(ctx->sys_sts, &snap);
+    uint8_t connected_mask = sys_sts_snap_connected_boards(&snap);
     for (int board = 0; board < 8; board++) {
-      uint32_t adc_data_fifo_status = sys_sts_get_adc_data_fifo_status(ctx->sys_sts, (uint8_t)board, false);
-      uint32_t dac_cmd_fifo_status = sys_sts_get_dac_cmd_fifo_status(ctx->sys_sts, (uint8_t)board, false);
-      uint32_t adc_cmd_fifo_status = sys_sts_get_adc_cmd_fifo_status(ctx->sys_sts, (uint8_t)board, false);
-      uint32_t dac_data_fifo_status = sys_sts_get_dac_data_fifo_status(ctx->sys_sts, (uint8_t)board, false);
-      
-      if (FIFO_PRESENT(adc_data_fifo_status) && 
-          FIFO_PRESENT(dac_cmd_fifo_status) && 
-          FIFO_PRESENT(adc_cmd_fifo_status) &&
-          FIFO_PRESENT(dac_data_fifo_status)) {
+      if (connected_mask & (1u << board)) {
         connected_boards[board] = true;
         connected_count++;
         printf("  Board %d: Connected\n", board);
@@ -760,17 +760,11 @@ int cmd_waveform_test(const char** args, int arg_count, const command_flag_t* fl
   int connected_count = 0;
   printf("Checking connected boards...\n");
   
+  struct sys_sts_snapshot_t snap;
+  sys_sts_snapshot(ctx->sys_sts, &snap);
+  uint8_t connected_mask = sys_sts_snap_connected_boards(&snap);
   for (int board = 0; board < 8; board++) {
-    uint32_t dac_cmd_fifo_status = sys_sts_get_dac_cmd_fifo_status(ctx->sys_sts, (uint8_t)board, false);
-    uint32_t dac_data_fifo_status = sys_sts_get_dac_data_fifo_status(ctx->sys_sts, (uint8_t)board, false);
-    uint32_t adc_cmd_fifo_status = sys_sts_get_adc_cmd_fifo_status(ctx->sys_sts, (uint8_t)board, false);
-    uint32_t adc_data_fifo_status = sys_sts_get_adc_data_fifo_status(ctx->sys_sts, (uint8_t)board, false);
-    
-    if (
-      FIFO_PRESENT(dac_cmd_fifo_status)  && 
-      FIFO_PRESENT(dac_data_fifo_status) &&
-      FIFO_PRESENT(adc_cmd_fifo_status)  && 
-      FIFO_PRESENT(adc_data_fifo_status)) {
+    if (connected_mask & (1u << board)) {
       connected_boards[board] = true;
       connected_count++;
       printf("  Board %d: Connected\n", board);
@@ -1207,67 +1201,13 @@ int cmd_waveform_test(const char** args, int arg_count, const command_flag_t* fl
     }
   }
   
-  // Wait for command buffers to preload before sending sync trigger
-  printf("Waiting for command buffers to preload (at least 10 words or stream completion)...\n");
-  bool buffers_ready = false;
-  int check_count = 0;
-  const int max_checks = 500; // Max 5 seconds at 10ms per check
-  
-  while (!buffers_ready && check_count < max_checks) {
-    buffers_ready = true;
-    
-    for (int board = 0; board < 8; board++) {
-      if (!connected_boards[board]) continue;
-      
-      // Check DAC command buffer
-      if (ctx->dac_cmd_stream_running[board]) {
-        uint32_t dac_cmd_fifo_status = sys_sts_get_dac_cmd_fifo_status(ctx->sys_sts, (uint8_t)board, false);
-        uint32_t dac_words = FIFO_STS_WORD_COUNT(dac_cmd_fifo_status);
-        if (dac_words < 10) {
-          buffers_ready = false;
-          if (*(ctx->verbose)) {
-            printf("  Board %d DAC buffer: %u words (waiting for 10+)\n", board, dac_words);
-          }
-        }
-      }
-      
-      // Check ADC command buffer  
-      if (ctx->adc_cmd_stream_running[board]) {
-        uint32_t adc_cmd_fifo_status = sys_sts_get_adc_cmd_fifo_status(ctx->sys_sts, (uint8_t)board, false);
-        uint32_t adc_words = FIFO_STS_WORD_COUNT(adc_cmd_fifo_status);
-        if (adc_words < 10) {
-          buffers_ready = false;
-          if (*(ctx->verbose)) {
-            printf("  Board %d ADC buffer: %u words (waiting for 10+)\n", board, adc_words);
-          }
-        }
-      }
-    }
-    
-    if (!buffers_ready) {
-      usleep(10000); // Wait 10ms
-      check_count++;
-    }
-  }
-  
-  if (check_count >= max_checks) {
-    printf("Warning: Timeout waiting for buffer preload!\n");
+  // Start barrier: release triggers only once every board's command FIFOs are prefilled
+  printf("Prefilling command FIFOs to %u%% on all boards before releasing triggers...\n", stream_prefill_pct);
+  stream_prefill_t prefill;
+  if (!stream_prefill_wait(ctx, connected_boards, stream_prefill_pct, STREAM_PREFILL_TIMEOUT_MS, &prefill)) {
+    printf("Warning: Timeout waiting for command FIFO prefill!\n");
     printf("Current buffer status:\n");
-    for (int board = 0; board < 8; board++) {
-      if (!connected_boards[board]) continue;
-      
-      if (ctx->dac_cmd_stream_running[board]) {
-        uint32_t dac_cmd_fifo_status = sys_sts_get_dac_cmd_fifo_status(ctx->sys_sts, (uint8_t)board, false);
-        uint32_t dac_words = FIFO_STS_WORD_COUNT(dac_cmd_fifo_status);
-        printf("  Board %d DAC command buffer: %u words\n", board, dac_words);
-      }
-      
-      if (ctx->adc_cmd_stream_running[board]) {
-        uint32_t adc_cmd_fifo_status = sys_sts_get_adc_cmd_fifo_status(ctx->sys_sts, (uint8_t)board, false);
-        uint32_t adc_words = FIFO_STS_WORD_COUNT(adc_cmd_fifo_status);
-        printf("  Board %d ADC command buffer: %u words\n", board, adc_words);
-      }
-    }
+    stream_prefill_print(&prefill);
     
     char input_buffer[1024];
     printf("Do you want to proceed anyway? (y/N): ");
@@ -1290,8 +1230,11 @@ int cmd_waveform_test(const char** args, int arg_count, const command_flag_t* fl
     }
     
     printf("Proceeding with waveform test...\n");
-  } else if (*(ctx->verbose)) {
-    printf("Command buffers preloaded successfully\n");
+  } else {
+    printf("All boards prefilled in %.1f ms\n", prefill.wait_ms);
+    if (*(ctx->verbose)) {
+      stream_prefill_print(&prefill);
+    }
   }
   
   // Send sync_ch trigger to start all streams (after all streams including trigger are set up)
@@ -1395,11 +1338,7 @@ int cmd_stop_waveform(const char** args, int arg_count, const command_flag_t* fl
     // Stop DAC command streaming
     if (ctx->dac_cmd_stream_running[board]) {
       printf("  Stopping DAC command stream for board %d\n", board);
-      ctx->dac_cmd_stream_stop[board] = true;
-      if (pthread_join(ctx->dac_cmd_stream_threads[board], NULL) != 0) {
-        fprintf(stderr, "Warning: Failed to join DAC command streaming thread for board %d\n", board);
-      }
-      ctx->dac_cmd_stream_running[board] = false;
+      dac_stream_engine_stop_session(ctx, (uint8_t)board);
       anything_stopped = true;
     }
     
@@ -1417,11 +1356,7 @@ int cmd_stop_waveform(const char** args, int arg_count, const command_flag_t* fl
     // Stop ADC data streaming
     if (ctx->adc_data_stream_running[board]) {
       printf("  Stopping ADC data stream for board %d\n", board);
-      ctx->adc_data_stream_stop[board] = true;
-      if (pthread_join(ctx->adc_data_stream_threads[board], NULL) != 0) {
-        fprintf(stderr, "Warning: Failed to join ADC data streaming thread for board %d\n", board);
-      }
-      ctx->adc_data_stream_running[board] = false;
+      adc_stream_engine_stop_session(ctx, (uint8_t)board);
       anything_stopped = true;
     }
   }
@@ -1502,6 +1437,7 @@ static void* fieldmap_thread(void* arg) {
   // Time-based verbose logging variables
   time_t last_verbose_time = time(NULL);
   time_t last_status_check_time = time(NULL);
+  uint64_t sts_not_before_ns = 0; // Last sample read (a sampled FIFO level must be newer)
   
   while (samples_collected < total_samples_expected && !(*should_stop)) {
     int current_board = current_channel / 8;
@@ -1509,12 +1445,12 @@ static void* fieldmap_thread(void* arg) {
     
     // Check if all connected boards have data available (4 words each) and trigger has 2 words
     bool all_data_ready = true;
-    uint32_t trig_status = sys_sts_get_trig_data_fifo_status(ctx->sys_sts, false);
+    uint32_t trig_status = sts_sampler_word(ctx->sys_sts, TRIG_DATA_FIFO_STS_OFFSET, sts_not_before_ns);
     
     // Periodic system status check and verbose logging (once every 5 seconds)
     if ((current_time - last_status_check_time) >= 5) {
       // Check system status for halt conditions (always run)
-      uint32_t hw_status = sys_sts_get_hw_status(ctx->sys_sts, false);
+      uint32_t hw_status = sts_sampler_word(ctx->sys_sts, HW_STS_REG_OFFSET, 0);
       uint32_t state = HW_STS_STATE(hw_status);
       uint32_t status_code = HW_STS_CODE(hw_status);
       
@@ -1537,7 +1473,7 @@ static void* fieldmap_thread(void* arg) {
         // Show status for all connected boards
         for (int board = 0; board < 8; board++) {
           if (!connected_boards[board]) continue;
-          uint32_t adc_status = sys_sts_get_adc_data_fifo_status(ctx->sys_sts, (uint8_t)board, false);
+          uint32_t adc_status = sts_sampler_word(ctx->sys_sts, ADC_DATA_FIFO_STS_OFFSET(board), sts_not_before_ns);
           printf("Fieldmap Thread [VERBOSE]: Board %d ADC FIFO status=0x%08X (count=%u)\n",
                  board, adc_status, FIFO_STS_WORD_COUNT(adc_status));
         }
@@ -1551,7 +1487,7 @@ static void* fieldmap_thread(void* arg) {
     // Check that all connected boards have 4 words available and trigger has 2 words
     for (int board = 0; board < 8; board++) {
       if (!connected_boards[board]) continue;
-      uint32_t adc_status = sys_sts_get_adc_data_fifo_status(ctx->sys_sts, (uint8_t)board, false);
+      uint32_t adc_status = sts_sampler_word(ctx->sys_sts, ADC_DATA_FIFO_STS_OFFSET(board), sts_not_before_ns);
       if (FIFO_STS_WORD_COUNT(adc_status) < 4) {
         all_data_ready = false;
         break;
@@ -1608,6 +1544,7 @@ static void* fieldmap_thread(void* arg) {
       
       // Read trigger data (64-bit)
       uint64_t trigger_data = trigger_read(ctx->trigger_ctrl);
+      sts_not_before_ns = sts_sampler_now_ns();
       double time_seconds = (double)trigger_data / (spi_freq_mhz * 1e6);
       
       if (verbose) {
@@ -1757,10 +1694,12 @@ int cmd_fieldmap(const char** args, int arg_count, const command_flag_t* flags,
   int connected_count = 0;
   printf("Checking connected boards...\n");
   
+  struct sys_sts_snapshot_t snap;
+  sys_sts_snapshot(ctx->sys_sts, &snap);
   for (int board = 0; board < 8; board++) {
-    uint32_t adc_data_fifo_status = sys_sts_get_adc_data_fifo_status(ctx->sys_sts, (uint8_t)board, false);
-    uint32_t dac_cmd_fifo_status = sys_sts_get_dac_cmd_fifo_status(ctx->sys_sts, (uint8_t)board, false);
-    uint32_t adc_cmd_fifo_status = sys_sts_get_adc_cmd_fifo_status(ctx->sys_sts, (uint8_t)board, false);
+    uint32_t adc_data_fifo_status = sys_sts_snap_adc_data_fifo_status(&snap, (uint8_t)board);
+    uint32_t dac_cmd_fifo_status = sys_sts_snap_dac_cmd_fifo_status(&snap, (uint8_t)board);
+    uint32_t adc_cmd_fifo_status = sys_sts_snap_adc_cmd_fifo_status(&snap, (uint8_t)board);
     
     if (FIFO_PRESENT(adc_data_fifo_status) && 
         FIFO_PRESENT(dac_cmd_fifo_status) && 
@@ -2033,7 +1972,7 @@ int cmd_fieldmap(const char** args, int arg_count, const command_flag_t* flags,
   ctx->fieldmap_stop = false;
   ctx->fieldmap_running = true;
   
-  if (pthread_create(&(ctx->fieldmap_thread), NULL, fieldmap_thread, &thread_params) != 0) {
+  if (rt_thread_create(&(ctx->fieldmap_thread), RT_CLASS_MONITOR, fieldmap_thread, &thread_params) != 0) {
     fprintf(stderr, "Failed to create fieldmap data collection thread\n");
     ctx->fieldmap_running = false;
     return -1;
@@ -2097,10 +2036,12 @@ int cmd_stop_fieldmap(const char** args, int arg_count, const command_flag_t* fl
 
 // Helper function to check that boards 0-3 are connected
 static int check_boards_connected(command_context_t* ctx) {
+  struct sys_sts_snapshot_t snap;
+  sys_sts_snapshot(ctx->sys_sts, &snap);
   for (int board = 0; board < 4; board++) {
-    uint32_t adc_data_fifo_status = sys_sts_get_adc_data_fifo_status(ctx->sys_sts, (uint8_t)board, false);
-    uint32_t dac_cmd_fifo_status = sys_sts_get_dac_cmd_fifo_status(ctx->sys_sts, (uint8_t)board, false);
-    uint32_t adc_cmd_fifo_status = sys_sts_get_adc_cmd_fifo_status(ctx->sys_sts, (uint8_t)board, false);
+    uint32_t adc_data_fifo_status = sys_sts_snap_adc_data_fifo_status(&snap, (uint8_t)board);
+    uint32_t dac_cmd_fifo_status = sys_sts_snap_dac_cmd_fifo_status(&snap, (uint8_t)board);
+    uint32_t adc_cmd_fifo_status = sys_sts_snap_adc_cmd_fifo_status(&snap, (uint8_t)board);
 
     if (FIFO_PRESENT(adc_data_fifo_status) == 0) {
       fprintf(stderr, "Board %d: ADC data FIFO not present - board not connected\n", board);
@@ -2143,16 +2084,11 @@ int cmd_find_bias(const char** args, int arg_count, const command_flag_t* flags,
     printf("Checking connected boards...\n");
   }
   
+  struct sys_sts_snapshot_t snap;
+  sys_sts_snapshot(ctx->sys_sts, &snap);
+  uint8_t connected_mask = sys_sts_snap_connected_boards(&snap);
   for (int board = 0; board < 8; board++) {
-    uint32_t adc_data_fifo_status = sys_sts_get_adc_data_fifo_status(ctx->sys_sts, (uint8_t)board, false);
-    uint32_t dac_cmd_fifo_status = sys_sts_get_dac_cmd_fifo_status(ctx->sys_sts, (uint8_t)board, false);
-    uint32_t adc_cmd_fifo_status = sys_sts_get_adc_cmd_fifo_status(ctx->sys_sts, (uint8_t)board, false);
-    uint32_t dac_data_fifo_status = sys_sts_get_dac_data_fifo_status(ctx->sys_sts, (uint8_t)board, false);
-    
-    if (FIFO_PRESENT(adc_data_fifo_status) && 
-        FIFO_PRESENT(dac_cmd_fifo_status) && 
-        FIFO_PRESENT(adc_cmd_fifo_status) &&
-        FIFO_PRESENT(dac_data_fifo_status)) {
+    if (connected_mask & (1u << board)) {
       connected_boards[board] = true;
       connected_count++;
       if (*(ctx->verbose)) {
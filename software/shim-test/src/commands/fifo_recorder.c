@@ -0,0 +1,240 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "fifo_recorder.h"
+#include "dac_ctrl.h"
+#include "adc_ctrl.h"
+#include "trigger_ctrl.h"
+#include "rt_profile.h"
+
+_Static_assert(sizeof(fifo_record_header_t) == FIFO_RECORD_HEADER_SIZE, "FIFO record header size");
+_Static_assert(sizeof(fifo_record_sample_t) == 48, "FIFO record sample size");
+
+// Recording state (owned by the command thread; the recorder thread writes the ring and counters)
+static struct {
+  struct sys_sts_t* sys_sts;
+  char file_path[1024];
+  uint32_t rate_hz;
+  uint8_t board_mask;
+  uint64_t word_mask;            // Status words read per sample (bit n = word n)
+  fifo_record_sample_t* ring;
+  uint64_t capacity;             // Samples in the ring
+  atomic_ullong samples_taken;
+  atomic_ullong missed_periods;
+  uint64_t start_realtime_ns;
+  uint64_t start_monotonic_ns;
+  pthread_t thread;
+  atomic_bool stop;
+  bool running;
+} recorder;
+
+// Clock time in nanoseconds
+static uint64_t clock_ns(clockid_t clock) {
+  struct timespec ts;
+  clock_gettime(clock, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// FIFO level of a status word as stored in a sample
+static uint16_t sample_level(uint32_t fifo_status) {
+  uint32_t words = FIFO_STS_WORD_COUNT(fifo_status);
+  return (words > FIFO_RECORD_LEVEL_MAX) ? FIFO_RECORD_LEVEL_MAX : (uint16_t)words;
+}
+
+// Recorder thread: one status pass per period on an absolute schedule
+static void* recorder_thread(void* arg) {
+  uint64_t period_ns = 1000000000ULL / recorder.rate_hz;
+  uint64_t next_ns = clock_ns(CLOCK_MONOTONIC);
+  recorder.start_realtime_ns = clock_ns(CLOCK_REALTIME);
+  recorder.start_monotonic_ns = next_ns;
+  uint64_t missed = 0;
+  struct sys_sts_snapshot_t snap;
+
+  while (!atomic_load_explicit(&recorder.stop, memory_order_relaxed)) {
+    sys_sts_snapshot_words(recorder.sys_sts, &snap, recorder.word_mask);
+
+    uint64_t taken = atomic_load_explicit(&recorder.samples_taken, memory_order_relaxed);
+    fifo_record_sample_t* sample = &recorder.ring[taken % recorder.capacity];
+    sample->time_us = (uint32_t)((snap.timestamp_ns - recorder.start_monotonic_ns) / 1000);
+    sample->trig_counter = sys_sts_snap_trig_counter(&snap);
+    sample->hw_status = sys_sts_snap_hw_status(&snap);
+    for (int board = 0; board < 8; board++) {
+      bool present = recorder.board_mask & (1u << board);
+      sample->dac_cmd[board] = present ? sample_level(sys_sts_snap_dac_cmd_fifo_status(&snap, board)) : FIFO_RECORD_ABSENT;
+      sample->adc_data[board] = present ? sample_level(sys_sts_snap_adc_data_fifo_status(&snap, board)) : FIFO_RECORD_ABSENT;
+    }
+    sample->trig_data = sample_level(sys_sts_snap_trig_data_fifo_status(&snap));
+    sample->missed = (missed > UINT16_MAX) ? UINT16_MAX : (uint16_t)missed;
+    atomic_store_explicit(&recorder.samples_taken, taken + 1, memory_order_relaxed);
+
+    // Next period; periods already past are skipped and counted rather than sampled late in a burst
+    next_ns += period_ns;
+    uint64_t now_ns = clock_ns(CLOCK_MONOTONIC);
+    missed = 0;
+    if (now_ns >= next_ns) {
+      missed = (now_ns - next_ns) / period_ns + 1;
+      next_ns += missed * period_ns;
+      atomic_fetch_add_explicit(&recorder.missed_periods, missed, memory_order_relaxed);
+    }
+    struct timespec ts = {
+      .tv_sec = (time_t)(next_ns / 1000000000ULL),
+      .tv_nsec = (long)(next_ns % 1000000000ULL)
+    };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+    }
+  }
+  return NULL;
+}
+
+// Start recording to memory (file_path is written when the recording stops; -1 on failure)
+int fifo_recorder_start(struct sys_sts_t* sys_sts, const char* file_path, uint32_t rate_hz, uint32_t seconds) {
+  if (recorder.running) {
+    fprintf(stderr, "FIFO recorder: Already recording to %s (stop it first)\n", recorder.file_path);
+    return -1;
+  }
+  if (rate_hz == 0 || rate_hz > FIFO_RECORD_MAX_RATE_HZ) {
+    fprintf(stderr, "FIFO recorder: Rate %u Hz out of range (1-%d Hz)\n", rate_hz, FIFO_RECORD_MAX_RATE_HZ);
+    return -1;
+  }
+  uint64_t capacity = (uint64_t)rate_hz * seconds;
+  if (capacity == 0 || capacity * sizeof(fifo_record_sample_t) > FIFO_RECORD_MAX_BYTES) {
+    fprintf(stderr, "FIFO recorder: %u s at %u Hz needs %llu MB; the limit is %u MB\n", seconds, rate_hz,
+            capacity * sizeof(fifo_record_sample_t) >> 20, FIFO_RECORD_MAX_BYTES >> 20);
+    return -1;
+  }
+  if (strlen(file_path) >= sizeof(recorder.file_path)) {
+    fprintf(stderr, "FIFO recorder: File path too long\n");
+    return -1;
+  }
+
+  // Check the file can be written now rather than losing the recording at the end
+  // (without truncating it: an existing file is only replaced when the recording is written)
+  FILE* file = fopen(file_path, "ab");
+  if (file == NULL) {
+    fprintf(stderr, "FIFO recorder: Failed to open %s: %s\n", file_path, strerror(errno));
+    return -1;
+  }
+  fclose(file);
+
+  fifo_record_sample_t* ring = malloc(capacity * sizeof(fifo_record_sample_t));
+  if (ring == NULL) {
+    fprintf(stderr, "FIFO recorder: Failed to allocate %llu MB ring\n", capacity * sizeof(fifo_record_sample_t) >> 20);
+    return -1;
+  }
+  memset(ring, 0, capacity * sizeof(fifo_record_sample_t)); // Fault it in now, not while sampling
+  rt_prefault(ring, capacity * sizeof(fifo_record_sample_t));
+
+  // Read only the words of the boards connected now
+  struct sys_sts_snapshot_t snap;
+  sys_sts_snapshot(sys_sts, &snap);
+  uint8_t board_mask = sys_sts_snap_connected_boards(&snap);
+  uint64_t word_mask = (1ull << HW_STS_REG_OFFSET) | (1ull << TRIG_COUNTER_OFFSET) | (1ull << TRIG_DATA_FIFO_STS_OFFSET);
+  for (int board = 0; board < 8; board++) {
+    if (board_mask & (1u << board)) {
+      word_mask |= (1ull << DAC_CMD_FIFO_STS_OFFSET(board)) | (1ull << ADC_DATA_FIFO_STS_OFFSET(board));
+    }
+  }
+
+  recorder.sys_sts = sys_sts;
+  strcpy(recorder.file_path, file_path);
+  recorder.rate_hz = rate_hz;
+  recorder.board_mask = board_mask;
+  recorder.word_mask = word_mask;
+  recorder.ring = ring;
+  recorder.capacity = capacity;
+  atomic_store(&recorder.samples_taken, 0);
+  atomic_store(&recorder.missed_periods, 0);
+  atomic_store(&recorder.stop, false);
+  if (rt_thread_create(&recorder.thread, RT_CLASS_MONITOR, recorder_thread, NULL) != 0) {
+    fprintf(stderr, "FIFO recorder: Failed to create recorder thread\n");
+    free(ring);
+    recorder.ring = NULL;
+    return -1;
+  }
+  recorder.running = true;
+  return 0;
+}
+
+// Stop recording and write the file (-1 if it could not be written; 0 if nothing was recording)
+int fifo_recorder_stop(void) {
+  if (!recorder.running) {
+    return 0;
+  }
+  atomic_store(&recorder.stop, true);
+  pthread_join(recorder.thread, NULL);
+  recorder.running = false;
+
+  uint64_t taken = atomic_load(&recorder.samples_taken);
+  uint64_t count = (taken < recorder.capacity) ? taken : recorder.capacity;
+  uint64_t first = taken - count;
+
+  fifo_record_header_t header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, FIFO_RECORD_MAGIC, sizeof(header.magic));
+  header.version = FIFO_RECORD_VERSION;
+  header.header_size = FIFO_RECORD_HEADER_SIZE;
+  header.sample_size = sizeof(fifo_record_sample_t);
+  header.board_mask = recorder.board_mask;
+  header.rate_hz = recorder.rate_hz;
+  header.dac_cmd_fifo_words = DAC_CMD_FIFO_WORDCOUNT;
+  header.adc_data_fifo_words = ADC_DATA_FIFO_WORDCOUNT;
+  header.trig_data_fifo_words = TRIG_DATA_FIFO_WORDCOUNT;
+  header.start_realtime_ns = recorder.start_realtime_ns;
+  header.start_monotonic_ns = recorder.start_monotonic_ns;
+  header.sample_count = count;
+  header.samples_taken = taken;
+  header.missed_periods = atomic_load(&recorder.missed_periods);
+
+  // Oldest first: from the oldest kept sample to the end of the ring, then from its start
+  int result = 0;
+  FILE* file = fopen(recorder.file_path, "wb");
+  if (file == NULL) {
+    fprintf(stderr, "FIFO recorder: Failed to open %s: %s\n", recorder.file_path, strerror(errno));
+    result = -1;
+  } else {
+    uint64_t start = first % recorder.capacity;
+    uint64_t first_span = (start + count > recorder.capacity) ? recorder.capacity - start : count;
+    if (fwrite(&header, sizeof(header), 1, file) != 1 ||
+        fwrite(&recorder.ring[start], sizeof(fifo_record_sample_t), first_span, file) != first_span ||
+        fwrite(recorder.ring, sizeof(fifo_record_sample_t), count - first_span, file) != count - first_span) {
+      fprintf(stderr, "FIFO recorder: Failed to write %s: %s\n", recorder.file_path, strerror(errno));
+      result = -1;
+    }
+    if (fclose(file) != 0) {
+      result = -1;
+    }
+  }
+  if (result == 0) {
+    printf("FIFO recorder: Wrote %llu samples (%.1f s at %u Hz, %llu missed periods) to %s\n",
+           count, (double)count / recorder.rate_hz, recorder.rate_hz, header.missed_periods, recorder.file_path);
+    if (taken > count) {
+      printf("FIFO recorder: The ring wrapped; the first %llu samples were overwritten\n", taken - count);
+    }
+  }
+  free(recorder.ring);
+  recorder.ring = NULL;
+  return result;
+}
+
+// True while recording
+bool fifo_recorder_running(void) {
+  return recorder.running;
+}
+
+// Print the recording state
+void fifo_recorder_print_status(void) {
+  if (!recorder.running) {
+    printf("FIFO recorder: off\n");
+    return;
+  }
+  uint64_t taken = atomic_load(&recorder.samples_taken);
+  printf("FIFO recorder: recording to %s at %u Hz (boards 0x%02X)\n",
+         recorder.file_path, recorder.rate_hz, recorder.board_mask);
+  printf("  %llu samples taken, %llu kept (ring of %.1f s), %llu missed periods\n",
+         taken, taken < recorder.capacity ? taken : recorder.capacity,
+         (double)recorder.capacity / recorder.rate_hz, atomic_load(&recorder.missed_periods));
+}
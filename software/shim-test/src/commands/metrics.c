@@ -0,0 +1,327 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include "metrics.h"
+#include "rt_profile.h"
+
+// Write latency bucket bounds
+const uint32_t metrics_latency_bucket_us[METRICS_LATENCY_BUCKETS] = {10, 50, 100, 500, 1000, 5000, 10000, 50000, 100000, UINT32_MAX};
+
+static metrics_fifo_t fifo_series[POLL_STREAM_COUNT][8];
+static metrics_writer_t writer_series[METRICS_WRITER_COUNT][8];
+static const char* writer_names[METRICS_WRITER_COUNT] = {"adc_data", "trig_data"};
+
+// Periodic export state (protected by export_lock)
+static pthread_mutex_t export_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t export_wake;
+static pthread_t export_thread;
+static bool export_running = false;
+static bool export_stop = false;
+static char export_path[1024];
+static uint32_t export_period_ms;
+
+// Series of a FIFO (board 0-7)
+metrics_fifo_t* metrics_fifo(poll_stream_t stream, uint8_t board) {
+  return &fifo_series[stream][board & 7];
+}
+
+// Series of an output file (board 0-7)
+metrics_writer_t* metrics_writer(metrics_writer_kind_t kind, uint8_t board) {
+  return &writer_series[kind][board & 7];
+}
+
+// Record an observed FIFO occupancy in words (stall = the FIFO was at its limit)
+void metrics_fifo_observe(metrics_fifo_t* fifo, uint32_t occupancy, bool stall) {
+  uint32_t capacity = atomic_load_explicit(&fifo->capacity, memory_order_relaxed);
+  uint32_t bucket = (capacity > 0) ? (uint32_t)((uint64_t)occupancy * METRICS_OCCUPANCY_BUCKETS / capacity) : 0;
+  if (bucket >= METRICS_OCCUPANCY_BUCKETS) {
+    bucket = METRICS_OCCUPANCY_BUCKETS - 1;
+  }
+  metrics_add(&fifo->polls, 1);
+  metrics_add(&fifo->occupancy_hist[bucket], 1);
+  metrics_add(&fifo->occupancy_sum, occupancy);
+  if (stall) {
+    metrics_add(&fifo->stalls, 1);
+  }
+}
+
+// Record a slack measurement in nanoseconds (keeps the least)
+void metrics_fifo_slack(metrics_fifo_t* fifo, uint64_t slack_ns) {
+  if (atomic_load_explicit(&fifo->slack_samples, memory_order_relaxed) == 0 ||
+      slack_ns < atomic_load_explicit(&fifo->min_slack_ns, memory_order_relaxed)) {
+    atomic_store_explicit(&fifo->min_slack_ns, slack_ns, memory_order_relaxed);
+  }
+  metrics_add(&fifo->slack_samples, 1);
+}
+
+// Record one written batch and how long it took to write and flush
+void metrics_writer_record(metrics_writer_t* writer, uint64_t bytes, uint64_t latency_ns) {
+  int bucket = 0;
+  while (bucket < METRICS_LATENCY_BUCKETS - 1 && latency_ns >= metrics_latency_bucket_us[bucket] * 1000ULL) {
+    bucket++;
+  }
+  metrics_add(&writer->bytes, bytes);
+  metrics_add(&writer->writes, 1);
+  metrics_add(&writer->latency_hist[bucket], 1);
+  metrics_add(&writer->latency_sum_ns, latency_ns);
+  if (latency_ns > atomic_load_explicit(&writer->max_latency_ns, memory_order_relaxed)) {
+    atomic_store_explicit(&writer->max_latency_ns, latency_ns, memory_order_relaxed);
+  }
+}
+
+// Clear every series (FIFO depths are kept, as they are set when a stream starts; streams must be idle)
+void metrics_reset(void) {
+  for (int s = 0; s < POLL_STREAM_COUNT; s++) {
+    for (int b = 0; b < 8; b++) {
+      metrics_fifo_t* fifo = &fifo_series[s][b];
+      atomic_store(&fifo->words, 0);
+      atomic_store(&fifo->polls, 0);
+      atomic_store(&fifo->stalls, 0);
+      for (int i = 0; i < METRICS_OCCUPANCY_BUCKETS; i++) {
+        atomic_store(&fifo->occupancy_hist[i], 0);
+      }
+      atomic_store(&fifo->occupancy_sum, 0);
+      atomic_store(&fifo->slack_samples, 0);
+      atomic_store(&fifo->min_slack_ns, 0);
+    }
+  }
+  for (int k = 0; k < METRICS_WRITER_COUNT; k++) {
+    for (int b = 0; b < 8; b++) {
+      metrics_writer_t* writer = &writer_series[k][b];
+      atomic_store(&writer->bytes, 0);
+      atomic_store(&writer->writes, 0);
+      for (int i = 0; i < METRICS_LATENCY_BUCKETS; i++) {
+        atomic_store(&writer->latency_hist[i], 0);
+      }
+      atomic_store(&writer->latency_sum_ns, 0);
+      atomic_store(&writer->max_latency_ns, 0);
+    }
+  }
+}
+
+// Load a counter for export
+static uint64_t load(_Atomic uint64_t* counter) {
+  return atomic_load_explicit(counter, memory_order_relaxed);
+}
+
+// Write the HELP and TYPE lines of a metric family
+static void write_family(FILE* out, const char* name, const char* type, const char* help) {
+  fprintf(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+// Write every series that has seen activity in Prometheus text format
+void metrics_write_text(FILE* out) {
+  // FIFOs that have been polled
+  bool fifo_active[POLL_STREAM_COUNT][8];
+  for (int s = 0; s < POLL_STREAM_COUNT; s++) {
+    for (int b = 0; b < 8; b++) {
+      fifo_active[s][b] = load(&fifo_series[s][b].polls) > 0;
+    }
+  }
+
+  write_family(out, "shim_fifo_words_total", "counter", "Words moved through the FIFO");
+  for (int s = 0; s < POLL_STREAM_COUNT; s++) {
+    for (int b = 0; b < 8; b++) {
+      if (!fifo_active[s][b]) continue;
+      fprintf(out, "shim_fifo_words_total{fifo=\"%s\",board=\"%d\"} %llu\n",
+              poll_policies[s].name, b, load(&fifo_series[s][b].words));
+    }
+  }
+
+  write_family(out, "shim_fifo_polls_total", "counter", "FIFO levels observed");
+  for (int s = 0; s < POLL_STREAM_COUNT; s++) {
+    for (int b = 0; b < 8; b++) {
+      if (!fifo_active[s][b]) continue;
+      fprintf(out, "shim_fifo_polls_total{fifo=\"%s\",board=\"%d\"} %llu\n",
+              poll_policies[s].name, b, load(&fifo_series[s][b].polls));
+    }
+  }
+
+  write_family(out, "shim_fifo_stalls_total", "counter", "Polls that found the FIFO at its limit (full data FIFO, empty command FIFO)");
+  for (int s = 0; s < POLL_STREAM_COUNT; s++) {
+    for (int b = 0; b < 8; b++) {
+      if (!fifo_active[s][b]) continue;
+      fprintf(out, "shim_fifo_stalls_total{fifo=\"%s\",board=\"%d\"} %llu\n",
+              poll_policies[s].name, b, load(&fifo_series[s][b].stalls));
+    }
+  }
+
+  write_family(out, "shim_fifo_occupancy_ratio", "histogram", "Fraction of the FIFO depth in use at each poll");
+  for (int s = 0; s < POLL_STREAM_COUNT; s++) {
+    for (int b = 0; b < 8; b++) {
+      if (!fifo_active[s][b]) continue;
+      metrics_fifo_t* fifo = &fifo_series[s][b];
+      uint64_t cumulative = 0;
+      for (int i = 0; i < METRICS_OCCUPANCY_BUCKETS; i++) {
+        cumulative += load(&fifo->occupancy_hist[i]);
+        if (i < METRICS_OCCUPANCY_BUCKETS - 1) {
+          fprintf(out, "shim_fifo_occupancy_ratio_bucket{fifo=\"%s\",board=\"%d\",le=\"%.1f\"} %llu\n",
+                  poll_policies[s].name, b, (double)(i + 1) / METRICS_OCCUPANCY_BUCKETS, cumulative);
+        }
+      }
+      uint32_t capacity = atomic_load_explicit(&fifo->capacity, memory_order_relaxed);
+      fprintf(out, "shim_fifo_occupancy_ratio_bucket{fifo=\"%s\",board=\"%d\",le=\"+Inf\"} %llu\n",
+              poll_policies[s].name, b, cumulative);
+      fprintf(out, "shim_fifo_occupancy_ratio_sum{fifo=\"%s\",board=\"%d\"} %.6f\n",
+              poll_policies[s].name, b, capacity > 0 ? (double)load(&fifo->occupancy_sum) / capacity : 0.0);
+      fprintf(out, "shim_fifo_occupancy_ratio_count{fifo=\"%s\",board=\"%d\"} %llu\n",
+              poll_policies[s].name, b, cumulative);
+    }
+  }
+
+  write_family(out, "shim_fifo_min_slack_seconds", "gauge", "Least time seen before the FIFO would run dry");
+  for (int s = 0; s < POLL_STREAM_COUNT; s++) {
+    for (int b = 0; b < 8; b++) {
+      if (!fifo_active[s][b] || load(&fifo_series[s][b].slack_samples) == 0) continue;
+      fprintf(out, "shim_fifo_min_slack_seconds{fifo=\"%s\",board=\"%d\"} %.9f\n",
+              poll_policies[s].name, b, load(&fifo_series[s][b].min_slack_ns) / 1e9);
+    }
+  }
+
+  // Files that have been written
+  bool writer_active[METRICS_WRITER_COUNT][8];
+  for (int k = 0; k < METRICS_WRITER_COUNT; k++) {
+    for (int b = 0; b < 8; b++) {
+      writer_active[k][b] = load(&writer_series[k][b].writes) > 0;
+    }
+  }
+
+  write_family(out, "shim_file_bytes_total", "counter", "Bytes written to the output file");
+  for (int k = 0; k < METRICS_WRITER_COUNT; k++) {
+    for (int b = 0; b < 8; b++) {
+      if (!writer_active[k][b]) continue;
+      fprintf(out, "shim_file_bytes_total{stream=\"%s\",board=\"%d\"} %llu\n",
+              writer_names[k], b, load(&writer_series[k][b].bytes));
+    }
+  }
+
+  write_family(out, "shim_file_write_seconds", "histogram", "Time to write and flush one batch");
+  for (int k = 0; k < METRICS_WRITER_COUNT; k++) {
+    for (int b = 0; b < 8; b++) {
+      if (!writer_active[k][b]) continue;
+      metrics_writer_t* writer = &writer_series[k][b];
+      uint64_t cumulative = 0;
+      for (int i = 0; i < METRICS_LATENCY_BUCKETS; i++) {
+        cumulative += load(&writer->latency_hist[i]);
+        if (metrics_latency_bucket_us[i] != UINT32_MAX) {
+          fprintf(out, "shim_file_write_seconds_bucket{stream=\"%s\",board=\"%d\",le=\"%g\"} %llu\n",
+                  writer_names[k], b, metrics_latency_bucket_us[i] / 1e6, cumulative);
+        }
+      }
+      fprintf(out, "shim_file_write_seconds_bucket{stream=\"%s\",board=\"%d\",le=\"+Inf\"} %llu\n",
+              writer_names[k], b, cumulative);
+      fprintf(out, "shim_file_write_seconds_sum{stream=\"%s\",board=\"%d\"} %.9f\n",
+              writer_names[k], b, load(&writer->latency_sum_ns) / 1e9);
+      fprintf(out, "shim_file_write_seconds_count{stream=\"%s\",board=\"%d\"} %llu\n",
+              writer_names[k], b, cumulative);
+    }
+  }
+
+  write_family(out, "shim_file_write_max_seconds", "gauge", "Longest time to write and flush one batch");
+  for (int k = 0; k < METRICS_WRITER_COUNT; k++) {
+    for (int b = 0; b < 8; b++) {
+      if (!writer_active[k][b]) continue;
+      fprintf(out, "shim_file_write_max_seconds{stream=\"%s\",board=\"%d\"} %.9f\n",
+              writer_names[k], b, load(&writer_series[k][b].max_latency_ns) / 1e9);
+    }
+  }
+}
+
+// Write the metrics to the export file through a temporary file and a rename
+static int export_write(const char* file_path) {
+  char tmp_path[1040];
+  snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", file_path);
+  FILE* out = fopen(tmp_path, "w");
+  if (out == NULL) {
+    fprintf(stderr, "Metrics export: Failed to open %s: %s\n", tmp_path, strerror(errno));
+    return -1;
+  }
+  metrics_write_text(out);
+  if (fclose(out) != 0 || rename(tmp_path, file_path) != 0) {
+    fprintf(stderr, "Metrics export: Failed to write %s: %s\n", file_path, strerror(errno));
+    return -1;
+  }
+  return 0;
+}
+
+// Export thread: rewrite the file every period until stopped, then once more
+static void* export_thread_func(void* arg) {
+  pthread_mutex_lock(&export_lock);
+  while (!export_stop) {
+    pthread_mutex_unlock(&export_lock);
+    export_write(export_path);
+    pthread_mutex_lock(&export_lock);
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    uint64_t deadline_ns = (uint64_t)deadline.tv_sec * 1000000000ULL + (uint64_t)deadline.tv_nsec +
+                           (uint64_t)export_period_ms * 1000000ULL;
+    deadline.tv_sec = (time_t)(deadline_ns / 1000000000ULL);
+    deadline.tv_nsec = (long)(deadline_ns % 1000000000ULL);
+    while (!export_stop && pthread_cond_timedwait(&export_wake, &export_lock, &deadline) != ETIMEDOUT) {
+    }
+  }
+  pthread_mutex_unlock(&export_lock);
+  export_write(export_path);
+  return NULL;
+}
+
+// Rewrite a file with the metrics every period_ms (replaces a running export; -1 on failure)
+int metrics_export_start(const char* file_path, uint32_t period_ms) {
+  if (period_ms < METRICS_EXPORT_MIN_MS || period_ms > METRICS_EXPORT_MAX_MS) {
+    fprintf(stderr, "Metrics export: Period %u ms out of range (%d-%d ms)\n",
+            period_ms, METRICS_EXPORT_MIN_MS, METRICS_EXPORT_MAX_MS);
+    return -1;
+  }
+  if (strlen(file_path) >= sizeof(export_path)) {
+    fprintf(stderr, "Metrics export: File path too long\n");
+    return -1;
+  }
+  metrics_export_stop();
+
+  // Check the file can be written before starting the thread
+  if (export_write(file_path) != 0) {
+    return -1;
+  }
+
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(&export_wake, &attr);
+  pthread_condattr_destroy(&attr);
+
+  strcpy(export_path, file_path);
+  export_period_ms = period_ms;
+  export_stop = false;
+  if (rt_thread_create(&export_thread, RT_CLASS_WRITER, export_thread_func, NULL) != 0) {
+    fprintf(stderr, "Metrics export: Failed to create export thread\n");
+    pthread_cond_destroy(&export_wake);
+    return -1;
+  }
+  export_running = true;
+  return 0;
+}
+
+// Stop the periodic export (the file is written a last time)
+void metrics_export_stop(void) {
+  if (!export_running) {
+    return;
+  }
+  pthread_mutex_lock(&export_lock);
+  export_stop = true;
+  pthread_cond_signal(&export_wake);
+  pthread_mutex_unlock(&export_lock);
+  pthread_join(export_thread, NULL);
+  pthread_cond_destroy(&export_wake);
+  export_running = false;
+}
+
+// True while a periodic export runs (its file path is copied to file_path if not NULL)
+bool metrics_export_running(char* file_path, size_t size) {
+  if (export_running && file_path != NULL && size > 0) {
+    snprintf(file_path, size, "%s", export_path);
+  }
+  return export_running;
+}
@@ -0,0 +1,257 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include "poll_sched.h"
+#include "metrics.h"
+#include "trace.h"
+#include "sys_sts.h"
+
+// Default policies
+poll_policy_t poll_policies[POLL_STREAM_COUNT] = {
+  [POLL_STREAM_ADC_DATA]     = {"adc_data",     2000,   20, 25, 50},
+  [POLL_STREAM_ADC_CMD]      = {"adc_cmd",      1000,   20, 50, 50},
+  [POLL_STREAM_DAC_CMD]      = {"dac_cmd",      1000,   20, 50, 50},
+  [POLL_STREAM_DAC_DEBUG]    = {"dac_debug",    1000,    0, 25, 50},
+  [POLL_STREAM_TRIG_DATA]    = {"trig_data",    10000,   0,  0, 50},
+  [POLL_STREAM_TRIG_MONITOR] = {"trig_monitor", 500000,  0,  0, 50},
+};
+
+// Wake latency bucket bounds
+const uint32_t poll_wake_bucket_us[POLL_WAKE_BUCKETS] = {10, 20, 50, 100, 200, 500, 1000, 2000, 5000, UINT32_MAX};
+
+// Statistics of finished streams
+static poll_stats_t poll_totals[POLL_STREAM_COUNT];
+static pthread_mutex_t poll_totals_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// CLOCK_MONOTONIC in nanoseconds
+static uint64_t monotonic_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Start scheduling a FIFO with the stream's current policy
+void poll_sched_init(poll_sched_t* sched, poll_stream_t stream, uint32_t capacity, double max_words_per_sec) {
+  memset(sched, 0, sizeof(*sched));
+  sched->stream = stream;
+  sched->policy = poll_policies[stream];
+  sched->capacity = capacity;
+  sched->max_rate = max_words_per_sec / 1e9;
+  sched->board = -1;
+}
+
+// Feed a board's FIFO metrics (metrics.h) with this scheduler's observations
+void poll_sched_track(poll_sched_t* sched, uint8_t board) {
+  sched->metrics = metrics_fifo(sched->stream, board);
+  sched->board = board;
+  atomic_store_explicit(&sched->metrics->capacity, sched->capacity, memory_order_relaxed);
+}
+
+// Record a FIFO level read from hardware
+void poll_sched_observe(poll_sched_t* sched, uint32_t available, uint32_t needed) {
+  uint64_t now = monotonic_ns();
+  sched->stats.polls++;
+  if (available < needed) {
+    sched->stats.wasted_polls++;
+  }
+  if (sched->metrics != NULL) {
+    // Command FIFO levels are free words; the metrics count words in the FIFO
+    bool command = sched->stream == POLL_STREAM_ADC_CMD || sched->stream == POLL_STREAM_DAC_CMD;
+    uint32_t occupancy = available;
+    if (command) {
+      occupancy = (sched->capacity > available) ? sched->capacity - available : 0;
+    }
+    metrics_fifo_observe(sched->metrics, occupancy, sched->capacity > 0 && available >= sched->capacity);
+  }
+
+  if (!sched->have_sample) {
+    sched->sample_level = available;
+    sched->sample_time_ns = now;
+    sched->have_sample = true;
+    return;
+  }
+  if (sched->capacity > 0 && available >= sched->capacity) {
+    sched->stats.limit_hits++;
+  }
+
+  // Close the rate sample once it spans long enough to be meaningful (spin polls don't)
+  uint64_t dt = now - sched->sample_time_ns;
+  if (dt >= POLL_SCHED_MIN_SAMPLE_NS) {
+    int64_t progress = (int64_t)available - sched->sample_level;
+    double sample_rate = (progress > 0) ? (double)progress / dt : 0.0;
+    sched->rate += POLL_SCHED_RATE_WEIGHT * (sample_rate - sched->rate);
+    sched->sample_level = available;
+    sched->sample_time_ns = now;
+  }
+}
+
+// Record words serviced since the last observation
+void poll_sched_consumed(poll_sched_t* sched, uint32_t words) {
+  sched->sample_level -= words;
+  if (sched->metrics != NULL) {
+    metrics_add(&sched->metrics->words, words);
+  }
+}
+
+// Predicted time until the batch target is ready (0 if it already is)
+uint64_t poll_sched_predict_ns(const poll_sched_t* sched, uint32_t available, uint32_t needed) {
+  uint32_t target = (uint32_t)((uint64_t)sched->capacity * sched->policy.threshold_pct / 100);
+  if (target < needed) {
+    target = needed;
+  }
+  if (available >= target) {
+    return 0;
+  }
+
+  double max_sleep_ns = sched->policy.max_sleep_us * 1e3;
+  double eta_ns = (sched->rate > 0.0) ? (target - available) / sched->rate : max_sleep_ns;
+  if (eta_ns > max_sleep_ns) {
+    eta_ns = max_sleep_ns;
+  }
+  // Never sleep through most of the time the FIFO needs to reach its limit at full speed
+  if (sched->max_rate > 0.0 && sched->capacity > available) {
+    double limit_ns = (sched->capacity - available) / sched->max_rate * sched->policy.headroom_pct / 100.0;
+    if (eta_ns > limit_ns) {
+      eta_ns = limit_ns;
+    }
+  }
+  return (uint64_t)eta_ns;
+}
+
+// Sleep for a predicted interval (spins, i.e. returns at once, inside the spin window)
+void poll_sched_sleep_ns(poll_sched_t* sched, uint64_t ns) {
+  uint64_t spin_ns = sched->policy.spin_us * 1000ULL;
+  if (ns <= spin_ns) {
+    sched->stats.spins++;
+    return;
+  }
+
+  // Wake one spin window early; the caller spin-polls the rest of the way
+  uint64_t start = monotonic_ns();
+  uint64_t deadline = start + ns - spin_ns;
+  struct timespec ts = {
+    .tv_sec = (time_t)(deadline / 1000000000ULL),
+    .tv_nsec = (long)(deadline % 1000000000ULL)
+  };
+  TRACE_BEGIN(trace_start_ns);
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+  }
+  TRACE_END(trace_start_ns, TRACE_SLEEP, sched->stream, sched->board, (uint32_t)((ns - spin_ns) / 1000));
+
+  uint64_t woke = monotonic_ns();
+  sched->stats.sleeps++;
+  sched->stats.sleep_ns += woke - start;
+  uint64_t late_ns = (woke > deadline) ? woke - deadline : 0;
+  sched->stats.oversleep_ns += late_ns;
+  if (late_ns > sched->stats.max_oversleep_ns) {
+    sched->stats.max_oversleep_ns = late_ns;
+  }
+  int bucket = 0;
+  while (bucket < POLL_WAKE_BUCKETS - 1 && late_ns >= poll_wake_bucket_us[bucket] * 1000ULL) {
+    bucket++;
+  }
+  sched->stats.wake_hist[bucket]++;
+}
+
+// Predict and sleep in one step
+void poll_sched_wait(poll_sched_t* sched, uint32_t available, uint32_t needed) {
+  poll_sched_sleep_ns(sched, poll_sched_predict_ns(sched, available, needed));
+}
+
+// Add a finished stream's statistics to the per-stream totals
+void poll_sched_finish(poll_sched_t* sched) {
+  pthread_mutex_lock(&poll_totals_lock);
+  poll_stats_add(&poll_totals[sched->stream], &sched->stats);
+  pthread_mutex_unlock(&poll_totals_lock);
+}
+
+// Accumulate statistics
+void poll_stats_add(poll_stats_t* total, const poll_stats_t* stats) {
+  total->polls += stats->polls;
+  total->wasted_polls += stats->wasted_polls;
+  total->limit_hits += stats->limit_hits;
+  total->sleeps += stats->sleeps;
+  total->spins += stats->spins;
+  total->sleep_ns += stats->sleep_ns;
+  total->oversleep_ns += stats->oversleep_ns;
+  if (stats->max_oversleep_ns > total->max_oversleep_ns) {
+    total->max_oversleep_ns = stats->max_oversleep_ns;
+  }
+  for (int i = 0; i < POLL_WAKE_BUCKETS; i++) {
+    total->wake_hist[i] += stats->wake_hist[i];
+  }
+}
+
+// Copy the totals for a stream
+void poll_stats_get_totals(poll_stream_t stream, poll_stats_t* totals) {
+  pthread_mutex_lock(&poll_totals_lock);
+  *totals = poll_totals[stream];
+  pthread_mutex_unlock(&poll_totals_lock);
+}
+
+// Clear the totals of every stream
+void poll_stats_reset_totals(void) {
+  pthread_mutex_lock(&poll_totals_lock);
+  memset(poll_totals, 0, sizeof(poll_totals));
+  pthread_mutex_unlock(&poll_totals_lock);
+}
+
+// Print statistics on one line after a prefix
+void poll_stats_print(const char* prefix, const poll_stats_t* stats) {
+  printf("%s%llu polls (%llu wasted, %.1f%%), %llu sleeps (avg %.1f us, oversleep avg %.1f us), %llu spins, %llu at FIFO limit\n",
+         prefix, stats->polls, stats->wasted_polls,
+         stats->polls > 0 ? 100.0 * stats->wasted_polls / stats->polls : 0.0,
+         stats->sleeps,
+         stats->sleeps > 0 ? stats->sleep_ns / 1e3 / stats->sleeps : 0.0,
+         stats->sleeps > 0 ? stats->oversleep_ns / 1e3 / stats->sleeps : 0.0,
+         stats->spins, stats->limit_hits);
+}
+
+// Print the wake latency histogram on one line after a prefix
+void poll_stats_print_wake_hist(const char* prefix, const poll_stats_t* stats) {
+  printf("%s", prefix);
+  uint32_t lower = 0;
+  for (int i = 0; i < POLL_WAKE_BUCKETS; i++) {
+    if (poll_wake_bucket_us[i] == UINT32_MAX) {
+      printf(" >=%u", lower);
+    } else {
+      printf(" <%u", poll_wake_bucket_us[i]);
+    }
+    printf(":%llu", stats->wake_hist[i]);
+    lower = poll_wake_bucket_us[i];
+  }
+  printf(" (us late; max %.1f us)\n", stats->max_oversleep_ns / 1e3);
+}
+
+// Look up a stream by policy name (-1 if unknown)
+int poll_stream_from_name(const char* name) {
+  for (int i = 0; i < POLL_STREAM_COUNT; i++) {
+    if (strcmp(name, poll_policies[i].name) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// ADC data: 4 words (8 samples) per ADC_RD, at most one ADC_RD per minimum ADC delay
+double poll_max_rate_adc_data(struct sys_sts_t* sys_sts) {
+  double spi_hz = sys_sts_get_spi_clk_freq_hz(sys_sts, false);
+  uint32_t min_cycles = sys_sts_get_adc_delay_too_short_time(sys_sts, false) + 1;
+  return (spi_hz > 0.0 && min_cycles > 1) ? 4.0 * spi_hz / min_cycles : 0.0;
+}
+
+// ADC commands: at most one command word consumed per minimum ADC delay
+double poll_max_rate_adc_cmd(struct sys_sts_t* sys_sts) {
+  double spi_hz = sys_sts_get_spi_clk_freq_hz(sys_sts, false);
+  uint32_t min_cycles = sys_sts_get_adc_delay_too_short_time(sys_sts, false) + 1;
+  return (spi_hz > 0.0 && min_cycles > 1) ? spi_hz / min_cycles : 0.0;
+}
+
+// DAC commands: one 5-word DAC_WR consumed per minimum DAC delay
+double poll_max_rate_dac_cmd(struct sys_sts_t* sys_sts) {
+  double spi_hz = sys_sts_get_spi_clk_freq_hz(sys_sts, false);
+  uint32_t min_cycles = sys_sts_get_dac_delay_too_short_time(sys_sts, false) + 1;
+  return (spi_hz > 0.0 && min_cycles > 1) ? 5.0 * spi_hz / min_cycles : 0.0;
+}
@@ -25,6 +25,8 @@
 #include "adc_ctrl.h"
 #include "map_memory.h"
 #include "trigger_ctrl.h"
+#include "rt_profile.h"
+#include "dac_interp.h"
 
 // Data structure for rev_c streaming
 typedef struct {
@@ -37,10 +39,20 @@ typedef struct {
   uint32_t delay_cycles;
   volatile bool* should_stop;
   bool final_zero_trigger;
+  struct rev_c_waveform* waveform; // DAC stream only: packed words, freed by the stream thread
 } rev_c_params_t;
 
-// Helper function to validate Rev C DAC file format (Amps)
-static int validate_rev_c_file_format_amps(const char* file_path, int* line_count) {
+// Rev C waveform packed into the DAC command FIFO words of one iteration per board.
+// Every line is a trigger-wait DAC_WR followed by its ramp of delayed DAC_WRs, all
+// encoded with CONT set; the stream clears it on the final command of the final iteration.
+typedef struct rev_c_waveform {
+  uint32_t words_per_board;  // FIFO words per iteration on each board (5 per DAC_WR)
+  uint32_t* words[4];        // Boards 0-3
+} rev_c_waveform_t;
+
+// Helper function to validate Rev C DAC file format (Amps) and convert each line to DAC codes
+// (line_count * 32 values returned in *dac_vals, freed by the caller)
+static int validate_rev_c_file_format_amps(const char* file_path, int* line_count, int16_t** dac_vals) {
   FILE* file = fopen(file_path, "r");
   if (file == NULL) {
     fprintf(stderr, "Failed to open Rev C DAC file (Amps) '%s': %s\n", file_path, strerror(errno));
@@ -50,6 +62,8 @@ static int validate_rev_c_file_format_amps(const char* file_path, int* line_coun
   char line[2048]; // Buffer for line (32 numbers * ~10 chars + spaces + newline)
   int valid_lines = 0;
   int line_num = 0;
+  int16_t* vals = NULL;
+  int vals_capacity = 0; // Lines
   
   while (fgets(line, sizeof(line), file)) {
     line_num++;
@@ -86,6 +100,7 @@ static int validate_rev_c_file_format_amps(const char* file_path, int* line_coun
         fprintf(stderr, "Rev C DAC file (Amps) line %d, value %d: %.3f out of range (-5.0 to 5.0)\n", 
                 line_num, i+1, val);
         fclose(file);
+        free(vals);
         return -1;
       }
       
@@ -100,6 +115,7 @@ static int validate_rev_c_file_format_amps(const char* file_path, int* line_coun
     if (parsed != 32) {
       fprintf(stderr, "Rev C DAC file (Amps) line %d: Expected 32 values, got %d\n", line_num, parsed);
       fclose(file);
+      free(vals);
       return -1;
     }
     
@@ -108,9 +124,27 @@ static int validate_rev_c_file_format_amps(const char* file_path, int* line_coun
     if (*token_start != '\n' && *token_start != '\r' && *token_start != '\0') {
       fprintf(stderr, "Rev C DAC file (Amps) line %d: Extra data after 32 values\n", line_num);
       fclose(file);
+      free(vals);
       return -1;
     }
     
+    // Convert the line to DAC codes
+    if (valid_lines == vals_capacity) {
+      int new_capacity = (vals_capacity == 0) ? 1024 : vals_capacity * 2;
+      int16_t* new_vals = realloc(vals, (size_t)new_capacity * 32 * sizeof(int16_t));
+      if (new_vals == NULL) {
+        fprintf(stderr, "Rev C DAC file (Amps) line %d: Out of memory for DAC values\n", line_num);
+        fclose(file);
+        free(vals);
+        return -1;
+      }
+      vals = new_vals;
+      vals_capacity = new_capacity;
+    }
+    for (int i = 0; i < 32; i++) {
+      vals[(size_t)valid_lines * 32 + i] = amps_to_dac(amp_vals[i]);
+    }
+    
     valid_lines++;
   }
   
@@ -118,127 +152,156 @@ static int validate_rev_c_file_format_amps(const char* file_path, int* line_coun
   
   if (valid_lines == 0) {
     fprintf(stderr, "Rev C DAC file (Amps) '%s' contains no valid data lines\n", file_path);
+    free(vals);
     return -1;
   }
   
   *line_count = valid_lines;
+  *dac_vals = vals;
   return 0;
 }
 
+// Free a packed Rev C waveform
+static void rev_c_waveform_free(rev_c_waveform_t* waveform) {
+  if (waveform == NULL) return;
+  for (int board = 0; board < 4; board++) {
+    free(waveform->words[board]);
+  }
+  free(waveform);
+}
+
+// Pack validated DAC codes and their ramps into one iteration of FIFO words per board
+static rev_c_waveform_t* rev_c_waveform_pack(const int16_t* dac_vals, int line_count, int ramp_samples, int ramp_delay_cycles) {
+  if (ramp_samples > 0 && (ramp_delay_cycles < 1 || ramp_delay_cycles > 0x1FFFFFF)) {
+    fprintf(stderr, "Invalid ramp delay: %d cycles. Must be 1 to 33554431 (25-bit value).\n", ramp_delay_cycles);
+    return NULL;
+  }
+  uint64_t words_per_board = (uint64_t)line_count * (ramp_samples + 1) * 5;
+  if (words_per_board > UINT32_MAX / 4) {
+    fprintf(stderr, "Rev C waveform too large: %llu FIFO words per board\n", (unsigned long long)words_per_board);
+    return NULL;
+  }
+
+  rev_c_waveform_t* waveform = calloc(1, sizeof(rev_c_waveform_t));
+  if (waveform == NULL) {
+    fprintf(stderr, "Failed to allocate Rev C waveform\n");
+    return NULL;
+  }
+  waveform->words_per_board = (uint32_t)words_per_board;
+
+  for (int board = 0; board < 4; board++) {
+    waveform->words[board] = malloc((size_t)words_per_board * sizeof(uint32_t));
+    if (waveform->words[board] == NULL) {
+      fprintf(stderr, "Failed to allocate %llu-word Rev C waveform for board %d\n",
+              (unsigned long long)words_per_board, board);
+      rev_c_waveform_free(waveform);
+      return NULL;
+    }
+
+    // Each line ramps up linearly from zero, as the per-line streaming did (its previous values were never updated)
+    uint32_t* out = waveform->words[board];
+    const int16_t prev_vals[8] = {0};
+    int16_t frames[DAC_INTERP_BLOCK_FRAMES][8];
+    for (int line = 0; line < line_count; line++) {
+      dac_interp_t ramp;
+      dac_interp_init(&ramp, DAC_INTERP_LINEAR, NULL, prev_vals, &dac_vals[(size_t)line * 32 + board * 8], NULL,
+                      (uint32_t)ramp_samples + 1);
+      int ramp_step = 0;
+      uint32_t frame_count;
+      while ((frame_count = dac_interp_generate(&ramp, frames, DAC_INTERP_BLOCK_FRAMES)) > 0) {
+        for (uint32_t frame = 0; frame < frame_count; frame++, ramp_step++) {
+          // Wait for the line's trigger on the first ramp step, then step by the ramp delay
+          bool trig = (ramp_step == 0);
+          dac_encode_dac_wr(out, frames[frame], trig ? DAC_TRIGGER_WAIT : DAC_DELAY_WAIT, DAC_CONTINUE, DAC_LDAC,
+                            trig ? 1 : (uint32_t)ramp_delay_cycles);
+          out += 5;
+        }
+      }
+    }
+  }
+  return waveform;
+}
+
 // Thread function for Rev C DAC command streaming to all 4 boards
+// (copies the packed words into each board's FIFO as far as its free space allows)
 static void* rev_c_dac_cmd_stream_thread(void* arg) {
   rev_c_params_t* stream_data = (rev_c_params_t*)arg;
   command_context_t* ctx = stream_data->ctx;
   const char* dac_file = stream_data->dac_file;
   int iterations = stream_data->iterations;
-  int ramp_samples = stream_data->ramp_samples;
-  int ramp_delay_cycles = stream_data->ramp_delay_cycles;
   int line_count = stream_data->line_count;
   volatile bool* should_stop = stream_data->should_stop;
   bool final_zero_trigger = stream_data->final_zero_trigger;
+  rev_c_waveform_t* waveform = stream_data->waveform;
   bool verbose = *(ctx->verbose);
   
   printf("Rev C DAC Stream Thread: Starting streaming from file '%s' (%d lines, %d iterations, final_zero=%s)\n", 
          dac_file, line_count, iterations, final_zero_trigger ? "yes" : "no");
   
-  FILE* file = fopen(dac_file, "r");
-  if (file == NULL) {
-    fprintf(stderr, "Rev C DAC Stream Thread: Failed to open file '%s': %s\n", dac_file, strerror(errno));
-    return NULL;
+  uint32_t words_per_board = waveform->words_per_board;
+  uint64_t total_commands_sent = 0;
+  uint64_t total_words_sent = 0;
+  
+  // Final command of the final iteration has CONT cleared
+  uint32_t final_cmd[4][5];
+  for (int board = 0; board < 4; board++) {
+    memcpy(final_cmd[board], &waveform->words[board][words_per_board - 5], sizeof(final_cmd[board]));
+    final_cmd[board][0] &= ~(1u << DAC_CMD_CONT_BIT);
   }
   
-  int total_commands_sent = 0;
-  int total_words_sent = 0;
+  // Each board advances through its iterations independently
+  uint32_t pos[4] = {0, 0, 0, 0};
+  int iteration[4] = {0, 0, 0, 0};
+  int boards_done = 0;
   
-  // Process all iterations
-  for (int iteration = 0; iteration < iterations && !(*should_stop); iteration++) {
-    rewind(file);
-    char line[2048];
-    int line_num = 0;
-
-    int16_t prev_line_dac_vals[32] = {0}; // To store previous values for ramping
+  while (boards_done < 4 && !(*should_stop)) {
+    bool wrote = false;
     
-    while (fgets(line, sizeof(line), file) && !(*should_stop)) {
-      // Skip empty lines and comments
-      char* trimmed = line;
-      while (*trimmed == ' ' || *trimmed == '\t') trimmed++;
-      if (*trimmed == '\n' || *trimmed == '\r' || *trimmed == '\0' || *trimmed == '#') {
-        continue;
-      }
+    for (int board = 0; board < 4; board++) {
+      if (iteration[board] == iterations) continue;
       
-      line_num++;
+      uint32_t fifo_status = sys_sts_get_dac_cmd_fifo_status(ctx->sys_sts, (uint8_t)board, false);
+      if (FIFO_PRESENT(fifo_status) == 0) {
+        fprintf(stderr, "Rev C New DAC Stream Thread: Board %d FIFO not present, stopping\n", board);
+        goto cleanup;
+      }
       
-      // Parse 32 values from the line (already validated in main function)
-      int16_t line_dac_vals[32];
-      char* token_start = trimmed;
-      char* endptr;
+      // Whole 5-word commands up to the end of the iteration, keeping one word of margin
+      uint32_t words_used = FIFO_STS_WORD_COUNT(fifo_status);
+      uint32_t available_words = (words_used + 1 < DAC_CMD_FIFO_WORDCOUNT) ? DAC_CMD_FIFO_WORDCOUNT - words_used - 1 : 0;
+      uint32_t burst = words_per_board - pos[board];
+      if (burst > available_words) {
+        burst = available_words - available_words % 5;
+      }
+      if (burst == 0) continue;
       
-      // Parse as doubles and convert to DAC units
-      for (int i = 0; i < 32; i++) {
-        while (*token_start == ' ' || *token_start == '\t') token_start++;
-        double amp_val = strtof(token_start, &endptr);
-        line_dac_vals[i] = amps_to_dac(amp_val);
-        token_start = endptr;
+      const uint32_t* src = &waveform->words[board][pos[board]];
+      bool ends_stream = (iteration[board] == iterations - 1) && (pos[board] + burst == words_per_board);
+      if (ends_stream) {
+        dac_write_burst(ctx->dac_ctrl, (uint8_t)board, src, burst - 5);
+        dac_write_burst(ctx->dac_ctrl, (uint8_t)board, final_cmd[board], 5);
+      } else {
+        dac_write_burst(ctx->dac_ctrl, (uint8_t)board, src, burst);
       }
+      pos[board] += burst;
+      total_commands_sent += burst / 5;
+      total_words_sent += burst;
+      wrote = true;
       
-      // Send DAC write commands to each of the 4 boards
-      for (int board = 0; board < 4; board++) {
-        // Wait for FIFO space (for whole ramp including final sample)
-        while (!(*should_stop)) {
-          uint32_t fifo_status = sys_sts_get_dac_cmd_fifo_status(ctx->sys_sts, (uint8_t)board, false);
-          
-          if (FIFO_PRESENT(fifo_status) == 0) {
-            fprintf(stderr, "Rev C New DAC Stream Thread: Board %d FIFO not present, stopping\n", board);
-            goto cleanup;
-          }
-          
-          uint32_t words_used = FIFO_STS_WORD_COUNT(fifo_status);
-          uint32_t available_words = DAC_CMD_FIFO_WORDCOUNT - words_used;
-          if (available_words >= 5 * (ramp_samples + 1)) { // Need space for 1 command + 4 data words
-            break; // Space available, proceed with command
-          }
-          
-          usleep(1000); // 1ms delay before checking again
+      if (pos[board] == words_per_board) {
+        iteration[board]++;
+        pos[board] = 0;
+        if (verbose) {
+          printf("Rev C DAC Stream Thread: Board %d completed iteration %d/%d\n", board, iteration[board], iterations);
         }
-        
-        // Handle ramping if requested
-        for (int ramp_step = 0; ramp_step <= ramp_samples; ramp_step++) {
-          double ramp_fraction = (double)(ramp_step + 1) / (double)(ramp_samples + 1);
-          int16_t cmd_ch_vals[8];
-          for (int ch = 0; ch < 8; ch++) {
-            int16_t target_val = line_dac_vals[board * 8 + ch];
-            int16_t start_val = prev_line_dac_vals[board * 8 + ch];
-            int16_t ramped_val = start_val + (int16_t)((target_val - start_val) * ramp_fraction);
-            cmd_ch_vals[ch] = ramped_val;
-          }
-        
-          // For the last dac_wr command at the end of the ramp of the last line, cont should be false
-          bool is_last_iteration = (iteration == iterations - 1);
-          bool is_last_line = (line_num == line_count);
-          bool is_last_ramp_step = (ramp_step == ramp_samples);
-          bool cont = !(is_last_iteration && is_last_line && is_last_ramp_step);
-
-          bool trig = (ramp_step == 0); // Only wait for trigger on first ramp step
-          int count = trig ? 1 : ramp_delay_cycles; // 1 trigger or delay cycles
-
-          // Send DAC write command with trigger wait (trig=trig, cont=cont, ldac=true, 1 trigger OR delay)
-          dac_cmd_dac_wr(ctx->dac_ctrl, (uint8_t)board, cmd_ch_vals, trig ? DAC_TRIGGER_WAIT : DAC_DELAY_WAIT, cont ? DAC_CONTINUE : DAC_NO_CONTINUE, DAC_LDAC, count, verbose);
-          total_commands_sent++;
-          total_words_sent += 5; // 1 command + 4 data words
-        
-          if (verbose && line_num <= 10) { // Only show first few lines to avoid spam
-            printf("Rev C DAC Stream Thread: Board %d, Line %d, Iteration %d, sent DAC write (5 words, channels %d-%d)\n", 
-                  board, line_num, iteration + 1, board * 8, board * 8 + 7);
-          }
+        if (iteration[board] == iterations) {
+          boards_done++;
         }
       }
-      
-      // Small delay between lines to prevent overwhelming the system
-      usleep(100); // 100μs delay
     }
     
-    if (verbose) {
-      printf("Rev C DAC Stream Thread: Completed iteration %d/%d\n", iteration + 1, iterations);
+    if (!wrote) {
+      usleep(1000); // 1ms delay before checking again
     }
   }
   
@@ -280,13 +343,13 @@ static void* rev_c_dac_cmd_stream_thread(void* arg) {
   }
   
 cleanup:
-  fclose(file);
+  rev_c_waveform_free(waveform);
   
   if (*should_stop) {
-    printf("Rev C DAC Stream Thread: Stopping stream (user requested), sent %d total commands (%d total words)\n",
+    printf("Rev C DAC Stream Thread: Stopping stream (user requested), sent %llu total commands (%llu total words)\n",
             total_commands_sent, total_words_sent);
   } else {
-    printf("Rev C DAC Stream Thread: Stream completed, sent %d total commands (%d total words, %d iteration%s%s)\n", 
+    printf("Rev C DAC Stream Thread: Stream completed, sent %llu total commands (%llu total words, %d iteration%s%s)\n", 
            total_commands_sent, total_words_sent, iterations, iterations == 1 ? "" : "s", final_zero_trigger ? " + final zero" : "");
   }
   
@@ -545,16 +608,11 @@ int cmd_rev_c_compat(const char** args, int arg_count, const command_flag_t* fla
   bool connected_boards[4] = {false}; // Only check first 4 boards
   int connected_count = 0;
   
+  struct sys_sts_snapshot_t snap;
+  sys_sts_snapshot(ctx->sys_sts, &snap);
+  uint8_t connected_mask = sys_sts_snap_connected_boards(&snap);
   for (int board = 0; board < 4; board++) {
-    uint32_t adc_data_fifo_status = sys_sts_get_adc_data_fifo_status(ctx->sys_sts, (uint8_t)board, false);
-    uint32_t dac_cmd_fifo_status = sys_sts_get_dac_cmd_fifo_status(ctx->sys_sts, (uint8_t)board, false);
-    uint32_t adc_cmd_fifo_status = sys_sts_get_adc_cmd_fifo_status(ctx->sys_sts, (uint8_t)board, false);
-    uint32_t dac_data_fifo_status = sys_sts_get_dac_data_fifo_status(ctx->sys_sts, (uint8_t)board, false);
-    
-    if (FIFO_PRESENT(adc_data_fifo_status) && 
-        FIFO_PRESENT(dac_cmd_fifo_status) && 
-        FIFO_PRESENT(adc_cmd_fifo_status) && 
-        FIFO_PRESENT(dac_data_fifo_status)) {
+    if (connected_mask & (1u << board)) {
       connected_boards[board] = true;
       connected_count++;
       printf("  Board %d: Connected\n", board);
@@ -581,7 +639,8 @@ int cmd_rev_c_compat(const char** args, int arg_count, const command_flag_t* fla
   // Validate file format
   printf("Validating DAC file format...\n");
   int line_count;
-  if (validate_rev_c_file_format_amps(resolved_dac_file, &line_count) != 0) {
+  int16_t* dac_vals = NULL;
+  if (validate_rev_c_file_format_amps(resolved_dac_file, &line_count, &dac_vals) != 0) {
     return -1;
   }
   printf("  Amps file validation passed: %d valid data lines\n", line_count);
@@ -595,6 +654,7 @@ int cmd_rev_c_compat(const char** args, int arg_count, const command_flag_t* fla
   
   if (fgets(input_buffer, sizeof(input_buffer), stdin) == NULL) {
     fprintf(stderr, "Failed to read iteration count.\n");
+    free(dac_vals);
     return -1;
   }
 
@@ -607,6 +667,7 @@ int cmd_rev_c_compat(const char** args, int arg_count, const command_flag_t* fla
   int iterations = atoi(input_buffer);
   if (iterations < 1) {
     fprintf(stderr, "Invalid iteration count. Must be >= 1.\n");
+    free(dac_vals);
     return -1;
   }
   
@@ -640,6 +701,7 @@ int cmd_rev_c_compat(const char** args, int arg_count, const command_flag_t* fla
   
   if (fgets(input_buffer, sizeof(input_buffer), stdin) == NULL) {
     fprintf(stderr, "Failed to read ramp samples.\n");
+    free(dac_vals);
     return -1;
   }
   // Remove newline
@@ -651,6 +713,7 @@ int cmd_rev_c_compat(const char** args, int arg_count, const command_flag_t* fla
   int ramp_samples = atoi(input_buffer);
   if (ramp_samples < 0) {
     fprintf(stderr, "Invalid ramp samples. Must be >= 0.\n");
+    free(dac_vals);
     return -1;
   }
 
@@ -662,6 +725,7 @@ int cmd_rev_c_compat(const char** args, int arg_count, const command_flag_t* fla
 
     if (fgets(input_buffer, sizeof(input_buffer), stdin) == NULL) {
       fprintf(stderr, "Failed to read ramp time.\n");
+      free(dac_vals);
       return -1;
     }
     
@@ -675,6 +739,7 @@ int cmd_rev_c_compat(const char** args, int arg_count, const command_flag_t* fla
     if (ramp_time_ms < 0.02 * ramp_samples) {
       fprintf(stderr, "Invalid ramp time. Must be >= %.2f ms for %d samples (20μs per sample).\n", 
               0.02 * ramp_samples, ramp_samples);
+      free(dac_vals);
       return -1;
     }
 
@@ -691,6 +756,7 @@ int cmd_rev_c_compat(const char** args, int arg_count, const command_flag_t* fla
   
   if (fgets(input_buffer, sizeof(input_buffer), stdin) == NULL) {
     fprintf(stderr, "Failed to read ADC delay.\n");
+    free(dac_vals);
     return -1;
   }
   
@@ -703,6 +769,7 @@ int cmd_rev_c_compat(const char** args, int arg_count, const command_flag_t* fla
   adc_delay_ms = atof(input_buffer);
   if (adc_delay_ms < 0.0) {
     fprintf(stderr, "Invalid ADC delay. Must be >= 0 milliseconds.\n");
+    free(dac_vals);
     return -1;
   }
   
@@ -718,6 +785,7 @@ int cmd_rev_c_compat(const char** args, int arg_count, const command_flag_t* fla
   
   if (fgets(input_buffer, sizeof(input_buffer), stdin) == NULL) {
     fprintf(stderr, "Failed to read trigger lockout time.\n");
+    free(dac_vals);
     return -1;
   }
   
@@ -730,6 +798,7 @@ int cmd_rev_c_compat(const char** args, int arg_count, const command_flag_t* fla
   lockout_ms = atof(input_buffer);
   if (lockout_ms <= 0) {
     fprintf(stderr, "Invalid trigger lockout time. Must be > 0 milliseconds.\n");
+    free(dac_vals);
     return -1;
   }
   
@@ -745,6 +814,7 @@ int cmd_rev_c_compat(const char** args, int arg_count, const command_flag_t* fla
   
   if (fgets(input_buffer, sizeof(input_buffer), stdin) == NULL) {
     fprintf(stderr, "Failed to read final zero trigger choice.\n");
+    free(dac_vals);
     return -1;
   }
   
@@ -763,6 +833,7 @@ int cmd_rev_c_compat(const char** args, int arg_count, const command_flag_t* fla
   
   if (fgets(input_buffer, sizeof(input_buffer), stdin) == NULL) {
     fprintf(stderr, "Failed to read output file path.\n");
+    free(dac_vals);
     return -1;
   }
   
@@ -776,6 +847,7 @@ int cmd_rev_c_compat(const char** args, int arg_count, const command_flag_t* fla
   
   if (strlen(base_output_file) == 0) {
     fprintf(stderr, "Output file path cannot be empty.\n");
+    free(dac_vals);
     return -1;
   }
   
@@ -829,6 +901,17 @@ int cmd_rev_c_compat(const char** args, int arg_count, const command_flag_t* fla
     adc_cmd_noop(ctx->adc_ctrl, (uint8_t)board, ADC_TRIGGER_WAIT, ADC_NO_CONTINUE, 1, *(ctx->verbose)); // Wait for 1 trigger
   }
 
+  // Convert the waveform to FIFO words once, so the DAC stream only copies words
+  rev_c_waveform_t* waveform = rev_c_waveform_pack(dac_vals, line_count, ramp_samples, ramp_delay_cycles);
+  free(dac_vals);
+  if (waveform == NULL) {
+    return -1;
+  }
+  for (int board = 0; board < 4; board++) {
+    rt_prefault(waveform->words[board], waveform->words_per_board * sizeof(uint32_t));
+  }
+  printf("  Packed DAC waveform: %u FIFO words per board per iteration\n", waveform->words_per_board);
+  
   // Start ADC data streaming for each board
   printf("Starting ADC data streaming for all 4 boards...\n");
   for (int board = 0; board < 4; board++) {
@@ -856,6 +939,7 @@ int cmd_rev_c_compat(const char** args, int arg_count, const command_flag_t* fla
     const char* adc_data_args[] = {board_str, sample_count_str, board_output_file};
     if (cmd_stream_adc_data_to_file(adc_data_args, 3, NULL, 0, ctx) != 0) {
       fprintf(stderr, "Failed to start ADC data streaming for board %d\n", board);
+      rev_c_waveform_free(waveform);
       return -1;
     }
   }
@@ -885,6 +969,7 @@ int cmd_rev_c_compat(const char** args, int arg_count, const command_flag_t* fla
     const char* trig_args[] = {trigger_count_str, trigger_output_file};
     if (cmd_stream_trig_data_to_file(trig_args, 2, NULL, 0, ctx) != 0) {
       fprintf(stderr, "Failed to start trigger data streaming\n");
+      rev_c_waveform_free(waveform);
       return -1;
     }
   }
@@ -910,7 +995,8 @@ int cmd_rev_c_compat(const char** args, int arg_count, const command_flag_t* fla
     .line_count = line_count,
     .delay_cycles = delay_cycles,
     .should_stop = &dac_cmd_stream_stop,
-    .final_zero_trigger = final_zero_trigger
+    .final_zero_trigger = final_zero_trigger,
+    .waveform = waveform
   };
   
   // Prepare ADC command streaming thread data
@@ -931,14 +1017,16 @@ int cmd_rev_c_compat(const char** args, int arg_count, const command_flag_t* fla
   
   if (start_trigger_monitor(ctx->sys_sts, expected_triggers, *(ctx->verbose)) != 0) {
     fprintf(stderr, "Failed to start trigger monitor\n");
+    rev_c_waveform_free(waveform);
     return -1;
   }
   
   // Start DAC and ADC command streaming threads
   printf("Starting DAC command streaming thread...\n");
   pthread_t dac_thread;
-  if (pthread_create(&dac_thread, NULL, rev_c_dac_cmd_stream_thread, &dac_cmd_stream_data) != 0) {
+  if (rt_thread_create(&dac_thread, RT_CLASS_FEED, rev_c_dac_cmd_stream_thread, &dac_cmd_stream_data) != 0) {
     fprintf(stderr, "Failed to create DAC command streaming thread: %s\n", strerror(errno));
+    rev_c_waveform_free(waveform);
     if (is_trigger_monitor_active()) {
       stop_trigger_monitor();
     }
@@ -950,7 +1038,7 @@ int cmd_rev_c_compat(const char** args, int arg_count, const command_flag_t* fla
   
   printf("Starting ADC command streaming thread...\n");
   pthread_t adc_cmd_thread;
-  if (pthread_create(&adc_cmd_thread, NULL, rev_c_adc_cmd_stream_thread, &adc_cmd_stream_data) != 0) {
+  if (rt_thread_create(&adc_cmd_thread, RT_CLASS_FEED, rev_c_adc_cmd_stream_thread, &adc_cmd_stream_data) != 0) {
     fprintf(stderr, "Failed to create ADC command streaming thread: %s\n", strerror(errno));
     dac_cmd_stream_stop = true;
     if (is_trigger_monitor_active()) {
@@ -970,10 +1058,12 @@ int cmd_rev_c_compat(const char** args, int arg_count, const command_flag_t* fla
   
   while (!buffers_ready && check_count < max_checks) {
     buffers_ready = true;
+    struct sys_sts_snapshot_t snap;
+    sys_sts_snapshot(ctx->sys_sts, &snap);
     
     for (int board = 0; board < 4; board++) {
       // Check DAC command buffer
-      uint32_t dac_cmd_fifo_status = sys_sts_get_dac_cmd_fifo_status(ctx->sys_sts, (uint8_t)board, false);
+      uint32_t dac_cmd_fifo_status = sys_sts_snap_dac_cmd_fifo_status(&snap, (uint8_t)board);
       uint32_t dac_words = FIFO_STS_WORD_COUNT(dac_cmd_fifo_status);
       if (dac_words < 10) {
         buffers_ready = false;
@@ -983,7 +1073,7 @@ int cmd_rev_c_compat(const char** args, int arg_count, const command_flag_t* fla
       }
       
       // Check ADC command buffer  
-      uint32_t adc_cmd_fifo_status = sys_sts_get_adc_cmd_fifo_status(ctx->sys_sts, (uint8_t)board, false);
+      uint32_t adc_cmd_fifo_status = sys_sts_snap_adc_cmd_fifo_status(&snap, (uint8_t)board);
       uint32_t adc_words = FIFO_STS_WORD_COUNT(adc_cmd_fifo_status);
       if (adc_words < 10) {
         buffers_ready = false;
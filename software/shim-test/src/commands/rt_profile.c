@@ -0,0 +1,189 @@
+#define _GNU_SOURCE // pthread_attr_setaffinity_np, pthread_getattr_np
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include "rt_profile.h"
+
+// Default class policies: feeders and drains on core 1 above everything else, the rest time-shared
+rt_class_policy_t rt_policies[RT_CLASS_COUNT] = {
+  [RT_CLASS_FEED]    = {"feed",    80,  1},
+  [RT_CLASS_DRAIN]   = {"drain",   70,  1},
+  [RT_CLASS_WRITER]  = {"writer",   0, -1},
+  [RT_CLASS_MONITOR] = {"monitor",  0, -1},
+};
+
+static bool profile_enabled = false;
+
+// Start routine and argument of a profiled thread
+typedef struct {
+  void* (*start)(void*);
+  void* arg;
+} rt_start_t;
+
+// Set up thread attributes for a class (false if the class needs no special attributes)
+static bool class_attr_init(pthread_attr_t* attr, rt_class_t cls) {
+  const rt_class_policy_t* policy = &rt_policies[cls];
+  pthread_attr_init(attr);
+  pthread_attr_setstacksize(attr, RT_STACK_BYTES);
+  if (policy->priority > 0) {
+    struct sched_param param = {.sched_priority = policy->priority};
+    pthread_attr_setinheritsched(attr, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(attr, SCHED_FIFO);
+    pthread_attr_setschedparam(attr, &param);
+  }
+  if (policy->cpu >= 0) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(policy->cpu, &cpus);
+    pthread_attr_setaffinity_np(attr, sizeof(cpus), &cpus);
+  }
+  return policy->priority > 0 || policy->cpu >= 0;
+}
+
+// Lock the calling thread's whole stack, which also faults it in
+static void lock_own_stack(void) {
+  pthread_attr_t attr;
+  void* stack;
+  size_t size;
+  if (pthread_getattr_np(pthread_self(), &attr) != 0) {
+    return;
+  }
+  if (pthread_attr_getstack(&attr, &stack, &size) == 0 && mlock(stack, size) != 0) {
+    fprintf(stderr, "RT profile: Failed to lock thread stack: %s\n", strerror(errno));
+  }
+  pthread_attr_destroy(&attr);
+}
+
+// Start routine of profiled threads: pre-fault the stack, then run the stream
+static void* profiled_thread(void* arg) {
+  rt_start_t start = *(rt_start_t*)arg;
+  free(arg);
+  lock_own_stack();
+  return start.start(start.arg);
+}
+
+// Start routine of the permission probe
+static void* probe_thread(void* arg) {
+  return NULL;
+}
+
+// Lock memory and check SCHED_FIFO is permitted, then apply the profile to new threads
+int rt_profile_enable(void) {
+  if (profile_enabled) {
+    return 0;
+  }
+
+  long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+  for (int cls = 0; cls < RT_CLASS_COUNT; cls++) {
+    if (rt_policies[cls].cpu >= cpu_count) {
+      fprintf(stderr, "RT profile: Class '%s' is pinned to CPU %d, but only %ld CPU(s) are online.\n",
+              rt_policies[cls].name, rt_policies[cls].cpu, cpu_count);
+      return -1;
+    }
+  }
+
+  if (mlockall(MCL_CURRENT) != 0) {
+    fprintf(stderr, "RT profile: Cannot lock memory (mlockall: %s). Run as root or with CAP_IPC_LOCK.\n",
+            strerror(errno));
+    return -1;
+  }
+
+  // Start one short-lived thread per class to find out whether its attributes are allowed
+  for (int cls = 0; cls < RT_CLASS_COUNT; cls++) {
+    pthread_attr_t attr;
+    if (!class_attr_init(&attr, (rt_class_t)cls)) {
+      pthread_attr_destroy(&attr);
+      continue;
+    }
+    pthread_t probe;
+    int result = pthread_create(&probe, &attr, probe_thread, NULL);
+    pthread_attr_destroy(&attr);
+    if (result != 0) {
+      fprintf(stderr, "RT profile: Cannot start '%s' threads at SCHED_FIFO priority %d on CPU %d (%s). "
+              "Run as root or with CAP_SYS_NICE.\n",
+              rt_policies[cls].name, rt_policies[cls].priority, rt_policies[cls].cpu, strerror(result));
+      munlockall();
+      return -1;
+    }
+    pthread_join(probe, NULL);
+  }
+
+  profile_enabled = true;
+  return 0;
+}
+
+// Unlock memory and create new threads with default attributes again
+void rt_profile_disable(void) {
+  if (!profile_enabled) {
+    return;
+  }
+  munlockall();
+  profile_enabled = false;
+}
+
+// True while the profile is enabled
+bool rt_profile_enabled(void) {
+  return profile_enabled;
+}
+
+// Look up a class by name (-1 if unknown)
+int rt_class_from_name(const char* name) {
+  for (int i = 0; i < RT_CLASS_COUNT; i++) {
+    if (strcmp(name, rt_policies[i].name) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// Create a stream thread with its class attributes (default attributes while the profile is off)
+int rt_thread_create(pthread_t* thread, rt_class_t cls, void* (*start)(void*), void* arg) {
+  if (!profile_enabled) {
+    int result = pthread_create(thread, NULL, start, arg);
+    errno = result;
+    return result;
+  }
+
+  rt_start_t* profiled = malloc(sizeof(rt_start_t));
+  if (profiled == NULL) {
+    errno = ENOMEM;
+    return ENOMEM;
+  }
+  profiled->start = start;
+  profiled->arg = arg;
+
+  pthread_attr_t attr;
+  class_attr_init(&attr, cls);
+  int result = pthread_create(thread, &attr, profiled_thread, profiled);
+  pthread_attr_destroy(&attr);
+  if (result == EPERM || result == EINVAL) {
+    // Permissions or CPUs changed since the profile was enabled: run the stream anyway, keeping
+    // the small stack so the thread does not lock a default-sized one
+    fprintf(stderr, "RT profile: Cannot start '%s' thread with its profile (%s); using default attributes\n",
+            rt_policies[cls].name, strerror(result));
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, RT_STACK_BYTES);
+    result = pthread_create(thread, &attr, profiled_thread, profiled);
+    pthread_attr_destroy(&attr);
+  }
+  if (result != 0) {
+    free(profiled);
+  }
+  errno = result;
+  return result;
+}
+
+// Lock and fault in a stream buffer while the profile is enabled
+void rt_prefault(void* buffer, size_t bytes) {
+  if (!profile_enabled || buffer == NULL || bytes == 0) {
+    return;
+  }
+  if (mlock(buffer, bytes) != 0) {
+    fprintf(stderr, "RT profile: Failed to lock %zu-byte stream buffer: %s\n", bytes, strerror(errno));
+  }
+}
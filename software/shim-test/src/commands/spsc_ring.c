@@ -0,0 +1,87 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "spsc_ring.h"
+
+// Allocate a ring of at least capacity_words words (rounded up to a power of two)
+int spsc_ring_init(spsc_ring_t* ring, size_t capacity_words) {
+  size_t capacity = 1;
+  while (capacity < capacity_words) {
+    capacity <<= 1;
+  }
+
+  memset(ring, 0, sizeof(*ring));
+  if (posix_memalign((void**)&ring->buffer, SPSC_RING_CACHE_LINE, capacity * sizeof(uint32_t)) != 0) {
+    fprintf(stderr, "Failed to allocate %zu-word ring buffer\n", capacity);
+    ring->buffer = NULL;
+    return -1;
+  }
+
+  ring->capacity = capacity;
+  ring->mask = capacity - 1;
+  atomic_init(&ring->head, 0);
+  atomic_init(&ring->tail, 0);
+  return 0;
+}
+
+// Free ring storage
+void spsc_ring_free(spsc_ring_t* ring) {
+  free(ring->buffer);
+  ring->buffer = NULL;
+  ring->capacity = 0;
+}
+
+// Number of words currently in the ring
+size_t spsc_ring_used(spsc_ring_t* ring) {
+  size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+  size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+  return head - tail;
+}
+
+// Producer: get a contiguous writable span
+size_t spsc_ring_write_span(spsc_ring_t* ring, uint32_t** span) {
+  size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+  size_t free_words = ring->capacity - (head - tail);
+  size_t to_end = ring->capacity - (head & ring->mask);
+
+  if (free_words == 0) {
+    ring->full_stalls++;
+    return 0;
+  }
+
+  *span = &ring->buffer[head & ring->mask];
+  return (free_words < to_end) ? free_words : to_end;
+}
+
+// Producer: publish count words written into the span
+void spsc_ring_commit(spsc_ring_t* ring, size_t count) {
+  size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed) + count;
+  atomic_store_explicit(&ring->head, head, memory_order_release);
+
+  size_t used = head - atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  if (used > ring->high_water) {
+    ring->high_water = used;
+  }
+}
+
+// Consumer: get a contiguous readable span
+size_t spsc_ring_read_span(spsc_ring_t* ring, uint32_t** span) {
+  size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+  size_t used = head - tail;
+  size_t to_end = ring->capacity - (tail & ring->mask);
+
+  if (used == 0) {
+    return 0;
+  }
+
+  *span = &ring->buffer[tail & ring->mask];
+  return (used < to_end) ? used : to_end;
+}
+
+// Consumer: release count words read from the span
+void spsc_ring_release(spsc_ring_t* ring, size_t count) {
+  size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed) + count;
+  atomic_store_explicit(&ring->tail, tail, memory_order_release);
+}
@@ -0,0 +1,79 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "stream_barrier.h"
+#include "sys_sts.h"
+#include "sts_sampler.h"
+#include "dac_ctrl.h"
+#include "adc_ctrl.h"
+
+uint32_t stream_prefill_pct = STREAM_PREFILL_DEFAULT_PCT;
+
+// Words a stream can always fit in a command FIFO: the depth less the safety word and
+// all but one word of a largest command (5-word DAC_WR, 2-word repeated ADC_RD)
+#define DAC_PREFILL_WORDS  (DAC_CMD_FIFO_WORDCOUNT - 1 - 4)
+#define ADC_PREFILL_WORDS  (ADC_CMD_FIFO_WORDCOUNT - 1 - 1)
+
+// Watermark in FIFO words (at least the stopper and one command word)
+static uint32_t prefill_target(uint32_t usable_words, uint32_t watermark_pct) {
+  uint32_t target = (uint32_t)((uint64_t)usable_words * watermark_pct / 100);
+  return (target < 2) ? 2 : target;
+}
+
+// Read every waited-for FIFO once; true if all are ready
+static bool prefill_poll(command_context_t* ctx, stream_prefill_t* prefill) {
+  // Read the running flags before the status: a stream that stopped has written everything it will
+  bool dac_running[8], adc_running[8];
+  for (int board = 0; board < 8; board++) {
+    dac_running[board] = ctx->dac_cmd_stream_running[board];
+    adc_running[board] = ctx->adc_cmd_stream_running[board];
+  }
+  struct sys_sts_snapshot_t snap;
+  sts_sampler_refresh(ctx->sys_sts, &snap);
+
+  bool all_ready = true;
+  for (int board = 0; board < 8; board++) {
+    if (!prefill->boards[board]) continue;
+
+    prefill->dac_words[board] = FIFO_STS_WORD_COUNT(sys_sts_snap_dac_cmd_fifo_status(&snap, (uint8_t)board));
+    prefill->adc_words[board] = FIFO_STS_WORD_COUNT(sys_sts_snap_adc_cmd_fifo_status(&snap, (uint8_t)board));
+    prefill->dac_ready[board] = !dac_running[board] || prefill->dac_words[board] >= prefill->dac_target;
+    prefill->adc_ready[board] = !adc_running[board] || prefill->adc_words[board] >= prefill->adc_target;
+    all_ready &= prefill->dac_ready[board] && prefill->adc_ready[board];
+  }
+  return all_ready;
+}
+
+// Wait until every board's command FIFOs reach the watermark or their streams finish writing
+bool stream_prefill_wait(command_context_t* ctx, const bool boards[8], uint32_t watermark_pct,
+                         uint32_t timeout_ms, stream_prefill_t* prefill) {
+  memset(prefill, 0, sizeof(*prefill));
+  memcpy(prefill->boards, boards, sizeof(prefill->boards));
+  prefill->dac_target = prefill_target(DAC_PREFILL_WORDS, watermark_pct);
+  prefill->adc_target = prefill_target(ADC_PREFILL_WORDS, watermark_pct);
+
+  struct timespec start, now;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  bool ready;
+  while (true) {
+    ready = prefill_poll(ctx, prefill);
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    prefill->wait_ms = (now.tv_sec - start.tv_sec) * 1e3 + (now.tv_nsec - start.tv_nsec) / 1e6;
+    if (ready || prefill->wait_ms >= timeout_ms) break;
+    usleep(STREAM_PREFILL_POLL_US);
+  }
+  return ready;
+}
+
+// Print each board's FIFO levels against the watermark
+void stream_prefill_print(const stream_prefill_t* prefill) {
+  for (int board = 0; board < 8; board++) {
+    if (!prefill->boards[board]) continue;
+    printf("  Board %d: DAC command FIFO %u/%u words%s, ADC command FIFO %u/%u words%s\n", board,
+           prefill->dac_words[board], prefill->dac_target,
+           prefill->dac_ready[board] ? "" : " (not ready)",
+           prefill->adc_words[board], prefill->adc_target,
+           prefill->adc_ready[board] ? "" : " (not ready)");
+  }
+}
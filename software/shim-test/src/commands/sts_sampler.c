@@ -0,0 +1,181 @@
+#include <stdio.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "sts_sampler.h"
+#include "rt_profile.h"
+
+// Published snapshot: written under publish_lock, read lock-free (odd seq = being written)
+static struct {
+  atomic_uint seq;
+  _Atomic uint64_t timestamp_ns[SYS_STS_WORDCOUNT]; // When each word was taken (0 = never)
+  _Atomic uint32_t words[SYS_STS_WORDCOUNT];
+} published;
+
+// Serializes publishers (the sampler thread and refreshes), so copies are published in time order
+static pthread_mutex_t publish_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_t sampler_thread;
+static atomic_bool sampler_running = false;
+static atomic_bool sampler_stop = false;
+static _Atomic uint32_t sampler_period = STS_SAMPLER_DEFAULT_PERIOD_US;
+static atomic_ullong sampler_demand = 0; // Words read since the last sample (bit n = word n)
+
+static atomic_ullong stat_samples, stat_skipped, stat_refreshes, stat_cached_reads, stat_direct_reads, stat_retries;
+
+// CLOCK_MONOTONIC time in nanoseconds (for not_before_ns)
+uint64_t sts_sampler_now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Publish the words in mask from a snapshot (publish_lock held)
+static void publish(const struct sys_sts_snapshot_t* snap, uint64_t mask) {
+  unsigned seq = atomic_load_explicit(&published.seq, memory_order_relaxed);
+  atomic_store_explicit(&published.seq, seq + 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  for (uint32_t i = 0; i < SYS_STS_WORDCOUNT; i++) {
+    if (mask & (1ull << i)) {
+      atomic_store_explicit(&published.timestamp_ns[i], snap->timestamp_ns, memory_order_relaxed);
+      atomic_store_explicit(&published.words[i], snap->words[i], memory_order_relaxed);
+    }
+  }
+  atomic_store_explicit(&published.seq, seq + 2, memory_order_release);
+}
+
+// Take a snapshot of the words in mask and publish it
+static void sample(struct sys_sts_t* sys_sts, struct sys_sts_snapshot_t* snap, uint64_t mask) {
+  pthread_mutex_lock(&publish_lock);
+  if (mask == STS_SAMPLER_ALL_WORDS) {
+    sys_sts_snapshot(sys_sts, snap);
+  } else {
+    sys_sts_snapshot_words(sys_sts, snap, mask);
+  }
+  publish(snap, mask);
+  pthread_mutex_unlock(&publish_lock);
+}
+
+// Sampler thread: publish a snapshot every period on an absolute schedule
+static void* sampler_thread_func(void* arg) {
+  struct sys_sts_t* sys_sts = (struct sys_sts_t*)arg;
+  struct timespec next;
+  clock_gettime(CLOCK_MONOTONIC, &next);
+
+  while (!atomic_load(&sampler_stop)) {
+    // Only sample the words read in the last period, so an idle sampler costs no bus traffic
+    uint64_t mask = atomic_exchange_explicit(&sampler_demand, 0, memory_order_relaxed);
+    if (mask != 0) {
+      struct sys_sts_snapshot_t snap;
+      sample(sys_sts, &snap, mask);
+      atomic_fetch_add_explicit(&stat_samples, 1, memory_order_relaxed);
+    } else {
+      atomic_fetch_add_explicit(&stat_skipped, 1, memory_order_relaxed);
+    }
+
+    // Next period, skipping any missed while the thread was held off
+    uint64_t next_ns = (uint64_t)next.tv_sec * 1000000000ULL + (uint64_t)next.tv_nsec +
+                       (uint64_t)atomic_load(&sampler_period) * 1000;
+    uint64_t now_ns = sts_sampler_now_ns();
+    if (next_ns < now_ns) next_ns = now_ns;
+    next.tv_sec = (time_t)(next_ns / 1000000000ULL);
+    next.tv_nsec = (long)(next_ns % 1000000000ULL);
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+  }
+  return NULL;
+}
+
+// Start the sampler thread with a period in microseconds (restarts it if running; -1 on failure)
+int sts_sampler_start(struct sys_sts_t* sys_sts, uint32_t period_us) {
+  if (period_us < STS_SAMPLER_MIN_PERIOD_US || period_us > STS_SAMPLER_MAX_PERIOD_US) {
+    fprintf(stderr, "Status sampler: Period %u us out of range (%d-%d us)\n",
+            period_us, STS_SAMPLER_MIN_PERIOD_US, STS_SAMPLER_MAX_PERIOD_US);
+    return -1;
+  }
+  sts_sampler_stop();
+
+  atomic_store(&stat_samples, 0);
+  atomic_store(&stat_skipped, 0);
+  atomic_store(&stat_refreshes, 0);
+  atomic_store(&stat_cached_reads, 0);
+  atomic_store(&stat_direct_reads, 0);
+  atomic_store(&stat_retries, 0);
+
+  atomic_store(&sampler_period, period_us);
+  atomic_store(&sampler_stop, false);
+  if (rt_thread_create(&sampler_thread, RT_CLASS_MONITOR, sampler_thread_func, sys_sts) != 0) {
+    fprintf(stderr, "Status sampler: Failed to create sampler thread\n");
+    return -1;
+  }
+  atomic_store(&sampler_running, true);
+  return 0;
+}
+
+// Stop the sampler thread (readers fall back to direct reads)
+void sts_sampler_stop(void) {
+  if (!atomic_load(&sampler_running)) {
+    return;
+  }
+  atomic_store(&sampler_running, false);
+  atomic_store(&sampler_stop, true);
+  pthread_join(sampler_thread, NULL);
+}
+
+// True while the sampler thread runs
+bool sts_sampler_running(void) {
+  return atomic_load(&sampler_running);
+}
+
+// Current period in microseconds
+uint32_t sts_sampler_period_us(void) {
+  return atomic_load(&sampler_period);
+}
+
+// Status word at a *_OFFSET in sys_sts.h, from the published copy if it is recent enough, else read directly
+uint32_t sts_sampler_word(struct sys_sts_t* sys_sts, uint32_t offset, uint64_t not_before_ns) {
+  if (atomic_load_explicit(&sampler_running, memory_order_relaxed)) {
+    uint64_t bit = 1ull << offset;
+    if (!(atomic_load_explicit(&sampler_demand, memory_order_relaxed) & bit)) {
+      atomic_fetch_or_explicit(&sampler_demand, bit, memory_order_relaxed);
+    }
+    uint64_t max_age_ns = (uint64_t)atomic_load_explicit(&sampler_period, memory_order_relaxed) *
+                          1000 * STS_SAMPLER_MAX_AGE_PERIODS;
+    uint64_t now_ns = sts_sampler_now_ns();
+    if (now_ns > max_age_ns && not_before_ns < now_ns - max_age_ns) {
+      not_before_ns = now_ns - max_age_ns;
+    }
+
+    // One attempt: never spin on a publish in progress, as the sampler may run at a
+    // lower priority than the reader on the same core
+    unsigned seq = atomic_load_explicit(&published.seq, memory_order_acquire);
+    uint64_t timestamp_ns = atomic_load_explicit(&published.timestamp_ns[offset], memory_order_relaxed);
+    uint32_t word = atomic_load_explicit(&published.words[offset], memory_order_relaxed);
+    atomic_thread_fence(memory_order_acquire);
+    if ((seq & 1) || atomic_load_explicit(&published.seq, memory_order_relaxed) != seq) {
+      atomic_fetch_add_explicit(&stat_retries, 1, memory_order_relaxed);
+    } else if (timestamp_ns != 0 && timestamp_ns >= not_before_ns) {
+      atomic_fetch_add_explicit(&stat_cached_reads, 1, memory_order_relaxed);
+      return word;
+    }
+  }
+
+  atomic_fetch_add_explicit(&stat_direct_reads, 1, memory_order_relaxed);
+  return mmio_read32(sys_sts->hw_status_reg + offset);
+}
+
+// Take a snapshot now and publish it (also copied to snap if not NULL)
+void sts_sampler_refresh(struct sys_sts_t* sys_sts, struct sys_sts_snapshot_t* snap) {
+  struct sys_sts_snapshot_t local;
+  sample(sys_sts, (snap != NULL) ? snap : &local, STS_SAMPLER_ALL_WORDS);
+  atomic_fetch_add_explicit(&stat_refreshes, 1, memory_order_relaxed);
+}
+
+// Copy the statistics
+void sts_sampler_get_stats(sts_sampler_stats_t* stats) {
+  stats->samples = atomic_load(&stat_samples);
+  stats->skipped = atomic_load(&stat_skipped);
+  stats->refreshes = atomic_load(&stat_refreshes);
+  stats->cached_reads = atomic_load(&stat_cached_reads);
+  stats->direct_reads = atomic_load(&stat_direct_reads);
+  stats->retries = atomic_load(&stat_retries);
+}
@@ -9,9 +9,19 @@
 #include <errno.h>
 #include <pthread.h>
 #include <glob.h>
+#include <sched.h>
 #include "system_commands.h"
 #include "command_helper.h"
 #include "experiment_commands.h"
+#include "adc_stream_engine.h"
+#include "dac_stream_engine.h"
+#include "poll_sched.h"
+#include "rt_profile.h"
+#include "stream_barrier.h"
+#include "sts_sampler.h"
+#include "metrics.h"
+#include "trace.h"
+#include "fifo_recorder.h"
 #include "sys_sts.h"
 #include "sys_ctrl.h"
 #include "spi_clk_ctrl.h"
@@ -85,11 +95,7 @@ int cmd_hard_reset(const char** args, int arg_count, const command_flag_t* flags
     // Stop DAC streams
     if (ctx->dac_cmd_stream_running[board]) {
       printf("    Stopping DAC command stream for board %d\n", board);
-      ctx->dac_cmd_stream_stop[board] = true;
-      if (pthread_join(ctx->dac_cmd_stream_threads[board], NULL) != 0) {
-        fprintf(stderr, "Warning: Failed to join DAC command streaming thread for board %d\n", board);
-      }
-      ctx->dac_cmd_stream_running[board] = false;
+      dac_stream_engine_stop_session(ctx, (uint8_t)board);
     }
     
     // Stop DAC debug streams
@@ -105,11 +111,7 @@ int cmd_hard_reset(const char** args, int arg_count, const command_flag_t* flags
     // Stop ADC streams
     if (ctx->adc_data_stream_running[board]) {
       printf("    Stopping ADC data stream for board %d\n", board);
-      ctx->adc_data_stream_stop[board] = true;
-      if (pthread_join(ctx->adc_data_stream_threads[board], NULL) != 0) {
-        fprintf(stderr, "Warning: Failed to join ADC data streaming thread for board %d\n", board);
-      }
-      ctx->adc_data_stream_running[board] = false;
+      adc_stream_engine_stop_session(ctx, (uint8_t)board);
     }
     if (ctx->adc_cmd_stream_running[board]) {
       printf("    Stopping ADC command stream for board %d\n", board);
@@ -270,6 +272,305 @@ int cmd_get_min_delay_times(const char** args, int arg_count, const command_flag
   return 0;
 }
 
+// Show or change the adaptive poll policy of a FIFO stream type
+int cmd_poll_policy(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  if (arg_count > 0) {
+    int stream = poll_stream_from_name(args[0]);
+    if (stream < 0) {
+      fprintf(stderr, "Unknown stream for poll_policy: '%s'. Run poll_policy with no arguments to list streams.\n", args[0]);
+      return -1;
+    }
+    if (arg_count < 3) {
+      fprintf(stderr, "Usage: poll_policy <stream> <max_sleep_us> <spin_us> [threshold_pct] [headroom_pct]\n");
+      return -1;
+    }
+    
+    uint32_t values[4] = {
+      poll_policies[stream].max_sleep_us, poll_policies[stream].spin_us,
+      poll_policies[stream].threshold_pct, poll_policies[stream].headroom_pct
+    };
+    for (int i = 1; i < arg_count; i++) {
+      char* endptr;
+      values[i - 1] = parse_value(args[i], &endptr);
+      if (*endptr != '\0') {
+        fprintf(stderr, "Invalid value for poll_policy: '%s'. Must be a number.\n", args[i]);
+        return -1;
+      }
+    }
+    if (values[0] == 0 || values[2] > 100 || values[3] == 0 || values[3] > 100) {
+      fprintf(stderr, "Invalid poll policy: max_sleep_us must be > 0, threshold_pct 0-100, headroom_pct 1-100.\n");
+      return -1;
+    }
+    poll_policies[stream].max_sleep_us = values[0];
+    poll_policies[stream].spin_us = values[1];
+    poll_policies[stream].threshold_pct = values[2];
+    poll_policies[stream].headroom_pct = values[3];
+    printf("Poll policy for '%s' updated (applies to streams started from now on).\n", poll_policies[stream].name);
+  }
+  
+  printf("Poll policies (max sleep, spin window, batch target %% of FIFO, headroom %% of time to FIFO limit):\n");
+  for (int i = 0; i < POLL_STREAM_COUNT; i++) {
+    printf("  %-13s max %7u us, spin %5u us, target %3u%%, headroom %3u%%\n", poll_policies[i].name,
+           poll_policies[i].max_sleep_us, poll_policies[i].spin_us,
+           poll_policies[i].threshold_pct, poll_policies[i].headroom_pct);
+  }
+  printf("Maximum rates from the SPI clock: ADC data %.0f words/s per board, ADC cmd %.0f words/s, DAC cmd %.0f words/s\n",
+         poll_max_rate_adc_data(ctx->sys_sts), poll_max_rate_adc_cmd(ctx->sys_sts), poll_max_rate_dac_cmd(ctx->sys_sts));
+  
+  printf("Totals for finished streams:\n");
+  for (int i = 0; i < POLL_STREAM_COUNT; i++) {
+    poll_stats_t totals;
+    poll_stats_get_totals((poll_stream_t)i, &totals);
+    if (totals.polls == 0 && totals.sleeps == 0 && totals.spins == 0) continue;
+    char prefix[32];
+    snprintf(prefix, sizeof(prefix), "  %-13s ", poll_policies[i].name);
+    poll_stats_print(prefix, &totals);
+  }
+  return 0;
+}
+
+// Show or change the real-time profile of stream threads, with wake latency histograms
+int cmd_rt_profile(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  if (arg_count == 1 && strcmp(args[0], "on") == 0) {
+    if (rt_profile_enable() != 0) {
+      fprintf(stderr, "Real-time profile not enabled; streams keep default scheduling.\n");
+      return -1;
+    }
+    printf("Real-time profile enabled (applies to streams started from now on).\n");
+  } else if (arg_count == 1 && strcmp(args[0], "off") == 0) {
+    rt_profile_disable();
+    printf("Real-time profile disabled (applies to streams started from now on).\n");
+  } else if (arg_count == 1 && strcmp(args[0], "reset") == 0) {
+    poll_stats_reset_totals();
+    printf("Poll statistics of finished streams cleared.\n");
+  } else if (arg_count > 0) {
+    int cls = rt_class_from_name(args[0]);
+    if (cls < 0 || arg_count != 3) {
+      fprintf(stderr, "Usage: rt_profile [on|off|reset] or rt_profile <class> <priority> <cpu> (run rt_profile to list classes)\n");
+      return -1;
+    }
+    char* endptr;
+    int priority = (int)parse_value(args[1], &endptr);
+    if (*endptr != '\0' || priority < 0 || priority > sched_get_priority_max(SCHED_FIFO)) {
+      fprintf(stderr, "Invalid priority for rt_profile: '%s'. Must be 0 (normal scheduling) to %d.\n",
+              args[1], sched_get_priority_max(SCHED_FIFO));
+      return -1;
+    }
+    int cpu = (strcmp(args[2], "any") == 0) ? -1 : (int)parse_value(args[2], &endptr);
+    if (cpu >= 0 && (*endptr != '\0' || cpu >= sysconf(_SC_NPROCESSORS_ONLN))) {
+      fprintf(stderr, "Invalid CPU for rt_profile: '%s'. Must be 'any' or 0-%ld.\n",
+              args[2], sysconf(_SC_NPROCESSORS_ONLN) - 1);
+      return -1;
+    }
+    rt_policies[cls].priority = priority;
+    rt_policies[cls].cpu = cpu;
+    printf("Real-time class '%s' updated (applies to streams started from now on).\n", rt_policies[cls].name);
+  }
+
+  printf("Real-time profile: %s\n", rt_profile_enabled() ? "enabled (memory locked)" : "disabled (default scheduling)");
+  for (int i = 0; i < RT_CLASS_COUNT; i++) {
+    char cpu[16];
+    if (rt_policies[i].cpu < 0) {
+      snprintf(cpu, sizeof(cpu), "any");
+    } else {
+      snprintf(cpu, sizeof(cpu), "%d", rt_policies[i].cpu);
+    }
+    if (rt_policies[i].priority > 0) {
+      printf("  %-8s SCHED_FIFO priority %2d, CPU %s\n", rt_policies[i].name, rt_policies[i].priority, cpu);
+    } else {
+      printf("  %-8s SCHED_OTHER,            CPU %s\n", rt_policies[i].name, cpu);
+    }
+  }
+
+  printf("Wake latency past the sleep deadline, finished streams (rt_profile reset clears):\n");
+  for (int i = 0; i < POLL_STREAM_COUNT; i++) {
+    poll_stats_t totals;
+    poll_stats_get_totals((poll_stream_t)i, &totals);
+    if (totals.sleeps == 0) continue;
+    char prefix[32];
+    snprintf(prefix, sizeof(prefix), "  %-13s", poll_policies[i].name);
+    poll_stats_print_wake_hist(prefix, &totals);
+  }
+  // The engine threads only add their sleeps to the totals at exit
+  if (ctx->dac_stream_engine != NULL && ctx->dac_stream_engine->poll.stats.sleeps > 0) {
+    poll_stats_print_wake_hist("  DAC feeder   ", &ctx->dac_stream_engine->poll.stats);
+  }
+  if (ctx->adc_stream_engine != NULL && ctx->adc_stream_engine->poll.stats.sleeps > 0) {
+    poll_stats_print_wake_hist("  ADC drain    ", &ctx->adc_stream_engine->poll.stats);
+  }
+  return 0;
+}
+
+// Show or set the command FIFO prefill watermark waited for before a waveform test releases triggers
+int cmd_prefill_watermark(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  if (arg_count > 0) {
+    char* endptr;
+    uint32_t pct = parse_value(args[0], &endptr);
+    if (*endptr != '\0' || pct > 100) {
+      fprintf(stderr, "Invalid prefill watermark: '%s'. Must be 0-100 (percent of each command FIFO).\n", args[0]);
+      return -1;
+    }
+    stream_prefill_pct = pct;
+  }
+  printf("Prefill watermark: %u%% of each DAC and ADC command FIFO (or the whole stream, if shorter) before triggers are released\n",
+         stream_prefill_pct);
+  return 0;
+}
+
+// Start, stop or show the shared status sampler
+int cmd_sts_sampler(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  if (arg_count > 0) {
+    if (strcmp(args[0], "off") == 0) {
+      sts_sampler_stop();
+    } else {
+      uint32_t period_us = STS_SAMPLER_DEFAULT_PERIOD_US;
+      if (strcmp(args[0], "on") != 0) {
+        char* endptr;
+        period_us = parse_value(args[0], &endptr);
+        if (*endptr != '\0') {
+          fprintf(stderr, "Invalid status sampler period: '%s'. Must be on, off or a period in microseconds.\n", args[0]);
+          return -1;
+        }
+      }
+      if (sts_sampler_start(ctx->sys_sts, period_us) != 0) {
+        return -1;
+      }
+    }
+  }
+
+  if (!sts_sampler_running()) {
+    printf("Status sampler: off (stream threads read status words directly)\n");
+    return 0;
+  }
+  sts_sampler_stats_t stats;
+  sts_sampler_get_stats(&stats);
+  uint64_t reads = stats.cached_reads + stats.direct_reads;
+  printf("Status sampler: every %u us\n", sts_sampler_period_us());
+  printf("  Snapshots: %llu sampled, %llu refreshed, %llu idle periods skipped\n",
+         stats.samples, stats.refreshes, stats.skipped);
+  printf("  Status reads: %llu from the shared copy (%.1f%%), %llu direct (%llu during a publish)\n",
+         stats.cached_reads, reads > 0 ? 100.0 * stats.cached_reads / reads : 0.0,
+         stats.direct_reads, stats.retries);
+  return 0;
+}
+
+// Print the run metrics, clear them, or export them to a file every period
+int cmd_metrics(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  if (arg_count == 0) {
+    metrics_write_text(stdout);
+    char export_file[1024];
+    if (metrics_export_running(export_file, sizeof(export_file))) {
+      printf("# Exporting to %s\n", export_file);
+    }
+    return 0;
+  }
+
+  if (strcmp(args[0], "reset") == 0 && arg_count == 1) {
+    // The stream threads update their series without locked read-modify-writes, so a reset
+    // while one runs could be overwritten by its next update
+    for (int board = 0; board < 8; board++) {
+      if (ctx->adc_data_stream_running[board] || ctx->adc_cmd_stream_running[board] ||
+          ctx->dac_cmd_stream_running[board] || ctx->dac_debug_stream_running[board]) {
+        fprintf(stderr, "Cannot reset metrics while board %d is streaming. Stop its streams first.\n", board);
+        return -1;
+      }
+    }
+    if (ctx->trig_data_stream_running) {
+      fprintf(stderr, "Cannot reset metrics while the trigger data stream is running. Stop it first.\n");
+      return -1;
+    }
+    metrics_reset();
+    printf("Metrics cleared.\n");
+    return 0;
+  }
+  if (strcmp(args[0], "export") != 0 || arg_count < 2) {
+    fprintf(stderr, "Usage: metrics [reset | export <file> [period_ms] | export off]\n");
+    return -1;
+  }
+
+  if (strcmp(args[1], "off") == 0) {
+    metrics_export_stop();
+    printf("Metrics export stopped.\n");
+    return 0;
+  }
+  uint32_t period_ms = METRICS_EXPORT_DEFAULT_MS;
+  if (arg_count > 2) {
+    char* endptr;
+    period_ms = parse_value(args[2], &endptr);
+    if (*endptr != '\0') {
+      fprintf(stderr, "Invalid metrics export period: '%s'. Must be a number of milliseconds.\n", args[2]);
+      return -1;
+    }
+  }
+  char file_path[1024];
+  clean_and_expand_path(args[1], file_path, sizeof(file_path));
+  if (metrics_export_start(file_path, period_ms) != 0) {
+    return -1;
+  }
+  printf("Exporting metrics to %s every %u ms.\n", file_path, period_ms);
+  return 0;
+}
+
+// Start, stop, clear or dump the hot-path trace of the stream threads
+int cmd_trace(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  if (arg_count == 0) {
+    trace_print_status();
+    return 0;
+  }
+
+  if (strcmp(args[0], "on") == 0 && arg_count == 1) {
+    if (trace_start() != 0) {
+      return -1;
+    }
+  } else if (strcmp(args[0], "off") == 0 && arg_count == 1) {
+    trace_stop();
+  } else if (strcmp(args[0], "clear") == 0 && arg_count == 1) {
+    trace_clear();
+  } else if (strcmp(args[0], "dump") == 0 && arg_count == 2) {
+    char file_path[1024];
+    clean_and_expand_path(args[1], file_path, sizeof(file_path));
+    return trace_dump(file_path);
+  } else {
+    fprintf(stderr, "Usage: trace [on | off | clear | dump <file>]\n");
+    return -1;
+  }
+  trace_print_status();
+  return 0;
+}
+
+// Start or stop the FIFO occupancy recorder, or show its state
+int cmd_fifo_record(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
+  if (arg_count == 0) {
+    fifo_recorder_print_status();
+    return 0;
+  }
+  if (strcmp(args[0], "stop") == 0 && arg_count == 1) {
+    if (!fifo_recorder_running()) {
+      printf("FIFO recorder: not recording\n");
+      return 0;
+    }
+    return fifo_recorder_stop();
+  }
+
+  uint32_t values[2] = {FIFO_RECORD_DEFAULT_RATE_HZ, FIFO_RECORD_DEFAULT_SECONDS};
+  const char* names[2] = {"rate", "duration"};
+  for (int i = 1; i < arg_count; i++) {
+    char* endptr;
+    values[i - 1] = parse_value(args[i], &endptr);
+    if (*endptr != '\0') {
+      fprintf(stderr, "Invalid fifo_record %s: '%s'. Must be a number.\n", names[i - 1], args[i]);
+      return -1;
+    }
+  }
+  char file_path[1024];
+  clean_and_expand_path(args[0], file_path, sizeof(file_path));
+  if (fifo_recorder_start(ctx->sys_sts, file_path, values[0], values[1]) != 0) {
+    return -1;
+  }
+  fifo_recorder_print_status();
+  return 0;
+}
+
 // Integrator configuration commands
 int cmd_set_integ_window(const char** args, int arg_count, const command_flag_t* flags, int flag_count, command_context_t* ctx) {
   char* endptr;
@@ -316,8 +617,10 @@ void safe_buffer_reset(command_context_t* ctx, bool verbose) {
     printf("Performing safe buffer reset...\n");
   }
   
-  // Check system status
-  uint32_t hw_status = sys_sts_get_hw_status(ctx->sys_sts, verbose);
+  // Check system status and every buffer from one status snapshot
+  struct sys_sts_snapshot_t snap;
+  sys_sts_snapshot(ctx->sys_sts, &snap);
+  uint32_t hw_status = sys_sts_snap_hw_status(&snap);
   uint32_t system_state = HW_STS_STATE(hw_status);
   bool system_is_off = (system_state != S_RUNNING);
   
@@ -335,7 +638,7 @@ void safe_buffer_reset(command_context_t* ctx, bool verbose) {
     uint32_t dac_bit = board * 2;  // 0, 2, 4, 6, 8, 10, 12, 14
     
     // Check DAC command buffer
-    uint32_t dac_cmd_fifo_status = sys_sts_get_dac_cmd_fifo_status(ctx->sys_sts, board, false);
+    uint32_t dac_cmd_fifo_status = sys_sts_snap_dac_cmd_fifo_status(&snap, board);
     if (FIFO_PRESENT(dac_cmd_fifo_status)) {
       if (system_is_off || FIFO_STS_WORD_COUNT(dac_cmd_fifo_status) > 0) {
         cmd_reset_mask |= (1U << dac_bit);
@@ -349,7 +652,7 @@ void safe_buffer_reset(command_context_t* ctx, bool verbose) {
     }
     
     // Check DAC data buffer
-    uint32_t dac_data_fifo_status = sys_sts_get_dac_data_fifo_status(ctx->sys_sts, board, false);
+    uint32_t dac_data_fifo_status = sys_sts_snap_dac_data_fifo_status(&snap, board);
     if (FIFO_PRESENT(dac_data_fifo_status)) {
       if (system_is_off || FIFO_STS_WORD_COUNT(dac_data_fifo_status) > 0) {
         data_reset_mask |= (1U << dac_bit);
@@ -370,7 +673,7 @@ void safe_buffer_reset(command_context_t* ctx, bool verbose) {
     uint32_t adc_bit = board * 2 + 1;  // 1, 3, 5, 7, 9, 11, 13, 15
     
     // Check ADC command buffer
-    uint32_t adc_cmd_fifo_status = sys_sts_get_adc_cmd_fifo_status(ctx->sys_sts, board, false);
+    uint32_t adc_cmd_fifo_status = sys_sts_snap_adc_cmd_fifo_status(&snap, board);
     if (FIFO_PRESENT(adc_cmd_fifo_status)) {
       if (system_is_off || FIFO_STS_WORD_COUNT(adc_cmd_fifo_status) > 0) {
         cmd_reset_mask |= (1U << adc_bit);
@@ -384,7 +687,7 @@ void safe_buffer_reset(command_context_t* ctx, bool verbose) {
     }
     
     // Check ADC data buffer
-    uint32_t adc_data_fifo_status = sys_sts_get_adc_data_fifo_status(ctx->sys_sts, board, false);
+    uint32_t adc_data_fifo_status = sys_sts_snap_adc_data_fifo_status(&snap, board);
     if (FIFO_PRESENT(adc_data_fifo_status)) {
       if (system_is_off || FIFO_STS_WORD_COUNT(adc_data_fifo_status) > 0) {
         data_reset_mask |= (1U << adc_bit);
@@ -399,7 +702,7 @@ void safe_buffer_reset(command_context_t* ctx, bool verbose) {
   }
   
   // Check trigger command and data buffers - bit 16
-  uint32_t trig_cmd_fifo_status = sys_sts_get_trig_cmd_fifo_status(ctx->sys_sts, false);
+  uint32_t trig_cmd_fifo_status = sys_sts_snap_trig_cmd_fifo_status(&snap);
   if (FIFO_PRESENT(trig_cmd_fifo_status)) {
     if (system_is_off || FIFO_STS_WORD_COUNT(trig_cmd_fifo_status) > 0) {
       cmd_reset_mask |= (1U << 16);
@@ -412,7 +715,7 @@ void safe_buffer_reset(command_context_t* ctx, bool verbose) {
     }
   }
   
-  uint32_t trig_data_fifo_status = sys_sts_get_trig_data_fifo_status(ctx->sys_sts, false);
+  uint32_t trig_data_fifo_status = sys_sts_snap_trig_data_fifo_status(&snap);
   if (FIFO_PRESENT(trig_data_fifo_status)) {
     if (system_is_off || FIFO_STS_WORD_COUNT(trig_data_fifo_status) > 0) {
       data_reset_mask |= (1U << 16);
@@ -0,0 +1,253 @@
+#define _GNU_SOURCE // syscall(SYS_gettid)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include "trace.h"
+#include "poll_sched.h"
+#include "rt_profile.h"
+
+// One thread's ring (written only by the thread that claimed it)
+typedef struct {
+  trace_record_t* events;            // TRACE_RING_EVENTS records
+  _Atomic uint64_t head;             // Events recorded (the next goes at head % TRACE_RING_EVENTS)
+  char name[TRACE_NAME_LENGTH];
+  int tid;
+} trace_ring_t;
+
+atomic_bool trace_enabled = false;
+
+static trace_ring_t* rings = NULL;   // TRACE_MAX_THREADS rings, allocated by the first trace_start
+static atomic_uint rings_claimed = 0;
+static atomic_uint generation = 1;   // Bumped by trace_clear so threads claim a ring again
+static atomic_ullong threads_dropped = 0;
+
+// Calling thread's ring and name
+static __thread trace_ring_t* thread_ring = NULL;
+static __thread unsigned thread_generation = 0;
+static __thread char thread_name[TRACE_NAME_LENGTH];
+
+static const char* event_names[TRACE_EVENT_COUNT] = {
+  [TRACE_FIFO_POLL]  = "poll",
+  [TRACE_FIFO_READ]  = "read",
+  [TRACE_FIFO_WRITE] = "write",
+  [TRACE_FILE_WRITE] = "file_write",
+  [TRACE_SLEEP]      = "sleep",
+};
+static const char* event_categories[TRACE_EVENT_COUNT] = {
+  [TRACE_FIFO_POLL]  = "fifo",
+  [TRACE_FIFO_READ]  = "fifo",
+  [TRACE_FIFO_WRITE] = "fifo",
+  [TRACE_FILE_WRITE] = "file",
+  [TRACE_SLEEP]      = "sleep",
+};
+
+// Calling thread's ring, claimed on first use after a start or clear (NULL if none is free)
+static trace_ring_t* claim_ring(void) {
+  unsigned current = atomic_load_explicit(&generation, memory_order_acquire);
+  if (thread_generation == current) {
+    return thread_ring;
+  }
+  thread_generation = current;
+  thread_ring = NULL;
+
+  unsigned index = atomic_fetch_add(&rings_claimed, 1);
+  if (rings == NULL || index >= TRACE_MAX_THREADS) {
+    atomic_fetch_add(&threads_dropped, 1);
+    return NULL;
+  }
+  trace_ring_t* ring = &rings[index];
+  ring->tid = (int)syscall(SYS_gettid);
+  if (thread_name[0] != '\0') {
+    memcpy(ring->name, thread_name, sizeof(ring->name));
+  } else {
+    snprintf(ring->name, sizeof(ring->name), "thread %d", ring->tid);
+  }
+  atomic_store_explicit(&ring->head, 0, memory_order_release);
+  thread_ring = ring;
+  return ring;
+}
+
+// Record a region started with trace_begin into the calling thread's ring
+void trace_record(uint64_t start_ns, trace_event_t event, int stream, int board, uint32_t value) {
+  uint64_t end_ns = trace_now_ns();
+  trace_ring_t* ring = claim_ring();
+  if (ring == NULL) {
+    return;
+  }
+  uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  // Pairs with the fence in copy_ring: a dump that sees this record's stores also sees the head before it
+  atomic_thread_fence(memory_order_release);
+  trace_record_t* record = &ring->events[head & (TRACE_RING_EVENTS - 1)];
+  uint64_t duration_ns = end_ns - start_ns;
+  record->start_ns = start_ns;
+  record->duration_ns = (duration_ns > UINT32_MAX) ? UINT32_MAX : (uint32_t)duration_ns;
+  record->event = (uint16_t)event;
+  record->stream = (int8_t)stream;
+  record->board = (int8_t)board;
+  record->value = value;
+  atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+// Name the calling thread's track (printf format; applies when the thread claims its ring)
+void trace_thread_name(const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  vsnprintf(thread_name, sizeof(thread_name), format, args);
+  va_end(args);
+  if (thread_ring != NULL && thread_generation == atomic_load(&generation)) {
+    memcpy(thread_ring->name, thread_name, sizeof(thread_ring->name));
+  }
+}
+
+// Allocate the rings and start recording (-1 on failure)
+int trace_start(void) {
+  if (rings == NULL) {
+    trace_ring_t* allocated = calloc(TRACE_MAX_THREADS, sizeof(trace_ring_t));
+    if (allocated == NULL) {
+      fprintf(stderr, "Trace: Failed to allocate rings\n");
+      return -1;
+    }
+    for (int i = 0; i < TRACE_MAX_THREADS; i++) {
+      allocated[i].events = malloc(TRACE_RING_EVENTS * sizeof(trace_record_t));
+      if (allocated[i].events == NULL) {
+        fprintf(stderr, "Trace: Failed to allocate rings\n");
+        for (int j = 0; j < i; j++) {
+          free(allocated[j].events);
+        }
+        free(allocated);
+        return -1;
+      }
+      rt_prefault(allocated[i].events, TRACE_RING_EVENTS * sizeof(trace_record_t));
+    }
+    rings = allocated;
+    atomic_fetch_add_explicit(&generation, 1, memory_order_release);
+  }
+  atomic_store(&trace_enabled, true);
+  return 0;
+}
+
+// Stop recording (the rings keep their events until cleared or restarted)
+void trace_stop(void) {
+  atomic_store(&trace_enabled, false);
+}
+
+// Drop every event and release the threads' rings
+void trace_clear(void) {
+  // A thread still in trace_record may add one event to the ring it had; that is harmless
+  atomic_store(&rings_claimed, 0);
+  atomic_store(&threads_dropped, 0);
+  atomic_fetch_add_explicit(&generation, 1, memory_order_release);
+}
+
+// Copy a ring's surviving events (oldest first); returns the count
+static size_t copy_ring(trace_ring_t* ring, trace_record_t* copy, uint64_t* recorded) {
+  uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+  uint64_t first = (head > TRACE_RING_EVENTS) ? head - TRACE_RING_EVENTS : 0;
+  for (uint64_t i = first; i < head; i++) {
+    copy[i - first] = ring->events[i & (TRACE_RING_EVENTS - 1)];
+  }
+
+  // Drop events the owner overwrote while they were copied (and the slot it may be writing);
+  // the fence keeps the copies above from being reordered after the second head load
+  atomic_thread_fence(memory_order_acquire);
+  uint64_t head_after = atomic_load_explicit(&ring->head, memory_order_acquire);
+  uint64_t valid = (head_after + 1 > TRACE_RING_EVENTS) ? head_after + 1 - TRACE_RING_EVENTS : 0;
+  size_t skip = (valid > first) ? (size_t)(valid - first) : 0;
+  size_t count = (size_t)(head - first);
+  if (skip >= count) {
+    *recorded = head_after;
+    return 0;
+  }
+  memmove(copy, copy + skip, (count - skip) * sizeof(trace_record_t));
+  *recorded = head_after;
+  return count - skip;
+}
+
+// Write the recorded events as Chrome trace JSON (-1 on failure)
+int trace_dump(const char* file_path) {
+  if (rings == NULL) {
+    fprintf(stderr, "Trace: Nothing recorded (start tracing with \"trace on\")\n");
+    return -1;
+  }
+  FILE* out = fopen(file_path, "w");
+  if (out == NULL) {
+    fprintf(stderr, "Trace: Failed to open %s: %s\n", file_path, strerror(errno));
+    return -1;
+  }
+  trace_record_t* copy = malloc(TRACE_RING_EVENTS * sizeof(trace_record_t));
+  if (copy == NULL) {
+    fprintf(stderr, "Trace: Failed to allocate dump buffer\n");
+    fclose(out);
+    return -1;
+  }
+
+  unsigned claimed = atomic_load(&rings_claimed);
+  if (claimed > TRACE_MAX_THREADS) claimed = TRACE_MAX_THREADS;
+  pid_t pid = getpid();
+  size_t total = 0;
+  bool first_entry = true;
+
+  fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+  for (unsigned r = 0; r < claimed; r++) {
+    trace_ring_t* ring = &rings[r];
+    uint64_t recorded;
+    size_t count = copy_ring(ring, copy, &recorded);
+
+    fprintf(out, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+            first_entry ? "" : ",", (int)pid, ring->tid, ring->name);
+    first_entry = false;
+    for (size_t i = 0; i < count; i++) {
+      const trace_record_t* record = &copy[i];
+      if (record->event >= TRACE_EVENT_COUNT) {
+        continue;
+      }
+      // Name events after their stream ("adc_data read") so tracks read at a glance
+      const char* stream = (record->stream >= 0 && record->stream < POLL_STREAM_COUNT)
+                           ? poll_policies[record->stream].name : "";
+      fprintf(out, ",\n{\"name\":\"%s%s%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,"
+                   "\"ts\":%llu.%03llu,\"dur\":%u.%03u,\"args\":{\"board\":%d,\"value\":%u}}",
+              stream, stream[0] != '\0' ? " " : "", event_names[record->event],
+              event_categories[record->event], (int)pid, ring->tid,
+              record->start_ns / 1000, record->start_ns % 1000,
+              record->duration_ns / 1000, record->duration_ns % 1000,
+              record->board, record->value);
+    }
+    total += count;
+  }
+  fprintf(out, "\n]}\n");
+  free(copy);
+
+  if (fclose(out) != 0) {
+    fprintf(stderr, "Trace: Failed to write %s: %s\n", file_path, strerror(errno));
+    return -1;
+  }
+  printf("Trace: Wrote %zu events from %u threads to %s\n", total, claimed, file_path);
+  return 0;
+}
+
+// Print recording state and per-thread event counts
+void trace_print_status(void) {
+  printf("Trace: %s", atomic_load(&trace_enabled) ? "on" : "off");
+#ifdef SHIM_TRACE_DISABLE
+  printf(" (trace points compiled out)");
+#endif
+  printf(", %d rings of %d events\n", TRACE_MAX_THREADS, TRACE_RING_EVENTS);
+  if (rings == NULL) {
+    return;
+  }
+  unsigned claimed = atomic_load(&rings_claimed);
+  if (claimed > TRACE_MAX_THREADS) claimed = TRACE_MAX_THREADS;
+  for (unsigned r = 0; r < claimed; r++) {
+    uint64_t head = atomic_load_explicit(&rings[r].head, memory_order_acquire);
+    printf("  %-24s tid %-7d %llu events (%llu kept)\n", rings[r].name, rings[r].tid,
+           head, head < TRACE_RING_EVENTS ? head : (uint64_t)TRACE_RING_EVENTS);
+  }
+  if (atomic_load(&threads_dropped) > 0) {
+    printf("  %llu threads not traced (all rings claimed; \"trace clear\" releases them)\n",
+           atomic_load(&threads_dropped));
+  }
+}
@@ -14,6 +14,12 @@
 #include "command_helper.h"
 #include "sys_sts.h"
 #include "trigger_ctrl.h"
+#include "capture_file.h"
+#include "poll_sched.h"
+#include "rt_profile.h"
+#include "sts_sampler.h"
+#include "metrics.h"
+#include "trace.h"
 
 // Global trigger monitor control
 static volatile bool g_trigger_monitor_should_stop = false;
@@ -166,66 +172,143 @@ static void* trigger_data_stream_thread(void* arg) {
   uint64_t sample_count = stream_data->sample_count;
   volatile bool* should_stop = stream_data->should_stop;
   bool binary_mode = stream_data->binary_mode;
+  bool chunked = stream_data->chunked;
   bool verbose = *(ctx->verbose);
+  TRACE_THREAD("trig_data");
+  capture_writer_t capture;
+  uint32_t* chunk_buffer = NULL;
+  size_t chunk_fill = 0;
 
   if (verbose) {
     printf("Trigger Stream Thread: Starting to write %llu samples to file '%s' (%s format)\n", 
-           sample_count, file_path, binary_mode ? "binary" : "ASCII");
+           sample_count, file_path, chunked ? "chunked binary" : binary_mode ? "binary" : "ASCII");
   }
 
   // Open file for writing (binary or text mode based on format)
-  FILE* file = fopen(file_path, binary_mode ? "wb" : "w");
+  FILE* file = capture_file_open(file_path, binary_mode ? "wb" : "w");
   if (file == NULL) {
     fprintf(stderr, "Trigger Stream Thread: Failed to open file '%s' for writing: %s\n", 
            file_path, strerror(errno));
     goto cleanup;
   }
 
+  if (chunked) {
+    capture_file_header_t header;
+    capture_header_init(&header, CAPTURE_STREAM_TRIG, CAPTURE_BOARD_NONE, CAPTURE_TRIG_CHUNK_WORDS);
+    header.spi_clk_freq_hz = sys_sts_get_spi_clk_freq_hz(ctx->sys_sts, false);
+    chunk_buffer = malloc(CAPTURE_TRIG_CHUNK_WORDS * sizeof(uint32_t));
+    if (chunk_buffer == NULL || capture_writer_open(&capture, file, &header) != 0) {
+      fprintf(stderr, "Trigger Stream Thread: Failed to start chunked capture\n");
+      free(chunk_buffer);
+      fclose(file);
+      goto cleanup;
+    }
+  }
+
   uint64_t samples_written = 0;
+  uint64_t samples[TRIG_STREAM_BATCH_SAMPLES];
+  size_t sample_bytes = (binary_mode || chunked) ? sizeof(uint64_t) : 19; // ASCII: "0x", 16 digits, newline
+  size_t unflushed_bytes = 0;
+  uint64_t oldest_unflushed_ns = 0;
+  poll_sched_t poll;
+  poll_sched_init(&poll, POLL_STREAM_TRIG_DATA, TRIG_DATA_FIFO_WORDCOUNT, 0.0);
+  poll_sched_track(&poll, 0);
+  uint64_t sts_not_before_ns = 0; // Last burst (a sampled FIFO level must be newer)
 
   while (samples_written < sample_count && !(*should_stop)) {
     // Check trigger data FIFO status
-    uint32_t data_status = sys_sts_get_trig_data_fifo_status(ctx->sys_sts, false);
+    TRACE_BEGIN(trace_poll_ns);
+    uint32_t data_status = sts_sampler_word(ctx->sys_sts, TRIG_DATA_FIFO_STS_OFFSET, sts_not_before_ns);
+    TRACE_END(trace_poll_ns, TRACE_FIFO_POLL, POLL_STREAM_TRIG_DATA, 0, FIFO_STS_WORD_COUNT(data_status));
 
     if (FIFO_PRESENT(data_status) == 0) {
       fprintf(stderr, "Trigger Stream Thread: Data FIFO not present, stopping stream\n");
       break;
     }
 
-    // Check if there are at least 2 words available for a sample
+    // Drain every complete sample (2 words each) in one burst
     uint32_t fifo_count = FIFO_STS_WORD_COUNT(data_status);
-    if (fifo_count >= 2) {
-      // Read 64-bit trigger data (2 words)
-      uint64_t trigger_data = trigger_read(ctx->trigger_ctrl);
-
-      // Write data based on format mode
-      if (binary_mode) {
-        // Binary mode: write raw 64-bit value directly
-        size_t written = fwrite(&trigger_data, sizeof(uint64_t), 1, file);
-        if (written != 1) {
-          fprintf(stderr, "Trigger Stream Thread: Failed to write to file: %s\n", strerror(errno));
-          break;
+    poll_sched_observe(&poll, fifo_count, 2);
+    uint64_t batch = fifo_count / 2;
+    if (batch > sample_count - samples_written) {
+      batch = sample_count - samples_written;
+    }
+    if (batch == 0) {
+      // Not enough data available; flush output that has waited long enough, then sleep until the next sample is predicted
+      if (unflushed_bytes > 0 && sts_sampler_now_ns() - oldest_unflushed_ns >= TRIG_STREAM_FLUSH_MS * 1000000ULL) {
+        fflush(file);
+        unflushed_bytes = 0;
+      }
+      poll_sched_wait(&poll, fifo_count, 2);
+      continue;
+    }
+    TRACE_BEGIN(trace_read_ns);
+    trigger_read_burst(ctx->trigger_ctrl, samples, (uint32_t)batch);
+    TRACE_END(trace_read_ns, TRACE_FIFO_READ, POLL_STREAM_TRIG_DATA, 0, 2 * (uint32_t)batch);
+    sts_not_before_ns = sts_sampler_now_ns();
+    poll_sched_consumed(&poll, 2 * (uint32_t)batch);
+    uint64_t write_start_ns = sts_not_before_ns;
+    TRACE_BEGIN(trace_write_ns);
+
+    // Write data based on format mode
+    bool write_failed = false;
+    if (chunked) {
+      // Chunked mode: collect samples and write a chunk whenever one fills
+      for (uint64_t i = 0; i < batch && !write_failed; i++) {
+        chunk_buffer[chunk_fill++] = (uint32_t)(samples[i] & 0xFFFFFFFF);
+        chunk_buffer[chunk_fill++] = (uint32_t)(samples[i] >> 32);
+        if (chunk_fill == CAPTURE_TRIG_CHUNK_WORDS) {
+          write_failed = capture_writer_write_chunk(&capture, chunk_buffer, chunk_fill, NULL, 0) != 0;
+          chunk_fill = 0;
         }
-      } else {
-        // ASCII mode: write one trigger sample per line
-        fprintf(file, "0x%016" PRIx64 "\n", trigger_data);
       }
+    } else if (binary_mode) {
+      // Binary mode: write raw 64-bit values directly
+      write_failed = fwrite(samples, sizeof(uint64_t), batch, file) != batch;
+    } else {
+      // ASCII mode: write one trigger sample per line
+      for (uint64_t i = 0; i < batch; i++) {
+        fprintf(file, "0x%016" PRIx64 "\n", samples[i]);
+      }
+    }
+    if (write_failed) {
+      fprintf(stderr, "Trigger Stream Thread: Failed to write to file: %s\n", strerror(errno));
+      break;
+    }
 
-      // Flush the file to ensure data is written
+    // Flush once enough output is pending or the oldest unflushed sample has waited long enough
+    uint64_t now_ns = sts_sampler_now_ns();
+    if (unflushed_bytes == 0) {
+      oldest_unflushed_ns = now_ns;
+    }
+    unflushed_bytes += batch * sample_bytes;
+    if (unflushed_bytes >= TRIG_STREAM_FLUSH_BYTES || now_ns - oldest_unflushed_ns >= TRIG_STREAM_FLUSH_MS * 1000000ULL) {
       fflush(file);
+      unflushed_bytes = 0;
+      now_ns = sts_sampler_now_ns();
+    }
+    metrics_writer_record(metrics_writer(METRICS_WRITER_TRIG, 0), batch * sample_bytes, now_ns - write_start_ns);
+    TRACE_END(trace_write_ns, TRACE_FILE_WRITE, POLL_STREAM_TRIG_DATA, 0, 2 * (uint32_t)batch);
 
-      samples_written++;
+    uint64_t previous = samples_written;
+    samples_written += batch;
 
-      if (verbose && samples_written % 1000 == 0) {
-        printf("Trigger Stream Thread: Written %llu/%llu samples (%.1f%%)\n",
-               samples_written, sample_count,
-               (double)samples_written / sample_count * 100.0);
-      }
-    } else {
-      // Not enough data available, sleep briefly
-      usleep(10000); // 10ms
+    if (verbose && samples_written / 1000 != previous / 1000) {
+      printf("Trigger Stream Thread: Written %llu/%llu samples (%.1f%%)\n",
+             samples_written, sample_count,
+             (double)samples_written / sample_count * 100.0);
     }
   }
+  poll_sched_finish(&poll);
+
+  if (chunked) {
+    // Final partial chunk, then the index
+    if (chunk_fill > 0 && capture_writer_write_chunk(&capture, chunk_buffer, chunk_fill, NULL, 0) != 0) {
+      fprintf(stderr, "Trigger Stream Thread: Failed to write to file: %s\n", strerror(errno));
+    }
+    capture_writer_close(&capture);
+    free(chunk_buffer);
+  }
 
   if (file) {
     fclose(file);
@@ -256,6 +339,11 @@ int cmd_stream_trig_data_to_file(const char** args, int arg_count, const command
   
   // Check for binary mode flag
   bool binary_mode = has_flag(flags, flag_count, FLAG_BIN);
+  // Chunked capture container (implies binary)
+  bool chunked = has_flag(flags, flag_count, FLAG_CHUNKED);
+  if (chunked) {
+    binary_mode = true;
+  }
   
   // Check if stream is already running
   if (ctx->trig_data_stream_running) {
@@ -294,7 +382,9 @@ int cmd_stream_trig_data_to_file(const char** args, int arg_count, const command
   // Check if there's a dot after the last slash (or no slash at all)
   if (dot == NULL || (slash != NULL && dot < slash)) {
     // No extension found, add default
-    if (binary_mode) {
+    if (chunked) {
+      strcat(final_path, ".cap");
+    } else if (binary_mode) {
       strcat(final_path, ".dat");
     } else {
       strcat(final_path, ".csv");
@@ -322,6 +412,7 @@ int cmd_stream_trig_data_to_file(const char** args, int arg_count, const command
   stream_data->sample_count = sample_count;
   stream_data->should_stop = &(ctx->trig_data_stream_stop);
   stream_data->binary_mode = binary_mode;
+  stream_data->chunked = chunked;
   
   if (*(ctx->verbose)) {
     printf("Initialized trigger stream parameters\n");
@@ -339,7 +430,7 @@ int cmd_stream_trig_data_to_file(const char** args, int arg_count, const command
   }
   
   // Create the streaming thread
-  if (pthread_create(&(ctx->trig_data_stream_thread), NULL, trigger_data_stream_thread, stream_data) != 0) {
+  if (rt_thread_create(&(ctx->trig_data_stream_thread), RT_CLASS_DRAIN, trigger_data_stream_thread, stream_data) != 0) {
     fprintf(stderr, "Failed to create trigger data streaming thread\n");
     ctx->trig_data_stream_running = false;
     free(stream_data);
@@ -388,10 +479,16 @@ static void* trigger_monitor_thread(void* arg) {
            params->expected_total_triggers);
   }
   
+  // Predict when the expected count will be reached from the observed trigger rate
+  poll_sched_t poll;
+  poll_sched_init(&poll, POLL_STREAM_TRIG_MONITOR, 0, 0.0);
+  poll_sched_observe(&poll, sts_sampler_word(params->sys_sts, TRIG_COUNTER_OFFSET, 0), params->expected_total_triggers);
+  
   while (!*(params->should_stop)) {
-    usleep(500000); // 500ms polling interval
+    poll_sched_wait(&poll, last_trigger_count, params->expected_total_triggers);
     
-    uint32_t current_trigger_count = sys_sts_get_trig_counter(params->sys_sts, false);
+    uint32_t current_trigger_count = sts_sampler_word(params->sys_sts, TRIG_COUNTER_OFFSET, 0);
+    poll_sched_observe(&poll, current_trigger_count, params->expected_total_triggers);
     // Since we reset the count after sync_ch, current_trigger_count is the actual triggers received
     
     // Check if 3 seconds have passed since last display
@@ -421,8 +518,10 @@ static void* trigger_monitor_thread(void* arg) {
   }
   
   if (params->verbose) {
+    poll_stats_print("Trigger monitor: ", &poll.stats);
     printf("Trigger monitor thread stopping\n");
   }
+  poll_sched_finish(&poll);
   
   pthread_exit(NULL);
 }
@@ -444,7 +543,7 @@ int start_trigger_monitor(struct sys_sts_t* sys_sts, uint32_t expected_triggers,
   monitor_params.should_stop = &g_trigger_monitor_should_stop;
   monitor_params.verbose = verbose;
   
-  int thread_result = pthread_create(&g_trigger_monitor_tid, NULL, trigger_monitor_thread, &monitor_params);
+  int thread_result = rt_thread_create(&g_trigger_monitor_tid, RT_CLASS_MONITOR, trigger_monitor_thread, &monitor_params);
   
   if (thread_result != 0) {
     printf("Failed to create trigger monitor thread: %s\n", strerror(thread_result));
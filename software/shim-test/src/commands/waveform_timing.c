@@ -0,0 +1,326 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "waveform_timing.h"
+#include "dac_ctrl.h"
+#include "adc_ctrl.h"
+
+// Start an empty timeline
+void timing_trace_init(timing_trace_t* trace, const char* name, uint32_t min_delay, uint64_t trigger_cycles) {
+  memset(trace, 0, sizeof(*trace));
+  trace->name = name;
+  trace->min_delay = min_delay;
+  trace->trigger_cycles = trigger_cycles;
+}
+
+// Free the timeline
+void timing_trace_free(timing_trace_t* trace) {
+  free(trace->events);
+  trace->events = NULL;
+  trace->count = 0;
+  trace->capacity = 0;
+}
+
+// Append a timeline point at the current cycle
+static void add_event(timing_trace_t* trace, uint32_t cmd_words, uint32_t data_words, uint32_t command) {
+  if (trace->error) return;
+  if (trace->count == trace->capacity) {
+    size_t capacity = (trace->capacity > 0) ? trace->capacity * 2 : 4096;
+    timing_event_t* events = realloc(trace->events, capacity * sizeof(timing_event_t));
+    if (events == NULL) {
+      fprintf(stderr, "Failed to allocate memory for the %s timing check\n", trace->name);
+      trace->error = true;
+      return;
+    }
+    trace->events = events;
+    trace->capacity = capacity;
+  }
+  trace->events[trace->count++] = (timing_event_t){
+    .cycle = trace->cycle,
+    .trigger_waits = trace->trigger_waits,
+    .cmd_words = cmd_words,
+    .data_words = data_words,
+    .command = command,
+  };
+  trace->cmd_words += cmd_words;
+  trace->data_words += data_words;
+  if (command > trace->commands) trace->commands = command;
+}
+
+// Wait for a number of triggers (0 = no wait)
+static void add_trigger_wait(timing_trace_t* trace, uint32_t triggers) {
+  if (triggers == 0) return;
+  trace->trigger_waits++;
+  trace->cycle += (uint64_t)triggers * trace->trigger_cycles;
+}
+
+// Check a delay against the minimum delay (false and reported if below it)
+static bool check_delay(timing_trace_t* trace, uint32_t value, uint32_t command) {
+  if (value >= trace->min_delay) {
+    return true;
+  }
+  if (trace->violations < TIMING_MAX_REPORTS) {
+    printf("  %s command %u: delay of %u cycles is below the minimum of %u\n",
+           trace->name, command, value, trace->min_delay);
+  }
+  trace->violations++;
+  return false;
+}
+
+// Add one DAC command starting at words[0]
+bool timing_trace_add_dac(timing_trace_t* trace, const uint32_t* words, uint32_t command) {
+  uint32_t word = words[0];
+  uint32_t code = word >> DAC_CMD_CMD_LSB;
+  bool trig = (word >> DAC_CMD_TRIG_BIT) & 0x1;
+  uint32_t value = word & 0x1FFFFFF;
+  add_event(trace, (code == DAC_CMD_DAC_WR) ? 5 : 1, 0, command);
+
+  switch (code) {
+    case DAC_CMD_NO_OP:
+      if (trig) {
+        add_trigger_wait(trace, value);
+        return true;
+      }
+      trace->cycle += value;
+      return check_delay(trace, value, command);
+    case DAC_CMD_DAC_WR:
+      // A triggered write updates first, then waits; a delayed write lands at the end of its delay
+      if (trig) {
+        trace->cycle += trace->min_delay;
+        add_trigger_wait(trace, value);
+        return true;
+      }
+      trace->cycle += value;
+      return check_delay(trace, value, command);
+    case DAC_CMD_DAC_WR_CH:
+      trace->cycle += DAC_CH_WRITE_CYCLES(trace->min_delay);
+      return true;
+    case DAC_CMD_ZERO:
+      trace->cycle += trace->min_delay;
+      return true;
+    default:
+      return true;
+  }
+}
+
+// Add one ADC command starting at words[0]
+bool timing_trace_add_adc(timing_trace_t* trace, const uint32_t* words, uint32_t command) {
+  uint32_t word = words[0];
+  uint32_t code = word >> ADC_CMD_CMD_LSB;
+  bool trig = (word >> ADC_CMD_TRIG_BIT) & 0x1;
+  uint32_t value = word & 0x1FFFFFF;
+  uint32_t cmd_words = adc_cmd_words(word);
+
+  if (code == ADC_CMD_NO_OP) {
+    add_event(trace, cmd_words, 0, command);
+    if (trig) {
+      add_trigger_wait(trace, value);
+      return true;
+    }
+    trace->cycle += value;
+    return check_delay(trace, value, command);
+  }
+  if (code != ADC_CMD_ADC_RD && code != ADC_CMD_ADC_RD_CH) {
+    add_event(trace, cmd_words, 0, command);
+    return true;
+  }
+
+  // Each read produces its samples when it starts, then waits
+  uint64_t reads = (cmd_words == 2) ? (uint64_t)words[1] + 1 : 1;
+  uint32_t read_words = (code == ADC_CMD_ADC_RD) ? 4 : 1;
+  bool ok = true;
+  if (code == ADC_CMD_ADC_RD_CH) {
+    trig = false;
+    value = trace->min_delay;
+  } else if (!trig) {
+    ok = check_delay(trace, value, command);
+  }
+
+  // Triggered reads with unknown trigger timing each give the host time to catch
+  // up, so one point stands for all of them; others are batched, stamped at the
+  // batch start (early, so the check stays conservative)
+  if (trig && trace->trigger_cycles == 0 && value > 0) {
+    add_event(trace, cmd_words, read_words, command);
+    trace->data_words += (reads - 1) * read_words;
+    trace->cycle += reads * trace->min_delay;
+    trace->trigger_waits += reads;
+    return ok;
+  }
+  // The trigger wait runs alongside the read
+  uint64_t read_cycles = value;
+  if (trig) {
+    read_cycles = (uint64_t)value * trace->trigger_cycles;
+    if (read_cycles < trace->min_delay) read_cycles = trace->min_delay;
+  }
+  for (uint64_t done = 0; done < reads; ) {
+    uint64_t batch = (reads - done < TIMING_READ_BATCH) ? reads - done : TIMING_READ_BATCH;
+    add_event(trace, (done == 0) ? cmd_words : 0, (uint32_t)(batch * read_words), command);
+    trace->cycle += batch * read_cycles;
+    done += batch;
+  }
+  if (trig && value > 0) trace->trigger_waits += reads;
+  return ok;
+}
+
+// Timeline points k >= count are the next iteration's points (k - count)
+static inline const timing_event_t* event_at(const timing_trace_t* trace, size_t k) {
+  return &trace->events[k % trace->count];
+}
+
+// Cycle of point k, with gap extra cycles per trigger wait
+static inline uint64_t event_cycle(const timing_trace_t* trace, size_t k, uint64_t gap) {
+  const timing_event_t* event = event_at(trace, k);
+  uint64_t cycle = event->cycle + event->trigger_waits * gap;
+  return (k >= trace->count) ? cycle + trace->cycle + trace->trigger_waits * gap : cycle;
+}
+
+// Trigger waits before point k
+static inline uint64_t event_waits(const timing_trace_t* trace, size_t k) {
+  uint64_t waits = event_at(trace, k)->trigger_waits;
+  return (k >= trace->count) ? waits + trace->trigger_waits : waits;
+}
+
+// Words point k moves in a FIFO
+static inline uint64_t event_words(const timing_trace_t* trace, size_t k, bool data) {
+  const timing_event_t* event = event_at(trace, k);
+  return data ? event->data_words : event->cmd_words;
+}
+
+// Check a command FIFO (data false) or the ADC data FIFO (data true) of a timeline
+void timing_check_fifo(const timing_trace_t* trace, bool data, uint32_t capacity, uint64_t service_cycles,
+                       timing_fifo_report_t* report) {
+  memset(report, 0, sizeof(*report));
+  report->data = data;
+  report->capacity = capacity;
+  report->service_cycles = service_cycles;
+  report->iteration_cycles = trace->cycle;
+  report->total_words = data ? trace->data_words : trace->cmd_words;
+  report->cover_cycles = UINT64_MAX;
+  for (int b = 0; b < TIMING_PROFILE_BUCKETS; b++) {
+    report->level[b] = INT64_MIN;
+  }
+
+  size_t n = trace->count;
+  const timing_event_t* ev = trace->events;
+  if (n == 0 || service_cycles == 0) return;
+
+  // Windows never span an unknown trigger wait: it counts as more than a service period
+  bool catch_up = (trace->trigger_cycles == 0);
+  uint64_t gap = catch_up ? service_cycles + 1 : 0;
+
+  // Most words in any service period, from each starting point through the wrap
+  size_t j = 0, c = 0;
+  uint64_t sum = 0, cover_sum = 0;
+  bool in_segment = false;
+  timing_segment_t segment = {0};
+  for (size_t i = 0; i < n; i++) {
+    if (j < i) { j = i; sum = 0; }
+    while (j < i + n && event_cycle(trace, j, gap) < event_cycle(trace, i, gap) + service_cycles) {
+      sum += event_words(trace, j, data);
+      j++;
+    }
+    if (sum > report->peak_words) {
+      report->peak_words = sum;
+      report->peak_command = ev[i].command;
+    }
+    if (sum > capacity) {
+      if (!in_segment) {
+        in_segment = true;
+        segment = (timing_segment_t){ ev[i].command, ev[(j - 1) % n].command, ev[i].cycle, sum, j > n };
+      } else {
+        segment.last_command = ev[(j - 1) % n].command;
+        segment.wraps = (j > n);
+        if (sum > segment.peak_words) segment.peak_words = sum;
+      }
+    } else if (in_segment) {
+      if (report->risky_count < TIMING_MAX_REPORTS) report->risky[report->risky_count] = segment;
+      report->risky_count++;
+      in_segment = false;
+    }
+    sum -= event_words(trace, i, data);
+
+    // Time until the point that needs more than the FIFO holds
+    if (c < i) { c = i; cover_sum = 0; }
+    while (c < i + n && cover_sum + event_words(trace, c, data) <= capacity) {
+      cover_sum += event_words(trace, c, data);
+      c++;
+    }
+    if (c < i + n && !(catch_up && event_waits(trace, c) > event_waits(trace, i))) {
+      uint64_t cover = event_cycle(trace, c, 0) - event_cycle(trace, i, 0);
+      if (cover < report->cover_cycles) report->cover_cycles = cover;
+    }
+    if (c > i) cover_sum -= event_words(trace, i, data);
+  }
+  if (in_segment) {
+    if (report->risky_count < TIMING_MAX_REPORTS) report->risky[report->risky_count] = segment;
+    report->risky_count++;
+  }
+
+  // Occupancy over one iteration, starting prefilled (command) or empty (data),
+  // with the host servicing at every multiple of the period
+  int64_t reset = data ? 0 : (int64_t)capacity;
+  int64_t level = reset;
+  uint64_t next_service = service_cycles;
+  uint64_t waits = 0;
+  for (size_t k = 0; k < n; k++) {
+    if (ev[k].cycle >= next_service) {
+      level = reset;
+      next_service = (ev[k].cycle / service_cycles + 1) * service_cycles;
+    }
+    if (catch_up && ev[k].trigger_waits > waits) level = reset;
+    waits = ev[k].trigger_waits;
+    level += data ? (int64_t)ev[k].data_words : -(int64_t)ev[k].cmd_words;
+    if (data ? (level > (int64_t)capacity) : (level < 0)) report->faults++;
+
+    int b = (trace->cycle > 0) ? (int)(ev[k].cycle * TIMING_PROFILE_BUCKETS / trace->cycle) : 0;
+    if (b >= TIMING_PROFILE_BUCKETS) b = TIMING_PROFILE_BUCKETS - 1;
+    if (report->level[b] == INT64_MIN || (data ? level > report->level[b] : level < report->level[b])) {
+      report->level[b] = level;
+    }
+  }
+}
+
+// Print a FIFO check
+bool timing_print_fifo(const timing_fifo_report_t* report, const char* name, double spi_hz) {
+  double us_per_cycle = 1e6 / spi_hz;
+  double service_us = report->service_cycles * us_per_cycle;
+  printf("  %s: %llu words per iteration", name, report->total_words);
+  if (report->iteration_cycles > 0) {
+    printf(", average %.1f kwords/s", report->total_words / (report->iteration_cycles * us_per_cycle) * 1e3);
+  }
+  printf("\n");
+  printf("    Busiest %.0f us service period: %llu of %u words (from command %u), host must move %.1f kwords/s\n",
+         service_us, report->peak_words, report->capacity, report->peak_command,
+         service_us > 0.0 ? report->peak_words / service_us * 1e3 : 0.0);
+  if (report->cover_cycles != UINT64_MAX) {
+    printf("    A %s FIFO lasts %.1f us at the busiest point\n",
+           report->data ? "drained" : "full", report->cover_cycles * us_per_cycle);
+  }
+  printf("    %s per tenth of the iteration:", report->data ? "Most queued words" : "Fewest queued words");
+  for (int b = 0; b < TIMING_PROFILE_BUCKETS; b++) {
+    if (report->level[b] == INT64_MIN) {
+      printf(" -");
+    } else {
+      printf(" %lld", (long long)report->level[b]);
+    }
+  }
+  printf("\n");
+
+  if (report->risky_count > 0) {
+    printf("    %llu segment%s need%s more words in one service period than the FIFO holds (%s risk):\n",
+           report->risky_count, report->risky_count == 1 ? "" : "s", report->risky_count == 1 ? "s" : "",
+           report->data ? "overflow" : "underflow");
+    uint64_t shown = (report->risky_count < TIMING_MAX_REPORTS) ? report->risky_count : TIMING_MAX_REPORTS;
+    for (uint64_t i = 0; i < shown; i++) {
+      const timing_segment_t* segment = &report->risky[i];
+      printf("      commands %u-%u%s from %.1f us: up to %llu words\n",
+             segment->first_command, segment->last_command, segment->wraps ? " (of the next iteration)" : "",
+             segment->start_cycle * us_per_cycle, segment->peak_words);
+    }
+  }
+  if (report->faults > 0) {
+    printf("    Predicted %s with a service every %.0f us: %llu\n",
+           report->data ? "overflows" : "underflows", service_us, report->faults);
+  }
+  return report->risky_count == 0;
+}
@@ -15,6 +15,9 @@ struct adc_ctrl_t create_adc_ctrl(bool verbose) {
       fprintf(stderr, "Failed to map ADC FIFO access for board %d\n", board);
       exit(EXIT_FAILURE);
     }
+    for (int i = 0; i < 8; i++) {
+      adc_ctrl.channel_order[board][i] = (uint8_t)i;
+    }
   }
 
   return adc_ctrl;
@@ -35,11 +38,50 @@ uint32_t adc_read_word(struct adc_ctrl_t *adc_ctrl, uint8_t board) {
   
   // Use volatile access to prevent compiler optimization and ensure actual memory read
   volatile uint32_t *buffer_ptr = adc_ctrl->buffer[board];
-  uint32_t value = *buffer_ptr;
+  uint32_t value = mmio_read32(buffer_ptr);
   
   return value;
 }
 
+// Read count ADC data words from a specific board into dst
+// The caller must have seen at least count words in the data FIFO status, since
+// reading an empty FIFO is a hardware underflow. Returns the number of words read.
+uint32_t adc_read_burst(struct adc_ctrl_t *adc_ctrl, uint8_t board, uint32_t *dst, uint32_t count) {
+  if (board > 7) {
+    fprintf(stderr, "Invalid ADC board: %d. Must be 0-7.\n", board);
+    return 0;
+  }
+  
+  if (adc_ctrl->buffer[board] == NULL) {
+    fprintf(stderr, "Error: ADC buffer[%d] is NULL. Cannot read data.\n", board);
+    return 0;
+  }
+  
+  if (count > ADC_DATA_FIFO_WORDCOUNT) {
+    count = ADC_DATA_FIFO_WORDCOUNT;
+  }
+  
+  mmio_read32_burst(adc_ctrl->buffer[board], dst, count);
+  return count;
+}
+
+// Write count pre-encoded command words to a specific board
+// The caller must have seen at least count free words in the command FIFO status,
+// and src must hold whole commands. Returns the number of words written.
+uint32_t adc_write_burst(struct adc_ctrl_t *adc_ctrl, uint8_t board, const uint32_t *src, uint32_t count) {
+  if (board > 7) {
+    fprintf(stderr, "Invalid ADC board: %d. Must be 0-7.\n", board);
+    return 0;
+  }
+  
+  if (count > ADC_CMD_FIFO_WORDCOUNT) {
+    count = ADC_CMD_FIFO_WORDCOUNT;
+  }
+  
+  mmio_write32_burst(adc_ctrl->buffer[board], src, count);
+  return count;
+}
+
 // Interpret and format ADC value as debug information
 char* adc_format_debug(uint32_t adc_value, bool verbose) {
   static char buffer[512];  // Static buffer for return string
@@ -212,6 +254,41 @@ char* adc_format_command(uint8_t cmd_code, bool verbose) {
   return buffer;
 }
 
+// ADC command word encoding
+uint32_t adc_encode_noop(adc_wait_mode_t trig, adc_continue_mode_t cont, uint32_t value) {
+  return (ADC_CMD_NO_OP  << ADC_CMD_CMD_LSB ) |
+         ((trig == ADC_TRIGGER_WAIT ? 1 : 0) << ADC_CMD_TRIG_BIT) |
+         ((cont == ADC_CONTINUE ? 1 : 0) << ADC_CMD_CONT_BIT) |
+         (value & 0x1FFFFFF);
+}
+
+uint32_t adc_encode_adc_rd(uint32_t words[2], adc_wait_mode_t trig, adc_continue_mode_t cont, uint32_t value, uint32_t repeat_count) {
+  words[0] = (ADC_CMD_ADC_RD << ADC_CMD_CMD_LSB ) |
+             ((trig == ADC_TRIGGER_WAIT ? 1 : 0) << ADC_CMD_TRIG_BIT) |
+             ((cont == ADC_CONTINUE ? 1 : 0) << ADC_CMD_CONT_BIT) |
+             (((repeat_count > 0) ? 1 : 0) << ADC_CMD_REPEAT_BIT) |
+             (value & 0x1FFFFFF);
+  if (repeat_count == 0) {
+    return 1;
+  }
+  words[1] = repeat_count & 0x1FFFFFF;
+  return 2;
+}
+
+uint32_t adc_encode_set_ord(const uint8_t channel_order[8]) {
+  uint32_t cmd_word = (ADC_CMD_SET_ORD << ADC_CMD_CMD_LSB);
+  for (int i = 0; i < 8; i++) {
+    cmd_word |= (uint32_t)(channel_order[i] & 0x7) << (3 * i);
+  }
+  return cmd_word;
+}
+
+void adc_decode_set_ord(uint32_t cmd_word, uint8_t channel_order[8]) {
+  for (int i = 0; i < 8; i++) {
+    channel_order[i] = (cmd_word >> (3 * i)) & 0x7;
+  }
+}
+
 // ADC command word functions
 void adc_cmd_noop(struct adc_ctrl_t *adc_ctrl, uint8_t board, adc_wait_mode_t trig, adc_continue_mode_t cont, uint32_t value, bool verbose) {
   if (board > 7) {
@@ -222,15 +299,12 @@ void adc_cmd_noop(struct adc_ctrl_t *adc_ctrl, uint8_t board, adc_wait_mode_t tr
     fprintf(stderr, "Invalid command value: %u. Must be 0 to 33554431 (25-bit value).\n", value);
     return;
   }
-  uint32_t cmd_word = (ADC_CMD_NO_OP  << ADC_CMD_CMD_LSB ) |
-                      ((trig == ADC_TRIGGER_WAIT ? 1 : 0) << ADC_CMD_TRIG_BIT) |
-                      ((cont == ADC_CONTINUE ? 1 : 0) << ADC_CMD_CONT_BIT) |
-                      (value & 0x1FFFFFF);
+  uint32_t cmd_word = adc_encode_noop(trig, cont, value);
   
   if (verbose) {
     printf("ADC[%d] NO_OP command word: 0x%08X\n", board, cmd_word);
   }
-  *(adc_ctrl->buffer[board]) = cmd_word;
+  mmio_write32(adc_ctrl->buffer[board], cmd_word);
 }
 
 void adc_cmd_adc_rd(struct adc_ctrl_t *adc_ctrl, uint8_t board, adc_wait_mode_t trig, adc_continue_mode_t cont, uint32_t value, uint32_t repeat_count, bool verbose) {
@@ -242,23 +316,16 @@ void adc_cmd_adc_rd(struct adc_ctrl_t *adc_ctrl, uint8_t board, adc_wait_mode_t
     fprintf(stderr, "Invalid command value: %u. Must be 0 to 33554431 (25-bit value).\n", value);
     return;
   }
-  uint32_t cmd_word = (ADC_CMD_ADC_RD << ADC_CMD_CMD_LSB ) |
-                      ((trig == ADC_TRIGGER_WAIT ? 1 : 0) << ADC_CMD_TRIG_BIT) |
-                      ((cont == ADC_CONTINUE ? 1 : 0) << ADC_CMD_CONT_BIT) |
-                      (((repeat_count > 0) ? 1 : 0) << ADC_CMD_REPEAT_BIT) |
-                      (value & 0x1FFFFFF);
+  uint32_t words[2];
+  uint32_t count = adc_encode_adc_rd(words, trig, cont, value, repeat_count);
   
   if (verbose) {
-    printf("ADC[%d] ADC_RD command word: 0x%08X\n", board, cmd_word);
-  }
-  *(adc_ctrl->buffer[board]) = cmd_word;
-
-  if (repeat_count > 0) {
-    if (verbose) {
-      printf("ADC[%d] REPEAT count: 0x%08X (repeat count: %u)\n", board, repeat_count, repeat_count);
+    printf("ADC[%d] ADC_RD command word: 0x%08X\n", board, words[0]);
+    if (count > 1) {
+      printf("ADC[%d] REPEAT count: 0x%08X (repeat count: %u)\n", board, words[1], repeat_count);
     }
-    *(adc_ctrl->buffer[board]) = repeat_count;
   }
+  mmio_write32_burst(adc_ctrl->buffer[board], words, count);
 }
 
 void adc_cmd_adc_rd_ch(struct adc_ctrl_t *adc_ctrl, uint8_t board, uint8_t ch, uint32_t repeat_count, bool verbose) {
@@ -278,13 +345,13 @@ void adc_cmd_adc_rd_ch(struct adc_ctrl_t *adc_ctrl, uint8_t board, uint8_t ch, u
   if (verbose) {
     printf("ADC[%d] ADC_RD_CH command word: 0x%08X (channel: %d)\n", board, cmd_word, ch);
   }
-  *(adc_ctrl->buffer[board]) = cmd_word;
+  mmio_write32(adc_ctrl->buffer[board], cmd_word);
 
   if (repeat_count > 0) {
     if (verbose) {
       printf("ADC[%d] REPEAT count: 0x%08X (repeat count: %u)\n", board, repeat_count, repeat_count);
     }
-    *(adc_ctrl->buffer[board]) = repeat_count;
+    mmio_write32(adc_ctrl->buffer[board], repeat_count);
   }
 }
 
@@ -301,22 +368,15 @@ void adc_cmd_set_ord(struct adc_ctrl_t *adc_ctrl, uint8_t board, uint8_t channel
     }
   }
 
-  uint32_t cmd_word = (ADC_CMD_SET_ORD << ADC_CMD_CMD_LSB) |
-                      ((channel_order[7] & 0x7) << 21    ) |
-                      ((channel_order[6] & 0x7) << 18    ) |
-                      ((channel_order[5] & 0x7) << 15    ) |
-                      ((channel_order[4] & 0x7) << 12    ) |
-                      ((channel_order[3] & 0x7) <<  9    ) |
-                      ((channel_order[2] & 0x7) <<  6    ) |
-                      ((channel_order[1] & 0x7) <<  3    ) |
-                      ((channel_order[0] & 0x7) <<  0    );
+  uint32_t cmd_word = adc_encode_set_ord(channel_order);
 
   if (verbose) {
     printf("ADC[%d] SET_ORD command word: 0x%08X (order: [%d,%d,%d,%d,%d,%d,%d,%d])\n", 
            board, cmd_word, channel_order[0], channel_order[1], channel_order[2], channel_order[3],
            channel_order[4], channel_order[5], channel_order[6], channel_order[7]);
   }
-  *(adc_ctrl->buffer[board]) = cmd_word;
+  mmio_write32(adc_ctrl->buffer[board], cmd_word);
+  memcpy(adc_ctrl->channel_order[board], channel_order, 8);
 }
 
 void adc_cmd_cancel(struct adc_ctrl_t *adc_ctrl, uint8_t board, bool verbose) {
@@ -330,7 +390,7 @@ void adc_cmd_cancel(struct adc_ctrl_t *adc_ctrl, uint8_t board, bool verbose) {
   if (verbose) {
     printf("ADC[%d] CANCEL command word: 0x%08X\n", board, cmd_word);
   }
-  *(adc_ctrl->buffer[board]) = cmd_word;
+  mmio_write32(adc_ctrl->buffer[board], cmd_word);
 }
 
 // Convert and format a single ADC sample from a 32-bit word (low 16 bits)
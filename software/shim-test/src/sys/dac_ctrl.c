@@ -27,7 +27,24 @@ uint32_t dac_read_data(struct dac_ctrl_t *dac_ctrl, uint8_t board) {
     return 0; // Return 0 for invalid board
   }
 
-  return *(dac_ctrl->buffer[board]);
+  return mmio_read32(dac_ctrl->buffer[board]);
+}
+
+// Write count pre-encoded command FIFO words to a specific board
+// The caller must have seen at least count free words in the command FIFO status,
+// since writing a full FIFO is a hardware overflow. Returns the number of words written.
+uint32_t dac_write_burst(struct dac_ctrl_t *dac_ctrl, uint8_t board, const uint32_t *src, uint32_t count) {
+  if (board > 7) {
+    fprintf(stderr, "Invalid DAC board: %d. Must be 0-7.\n", board);
+    return 0;
+  }
+  
+  if (count > DAC_CMD_FIFO_WORDCOUNT) {
+    count = DAC_CMD_FIFO_WORDCOUNT;
+  }
+  
+  mmio_write32_burst(dac_ctrl->buffer[board], src, count);
+  return count;
 }
 
 // Interpret and format DAC data word as calibration or debug information
@@ -172,6 +189,33 @@ char* dac_format_state(uint8_t state_code, bool verbose) {
   return buffer;
 }
 
+// DAC command word encoding
+uint32_t dac_encode_noop(dac_wait_mode_t trig, dac_continue_mode_t cont, dac_ldac_mode_t ldac, uint32_t value) {
+  return (DAC_CMD_NO_OP  << DAC_CMD_CMD_LSB ) |
+         ((ldac == DAC_LDAC ? 1 : 0) << DAC_CMD_LDAC_BIT) |
+         ((trig == DAC_TRIGGER_WAIT ? 1 : 0) << DAC_CMD_TRIG_BIT) |
+         ((cont == DAC_CONTINUE ? 1 : 0) << DAC_CMD_CONT_BIT) |
+         (value & 0x1FFFFFF);
+}
+
+void dac_encode_dac_wr(uint32_t words[5], const int16_t ch_vals[8], dac_wait_mode_t trig, dac_continue_mode_t cont, dac_ldac_mode_t ldac, uint32_t value) {
+  words[0] = (DAC_CMD_DAC_WR << DAC_CMD_CMD_LSB ) |
+             ((trig == DAC_TRIGGER_WAIT ? 1 : 0) << DAC_CMD_TRIG_BIT) |
+             ((cont == DAC_CONTINUE ? 1 : 0) << DAC_CMD_CONT_BIT) |
+             ((ldac == DAC_LDAC ? 1 : 0) << DAC_CMD_LDAC_BIT) |
+             (value & 0x1FFFFFF);
+  // Each word contains two channels: [31:16] = ch N+1, [15:0] = ch N
+  for (int i = 0; i < 8; i += 2) {
+    words[1 + i / 2] = ((uint32_t)(uint16_t)ch_vals[i + 1] << 16) | (uint32_t)(uint16_t)ch_vals[i];
+  }
+}
+
+uint32_t dac_encode_dac_wr_ch(uint8_t ch, int16_t ch_val) {
+  return (DAC_CMD_DAC_WR_CH << DAC_CMD_CMD_LSB) |
+         ((ch & 0x7) << 16) |         // Channel index
+         ((uint16_t)ch_val & 0xFFFF); // Channel value
+}
+
 // DAC command word functions
 void dac_cmd_noop(struct dac_ctrl_t *dac_ctrl, uint8_t board, dac_wait_mode_t trig, dac_continue_mode_t cont, dac_ldac_mode_t ldac, uint32_t value, bool verbose) {
   if (board > 7) {
@@ -182,16 +226,12 @@ void dac_cmd_noop(struct dac_ctrl_t *dac_ctrl, uint8_t board, dac_wait_mode_t tr
     fprintf(stderr, "Invalid command value: %u. Must be 0 to 33554431 (25-bit value).\n", value);
     return;
   }
-  uint32_t cmd_word = (DAC_CMD_NO_OP  << DAC_CMD_CMD_LSB ) |
-                      ((ldac == DAC_LDAC ? 1 : 0) << DAC_CMD_LDAC_BIT) |
-                      ((trig == DAC_TRIGGER_WAIT ? 1 : 0) << DAC_CMD_TRIG_BIT) |
-                      ((cont == DAC_CONTINUE ? 1 : 0) << DAC_CMD_CONT_BIT) |
-                      (value & 0x1FFFFFF);
+  uint32_t cmd_word = dac_encode_noop(trig, cont, ldac, value);
   
   if (verbose) {
     printf("DAC[%d] NO_OP command word: 0x%08X\n", board, cmd_word);
   }
-  *(dac_ctrl->buffer[board]) = cmd_word;
+  mmio_write32(dac_ctrl->buffer[board], cmd_word);
 }
 
 void dac_cmd_dac_wr(struct dac_ctrl_t *dac_ctrl, uint8_t board, int16_t ch_vals[8], dac_wait_mode_t trig, dac_continue_mode_t cont, dac_ldac_mode_t ldac, uint32_t value, bool verbose) {
@@ -204,29 +244,17 @@ void dac_cmd_dac_wr(struct dac_ctrl_t *dac_ctrl, uint8_t board, int16_t ch_vals[
     return;
   }
   
-  uint32_t cmd_word = (DAC_CMD_DAC_WR << DAC_CMD_CMD_LSB ) |
-                      ((trig == DAC_TRIGGER_WAIT ? 1 : 0) << DAC_CMD_TRIG_BIT) |
-                      ((cont == DAC_CONTINUE ? 1 : 0) << DAC_CMD_CONT_BIT) |
-                      ((ldac == DAC_LDAC ? 1 : 0) << DAC_CMD_LDAC_BIT) |
-                      (value & 0x1FFFFFF);
+  uint32_t words[5];
+  dac_encode_dac_wr(words, ch_vals, trig, cont, ldac, value);
   
   if (verbose) {
-    printf("DAC[%d] DAC_WR command word: 0x%08X\n", board, cmd_word);
-  }
-  *(dac_ctrl->buffer[board]) = cmd_word;
-
-  // Write channel values
-  for (int i = 0; i < 8; i += 2) {
-    // Each word contains two channels: [31:16] = ch N+1, [15:0] = ch N
-    int16_t val0 = ch_vals[i];
-    int16_t val1 = ch_vals[i + 1];
-    uint32_t word = (((uint32_t)(uint16_t)val1 << 16) & 0xFFFF0000) | (((uint32_t)(uint16_t)val0) & 0x0000FFFF);
-    if (verbose) {
+    printf("DAC[%d] DAC_WR command word: 0x%08X\n", board, words[0]);
+    for (int i = 0; i < 8; i += 2) {
       printf("DAC[%d] Channel data word %d: 0x%08X (ch%d=0x%04X, ch%d=0x%04X)\n", 
-             board, i/2, word, i, val0, i+1, val1);
+             board, i/2, words[1 + i/2], i, (uint16_t)ch_vals[i], i+1, (uint16_t)ch_vals[i+1]);
     }
-    *(dac_ctrl->buffer[board]) = word;
   }
+  mmio_write32_burst(dac_ctrl->buffer[board], words, 5);
 }
 
 void dac_cmd_dac_wr_ch(struct dac_ctrl_t *dac_ctrl, uint8_t board, uint8_t ch, int16_t ch_val, bool verbose) {
@@ -239,15 +267,13 @@ void dac_cmd_dac_wr_ch(struct dac_ctrl_t *dac_ctrl, uint8_t board, uint8_t ch, i
     return;
   }
 
-  uint32_t cmd_word = (DAC_CMD_DAC_WR_CH << DAC_CMD_CMD_LSB) |
-                      ((ch & 0x7) << 16) | // Channel index
-                      (ch_val & 0xFFFF);   // Channel value
+  uint32_t cmd_word = dac_encode_dac_wr_ch(ch, ch_val);
 
   if (verbose) {
     printf("DAC[%d] DAC_WR_CH command word: 0x%08X (channel %d, value=%d, bits=0x%04X)\n", 
            board, cmd_word, ch, ch_val, (uint16_t)ch_val & 0xFFFF);
   }
-  *(dac_ctrl->buffer[board]) = cmd_word;
+  mmio_write32(dac_ctrl->buffer[board], cmd_word);
 }
 
 void dac_cmd_set_cal(struct dac_ctrl_t *dac_ctrl, uint8_t board, uint8_t ch, int16_t cal, bool verbose) {
@@ -268,7 +294,7 @@ void dac_cmd_set_cal(struct dac_ctrl_t *dac_ctrl, uint8_t board, uint8_t ch, int
     printf("DAC[%d] SET_CAL command word: 0x%08X (channel %d, cal=%d, bits=0x%04X)\n", 
            board, cmd_word, ch, cal, (uint16_t)cal & 0xFFFF);
   }
-  *(dac_ctrl->buffer[board]) = cmd_word;
+  mmio_write32(dac_ctrl->buffer[board], cmd_word);
 }
 
 void dac_cmd_get_cal(struct dac_ctrl_t *dac_ctrl, uint8_t board, uint8_t channel, bool verbose) {
@@ -288,7 +314,7 @@ void dac_cmd_get_cal(struct dac_ctrl_t *dac_ctrl, uint8_t board, uint8_t channel
     printf("DAC[%d] GET_CAL command word: 0x%08X (channel %d)\n", 
            board, cmd_word, channel);
   }
-  *(dac_ctrl->buffer[board]) = cmd_word;
+  mmio_write32(dac_ctrl->buffer[board], cmd_word);
 }
 
 void dac_cmd_zero(struct dac_ctrl_t *dac_ctrl, uint8_t board, bool verbose) {
@@ -301,7 +327,7 @@ void dac_cmd_zero(struct dac_ctrl_t *dac_ctrl, uint8_t board, bool verbose) {
   if (verbose) {
     printf("DAC[%d] ZERO command word: 0x%08X\n", board, cmd_word);
   }
-  *(dac_ctrl->buffer[board]) = cmd_word;
+  mmio_write32(dac_ctrl->buffer[board], cmd_word);
 }
 
 void dac_cmd_cancel(struct dac_ctrl_t *dac_ctrl, uint8_t board, bool verbose) {
@@ -314,5 +340,5 @@ void dac_cmd_cancel(struct dac_ctrl_t *dac_ctrl, uint8_t board, bool verbose) {
   if (verbose) {
     printf("DAC[%d] CANCEL command word: 0x%08X\n", board, cmd_word);
   }
-  *(dac_ctrl->buffer[board]) = cmd_word;
+  mmio_write32(dac_ctrl->buffer[board], cmd_word);
 }
@@ -6,10 +6,32 @@
 #include <stdlib.h> // For exit function and NULL definition etc.
 #include <sys/mman.h> // For mmap function
 #include <unistd.h> // For sysconf function
+#include "map_memory.h"
+
+// Active MMIO backend (NULL = direct /dev/mem access)
+const mmio_backend_t *mmio_backend = NULL;
+
+// Install an MMIO backend (NULL restores direct /dev/mem access)
+void mmio_set_backend(const mmio_backend_t *backend) {
+  mmio_backend = backend;
+}
+
+// Get the name of the active MMIO backend
+const char *mmio_backend_name(void) {
+  return (mmio_backend != NULL) ? mmio_backend->name : "/dev/mem";
+}
 
 // Map a 32-bit memory region
 uint32_t *map_32bit_memory(uint32_t base_addr, size_t wordcount, char *name, bool verbose) {
 
+  // Let an installed backend provide the mapping instead of /dev/mem
+  if (mmio_backend != NULL) {
+    if (verbose) {
+      printf("Mapping memory region [%s] through MMIO backend '%s'...\n", name, mmio_backend->name);
+    }
+    return mmio_backend->map(base_addr, wordcount, name, verbose);
+  }
+
   if (verbose) {
     printf("Mapping memory region [%s] at base address 0x%" PRIx32 " with size %zu bytes...\n", name, base_addr, wordcount * 4);
   }
@@ -0,0 +1,1021 @@
+#include <inttypes.h> // For PRIu64 format specifier
+#include <pthread.h> // For pthread_mutex functions
+#include <stdio.h> // For printf and perror functions
+#include <stdlib.h> // For calloc, free functions
+#include <string.h> // For memset function
+#include <time.h> // For clock_gettime function
+#include <unistd.h> // For sysconf function
+#include "shim_emu.h"
+#include "sys_ctrl.h"
+#include "sys_sts.h"
+#include "spi_clk_ctrl.h"
+#include "dac_ctrl.h"
+#include "adc_ctrl.h"
+#include "trigger_ctrl.h"
+
+//////////////////// Internal Definitions ////////////////////
+#define EMU_MAX_REGIONS 32
+#define EMU_TRIG_RING   4096 // Recent trigger fire times kept for DAC/ADC trigger waits
+#define EMU_NEVER       UINT64_MAX
+
+// Kind of emulated memory region
+typedef enum {
+  EMU_REGION_OTHER = 0,
+  EMU_REGION_SYS_CTRL,
+  EMU_REGION_SYS_STS,
+  EMU_REGION_SPI_CLK,
+  EMU_REGION_DAC_FIFO,
+  EMU_REGION_ADC_FIFO,
+  EMU_REGION_TRIG_FIFO
+} emu_region_kind_t;
+
+// Emulated memory region (backing store for map_32bit_memory)
+typedef struct {
+  uint32_t *mem;
+  size_t wordcount;
+  emu_region_kind_t kind;
+  int board;
+} emu_region_t;
+
+// Emulated FIFO with per-word arrival times (in SPI cycles)
+typedef struct {
+  uint32_t *words;
+  uint64_t *arrival;
+  uint32_t depth;
+  uint32_t head;
+  uint32_t count;
+} emu_fifo_t;
+
+// Trigger wait state shared by the DAC and ADC core models
+typedef struct {
+  bool active;       // Waiting for triggers
+  uint32_t needed;   // Number of triggers still required
+  uint64_t start;    // Cycle at which the wait started
+} emu_trig_wait_t;
+
+// DAC core model
+typedef struct {
+  uint64_t cursor;   // Cycle at which the core is ready for its next command
+  bool cont;         // Last command had CONTINUE set
+  emu_trig_wait_t wait;
+  int16_t ch_vals[8];
+  int16_t cal[8];
+} emu_dac_t;
+
+// ADC core model
+typedef struct {
+  uint64_t cursor;   // Cycle at which the core is ready for its next command/read
+  bool cont;         // Last command had CONTINUE set
+  emu_trig_wait_t wait;
+  uint8_t order[8];
+  uint32_t cmd_word; // ADC_RD/ADC_RD_CH command being repeated
+  uint32_t reads_left; // Remaining reads of cmd_word
+} emu_adc_t;
+
+// Trigger core model
+typedef struct {
+  uint64_t cursor;   // Cycle at which the core is ready for its next command
+  bool busy;         // Executing EXPECT_EXT or DELAY
+  uint32_t cmd;      // Command being executed
+  bool log;          // Log triggers of the current command
+  uint32_t remaining; // External triggers left to expect
+  uint64_t ready;    // DELAY completion cycle
+  uint32_t lockout;  // Minimum cycles between external triggers
+  uint64_t last_fire;
+  bool timer_running; // 64-bit trigger timer started by first logged trigger
+  uint64_t timer_origin;
+  uint32_t counter;
+  uint64_t fire_total; // Total trigger pulses since power-on
+  uint64_t fire_cycle[EMU_TRIG_RING];
+} emu_trig_t;
+
+// Complete emulator state
+static struct {
+  bool initialized;
+  pthread_mutex_t lock;
+  shim_emu_config_t config;
+  shim_emu_stats_t stats;
+
+  // Emulated time base
+  uint64_t base_ns;
+  uint64_t base_cycles;
+
+  // Mapped regions
+  emu_region_t regions[EMU_MAX_REGIONS];
+  int region_count;
+
+  // Hardware manager state
+  uint32_t ctrl_enable;
+  uint32_t power_enable;
+  uint32_t state;
+  uint32_t status_code;
+  uint32_t status_board;
+
+  // FIFOs and core models
+  emu_fifo_t dac_cmd[8];
+  emu_fifo_t dac_data[8];
+  emu_fifo_t adc_cmd[8];
+  emu_fifo_t adc_data[8];
+  emu_fifo_t trig_cmd;
+  emu_fifo_t trig_data;
+  emu_dac_t dac[8];
+  emu_adc_t adc[8];
+  emu_trig_t trig;
+} emu;
+
+//////////////////////////////////////////////////////////////////
+
+// Get CLOCK_MONOTONIC time in nanoseconds
+static uint64_t emu_now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Get the current emulated SPI cycle
+static uint64_t emu_now_cycles(void) {
+  uint64_t delta_ns = emu_now_ns() - emu.base_ns;
+  uint64_t hz = emu.config.spi_clk_freq_hz;
+  // Split to avoid 64-bit overflow on long runs
+  return emu.base_cycles + (delta_ns / 1000000000ULL) * hz + ((delta_ns % 1000000000ULL) * hz) / 1000000000ULL;
+}
+
+// Allocate a FIFO of the given depth
+static void emu_fifo_init(emu_fifo_t *fifo, uint32_t depth) {
+  fifo->words = calloc(depth, sizeof(uint32_t));
+  fifo->arrival = calloc(depth, sizeof(uint64_t));
+  if (fifo->words == NULL || fifo->arrival == NULL) {
+    perror("calloc");
+    exit(EXIT_FAILURE);
+  }
+  fifo->depth = depth;
+  fifo->head = 0;
+  fifo->count = 0;
+}
+
+static void emu_fifo_clear(emu_fifo_t *fifo) {
+  fifo->head = 0;
+  fifo->count = 0;
+}
+
+// Push a word; returns false on overflow
+static bool emu_fifo_push(emu_fifo_t *fifo, uint32_t word, uint64_t cycle) {
+  if (fifo->count >= fifo->depth) return false;
+  uint32_t tail = (fifo->head + fifo->count) % fifo->depth;
+  fifo->words[tail] = word;
+  fifo->arrival[tail] = cycle;
+  fifo->count++;
+  return true;
+}
+
+// Peek the word at position index from the head
+static uint32_t emu_fifo_peek(const emu_fifo_t *fifo, uint32_t index, uint64_t *arrival) {
+  uint32_t pos = (fifo->head + index) % fifo->depth;
+  if (arrival != NULL) *arrival = fifo->arrival[pos];
+  return fifo->words[pos];
+}
+
+static uint32_t emu_fifo_pop(emu_fifo_t *fifo) {
+  uint32_t word = fifo->words[fifo->head];
+  fifo->head = (fifo->head + 1) % fifo->depth;
+  fifo->count--;
+  return word;
+}
+
+// Build a FIFO status word (same layout as the hardware FIFO status registers)
+static uint32_t emu_fifo_status(const emu_fifo_t *fifo, bool present) {
+  if (!present) return 0;
+  uint32_t count = fifo->count;
+  uint32_t sts = count & 0x7FFFFFF;
+  if (count >= fifo->depth) sts |= (1u << 27);
+  if (count + SHIM_EMU_FIFO_ALMOST_MARGIN >= fifo->depth) sts |= (1u << 28);
+  if (count == 0) sts |= (1u << 29);
+  if (count <= SHIM_EMU_FIFO_ALMOST_MARGIN) sts |= (1u << 30);
+  sts |= (1u << 31);
+  return sts;
+}
+
+static bool emu_board_present(int board) {
+  return (emu.config.board_mask >> board) & 0x1;
+}
+
+// Halt the emulated system with a status code
+static void emu_halt(uint32_t code, int board) {
+  if (emu.state == S_HALTED) return;
+  emu.state = S_HALTED;
+  emu.status_code = code;
+  emu.status_board = (uint32_t)board & 0x7;
+  if (emu.config.verbose) {
+    printf("Shim Emulator: HALTED with status 0x%04" PRIx32 " (board %d)\n", code, board);
+  }
+}
+
+// Reset the core models when the system enters the running state
+static void emu_reset_cores(uint64_t now) {
+  for (int b = 0; b < 8; b++) {
+    memset(&emu.dac[b], 0, sizeof(emu.dac[b]));
+    emu.dac[b].cursor = now;
+    memset(&emu.adc[b], 0, sizeof(emu.adc[b]));
+    emu.adc[b].cursor = now;
+    for (int i = 0; i < 8; i++) emu.adc[b].order[i] = (uint8_t)i;
+  }
+  uint64_t fire_total = emu.trig.fire_total;
+  memset(&emu.trig, 0, sizeof(emu.trig));
+  emu.trig.fire_total = fire_total;
+  emu.trig.cursor = now;
+}
+
+//////////////////// Trigger Core Model ////////////////////
+
+// Emit a trigger pulse at the given cycle
+static void emu_trig_fire(uint64_t cycle, bool log) {
+  emu_trig_t *t = &emu.trig;
+  t->fire_cycle[t->fire_total % EMU_TRIG_RING] = cycle;
+  t->fire_total++;
+  t->counter++;
+  t->last_fire = cycle;
+
+  if (log) {
+    if (!t->timer_running) {
+      t->timer_running = true;
+      t->timer_origin = cycle;
+    }
+    uint64_t timestamp = cycle - t->timer_origin + 1;
+    if (!emu_fifo_push(&emu.trig_data, (uint32_t)(timestamp & 0xFFFFFFFF), cycle) ||
+        !emu_fifo_push(&emu.trig_data, (uint32_t)(timestamp >> 32), cycle)) {
+      emu_halt(STS_TRIG_DATA_BUF_OVERFLOW, 0);
+      return;
+    }
+    emu.stats.trig_words += 2;
+  }
+}
+
+// First external trigger edge at or after the given cycle
+static uint64_t emu_next_ext_trig(uint64_t cycle) {
+  if (emu.config.ext_trig_freq_hz == 0) return EMU_NEVER;
+  uint64_t period = emu.config.spi_clk_freq_hz / emu.config.ext_trig_freq_hz;
+  if (period == 0) period = 1;
+  if (emu.trig.lockout > period) period = emu.trig.lockout;
+  return ((cycle + period - 1) / period) * period;
+}
+
+// Advance the trigger core to the given cycle
+static void emu_trig_advance(uint64_t now) {
+  emu_trig_t *t = &emu.trig;
+
+  while (emu.state == S_RUNNING) {
+    if (t->busy) {
+      // CANCEL and RESET_COUNT at the head of the buffer act during a wait
+      if (emu.trig_cmd.count > 0) {
+        uint64_t arrival;
+        uint32_t head = emu_fifo_peek(&emu.trig_cmd, 0, &arrival);
+        uint32_t code = head >> TRIG_CMD_CODE_SHIFT;
+        if (code == TRIG_CMD_CANCEL && arrival <= now) {
+          emu_fifo_pop(&emu.trig_cmd);
+          t->busy = false;
+          t->cursor = (arrival > t->cursor) ? arrival : t->cursor;
+          continue;
+        }
+        if (code == TRIG_CMD_RESET_COUNT && arrival <= now) {
+          emu_fifo_pop(&emu.trig_cmd);
+          t->counter = 0;
+          t->timer_running = false;
+          continue;
+        }
+      }
+
+      if (t->cmd == TRIG_CMD_EXPECT_EXT) {
+        uint64_t next = emu_next_ext_trig(t->last_fire + 1 > t->cursor ? t->last_fire + 1 : t->cursor);
+        while (t->remaining > 0 && next <= now) {
+          emu_trig_fire(next, t->log);
+          if (emu.state != S_RUNNING) return;
+          t->remaining--;
+          t->cursor = next;
+          next = emu_next_ext_trig(next + 1);
+        }
+        if (t->remaining > 0) return;
+      } else { // TRIG_CMD_DELAY
+        if (t->ready > now) return;
+        t->cursor = t->ready;
+      }
+      t->busy = false;
+    }
+
+    if (t->cursor > now || emu.trig_cmd.count == 0) return;
+
+    uint64_t arrival;
+    uint32_t word = emu_fifo_peek(&emu.trig_cmd, 0, &arrival);
+    if (arrival > now) return;
+    if (arrival > t->cursor) t->cursor = arrival;
+    emu_fifo_pop(&emu.trig_cmd);
+
+    uint32_t code = word >> TRIG_CMD_CODE_SHIFT;
+    bool log = (word >> TRIG_CMD_LOG_BIT) & 0x1;
+    uint32_t value = word & TRIG_CMD_VALUE_MASK;
+    switch (code) {
+      case TRIG_CMD_SYNC_CH:
+      case TRIG_CMD_FORCE_TRIG:
+        // Sync fires as soon as it is reached (the model's cores are always ready)
+        emu_trig_fire(t->cursor, log);
+        break;
+      case TRIG_CMD_SET_LOCKOUT:
+        t->lockout = value;
+        break;
+      case TRIG_CMD_EXPECT_EXT:
+        if (value > 0) {
+          t->busy = true;
+          t->cmd = code;
+          t->log = log;
+          t->remaining = value;
+        }
+        break;
+      case TRIG_CMD_DELAY:
+        if (value > 0) {
+          t->busy = true;
+          t->cmd = code;
+          t->ready = t->cursor + value;
+        }
+        break;
+      case TRIG_CMD_RESET_COUNT:
+        t->counter = 0;
+        t->timer_running = false;
+        break;
+      case TRIG_CMD_CANCEL:
+        break;
+      default:
+        emu_halt(STS_BAD_TRIG_CMD, 0);
+        return;
+    }
+  }
+}
+
+// Resolve a trigger wait; returns true (and the completion cycle) once enough triggers fired
+static bool emu_trig_wait_done(emu_trig_wait_t *wait, uint64_t *done_cycle) {
+  emu_trig_t *t = &emu.trig;
+  if (wait->needed == 0) {
+    *done_cycle = wait->start;
+    return true;
+  }
+
+  // Find the first trigger fired at or after the start of the wait
+  uint64_t oldest = (t->fire_total > EMU_TRIG_RING) ? t->fire_total - EMU_TRIG_RING : 0;
+  uint64_t idx = t->fire_total;
+  while (idx > oldest && t->fire_cycle[(idx - 1) % EMU_TRIG_RING] >= wait->start) {
+    idx--;
+  }
+
+  uint64_t last = idx + wait->needed - 1;
+  if (last >= t->fire_total) return false;
+  *done_cycle = t->fire_cycle[last % EMU_TRIG_RING];
+  return true;
+}
+
+//////////////////// DAC Core Model ////////////////////
+
+// Advance one DAC core to the given cycle
+static void emu_dac_advance(int board, uint64_t now) {
+  emu_dac_t *d = &emu.dac[board];
+  emu_fifo_t *fifo = &emu.dac_cmd[board];
+
+  while (emu.state == S_RUNNING) {
+    if (d->wait.active) {
+      // CANCEL at the head of the buffer interrupts a wait
+      if (fifo->count > 0) {
+        uint64_t arrival;
+        uint32_t head = emu_fifo_peek(fifo, 0, &arrival);
+        if ((head >> DAC_CMD_CMD_LSB) == DAC_CMD_CANCEL && arrival <= now) {
+          emu_fifo_pop(fifo);
+          d->wait.active = false;
+          d->cont = false;
+          if (arrival > d->cursor) d->cursor = arrival;
+          continue;
+        }
+      }
+      uint64_t done;
+      if (!emu_trig_wait_done(&d->wait, &done)) return;
+      d->wait.active = false;
+      if (done > d->cursor) d->cursor = done;
+    }
+
+    if (d->cursor > now) return;
+
+    // Command needed at d->cursor
+    uint64_t arrival = 0;
+    uint32_t word = (fifo->count > 0) ? emu_fifo_peek(fifo, 0, &arrival) : 0;
+    uint32_t code = word >> DAC_CMD_CMD_LSB;
+    uint32_t needed = (code == DAC_CMD_DAC_WR) ? 5 : 1;
+    uint64_t last_arrival = arrival;
+    if (fifo->count >= needed) emu_fifo_peek(fifo, needed - 1, &last_arrival);
+
+    if (fifo->count < needed || last_arrival > now) {
+      // Nothing complete yet; with CONTINUE the buffer has already underflowed
+      if (d->cont) {
+        emu_halt(STS_DAC_CMD_BUF_UNDERFLOW, board);
+      } else {
+        d->cursor = now;
+      }
+      return;
+    }
+    if (last_arrival > d->cursor) {
+      if (d->cont) {
+        emu_halt(STS_DAC_CMD_BUF_UNDERFLOW, board);
+        return;
+      }
+      d->cursor = last_arrival;
+    }
+
+    emu_fifo_pop(fifo);
+    emu.stats.dac_cmds[board]++;
+    bool trig = (word >> DAC_CMD_TRIG_BIT) & 0x1;
+    uint32_t value = word & 0x1FFFFFF;
+    d->cont = false;
+
+    switch (code) {
+      case DAC_CMD_NO_OP:
+        d->cont = (word >> DAC_CMD_CONT_BIT) & 0x1;
+        if (trig) {
+          d->wait = (emu_trig_wait_t){ .active = true, .needed = value, .start = d->cursor };
+        } else {
+          if (value < emu.config.dac_min_cycles) {
+            emu_halt(STS_DAC_DELAY_TOO_SHORT, board);
+            return;
+          }
+          d->cursor += value;
+        }
+        break;
+      case DAC_CMD_DAC_WR:
+        for (int i = 0; i < 8; i += 2) {
+          uint32_t data = emu_fifo_pop(fifo);
+          d->ch_vals[i] = (int16_t)(data & 0xFFFF);
+          d->ch_vals[i + 1] = (int16_t)(data >> 16);
+        }
+        d->cont = (word >> DAC_CMD_CONT_BIT) & 0x1;
+        if (trig) {
+          d->cursor += emu.config.dac_min_cycles;
+          d->wait = (emu_trig_wait_t){ .active = true, .needed = value, .start = d->cursor };
+        } else {
+          if (value < emu.config.dac_min_cycles) {
+            emu_halt(STS_DAC_DELAY_TOO_SHORT, board);
+            return;
+          }
+          d->cursor += value;
+        }
+        break;
+      case DAC_CMD_DAC_WR_CH:
+        d->ch_vals[(word >> 16) & 0x7] = (int16_t)(word & 0xFFFF);
+        d->cursor += DAC_CH_WRITE_CYCLES(emu.config.dac_min_cycles);
+        break;
+      case DAC_CMD_SET_CAL:
+        d->cal[(word >> 16) & 0x7] = (int16_t)(word & 0xFFFF);
+        break;
+      case DAC_CMD_GET_CAL: {
+        uint32_t ch = (word >> 16) & 0x7;
+        uint32_t data = ((uint32_t)DAC_CAL_DATA << 28) | (ch << 16) | (uint16_t)d->cal[ch];
+        if (!emu_fifo_push(&emu.dac_data[board], data, d->cursor)) {
+          emu_halt(STS_DAC_DATA_BUF_OVERFLOW, board);
+          return;
+        }
+        break;
+      }
+      case DAC_CMD_ZERO:
+        memset(d->ch_vals, 0, sizeof(d->ch_vals));
+        d->cursor += emu.config.dac_min_cycles;
+        break;
+      case DAC_CMD_CANCEL:
+        break;
+      default:
+        emu_halt(STS_BAD_DAC_CMD, board);
+        return;
+    }
+  }
+}
+
+//////////////////// ADC Core Model ////////////////////
+
+// Perform one read of the current ADC_RD/ADC_RD_CH command at a->cursor
+static bool emu_adc_read(int board) {
+  emu_adc_t *a = &emu.adc[board];
+  emu_fifo_t *data = &emu.adc_data[board];
+  const int16_t *loopback = emu.dac[board].ch_vals; // ADC sees the DAC outputs
+
+  if ((a->cmd_word >> ADC_CMD_CMD_LSB) == ADC_CMD_ADC_RD_CH) {
+    uint32_t ch = a->cmd_word & 0x7;
+    if (!emu_fifo_push(data, (uint16_t)loopback[ch], a->cursor)) {
+      emu_halt(STS_ADC_DATA_BUF_OVERFLOW, board);
+      return false;
+    }
+    emu.stats.adc_words[board]++;
+    a->cursor += emu.config.adc_min_cycles;
+    return true;
+  }
+
+  for (int i = 0; i < 8; i += 2) {
+    uint32_t word = ((uint32_t)(uint16_t)loopback[a->order[i + 1]] << 16) |
+                    (uint32_t)(uint16_t)loopback[a->order[i]];
+    if (!emu_fifo_push(data, word, a->cursor)) {
+      emu_halt(STS_ADC_DATA_BUF_OVERFLOW, board);
+      return false;
+    }
+  }
+  emu.stats.adc_words[board] += 4;
+
+  bool trig = (a->cmd_word >> ADC_CMD_TRIG_BIT) & 0x1;
+  uint32_t value = a->cmd_word & 0x1FFFFFF;
+  if (trig) {
+    a->cursor += emu.config.adc_min_cycles;
+    a->wait = (emu_trig_wait_t){ .active = true, .needed = value, .start = a->cursor };
+  } else {
+    if (value < emu.config.adc_min_cycles) {
+      emu_halt(STS_ADC_DELAY_TOO_SHORT, board);
+      return false;
+    }
+    a->cursor += value;
+  }
+  return true;
+}
+
+// Advance one ADC core to the given cycle
+static void emu_adc_advance(int board, uint64_t now) {
+  emu_adc_t *a = &emu.adc[board];
+  emu_fifo_t *fifo = &emu.adc_cmd[board];
+
+  while (emu.state == S_RUNNING) {
+    if (a->wait.active) {
+      // CANCEL at the head of the buffer interrupts a wait
+      if (fifo->count > 0) {
+        uint64_t arrival;
+        uint32_t head = emu_fifo_peek(fifo, 0, &arrival);
+        if ((head >> ADC_CMD_CMD_LSB) == ADC_CMD_CANCEL && arrival <= now) {
+          emu_fifo_pop(fifo);
+          a->wait.active = false;
+          a->reads_left = 0;
+          a->cont = false;
+          if (arrival > a->cursor) a->cursor = arrival;
+          continue;
+        }
+      }
+      uint64_t done;
+      if (!emu_trig_wait_done(&a->wait, &done)) return;
+      a->wait.active = false;
+      if (done > a->cursor) a->cursor = done;
+    }
+
+    if (a->cursor > now) return;
+
+    // Continue a repeated read
+    if (a->reads_left > 0) {
+      a->reads_left--;
+      if (!emu_adc_read(board)) return;
+      continue;
+    }
+
+    // Command needed at a->cursor
+    uint64_t arrival = 0;
+    uint32_t word = (fifo->count > 0) ? emu_fifo_peek(fifo, 0, &arrival) : 0;
+    uint32_t code = word >> ADC_CMD_CMD_LSB;
+    bool repeat = (code == ADC_CMD_ADC_RD || code == ADC_CMD_ADC_RD_CH) && ((word >> ADC_CMD_REPEAT_BIT) & 0x1);
+    uint32_t needed = repeat ? 2 : 1;
+    uint64_t last_arrival = arrival;
+    if (fifo->count >= needed) emu_fifo_peek(fifo, needed - 1, &last_arrival);
+
+    if (fifo->count < needed || last_arrival > now) {
+      if (a->cont) {
+        emu_halt(STS_ADC_CMD_BUF_UNDERFLOW, board);
+      } else {
+        a->cursor = now;
+      }
+      return;
+    }
+    if (last_arrival > a->cursor) {
+      if (a->cont) {
+        emu_halt(STS_ADC_CMD_BUF_UNDERFLOW, board);
+        return;
+      }
+      a->cursor = last_arrival;
+    }
+
+    emu_fifo_pop(fifo);
+    bool trig = (word >> ADC_CMD_TRIG_BIT) & 0x1;
+    uint32_t value = word & 0x1FFFFFF;
+    a->cont = false;
+
+    switch (code) {
+      case ADC_CMD_NO_OP:
+        a->cont = (word >> ADC_CMD_CONT_BIT) & 0x1;
+        if (trig) {
+          a->wait = (emu_trig_wait_t){ .active = true, .needed = value, .start = a->cursor };
+        } else {
+          a->cursor += value;
+        }
+        break;
+      case ADC_CMD_SET_ORD:
+        for (int i = 0; i < 8; i++) a->order[i] = (word >> (3 * i)) & 0x7;
+        break;
+      case ADC_CMD_ADC_RD:
+      case ADC_CMD_ADC_RD_CH:
+        a->cmd_word = word;
+        a->reads_left = repeat ? emu_fifo_pop(fifo) : 0;
+        if (code == ADC_CMD_ADC_RD) a->cont = (word >> ADC_CMD_CONT_BIT) & 0x1;
+        if (!emu_adc_read(board)) return;
+        break;
+      case ADC_CMD_CANCEL:
+        break;
+      default:
+        emu_halt(STS_BAD_ADC_CMD, board);
+        return;
+    }
+  }
+}
+
+//////////////////// Register Map ////////////////////
+
+// Bring all core models up to the current emulated time
+static void emu_advance(void) {
+  uint64_t now = emu_now_cycles();
+  emu.stats.spi_cycles = now;
+  if (emu.state != S_RUNNING) return;
+
+  emu_trig_advance(now);
+  for (int b = 0; b < 8; b++) {
+    if (!emu_board_present(b)) continue;
+    emu_dac_advance(b, now);
+    emu_adc_advance(b, now);
+  }
+}
+
+// Update the hardware manager state after an enable register write
+static void emu_update_state(void) {
+  if (emu.ctrl_enable == 0) {
+    if (emu.state == S_RUNNING) emu.status_code = STS_PS_SHUTDOWN;
+    emu.state = S_IDLE;
+    return;
+  }
+  if (emu.state == S_HALTED) return;
+  if (emu.power_enable == 0) {
+    emu.state = S_WAIT_FOR_POW_EN;
+    emu.status_code = STS_OK;
+    return;
+  }
+  if (emu.state != S_RUNNING) {
+    emu.state = S_RUNNING;
+    emu.status_code = STS_OK;
+    emu.status_board = 0;
+    emu_reset_cores(emu_now_cycles());
+  }
+}
+
+// Apply a buffer reset mask (DAC board N = bit 2N, ADC board N = bit 2N+1, trigger = bit 16)
+static void emu_buffer_reset(uint32_t mask, bool data) {
+  for (int b = 0; b < 8; b++) {
+    if ((mask >> (2 * b)) & 0x1) emu_fifo_clear(data ? &emu.dac_data[b] : &emu.dac_cmd[b]);
+    if ((mask >> (2 * b + 1)) & 0x1) emu_fifo_clear(data ? &emu.adc_data[b] : &emu.adc_cmd[b]);
+  }
+  if ((mask >> 16) & 0x1) emu_fifo_clear(data ? &emu.trig_data : &emu.trig_cmd);
+}
+
+// Read an emulated status register word
+static uint32_t emu_sys_sts_read(size_t offset) {
+  if (offset == HW_STS_REG_OFFSET) {
+    return (emu.state & 0xF) | ((emu.status_code & 0x1FFFFFF) << 4) | ((emu.status_board & 0x7) << 29);
+  }
+  for (int b = 0; b < 8; b++) {
+    bool present = emu_board_present(b);
+    if (offset == (size_t)DAC_CMD_FIFO_STS_OFFSET(b)) return emu_fifo_status(&emu.dac_cmd[b], present);
+    if (offset == (size_t)ADC_CMD_FIFO_STS_OFFSET(b)) return emu_fifo_status(&emu.adc_cmd[b], present);
+    if (offset == (size_t)DAC_DATA_FIFO_STS_OFFSET(b)) return emu_fifo_status(&emu.dac_data[b], present);
+    if (offset == (size_t)ADC_DATA_FIFO_STS_OFFSET(b)) return emu_fifo_status(&emu.adc_data[b], present);
+  }
+  switch (offset) {
+    case TRIG_CMD_FIFO_STS_OFFSET: return emu_fifo_status(&emu.trig_cmd, true);
+    case TRIG_DATA_FIFO_STS_OFFSET: return emu_fifo_status(&emu.trig_data, true);
+    case SPI_CLK_FREQ_OFFSET: return emu.config.spi_clk_freq_hz;
+    case TRIG_COUNTER_OFFSET: return emu.trig.counter;
+    case DEBUG_REG_OFFSET: return (1u << DEBUG_SPI_CLK_LOCKED_BIT);
+    case DEBUG_DAC_DELAY_TOO_SHORT_TIME_OFFSET: return emu.config.dac_min_cycles - 1;
+    case DEBUG_ADC_DELAY_TOO_SHORT_TIME_OFFSET: return emu.config.adc_min_cycles - 1;
+    default: return 0;
+  }
+}
+
+// Find the region containing an address
+static emu_region_t *emu_find_region(volatile uint32_t *addr, size_t *offset) {
+  for (int i = 0; i < emu.region_count; i++) {
+    emu_region_t *r = &emu.regions[i];
+    if ((uint32_t *)addr >= r->mem && (uint32_t *)addr < r->mem + r->wordcount) {
+      *offset = (size_t)((uint32_t *)addr - r->mem);
+      return r;
+    }
+  }
+  return NULL;
+}
+
+// Backend map function
+static uint32_t *emu_map(uint32_t base_addr, size_t wordcount, const char *name, bool verbose) {
+  pthread_mutex_lock(&emu.lock);
+  if (emu.region_count >= EMU_MAX_REGIONS) {
+    pthread_mutex_unlock(&emu.lock);
+    fprintf(stderr, "Shim Emulator: Too many mapped regions (max %d)\n", EMU_MAX_REGIONS);
+    return NULL;
+  }
+
+  // Round up to whole pages like the /dev/mem mapping does
+  long page_size = sysconf(_SC_PAGESIZE);
+  size_t words = (((wordcount * 4) + page_size - 1) / page_size) * page_size / 4;
+  emu_region_t *r = &emu.regions[emu.region_count];
+  r->mem = calloc(words, sizeof(uint32_t));
+  if (r->mem == NULL) {
+    pthread_mutex_unlock(&emu.lock);
+    perror("calloc");
+    return NULL;
+  }
+  r->wordcount = words;
+  r->board = 0;
+  r->kind = EMU_REGION_OTHER;
+
+  if (base_addr == SYS_CTRL_BASE) r->kind = EMU_REGION_SYS_CTRL;
+  else if (base_addr == SYS_STS) r->kind = EMU_REGION_SYS_STS;
+  else if (base_addr == SPI_CLK_BASE) r->kind = EMU_REGION_SPI_CLK;
+  else if (base_addr == TRIG_FIFO) r->kind = EMU_REGION_TRIG_FIFO;
+  for (int b = 0; b < 8; b++) {
+    if (base_addr == (uint32_t)DAC_FIFO(b)) { r->kind = EMU_REGION_DAC_FIFO; r->board = b; }
+    if (base_addr == (uint32_t)ADC_FIFO(b)) { r->kind = EMU_REGION_ADC_FIFO; r->board = b; }
+  }
+  if (r->kind == EMU_REGION_SYS_CTRL) {
+    r->mem[DO_DAC_PRE_DELAY_OFFSET] = 1; // HDL reset value (DO_DAC_PRE_DELAY)
+  }
+  emu.region_count++;
+  pthread_mutex_unlock(&emu.lock);
+
+  if (verbose) {
+    printf("Shim Emulator: Mapped [%s] at 0x%08" PRIx32 " (%zu words)\n", name, base_addr, words);
+  }
+  return r->mem;
+}
+
+// Backend read function
+static uint32_t emu_read32(volatile uint32_t *addr) {
+  uint32_t value = 0;
+  size_t offset;
+
+  pthread_mutex_lock(&emu.lock);
+  emu.stats.mmio_reads++;
+  emu_advance();
+  emu_region_t *r = emu_find_region(addr, &offset);
+  if (r == NULL) {
+    pthread_mutex_unlock(&emu.lock);
+    return 0;
+  }
+
+  switch (r->kind) {
+    case EMU_REGION_SYS_STS:
+      value = emu_sys_sts_read(offset);
+      break;
+    case EMU_REGION_DAC_FIFO:
+      if (emu.dac_data[r->board].count == 0) emu_halt(STS_DAC_DATA_BUF_UNDERFLOW, r->board);
+      else value = emu_fifo_pop(&emu.dac_data[r->board]);
+      break;
+    case EMU_REGION_ADC_FIFO:
+      if (emu.adc_data[r->board].count == 0) emu_halt(STS_ADC_DATA_BUF_UNDERFLOW, r->board);
+      else value = emu_fifo_pop(&emu.adc_data[r->board]);
+      break;
+    case EMU_REGION_TRIG_FIFO:
+      if (emu.trig_data.count == 0) emu_halt(STS_TRIG_DATA_BUF_UNDERFLOW, 0);
+      else value = emu_fifo_pop(&emu.trig_data);
+      break;
+    default:
+      value = r->mem[offset];
+      break;
+  }
+  pthread_mutex_unlock(&emu.lock);
+  return value;
+}
+
+// Backend burst read function (one lock and time update per burst)
+static void emu_read32_burst(volatile uint32_t *addr, uint32_t *dst, size_t count) {
+  size_t offset = 0;
+
+  pthread_mutex_lock(&emu.lock);
+  emu.stats.mmio_reads += count;
+  emu_advance();
+  emu_region_t *r = emu_find_region(addr, &offset);
+  emu_fifo_t *fifo = NULL;
+  uint32_t sts_code = 0;
+  int board = 0;
+  if (r != NULL) {
+    board = r->board;
+    if (r->kind == EMU_REGION_DAC_FIFO) { fifo = &emu.dac_data[board]; sts_code = STS_DAC_DATA_BUF_UNDERFLOW; }
+    if (r->kind == EMU_REGION_ADC_FIFO) { fifo = &emu.adc_data[board]; sts_code = STS_ADC_DATA_BUF_UNDERFLOW; }
+    if (r->kind == EMU_REGION_TRIG_FIFO) { fifo = &emu.trig_data; sts_code = STS_TRIG_DATA_BUF_UNDERFLOW; }
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    if (fifo == NULL) {
+      dst[i] = (r != NULL) ? r->mem[offset] : 0;
+    } else if (fifo->count == 0) {
+      emu_halt(sts_code, board);
+      dst[i] = 0;
+    } else {
+      dst[i] = emu_fifo_pop(fifo);
+    }
+  }
+  pthread_mutex_unlock(&emu.lock);
+}
+
+// Backend block read function (one lock and time update per block, so status snapshots are consistent)
+static void emu_read32_block(volatile uint32_t *addr, uint32_t *dst, size_t count) {
+  size_t offset = 0;
+
+  pthread_mutex_lock(&emu.lock);
+  emu.stats.mmio_reads += count;
+  emu_advance();
+  emu_region_t *r = emu_find_region(addr, &offset);
+  for (size_t i = 0; i < count; i++) {
+    if (r == NULL || offset + i >= r->wordcount) {
+      dst[i] = 0;
+    } else if (r->kind == EMU_REGION_SYS_STS) {
+      dst[i] = emu_sys_sts_read(offset + i);
+    } else {
+      dst[i] = r->mem[offset + i];
+    }
+  }
+  pthread_mutex_unlock(&emu.lock);
+}
+
+// Apply one write to a region (emu.lock held)
+static void emu_write_locked(emu_region_t *r, size_t offset, uint32_t value) {
+  uint64_t now = emu.stats.spi_cycles;
+  switch (r->kind) {
+    case EMU_REGION_SYS_CTRL:
+      r->mem[offset] = value;
+      if (offset == CTRL_ENABLE_OFFSET) {
+        emu.ctrl_enable = value;
+        emu_update_state();
+      } else if (offset == POWER_ENABLE_OFFSET) {
+        emu.power_enable = value;
+        emu_update_state();
+      } else if (offset == CMD_BUF_RESET_OFFSET) {
+        emu_buffer_reset(value, false);
+      } else if (offset == DATA_BUF_RESET_OFFSET) {
+        emu_buffer_reset(value, true);
+      }
+      break;
+    case EMU_REGION_DAC_FIFO:
+      if (emu_board_present(r->board) && !emu_fifo_push(&emu.dac_cmd[r->board], value, now)) {
+        emu_halt(STS_DAC_CMD_BUF_OVERFLOW, r->board);
+      }
+      break;
+    case EMU_REGION_ADC_FIFO:
+      if (emu_board_present(r->board) && !emu_fifo_push(&emu.adc_cmd[r->board], value, now)) {
+        emu_halt(STS_ADC_CMD_BUF_OVERFLOW, r->board);
+      }
+      break;
+    case EMU_REGION_TRIG_FIFO:
+      if (!emu_fifo_push(&emu.trig_cmd, value, now)) {
+        emu_halt(STS_TRIG_CMD_BUF_OVERFLOW, 0);
+      }
+      break;
+    case EMU_REGION_SYS_STS:
+      break; // Read-only
+    default:
+      r->mem[offset] = value;
+      break;
+  }
+}
+
+// Backend write function
+static void emu_write32(volatile uint32_t *addr, uint32_t value) {
+  size_t offset;
+
+  pthread_mutex_lock(&emu.lock);
+  emu.stats.mmio_writes++;
+  emu_advance();
+  emu_region_t *r = emu_find_region(addr, &offset);
+  if (r != NULL) {
+    emu_write_locked(r, offset, value);
+  }
+  pthread_mutex_unlock(&emu.lock);
+}
+
+// Backend burst write function (one lock and time update per burst)
+static void emu_write32_burst(volatile uint32_t *addr, const uint32_t *src, size_t count) {
+  size_t offset;
+
+  pthread_mutex_lock(&emu.lock);
+  emu.stats.mmio_writes += count;
+  emu_advance();
+  emu_region_t *r = emu_find_region(addr, &offset);
+  if (r != NULL) {
+    for (size_t i = 0; i < count; i++) {
+      emu_write_locked(r, offset, src[i]);
+    }
+  }
+  pthread_mutex_unlock(&emu.lock);
+}
+
+static const mmio_backend_t emu_backend = {
+  .name = "shim emulator",
+  .map = emu_map,
+  .read32 = emu_read32,
+  .write32 = emu_write32,
+  .read32_burst = emu_read32_burst,
+  .write32_burst = emu_write32_burst,
+  .read32_block = emu_read32_block
+};
+
+//////////////////// Public Interface ////////////////////
+
+// Fill a configuration with the default settings
+void shim_emu_default_config(shim_emu_config_t *config) {
+  config->spi_clk_freq_hz = SHIM_EMU_DEFAULT_SPI_CLK_FREQ_HZ;
+  config->ext_trig_freq_hz = SHIM_EMU_DEFAULT_EXT_TRIG_FREQ_HZ;
+  config->dac_min_cycles = SHIM_EMU_DEFAULT_DAC_MIN_CYCLES;
+  config->adc_min_cycles = SHIM_EMU_DEFAULT_ADC_MIN_CYCLES;
+  config->board_mask = 0xFF;
+  config->verbose = false;
+}
+
+// Initialize the emulator and return its MMIO backend
+const mmio_backend_t *shim_emu_init(const shim_emu_config_t *config) {
+  if (emu.initialized) return &emu_backend;
+
+  pthread_mutex_init(&emu.lock, NULL);
+  emu.config = *config;
+  if (emu.config.spi_clk_freq_hz == 0) emu.config.spi_clk_freq_hz = SHIM_EMU_DEFAULT_SPI_CLK_FREQ_HZ;
+  if (emu.config.dac_min_cycles == 0) emu.config.dac_min_cycles = 1;
+  if (emu.config.adc_min_cycles == 0) emu.config.adc_min_cycles = 1;
+  emu.base_ns = emu_now_ns();
+  emu.base_cycles = 0;
+
+  for (int b = 0; b < 8; b++) {
+    emu_fifo_init(&emu.dac_cmd[b], DAC_CMD_FIFO_WORDCOUNT);
+    emu_fifo_init(&emu.dac_data[b], DAC_DATA_FIFO_WORDCOUNT);
+    emu_fifo_init(&emu.adc_cmd[b], ADC_CMD_FIFO_WORDCOUNT);
+    emu_fifo_init(&emu.adc_data[b], ADC_DATA_FIFO_WORDCOUNT);
+  }
+  emu_fifo_init(&emu.trig_cmd, TRIG_CMD_FIFO_WORDCOUNT);
+  emu_fifo_init(&emu.trig_data, TRIG_DATA_FIFO_WORDCOUNT);
+
+  emu.state = S_IDLE;
+  emu.status_code = STS_EMPTY;
+  emu_reset_cores(0);
+  emu.initialized = true;
+
+  if (emu.config.verbose) {
+    printf("Shim Emulator: SPI clock %" PRIu32 " Hz, external triggers %" PRIu32 " Hz, board mask 0x%02X\n",
+           emu.config.spi_clk_freq_hz, emu.config.ext_trig_freq_hz, emu.config.board_mask);
+  }
+  return &emu_backend;
+}
+
+// Change the emulated SPI clock rate at runtime
+void shim_emu_set_spi_clk_freq(uint32_t freq_hz) {
+  if (!emu.initialized || freq_hz == 0) return;
+  pthread_mutex_lock(&emu.lock);
+  // Rebase so elapsed cycles stay continuous across the rate change
+  emu.base_cycles = emu_now_cycles();
+  emu.base_ns = emu_now_ns();
+  emu.config.spi_clk_freq_hz = freq_hz;
+  pthread_mutex_unlock(&emu.lock);
+}
+
+// Change the emulated external trigger rate at runtime
+void shim_emu_set_ext_trig_freq(uint32_t freq_hz) {
+  if (!emu.initialized) return;
+  pthread_mutex_lock(&emu.lock);
+  emu.config.ext_trig_freq_hz = freq_hz;
+  pthread_mutex_unlock(&emu.lock);
+}
+
+// Copy the emulator counters
+void shim_emu_get_stats(shim_emu_stats_t *stats) {
+  if (!emu.initialized) {
+    memset(stats, 0, sizeof(*stats));
+    return;
+  }
+  pthread_mutex_lock(&emu.lock);
+  *stats = emu.stats;
+  pthread_mutex_unlock(&emu.lock);
+}
+
+// Print the emulator configuration and counters
+void shim_emu_print_stats(void) {
+  if (!emu.initialized) {
+    printf("Shim emulator is not active.\n");
+    return;
+  }
+  shim_emu_stats_t stats;
+  shim_emu_get_stats(&stats);
+
+  printf("Shim Emulator:\n");
+  printf("  SPI clock: %" PRIu32 " Hz, external triggers: %" PRIu32 " Hz\n",
+         emu.config.spi_clk_freq_hz, emu.config.ext_trig_freq_hz);
+  printf("  Min delays: DAC %" PRIu32 " cycles, ADC %" PRIu32 " cycles\n",
+         emu.config.dac_min_cycles, emu.config.adc_min_cycles);
+  printf("  Emulated SPI cycles: %" PRIu64 "\n", stats.spi_cycles);
+  printf("  MMIO reads: %" PRIu64 ", writes: %" PRIu64 "\n", stats.mmio_reads, stats.mmio_writes);
+  for (int b = 0; b < 8; b++) {
+    if (stats.dac_cmds[b] == 0 && stats.adc_words[b] == 0) continue;
+    printf("  Board %d: %" PRIu64 " DAC commands, %" PRIu64 " ADC words\n", b, stats.dac_cmds[b], stats.adc_words[b]);
+  }
+  printf("  Trigger data words: %" PRIu64 "\n", stats.trig_words);
+}
@@ -26,6 +26,7 @@ struct sys_ctrl_t create_sys_ctrl(bool verbose) {
   sys_ctrl.debug                   = sys_ctrl_ptr + DEBUG_OFFSET;
   sys_ctrl.mosi_sck_pol            = sys_ctrl_ptr + MOSI_SCK_POL_OFFSET;
   sys_ctrl.miso_sck_pol            = sys_ctrl_ptr + MISO_SCK_POL_OFFSET;
+  sys_ctrl.do_dac_pre_delay        = sys_ctrl_ptr + DO_DAC_PRE_DELAY_OFFSET;
   
   return sys_ctrl;
 }
@@ -35,7 +36,7 @@ void sys_ctrl_turn_ctrl_on(struct sys_ctrl_t *sys_ctrl, bool verbose) {
   if (verbose) {
     printf("Turning on the control board...\n");
   }
-  *(sys_ctrl->ctrl_enable) = 1; // Set the system enable register to 1
+  mmio_write32(sys_ctrl->ctrl_enable, 1); // Set the system enable register to 1
 }
 
 // Turn the power board on
@@ -43,7 +44,7 @@ void sys_ctrl_turn_pow_on(struct sys_ctrl_t *sys_ctrl, bool verbose) {
   if (verbose) {
     printf("Turning on the power board...\n");
   }
-  *(sys_ctrl->power_enable) = 1; // Set the power enable register to 1
+  mmio_write32(sys_ctrl->power_enable, 1); // Set the power enable register to 1
 }
 
 // Turn the system off
@@ -51,8 +52,8 @@ void sys_ctrl_turn_off(struct sys_ctrl_t *sys_ctrl, bool verbose) {
   if (verbose) {
     printf("Turning off the system...\n");
   }
-  *(sys_ctrl->ctrl_enable) = 0; // Set the system enable register to 0
-  *(sys_ctrl->power_enable) = 0;  // Set the power enable register to 0
+  mmio_write32(sys_ctrl->ctrl_enable, 0); // Set the system enable register to 0
+  mmio_write32(sys_ctrl->power_enable, 0);  // Set the power enable register to 0
 }
 
 // Set the boot_test_skip register to a 16-bit value
@@ -61,9 +62,9 @@ void sys_ctrl_set_boot_test_skip(struct sys_ctrl_t *sys_ctrl, uint16_t value, bo
     printf("Setting boot_test_skip to 0x%" PRIx32 "\n", value);
   }
   // Write the 16-bit value to the boot_test_skip register
-  *(sys_ctrl->boot_test_skip) = (uint32_t)value;
+  mmio_write32(sys_ctrl->boot_test_skip, (uint32_t)value);
   if (verbose) {
-    printf("boot_test_skip set to 0x%" PRIx32 "\n", *(sys_ctrl->boot_test_skip));
+    printf("boot_test_skip set to 0x%" PRIx32 "\n", mmio_read32(sys_ctrl->boot_test_skip));
   }
 }
 
@@ -73,9 +74,9 @@ void sys_ctrl_set_debug(struct sys_ctrl_t *sys_ctrl, uint16_t value, bool verbos
     printf("Setting debug to 0x%" PRIx32 "\n", value);
   }
   // Write the 16-bit value to the debug register
-  *(sys_ctrl->debug) = (uint32_t)value;
+  mmio_write32(sys_ctrl->debug, (uint32_t)value);
   if (verbose) {
-    printf("debug set to 0x%" PRIx32 "\n", *(sys_ctrl->debug));
+    printf("debug set to 0x%" PRIx32 "\n", mmio_read32(sys_ctrl->debug));
   }
 }
 
@@ -89,9 +90,9 @@ void sys_ctrl_set_cmd_buf_reset(struct sys_ctrl_t *sys_ctrl, uint32_t mask, bool
     printf("Setting cmd_buf_reset to 0x%" PRIx32 "\n", mask);
   }
   // Write the 17-bit mask to the cmd_buf_reset register
-  *(sys_ctrl->cmd_buf_reset) = mask & 0x1FFFF; // Mask to 17 bits
+  mmio_write32(sys_ctrl->cmd_buf_reset, mask & 0x1FFFF); // Mask to 17 bits
   if (verbose) {
-    printf("cmd_buf_reset set to 0x%" PRIx32 "\n", *(sys_ctrl->cmd_buf_reset));
+    printf("cmd_buf_reset set to 0x%" PRIx32 "\n", mmio_read32(sys_ctrl->cmd_buf_reset));
   }
 }
 
@@ -105,41 +106,41 @@ void sys_ctrl_set_data_buf_reset(struct sys_ctrl_t *sys_ctrl, uint32_t mask, boo
     printf("Setting data_buf_reset to 0x%" PRIx32 "\n", mask);
   }
   // Write the 17-bit mask to the data_buf_reset register
-  *(sys_ctrl->data_buf_reset) = mask & 0x1FFFF; // Mask to 17 bits
+  mmio_write32(sys_ctrl->data_buf_reset, mask & 0x1FFFF); // Mask to 17 bits
   if (verbose) {
-    printf("data_buf_reset set to 0x%" PRIx32 "\n", *(sys_ctrl->data_buf_reset));
+    printf("data_buf_reset set to 0x%" PRIx32 "\n", mmio_read32(sys_ctrl->data_buf_reset));
   }
 }
 
 // Invert the MOSI SCK polarity register
 void sys_ctrl_invert_mosi_sck(struct sys_ctrl_t *sys_ctrl, bool verbose) {
-  uint32_t current_value = *(sys_ctrl->mosi_sck_pol);
+  uint32_t current_value = mmio_read32(sys_ctrl->mosi_sck_pol);
   uint32_t new_value = current_value ^ 0x1; // Invert the last bit
   
   if (verbose) {
     printf("Inverting MOSI SCK polarity from 0x%" PRIx32 " to 0x%" PRIx32 "\n", current_value, new_value);
   }
   
-  *(sys_ctrl->mosi_sck_pol) = new_value;
+  mmio_write32(sys_ctrl->mosi_sck_pol, new_value);
   
   if (verbose) {
-    printf("MOSI SCK polarity set to 0x%" PRIx32 "\n", *(sys_ctrl->mosi_sck_pol));
+    printf("MOSI SCK polarity set to 0x%" PRIx32 "\n", mmio_read32(sys_ctrl->mosi_sck_pol));
   }
 }
 
 // Invert the MISO SCK polarity register
 void sys_ctrl_invert_miso_sck(struct sys_ctrl_t *sys_ctrl, bool verbose) {
-  uint32_t current_value = *(sys_ctrl->miso_sck_pol);
+  uint32_t current_value = mmio_read32(sys_ctrl->miso_sck_pol);
   uint32_t new_value = current_value ^ 0x1; // Invert the last bit
   
   if (verbose) {
     printf("Inverting MISO SCK polarity from 0x%" PRIx32 " to 0x%" PRIx32 "\n", current_value, new_value);
   }
   
-  *(sys_ctrl->miso_sck_pol) = new_value;
+  mmio_write32(sys_ctrl->miso_sck_pol, new_value);
   
   if (verbose) {
-    printf("MISO SCK polarity set to 0x%" PRIx32 "\n", *(sys_ctrl->miso_sck_pol));
+    printf("MISO SCK polarity set to 0x%" PRIx32 "\n", mmio_read32(sys_ctrl->miso_sck_pol));
   }
 }
 
@@ -149,9 +150,9 @@ void sys_ctrl_set_integ_window(struct sys_ctrl_t *sys_ctrl, uint32_t value, bool
     printf("Setting integ_window to 0x%" PRIx32 "\n", value);
   }
   // Write the 32-bit value to the integrator window register
-  *(sys_ctrl->integ_window) = value;
+  mmio_write32(sys_ctrl->integ_window, value);
   if (verbose) {
-    printf("integ_window set to 0x%" PRIx32 "\n", *(sys_ctrl->integ_window));
+    printf("integ_window set to 0x%" PRIx32 "\n", mmio_read32(sys_ctrl->integ_window));
   }
 }
 
@@ -161,9 +162,9 @@ void sys_ctrl_set_integ_threshold_average(struct sys_ctrl_t *sys_ctrl, uint32_t
     printf("Setting integ_threshold_average to 0x%" PRIx32 "\n", value);
   }
   // Write the 32-bit value to the integrator threshold average register
-  *(sys_ctrl->integ_threshold_average) = value;
+  mmio_write32(sys_ctrl->integ_threshold_average, value);
   if (verbose) {
-    printf("integ_threshold_average set to 0x%" PRIx32 "\n", *(sys_ctrl->integ_threshold_average));
+    printf("integ_threshold_average set to 0x%" PRIx32 "\n", mmio_read32(sys_ctrl->integ_threshold_average));
   }
 }
 
@@ -173,8 +174,17 @@ void sys_ctrl_set_integ_enable(struct sys_ctrl_t *sys_ctrl, uint32_t value, bool
     printf("Setting integ_enable to 0x%" PRIx32 "\n", value);
   }
   // Write the 32-bit value to the integrator enable register
-  *(sys_ctrl->integ_enable) = value;
+  mmio_write32(sys_ctrl->integ_enable, value);
   if (verbose) {
-    printf("integ_enable set to 0x%" PRIx32 "\n", *(sys_ctrl->integ_enable));
+    printf("integ_enable set to 0x%" PRIx32 "\n", mmio_read32(sys_ctrl->integ_enable));
   }
 }
+
+// Read the DAC pre-delay register (true = delayed DAC writes land at the end of the delay)
+bool sys_ctrl_get_dac_pre_delay(struct sys_ctrl_t *sys_ctrl, bool verbose) {
+  uint32_t value = mmio_read32(sys_ctrl->do_dac_pre_delay);
+  if (verbose) {
+    printf("do_dac_pre_delay is 0x%" PRIx32 "\n", value);
+  }
+  return (value & 0x1) != 0;
+}
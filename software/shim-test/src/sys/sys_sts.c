@@ -4,6 +4,7 @@
 #include <unistd.h> // For read, write, close functions
 #include <fcntl.h> // For open function
 #include <pthread.h> // For pthread functions
+#include <time.h> // For clock_gettime
 #include "sys_sts.h"
 #include "map_memory.h"
 
@@ -49,31 +50,65 @@ struct sys_sts_t create_sys_sts(bool verbose) {
   return sys_sts;
 }
 
+// Copy the whole status block into a snapshot in one pass
+void sys_sts_snapshot(struct sys_sts_t *sys_sts, struct sys_sts_snapshot_t *snap) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  snap->timestamp_ns = (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+  mmio_read32_block(sys_sts->hw_status_reg, snap->words, SYS_STS_WORDCOUNT);
+}
+
+// Copy only the words in mask (bit n = word n) into a snapshot in one pass (others are left as they were)
+void sys_sts_snapshot_words(struct sys_sts_t *sys_sts, struct sys_sts_snapshot_t *snap, uint64_t mask) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  snap->timestamp_ns = (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+  for (uint32_t i = 0; i < SYS_STS_WORDCOUNT; i++) {
+    if (mask & (1ull << i)) {
+      snap->words[i] = mmio_read32(sys_sts->hw_status_reg + i);
+    }
+  }
+}
+
+// Bitmask of boards (bit n = board n) whose DAC and ADC command and data FIFOs are all present
+uint8_t sys_sts_snap_connected_boards(const struct sys_sts_snapshot_t *snap) {
+  uint8_t mask = 0;
+  for (uint8_t board = 0; board < 8; board++) {
+    if (FIFO_PRESENT(sys_sts_snap_dac_cmd_fifo_status(snap, board)) &&
+        FIFO_PRESENT(sys_sts_snap_dac_data_fifo_status(snap, board)) &&
+        FIFO_PRESENT(sys_sts_snap_adc_cmd_fifo_status(snap, board)) &&
+        FIFO_PRESENT(sys_sts_snap_adc_data_fifo_status(snap, board))) {
+      mask |= (uint8_t)(1u << board);
+    }
+  }
+  return mask;
+}
+
 // Get hardware status register value
 uint32_t sys_sts_get_hw_status(struct sys_sts_t *sys_sts, bool verbose) {
   if (verbose) {
     printf("Reading hardware status register...\n");
-    printf("Hardware status raw: 0x%" PRIx32 "\n", *(sys_sts->hw_status_reg));
+    printf("Hardware status raw: 0x%" PRIx32 "\n", mmio_read32(sys_sts->hw_status_reg));
   }
-  return *(sys_sts->hw_status_reg);
+  return mmio_read32(sys_sts->hw_status_reg);
 }
 
 // Get SPI clock frequency in Hz
 uint32_t sys_sts_get_spi_clk_freq_hz(struct sys_sts_t *sys_sts, bool verbose) {
   if (verbose) {
     printf("Reading SPI clock frequency register...\n");
-    printf("SPI clock frequency raw: 0x%" PRIx32 "\n", *(sys_sts->spi_clk_freq_hz));
+    printf("SPI clock frequency raw: 0x%" PRIx32 "\n", mmio_read32(sys_sts->spi_clk_freq_hz));
   }
-  return *(sys_sts->spi_clk_freq_hz);
+  return mmio_read32(sys_sts->spi_clk_freq_hz);
 }
 
 // Get FIFO status from a status pointer
 uint32_t get_fifo_status(volatile uint32_t *fifo_sts_ptr, const char *fifo_name, bool verbose) {
   if (verbose) {
     printf("Reading %s FIFO status register...\n", fifo_name);
-    printf("%s FIFO status raw: 0x%08" PRIx32 "\n", fifo_name, *fifo_sts_ptr);
+    printf("%s FIFO status raw: 0x%08" PRIx32 "\n", fifo_name, mmio_read32(fifo_sts_ptr));
   }
-  return *fifo_sts_ptr;
+  return mmio_read32(fifo_sts_ptr);
 }
 
 // Interpret and print hardware status
@@ -300,7 +335,7 @@ void print_spi_clk_freq(uint32_t freq_hz, bool verbose) {
 
 // Print debug register
 void print_debug_register(struct sys_sts_t *sys_sts) {
-  uint32_t value = *(sys_sts->debug);
+  uint32_t value = mmio_read32(sys_sts->debug);
   printf("Debug Register: 0x%08" PRIx32 " (0b", value);
   for (int bit = 31; bit >= 0; bit--) {
     printf("%u", (value >> bit) & 1);
@@ -364,36 +399,36 @@ uint32_t sys_sts_get_trig_data_fifo_status(struct sys_sts_t *sys_sts, bool verbo
 uint32_t sys_sts_get_trig_counter(struct sys_sts_t *sys_sts, bool verbose) {
   if (verbose) {
     printf("Reading trigger counter register...\n");
-    printf("Trigger counter raw: 0x%" PRIx32 "\n", *(sys_sts->trig_counter));
+    printf("Trigger counter raw: 0x%" PRIx32 "\n", mmio_read32(sys_sts->trig_counter));
   }
-  return *(sys_sts->trig_counter);
+  return mmio_read32(sys_sts->trig_counter);
 }
 
 // Get debug register value
 uint32_t sys_sts_get_debug(struct sys_sts_t *sys_sts, bool verbose) {
   if (verbose) {
     printf("Reading debug register...\n");
-    printf("Debug register raw: 0x%" PRIx32 "\n", *(sys_sts->debug));
+    printf("Debug register raw: 0x%" PRIx32 "\n", mmio_read32(sys_sts->debug));
   }
-  return *(sys_sts->debug);
+  return mmio_read32(sys_sts->debug);
 }
 
 // Get DAC "delay too short" time in SPI clock cycles
 uint32_t sys_sts_get_dac_delay_too_short_time(struct sys_sts_t *sys_sts, bool verbose) {
   if (verbose) {
     printf("Reading DAC 'delay too short' time register...\n");
-    printf("DAC 'delay too short' time raw: 0x%" PRIx32 "\n", *(sys_sts->dac_delay_too_short_time));
+    printf("DAC 'delay too short' time raw: 0x%" PRIx32 "\n", mmio_read32(sys_sts->dac_delay_too_short_time));
   }
-  return *(sys_sts->dac_delay_too_short_time);
+  return mmio_read32(sys_sts->dac_delay_too_short_time);
 }
 
 // Get ADC "delay too short" time in SPI clock cycles
 uint32_t sys_sts_get_adc_delay_too_short_time(struct sys_sts_t *sys_sts, bool verbose) {
   if (verbose) {
     printf("Reading ADC 'delay too short' time register...\n");
-    printf("ADC 'delay too short' time raw: 0x%" PRIx32 "\n", *(sys_sts->adc_delay_too_short_time));
+    printf("ADC 'delay too short' time raw: 0x%" PRIx32 "\n", mmio_read32(sys_sts->adc_delay_too_short_time));
   }
-  return *(sys_sts->adc_delay_too_short_time);
+  return mmio_read32(sys_sts->adc_delay_too_short_time);
 }
   
 
@@ -19,11 +19,27 @@ struct trigger_ctrl_t create_trigger_ctrl(bool verbose) {
 
 // Read 64-bit trigger data from FIFO as a pair of 32-bit words
 uint64_t trigger_read(struct trigger_ctrl_t *trigger_ctrl) {
-  uint32_t low_word = *(trigger_ctrl->buffer);
-  uint32_t high_word = *(trigger_ctrl->buffer);
+  uint32_t low_word = mmio_read32(trigger_ctrl->buffer);
+  uint32_t high_word = mmio_read32(trigger_ctrl->buffer);
   return ((uint64_t)high_word << 32) | low_word; // Combine into 64-bit value
 }
 
+// Read count 64-bit trigger samples into dst
+// The caller must have seen at least 2 * count words in the data FIFO status, since
+// reading an empty FIFO is a hardware underflow. Returns the number of samples read.
+uint32_t trigger_read_burst(struct trigger_ctrl_t *trigger_ctrl, uint64_t *dst, uint32_t count) {
+  uint32_t words[TRIG_DATA_FIFO_WORDCOUNT];
+  if (count > TRIG_DATA_FIFO_WORDCOUNT / 2) {
+    count = TRIG_DATA_FIFO_WORDCOUNT / 2;
+  }
+  
+  mmio_read32_burst(trigger_ctrl->buffer, words, 2 * count);
+  for (uint32_t i = 0; i < count; i++) {
+    dst[i] = ((uint64_t)words[2 * i + 1] << 32) | words[2 * i]; // Low word first
+  }
+  return count;
+}
+
 // Trigger command functions
 void trigger_cmd_sync_ch(struct trigger_ctrl_t *trigger_ctrl, bool log, bool verbose) {
   uint32_t cmd_word = (TRIG_CMD_SYNC_CH << TRIG_CMD_CODE_SHIFT) |
@@ -34,7 +50,7 @@ void trigger_cmd_sync_ch(struct trigger_ctrl_t *trigger_ctrl, bool log, bool ver
            cmd_word, TRIG_CMD_SYNC_CH, log ? 1 : 0);
   }
   
-  *(trigger_ctrl->buffer) = cmd_word;
+  mmio_write32(trigger_ctrl->buffer, cmd_word);
 }
 
 void trigger_cmd_set_lockout(struct trigger_ctrl_t *trigger_ctrl, uint32_t cycles, bool verbose) {
@@ -50,7 +66,7 @@ void trigger_cmd_set_lockout(struct trigger_ctrl_t *trigger_ctrl, uint32_t cycle
            cmd_word, TRIG_CMD_SET_LOCKOUT, cycles);
   }
   
-  *(trigger_ctrl->buffer) = cmd_word;
+  mmio_write32(trigger_ctrl->buffer, cmd_word);
 }
 
 void trigger_cmd_expect_ext(struct trigger_ctrl_t *trigger_ctrl, uint32_t count, bool log, bool verbose) {
@@ -68,7 +84,7 @@ void trigger_cmd_expect_ext(struct trigger_ctrl_t *trigger_ctrl, uint32_t count,
            cmd_word, TRIG_CMD_EXPECT_EXT, log ? 1 : 0, count);
   }
   
-  *(trigger_ctrl->buffer) = cmd_word;
+  mmio_write32(trigger_ctrl->buffer, cmd_word);
 }
 
 void trigger_cmd_delay(struct trigger_ctrl_t *trigger_ctrl, uint32_t cycles, bool verbose) {
@@ -84,7 +100,7 @@ void trigger_cmd_delay(struct trigger_ctrl_t *trigger_ctrl, uint32_t cycles, boo
            cmd_word, TRIG_CMD_DELAY, cycles);
   }
   
-  *(trigger_ctrl->buffer) = cmd_word;
+  mmio_write32(trigger_ctrl->buffer, cmd_word);
 }
 
 void trigger_cmd_force_trig(struct trigger_ctrl_t *trigger_ctrl, bool log, bool verbose) {
@@ -96,7 +112,7 @@ void trigger_cmd_force_trig(struct trigger_ctrl_t *trigger_ctrl, bool log, bool
            cmd_word, TRIG_CMD_FORCE_TRIG, log ? 1 : 0);
   }
   
-  *(trigger_ctrl->buffer) = cmd_word;
+  mmio_write32(trigger_ctrl->buffer, cmd_word);
 }
 
 void trigger_cmd_cancel(struct trigger_ctrl_t *trigger_ctrl, bool verbose) {
@@ -107,7 +123,7 @@ void trigger_cmd_cancel(struct trigger_ctrl_t *trigger_ctrl, bool verbose) {
            cmd_word, TRIG_CMD_CANCEL);
   }
   
-  *(trigger_ctrl->buffer) = cmd_word;
+  mmio_write32(trigger_ctrl->buffer, cmd_word);
 }
 
 void trigger_cmd_reset_count(struct trigger_ctrl_t *trigger_ctrl, bool verbose) {
@@ -118,6 +134,6 @@ void trigger_cmd_reset_count(struct trigger_ctrl_t *trigger_ctrl, bool verbose)
            cmd_word, TRIG_CMD_RESET_COUNT);
   }
   
-  *(trigger_ctrl->buffer) = cmd_word;
+  mmio_write32(trigger_ctrl->buffer, cmd_word);
 }
   